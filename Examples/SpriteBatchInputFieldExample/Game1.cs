@@ -14,6 +14,7 @@ namespace SimpleMonogameTruetype.Example
 		BitmapData data;
 		string input = "";
 		Texture2D fontTexture;
+		TextTarget textTarget = new TextTarget();
 
 		public Game1()
 		{
@@ -49,23 +50,37 @@ namespace SimpleMonogameTruetype.Example
 		//Render again only when text is changed
 		private void RenderText()
 		{
-			//Dispose the old texture
-			if (fontTexture != null)
-				fontTexture.Dispose();
-
 			//No text to render
 			if (input == "")
+			{
+				textTarget.Cancel();
+				if (fontTexture != null)
+					fontTexture.Dispose();
+				fontTexture = null;
+				return;
+			}
+
+			//Rasterize the font at size 48pt on a worker thread
+			//  Characters typed or pasted before it starts replace the text instead of being rendered one at a time
+			font.ScheduleBitmapData(textTarget, input, Font.PointsToPixels(48), 0, 1.5f);
+		}
+
+		private void UpdateTexture()
+		{
+			//Reuses the alpha buffer of the previous render
+			if (!textTarget.TryGetResult(ref data))
 				return;
 
-			//Rasterize the font at size 48pt
-			data = font.GenerateBitmapData(input, Font.PointsToPixels(48));
+			//Dispose the old texture
+			if (fontTexture != null)
+				fontTexture.Dispose();
 
 			//Create a texture to hold the rendered string
 			//  SurfaceFormat must be Alpha8
 			fontTexture = new Texture2D(GraphicsDevice, data.Width, data.Height, false, SurfaceFormat.Alpha8);
 
 			//Set texture data
-			fontTexture.SetData(data.Alphas);
+			fontTexture.SetData(data.Alphas, 0, data.Width * data.Height);
 		}
 
 		protected override void Initialize()
@@ -83,6 +98,9 @@ namespace SimpleMonogameTruetype.Example
 			font = new Font("Candara");
 			Console.WriteLine("Loaded " + font.Name);
 
+			//Text may wait up to a frame for more input, TimeSpan ticks are 100 ns
+			Font.SetRenderLatencyBudget((int)(TargetElapsedTime.Ticks / 10));
+
 			RenderInstructions();
 			RenderText();
 		}
@@ -102,6 +120,10 @@ namespace SimpleMonogameTruetype.Example
 			if (Keyboard.GetState().IsKeyDown(Keys.Escape))
 				Exit();
 
+			//Scheduled text is started early enough to be shown in the next frame
+			Font.SetFrameDeadline((int)(TargetElapsedTime.Ticks / 10));
+			UpdateTexture();
+
 			base.Update(gameTime);
 		}
 
@@ -25,6 +25,7 @@ namespace SimpleMonogameTruetype.Example
 		Font font;
 		BitmapData data;
 		Texture2D fontTexture;
+		TextTarget textTarget = new TextTarget();
 
 		public Game1(int width, int height)
 		{
@@ -62,8 +63,16 @@ namespace SimpleMonogameTruetype.Example
 		//Render again only when size is changed
 		private void RenderText(int width)
 		{
-			//Rasterize the font at size 12pt
-			data = font.GenerateBitmapData(englishLoremIpsum, Font.PointsToPixels(12), width - 10);
+			//Rasterize the font at size 12pt on a worker thread, the old texture is drawn until it is done
+			//  While the window is being dragged this replaces the render for the previous size if it hasn't started
+			font.ScheduleBitmapData(textTarget, englishLoremIpsum, Font.PointsToPixels(12), width - 10, 1.5f);
+		}
+
+		private void UpdateTexture()
+		{
+			//Reuses the alpha buffer of the previous render
+			if (!textTarget.TryGetResult(ref data))
+				return;
 
 			//Dispose the old texture
 			if (fontTexture != null)
@@ -74,7 +83,7 @@ namespace SimpleMonogameTruetype.Example
 			fontTexture = new Texture2D(GraphicsDevice, data.Width, data.Height, false, SurfaceFormat.Alpha8);
 
 			//Set texture data
-			fontTexture.SetData(data.Alphas);
+			fontTexture.SetData(data.Alphas, 0, data.Width * data.Height);
 		}
 
 		protected override void Initialize()
@@ -95,6 +104,9 @@ namespace SimpleMonogameTruetype.Example
 			//  or if it's an installed font, by specifying its name
 			font = new Font("Arial");
 			Console.WriteLine("Loaded " + font.Name);
+
+			//While the window is dragged the text is rendered at most every 50 ms, for the newest size
+			Font.SetRenderLatencyBudget(50000);
 			RenderText(Window.ClientBounds.Width);
 		}
 
@@ -112,6 +124,8 @@ namespace SimpleMonogameTruetype.Example
 			if (Keyboard.GetState().IsKeyDown(Keys.Escape))
 				Exit();
 
+			UpdateTexture();
+
 			base.Update(gameTime);
 		}
 
@@ -122,7 +136,8 @@ namespace SimpleMonogameTruetype.Example
 			//Draw the font texture with our pixel shader
 			//  If you need to draw something else as well, you might need another Begin() ... End() -block
 			spriteBatch.Begin(effect: effect);
-			spriteBatch.Draw(fontTexture, new Vector2(5, 5), new Color(0, 0, 0, 255));
+			if (fontTexture != null)
+				spriteBatch.Draw(fontTexture, new Vector2(5, 5), new Color(0, 0, 0, 255));
 			spriteBatch.End();
 
 			base.Draw(gameTime);
@@ -1,11 +1,14 @@
-﻿using System.Drawing;
+﻿using System;
+using System.Drawing;
+using System.Drawing.Imaging;
+using System.Runtime.InteropServices;
 
 namespace SimpleMonogameTruetype
 {
 	/// <summary>
 	/// An object containing size and alpha values for a bitmap.
 	/// </summary>
-	public struct BitmapData
+	public unsafe struct BitmapData
 	{
 		/// <summary>
 		/// Width of the bitmap.
@@ -21,9 +24,14 @@ namespace SimpleMonogameTruetype
 		/// </summary>
 		public int YOffset;
 		/// <summary>
-		/// Alpha values for every pixel.
+		/// Alpha values for every pixel, or whole pixels if <see cref="Format"/> is not <see cref="BitmapFormat.Alpha8"/>.
+		/// When the bitmap data is reused the array may be longer than the bitmap.
 		/// </summary>
 		public byte[] Alphas;
+		/// <summary>
+		/// Pixel layout of <see cref="Alphas"/>.
+		/// </summary>
+		public BitmapFormat Format;
 
 		/// <summary>
 		/// Creates a new <see cref="BitmapData"/> object.
@@ -38,6 +46,24 @@ namespace SimpleMonogameTruetype
 			Height = height;
 			YOffset = yOffset;
 			Alphas = alphas;
+			Format = BitmapFormat.Alpha8;
+		}
+
+		/// <summary>
+		/// Creates a new <see cref="BitmapData"/> object.
+		/// </summary>
+		/// <param name="width">Width of the bitmap.</param>
+		/// <param name="height">Height of the bitmap.</param>
+		/// <param name="yOffset">Offset of the top-most row.</param>
+		/// <param name="pixels">Pixel values in <paramref name="format"/>.</param>
+		/// <param name="format">Pixel layout of <paramref name="pixels"/>.</param>
+		public BitmapData(int width, int height, int yOffset, byte[] pixels, BitmapFormat format)
+		{
+			Width = width;
+			Height = height;
+			YOffset = yOffset;
+			Alphas = pixels;
+			Format = format;
 		}
 
 		/// <summary>
@@ -59,19 +85,33 @@ namespace SimpleMonogameTruetype
 		/// <returns></returns>
 		public byte[] ExpandToRGBA(byte r, byte g, byte b)
 		{
-			byte[] pixels = new byte[Alphas.Length * 4];
-			for (int i = 0; i < Alphas.Length; i++)
-			{
-				int i4 = i * 4;
-				pixels[i4 + 0] = r;
-				pixels[i4 + 1] = g;
-				pixels[i4 + 2] = b;
-				pixels[i4 + 3] = Alphas[i];
-			}
+			byte[] pixels = new byte[Width * Height * 4];
+			ExpandToRGBA(r, g, b, pixels);
 
 			return pixels;
 		}
 
+		/// <summary>
+		/// Expand from alpha only to RGBA into an existing array.
+		/// </summary>
+		/// <param name="r">Red value.</param>
+		/// <param name="g">Green value.</param>
+		/// <param name="b">Blue value.</param>
+		/// <param name="pixels">Array of at least <see cref="Width"/> * <see cref="Height"/> * 4 bytes.</param>
+		public void ExpandToRGBA(byte r, byte g, byte b, byte[] pixels)
+		{
+			if (Format != BitmapFormat.Alpha8)
+				throw new InvalidOperationException("Bitmap data is already in " + Format + " format");
+			if (pixels.Length < Width * Height * 4)
+				throw new ArgumentException("Array is smaller than Width * Height * 4");
+
+			fixed (byte* a = Alphas)
+			fixed (byte* p = pixels)
+			{
+				ExpandBitmap(a, Width, Height, p, Width * 4, (int)BitmapFormat.Rgba8, r << 16 | g << 8 | b);
+			}
+		}
+
 		/// <summary>
 		/// Saves bitmap data to a file.
 		/// </summary>
@@ -79,11 +119,22 @@ namespace SimpleMonogameTruetype
 		/// <param name="hexColor">Text color in hexadecimal.</param>
 		public void SaveToFile(string path, int hexColor = 0)
 		{
-			Bitmap bitmap = new Bitmap(Width, Height);
-			for (int i = 0; i < Alphas.Length; i++)
-				bitmap.SetPixel(i % Width, i / Width, Color.FromArgb(Alphas[i] << 24 | hexColor));
+			if (Format != BitmapFormat.Alpha8)
+				throw new InvalidOperationException("Only Alpha8 bitmap data can be saved");
+
+			//32bpp ARGB is stored as BGRA in memory
+			Bitmap bitmap = new Bitmap(Width, Height, PixelFormat.Format32bppArgb);
+			System.Drawing.Imaging.BitmapData locked = bitmap.LockBits(new Rectangle(0, 0, Width, Height), ImageLockMode.WriteOnly, PixelFormat.Format32bppArgb);
+			fixed (byte* a = Alphas)
+			{
+				ExpandBitmap(a, Width, Height, (byte*)locked.Scan0, locked.Stride, (int)BitmapFormat.Bgra8, hexColor);
+			}
+			bitmap.UnlockBits(locked);
 
 			bitmap.Save(path);
 		}
+
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
+		private static extern void ExpandBitmap(byte* alphas, int width, int height, byte* destination, int stride, int format, int color);
 	}
 }
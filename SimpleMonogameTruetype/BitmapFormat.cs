@@ -0,0 +1,25 @@
+﻿namespace SimpleMonogameTruetype
+{
+	/// <summary>
+	/// Pixel layout of generated bitmap data.
+	/// </summary>
+	public enum BitmapFormat
+	{
+		/// <summary>
+		/// One alpha byte per pixel. Matches SurfaceFormat.Alpha8.
+		/// </summary>
+		Alpha8 = 0,
+		/// <summary>
+		/// Red, green, blue and alpha bytes per pixel. Matches SurfaceFormat.Color with non-premultiplied blending.
+		/// </summary>
+		Rgba8 = 1,
+		/// <summary>
+		/// Blue, green, red and alpha bytes per pixel. Matches System.Drawing's 32bpp ARGB and SurfaceFormat.Bgra32.
+		/// </summary>
+		Bgra8 = 2,
+		/// <summary>
+		/// Red, green, blue and alpha bytes per pixel with the color multiplied by alpha. Matches SurfaceFormat.Color with BlendState.AlphaBlend.
+		/// </summary>
+		PremultipliedRgba8 = 3
+	}
+}
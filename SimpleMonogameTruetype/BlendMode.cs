@@ -0,0 +1,21 @@
+﻿namespace SimpleMonogameTruetype
+{
+	/// <summary>
+	/// How rendered coverage is combined with the contents of the destination.
+	/// </summary>
+	public enum BlendMode
+	{
+		/// <summary>
+		/// The area of the bitmap is cleared and overwritten.
+		/// </summary>
+		Replace = 0,
+		/// <summary>
+		/// Each pixel keeps the larger of the existing and the new coverage. Overlapping strings don't get darker.
+		/// </summary>
+		Max = 1,
+		/// <summary>
+		/// Coverage is added to the existing value and saturates at 255.
+		/// </summary>
+		Add = 2
+	}
+}
@@ -0,0 +1,29 @@
+﻿using System.Runtime.InteropServices;
+
+namespace SimpleMonogameTruetype
+{
+	/// <summary>
+	/// A range of characters a font has glyphs for.
+	/// </summary>
+	[StructLayout(LayoutKind.Sequential)]
+	public struct CoverageRange
+	{
+		/// <summary>
+		/// First character of the range.
+		/// </summary>
+		public int First;
+		/// <summary>
+		/// Last character of the range, included in it.
+		/// </summary>
+		public int Last;
+
+		/// <summary>
+		/// Returns true if the character is in the range.
+		/// </summary>
+		/// <param name="codepoint">Unicode codepoint of the character.</param>
+		public bool Contains(int codepoint)
+		{
+			return codepoint >= First && codepoint <= Last;
+		}
+	}
+}
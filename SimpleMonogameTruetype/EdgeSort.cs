@@ -0,0 +1,19 @@
+﻿namespace SimpleMonogameTruetype
+{
+	/// <summary>
+	/// How the outline edges of a glyph are put in the order the <see cref="Rasterizer.List"/> and <see cref="Rasterizer.EdgeTable"/>
+	/// rasterizers reach them in.
+	/// </summary>
+	public enum EdgeSort
+	{
+		/// <summary>
+		/// Compared by their highest point with quicksort.
+		/// </summary>
+		Quicksort = 0,
+		/// <summary>
+		/// Counted into one bucket per row of the glyph, in time linear in the edges and rows. Gives the same bitmaps as
+		/// <see cref="Quicksort"/> and is faster, most of all for glyphs with many edges.
+		/// </summary>
+		Buckets = 1
+	}
+}
@@ -0,0 +1,18 @@
+﻿namespace SimpleMonogameTruetype
+{
+	/// <summary>
+	/// How the curves of a glyph outline are flattened into the line segments the rasterizers draw.
+	/// </summary>
+	public enum Flattening
+	{
+		/// <summary>
+		/// Curves are halved until every half is within the error of a straight line.
+		/// </summary>
+		Halving = 0,
+		/// <summary>
+		/// The segments each curve needs are computed from its control points and emitted in one pass, quadratic curves with
+		/// points spaced by curvature. Takes fewer segments than <see cref="Halving"/>, but the bitmaps differ slightly along curves.
+		/// </summary>
+		Analytic = 1
+	}
+}
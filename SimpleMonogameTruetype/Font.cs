@@ -1,5 +1,8 @@
 ﻿using System;
+using System.Drawing;
 using System.Runtime.InteropServices;
+using System.Threading;
+using System.Threading.Tasks;
 
 namespace SimpleMonogameTruetype
 {
@@ -67,14 +70,286 @@ namespace SimpleMonogameTruetype
 		/// <returns>A <see cref="BitmapData"/> object containing the size and alpha values for the bitmap.</returns>
 		public BitmapData GenerateBitmapData(string text, int fontSize, int maxWidth, float lineSpacing)
 		{
-			MeasureBitmap(handle, text, fontSize, out int width, out int height, out int yOffset, maxWidth, lineSpacing);
-			byte[] data = new byte[width * height];
-			fixed (byte* p = data)
+			fixed (char* p = text)
 			{
-				GenerateBitmap(handle, p, width);
+				return Generate(p, text.Length, fontSize, maxWidth, lineSpacing, false, null);
+			}
+		}
+
+		/// <summary>
+		/// Generates bitmap data for the desired string using the font. The alpha buffer of <paramref name="data"/> is reused when it is
+		/// large enough, so rendering every frame into the same <see cref="BitmapData"/> doesn't allocate.
+		/// </summary>
+		/// <param name="text">The text to be rendered.</param>
+		/// <param name="fontSize">Font size in pixels. To convert from pt units use <see cref="PointsToPixels(int)"/>.</param>
+		/// <param name="maxWidth">Break the line is this width is exceeded. Resulting width may be smaller than this.</param>
+		/// <param name="lineSpacing">Space between the lines.</param>
+		/// <param name="data">Receives the result. <see cref="BitmapData.Alphas"/> may be longer than <see cref="BitmapData.Width"/> * <see cref="BitmapData.Height"/>.</param>
+		public void GenerateBitmapData(string text, int fontSize, int maxWidth, float lineSpacing, ref BitmapData data)
+		{
+			fixed (char* p = text)
+			{
+				data = Generate(p, text.Length, fontSize, maxWidth, lineSpacing, false, data.Alphas);
+			}
+		}
+
+		/// <summary>
+		/// Generates bitmap data for a range of characters, for example the contents of an input field, without creating a string.
+		/// The alpha buffer of <paramref name="data"/> is reused when it is large enough.
+		/// </summary>
+		/// <param name="text">Characters containing the text to be rendered.</param>
+		/// <param name="start">Index of the first character to render.</param>
+		/// <param name="length">Number of characters to render.</param>
+		/// <param name="fontSize">Font size in pixels. To convert from pt units use <see cref="PointsToPixels(int)"/>.</param>
+		/// <param name="maxWidth">Break the line is this width is exceeded. Resulting width may be smaller than this.</param>
+		/// <param name="lineSpacing">Space between the lines.</param>
+		/// <param name="data">Receives the result. <see cref="BitmapData.Alphas"/> may be longer than <see cref="BitmapData.Width"/> * <see cref="BitmapData.Height"/>.</param>
+		public void GenerateBitmapData(char[] text, int start, int length, int fontSize, int maxWidth, float lineSpacing, ref BitmapData data)
+		{
+			if (start < 0 || length < 0 || start + length > text.Length)
+				throw new ArgumentOutOfRangeException("length");
+
+			fixed (char* p = text)
+			{
+				data = Generate(p + start, length, fontSize, maxWidth, lineSpacing, false, data.Alphas);
+			}
+		}
+
+		/// <summary>
+		/// Generates bitmap data for UTF-8 text, for strings that are kept as UTF-8 and would otherwise be converted to a string first.
+		/// The bytes are decoded by the native library.
+		/// </summary>
+		/// <param name="utf8">Bytes containing the text to be rendered as UTF-8.</param>
+		/// <param name="start">Index of the first byte to render.</param>
+		/// <param name="length">Number of bytes to render.</param>
+		/// <param name="fontSize">Font size in pixels. To convert from pt units use <see cref="PointsToPixels(int)"/>.</param>
+		/// <param name="maxWidth">Break the line is this width is exceeded. Resulting width may be smaller than this.</param>
+		/// <param name="lineSpacing">Space between the lines.</param>
+		/// <returns>A <see cref="BitmapData"/> object containing the size and alpha values for the bitmap.</returns>
+		public BitmapData GenerateBitmapData(byte[] utf8, int start, int length, int fontSize, int maxWidth, float lineSpacing)
+		{
+			BitmapData data = new BitmapData();
+			GenerateBitmapData(utf8, start, length, fontSize, maxWidth, lineSpacing, ref data);
+
+			return data;
+		}
+
+		/// <summary>
+		/// Generates bitmap data for UTF-8 text. The alpha buffer of <paramref name="data"/> is reused when it is large enough.
+		/// </summary>
+		/// <param name="utf8">Bytes containing the text to be rendered as UTF-8.</param>
+		/// <param name="start">Index of the first byte to render.</param>
+		/// <param name="length">Number of bytes to render.</param>
+		/// <param name="fontSize">Font size in pixels. To convert from pt units use <see cref="PointsToPixels(int)"/>.</param>
+		/// <param name="maxWidth">Break the line is this width is exceeded. Resulting width may be smaller than this.</param>
+		/// <param name="lineSpacing">Space between the lines.</param>
+		/// <param name="data">Receives the result. <see cref="BitmapData.Alphas"/> may be longer than <see cref="BitmapData.Width"/> * <see cref="BitmapData.Height"/>.</param>
+		public void GenerateBitmapData(byte[] utf8, int start, int length, int fontSize, int maxWidth, float lineSpacing, ref BitmapData data)
+		{
+			if (start < 0 || length < 0 || start + length > utf8.Length)
+				throw new ArgumentOutOfRangeException("length");
+
+			fixed (byte* p = utf8)
+			{
+				MeasureBitmapUtf8(handle, p + start, length, fontSize, out int width, out int height, out int yOffset, maxWidth, lineSpacing);
+				data = GenerateMeasured(width, height, yOffset, maxWidth, false, data.Alphas);
+			}
+		}
+
+		/// <summary>
+		/// Generates bitmap data for UTF-8 text in unmanaged memory, such as a string owned by a native engine.
+		/// The alpha buffer of <paramref name="data"/> is reused when it is large enough.
+		/// </summary>
+		/// <param name="utf8">Pointer to the text to be rendered as UTF-8.</param>
+		/// <param name="length">Number of bytes to render.</param>
+		/// <param name="fontSize">Font size in pixels. To convert from pt units use <see cref="PointsToPixels(int)"/>.</param>
+		/// <param name="maxWidth">Break the line is this width is exceeded. Resulting width may be smaller than this.</param>
+		/// <param name="lineSpacing">Space between the lines.</param>
+		/// <param name="data">Receives the result. <see cref="BitmapData.Alphas"/> may be longer than <see cref="BitmapData.Width"/> * <see cref="BitmapData.Height"/>.</param>
+		public void GenerateBitmapData(IntPtr utf8, int length, int fontSize, int maxWidth, float lineSpacing, ref BitmapData data)
+		{
+			if (length < 0)
+				throw new ArgumentOutOfRangeException("length");
+
+			MeasureBitmapUtf8(handle, (byte*)utf8, length, fontSize, out int width, out int height, out int yOffset, maxWidth, lineSpacing);
+			data = GenerateMeasured(width, height, yOffset, maxWidth, false, data.Alphas);
+		}
+
+		/// <summary>
+		/// Generates bitmap data straight into unmanaged memory, such as a mapped texture or a buffer owned by the caller.
+		/// The memory must be cleared to zero. <see cref="BitmapData.Alphas"/> of the result is null.
+		/// </summary>
+		/// <param name="text">The text to be rendered.</param>
+		/// <param name="fontSize">Font size in pixels. To convert from pt units use <see cref="PointsToPixels(int)"/>.</param>
+		/// <param name="maxWidth">Break the line is this width is exceeded. Resulting width may be smaller than this.</param>
+		/// <param name="lineSpacing">Space between the lines.</param>
+		/// <param name="destination">Cleared memory the alpha values are written to, rows are <see cref="BitmapData.Width"/> bytes apart.</param>
+		/// <param name="destinationSize">Size of <paramref name="destination"/> in bytes.</param>
+		/// <returns>A <see cref="BitmapData"/> object containing the size of the bitmap.</returns>
+		public BitmapData GenerateBitmapData(string text, int fontSize, int maxWidth, float lineSpacing, IntPtr destination, int destinationSize)
+		{
+			fixed (char* p = text)
+			{
+				MeasureBitmapN(handle, p, text.Length, fontSize, out int width, out int height, out int yOffset, maxWidth, lineSpacing);
+				if (width * height > destinationSize)
+					throw new ArgumentException("Destination is smaller than the bitmap (" + width + "x" + height + ")");
+
+				GenerateBitmap(handle, (byte*)destination, width);
+				return new BitmapData(width, height, yOffset, null);
+			}
+		}
+
+		/// <summary>
+		/// Generates bitmap data in the given pixel format. Colored formats are written by the native library directly, without an alpha bitmap in between.
+		/// </summary>
+		/// <param name="text">The text to be rendered.</param>
+		/// <param name="fontSize">Font size in pixels. To convert from pt units use <see cref="PointsToPixels(int)"/>.</param>
+		/// <param name="maxWidth">Break the line is this width is exceeded. Resulting width may be smaller than this.</param>
+		/// <param name="lineSpacing">Space between the lines.</param>
+		/// <param name="format">Pixel layout of the result.</param>
+		/// <param name="hexColor">Text color in hexadecimal. Ignored for <see cref="BitmapFormat.Alpha8"/>.</param>
+		/// <returns>A <see cref="BitmapData"/> object containing the size and pixel values for the bitmap.</returns>
+		public BitmapData GenerateBitmapData(string text, int fontSize, int maxWidth, float lineSpacing, BitmapFormat format, int hexColor)
+		{
+			BitmapData data = new BitmapData();
+			GenerateBitmapData(text, fontSize, maxWidth, lineSpacing, format, hexColor, ref data);
+
+			return data;
+		}
+
+		/// <summary>
+		/// Generates bitmap data in the given pixel format. The pixel array of <paramref name="data"/> is reused when it is large enough.
+		/// </summary>
+		/// <param name="text">The text to be rendered.</param>
+		/// <param name="fontSize">Font size in pixels. To convert from pt units use <see cref="PointsToPixels(int)"/>.</param>
+		/// <param name="maxWidth">Break the line is this width is exceeded. Resulting width may be smaller than this.</param>
+		/// <param name="lineSpacing">Space between the lines.</param>
+		/// <param name="format">Pixel layout of the result.</param>
+		/// <param name="hexColor">Text color in hexadecimal. Ignored for <see cref="BitmapFormat.Alpha8"/>.</param>
+		/// <param name="data">Receives the result. <see cref="BitmapData.Alphas"/> may be longer than the bitmap.</param>
+		public void GenerateBitmapData(string text, int fontSize, int maxWidth, float lineSpacing, BitmapFormat format, int hexColor, ref BitmapData data)
+		{
+			fixed (char* p = text)
+			{
+				MeasureBitmapN(handle, p, text.Length, fontSize, out int width, out int height, out int yOffset, maxWidth, lineSpacing);
+
+				int rowSize = width * (format == BitmapFormat.Alpha8 ? 1 : 4);
+				byte[] pixels = data.Alphas;
+				if (pixels == null || pixels.Length < rowSize * height)
+					pixels = new byte[rowSize * height];
+
+				fixed (byte* d = pixels)
+				{
+					GenerateBitmapFormat(handle, d, rowSize, (int)format, hexColor);
+				}
+
+				data = new BitmapData(width, height, yOffset, pixels, format);
+			}
+		}
+
+		/// <summary>
+		/// Generates bitmap data in the given pixel format straight into unmanaged memory, for example a mapped texture region.
+		/// Every pixel of the bitmap is written, so the memory doesn't need to be cleared. <see cref="BitmapData.Alphas"/> of the result is null.
+		/// </summary>
+		/// <param name="text">The text to be rendered.</param>
+		/// <param name="fontSize">Font size in pixels. To convert from pt units use <see cref="PointsToPixels(int)"/>.</param>
+		/// <param name="maxWidth">Break the line is this width is exceeded. Resulting width may be smaller than this.</param>
+		/// <param name="lineSpacing">Space between the lines.</param>
+		/// <param name="format">Pixel layout of the result.</param>
+		/// <param name="hexColor">Text color in hexadecimal. Ignored for <see cref="BitmapFormat.Alpha8"/>.</param>
+		/// <param name="destination">Memory the pixels are written to.</param>
+		/// <param name="stride">Distance between rows of <paramref name="destination"/> in bytes.</param>
+		/// <param name="destinationSize">Size of <paramref name="destination"/> in bytes.</param>
+		/// <returns>A <see cref="BitmapData"/> object containing the size of the bitmap.</returns>
+		public BitmapData GenerateBitmapData(string text, int fontSize, int maxWidth, float lineSpacing, BitmapFormat format, int hexColor,
+			IntPtr destination, int stride, int destinationSize)
+		{
+			fixed (char* p = text)
+			{
+				MeasureBitmapN(handle, p, text.Length, fontSize, out int width, out int height, out int yOffset, maxWidth, lineSpacing);
+				int rowSize = width * (format == BitmapFormat.Alpha8 ? 1 : 4);
+				if (stride < rowSize || (height > 0 && stride * (height - 1) + rowSize > destinationSize))
+					throw new ArgumentException("Destination is smaller than the bitmap (" + width + "x" + height + ")");
+
+				GenerateBitmapFormat(handle, (byte*)destination, stride, (int)format, hexColor);
+				return new BitmapData(width, height, yOffset, null, format);
+			}
+		}
+
+		/// <summary>
+		/// Generates bitmap data of which only the part inside <paramref name="clip"/> is rendered, for when only part of the texture is drawn.
+		/// Glyphs outside the rectangle are skipped and glyphs on its edges are rasterized only over the visible rows and columns. Pixels outside it are zero.
+		/// </summary>
+		/// <param name="text">The text to be rendered.</param>
+		/// <param name="fontSize">Font size in pixels. To convert from pt units use <see cref="PointsToPixels(int)"/>.</param>
+		/// <param name="maxWidth">Break the line is this width is exceeded. Resulting width may be smaller than this.</param>
+		/// <param name="lineSpacing">Space between the lines.</param>
+		/// <param name="clip">Visible area in bitmap coordinates.</param>
+		/// <returns>A <see cref="BitmapData"/> object containing the size and alpha values for the bitmap.</returns>
+		public BitmapData GenerateBitmapData(string text, int fontSize, int maxWidth, float lineSpacing, Rectangle clip)
+		{
+			fixed (char* p = text)
+			{
+				MeasureBitmapN(handle, p, text.Length, fontSize, out int width, out int height, out int yOffset, maxWidth, lineSpacing);
+				byte[] alphas = new byte[width * height];
+				fixed (byte* d = alphas)
+				{
+					GenerateBitmapInto(handle, d, width, clip.X, clip.Y, clip.Width, clip.Height, 0, 0, (int)BlendMode.Replace);
+				}
+
+				return new BitmapData(width, height, yOffset, alphas);
 			}
+		}
+
+		/// <summary>
+		/// Draws text into a region of a larger alpha buffer, for example a persistent staging buffer or a mapped texture that holds many strings.
+		/// Only pixels inside <paramref name="clip"/> are written and the rest of the buffer is left as it is. <see cref="BitmapData.Alphas"/> of the result is null.
+		/// </summary>
+		/// <param name="text">The text to be rendered.</param>
+		/// <param name="fontSize">Font size in pixels. To convert from pt units use <see cref="PointsToPixels(int)"/>.</param>
+		/// <param name="maxWidth">Break the line is this width is exceeded. Resulting width may be smaller than this.</param>
+		/// <param name="lineSpacing">Space between the lines.</param>
+		/// <param name="destination">Alpha buffer the text is drawn into.</param>
+		/// <param name="stride">Distance between rows of <paramref name="destination"/> in bytes.</param>
+		/// <param name="destinationHeight">Number of rows in <paramref name="destination"/>.</param>
+		/// <param name="clip">Area of the destination that may be written.</param>
+		/// <param name="origin">Position of the top left corner of the bitmap in the destination.</param>
+		/// <param name="blend">How the text is combined with the contents of the destination.</param>
+		/// <returns>A <see cref="BitmapData"/> object containing the size of the bitmap.</returns>
+		public BitmapData GenerateBitmapData(string text, int fontSize, int maxWidth, float lineSpacing,
+			IntPtr destination, int stride, int destinationHeight, Rectangle clip, Point origin, BlendMode blend)
+		{
+			if (clip.X < 0 || clip.Y < 0 || clip.Right > stride || clip.Bottom > destinationHeight)
+				throw new ArgumentOutOfRangeException("clip", "Clip rectangle is outside the destination");
 
-			return new BitmapData(width, height, yOffset, data);
+			fixed (char* p = text)
+			{
+				MeasureBitmapN(handle, p, text.Length, fontSize, out int width, out int height, out int yOffset, maxWidth, lineSpacing);
+				GenerateBitmapInto(handle, (byte*)destination, stride, clip.X, clip.Y, clip.Width, clip.Height, origin.X, origin.Y, (int)blend);
+				return new BitmapData(width, height, yOffset, null);
+			}
+		}
+
+		/// <summary>
+		/// Draws text into a region of a larger alpha buffer. Only pixels inside <paramref name="clip"/> are written.
+		/// </summary>
+		/// <param name="text">The text to be rendered.</param>
+		/// <param name="fontSize">Font size in pixels. To convert from pt units use <see cref="PointsToPixels(int)"/>.</param>
+		/// <param name="maxWidth">Break the line is this width is exceeded. Resulting width may be smaller than this.</param>
+		/// <param name="lineSpacing">Space between the lines.</param>
+		/// <param name="destination">Alpha buffer the text is drawn into.</param>
+		/// <param name="stride">Distance between rows of <paramref name="destination"/> in bytes.</param>
+		/// <param name="clip">Area of the destination that may be written.</param>
+		/// <param name="origin">Position of the top left corner of the bitmap in the destination.</param>
+		/// <param name="blend">How the text is combined with the contents of the destination.</param>
+		/// <returns>A <see cref="BitmapData"/> object containing the size of the bitmap.</returns>
+		public BitmapData GenerateBitmapData(string text, int fontSize, int maxWidth, float lineSpacing,
+			byte[] destination, int stride, Rectangle clip, Point origin, BlendMode blend)
+		{
+			fixed (byte* d = destination)
+			{
+				return GenerateBitmapData(text, fontSize, maxWidth, lineSpacing, (IntPtr)d, stride, destination.Length / stride, clip, origin, blend);
+			}
 		}
 
 		/// <summary>
@@ -122,17 +397,26 @@ namespace SimpleMonogameTruetype
 		/// <returns>A <see cref="BitmapData"/> object containing the size and alpha values for the bitmap.</returns>
 		public BitmapData GenerateBitmapDataForceWidth(string text, int fontSize, int maxWidth, float lineSpacing)
 		{
-			MeasureBitmap(handle, text, fontSize, out int width, out int height, out int yOffset, maxWidth, lineSpacing);
-			if (width < maxWidth)
-				width = maxWidth;
-			byte[] data = new byte[width * height];
-			fixed (byte* p = data)
+			fixed (char* p = text)
 			{
-				GenerateBitmap(handle, p, width);
+				return Generate(p, text.Length, fontSize, maxWidth, lineSpacing, true, null);
 			}
-			//GenerateBitmap(handle, data, width);
+		}
 
-			return new BitmapData(width, height, yOffset, data);
+		/// <summary>
+		/// Generates bitmap data for the desired string using the font. The alpha buffer of <paramref name="data"/> is reused when it is large enough.
+		/// </summary>
+		/// <param name="text">The text to be rendered.</param>
+		/// <param name="fontSize">Font size in pixels. To convert from pt units use <see cref="PointsToPixels(int)"/>.</param>
+		/// <param name="maxWidth">Break the line is this width is exceeded. Sets the width of the bitmap.</param>
+		/// <param name="lineSpacing">Space between the lines.</param>
+		/// <param name="data">Receives the result. <see cref="BitmapData.Alphas"/> may be longer than <see cref="BitmapData.Width"/> * <see cref="BitmapData.Height"/>.</param>
+		public void GenerateBitmapDataForceWidth(string text, int fontSize, int maxWidth, float lineSpacing, ref BitmapData data)
+		{
+			fixed (char* p = text)
+			{
+				data = Generate(p, text.Length, fontSize, maxWidth, lineSpacing, true, data.Alphas);
+			}
 		}
 
 		/// <summary>
@@ -147,6 +431,219 @@ namespace SimpleMonogameTruetype
 			return GenerateBitmapDataForceWidth(text, fontSize, maxWidth, 1.5f);
 		}
 
+		/// <summary>
+		/// Generates a signed distance field for the desired string using the font. Edges are at value 128, inside is brighter and
+		/// the field fades to 0 at <paramref name="spread"/> pixels outside the glyphs. The result can be drawn at any scale with an alpha test or smoothstep shader.
+		/// </summary>
+		/// <param name="text">The text to be rendered.</param>
+		/// <param name="fontSize">Font size in pixels the field is generated at.</param>
+		/// <param name="spread">Distance in pixels the field reaches outside the glyphs.</param>
+		/// <param name="maxWidth">Break the line is this width is exceeded. Resulting width may be smaller than this.</param>
+		/// <param name="lineSpacing">Space between the lines.</param>
+		/// <returns>A <see cref="BitmapData"/> object containing the size and distance values for the bitmap.</returns>
+		public BitmapData GenerateDistanceFieldData(string text, int fontSize, int spread, int maxWidth, float lineSpacing)
+		{
+			SetRenderMode(RenderSDF, spread);
+			BitmapData data = GenerateBitmapData(text, fontSize, maxWidth, lineSpacing);
+			SetRenderMode(RenderCoverage, 0);
+
+			return data;
+		}
+
+		/// <summary>
+		/// Generates a signed distance field for the desired string using the font.
+		/// </summary>
+		/// <param name="text">The text to be rendered.</param>
+		/// <param name="fontSize">Font size in pixels the field is generated at.</param>
+		/// <param name="spread">Distance in pixels the field reaches outside the glyphs.</param>
+		/// <returns>A <see cref="BitmapData"/> object containing the size and distance values for the bitmap.</returns>
+		public BitmapData GenerateDistanceFieldData(string text, int fontSize, int spread)
+		{
+			return GenerateDistanceFieldData(text, fontSize, spread, 0, 1.5f);
+		}
+
+		/// <summary>
+		/// Queues the string to be measured and rendered on a native worker thread, so the game thread doesn't wait for it. Take the result
+		/// from the returned job once <see cref="RenderJob.IsCompleted"/> is true, or cancel it if the text or size has changed since.
+		/// </summary>
+		/// <param name="text">The text to be rendered.</param>
+		/// <param name="fontSize">Font size in pixels. To convert from pt units use <see cref="PointsToPixels(int)"/>.</param>
+		/// <param name="maxWidth">Break the line is this width is exceeded. Resulting width may be smaller than this.</param>
+		/// <param name="lineSpacing">Space between the lines.</param>
+		/// <returns>A <see cref="RenderJob"/> that gives the same <see cref="BitmapData"/> as <see cref="GenerateBitmapData(string, int, int, float)"/>.</returns>
+		public RenderJob QueueBitmapData(string text, int fontSize, int maxWidth, float lineSpacing)
+		{
+			fixed (char* p = text)
+			{
+				return new RenderJob(QueueRender(handle, p, text.Length, fontSize, maxWidth, lineSpacing, 0));
+			}
+		}
+
+		/// <summary>
+		/// Queues a signed distance field of the string to be generated on a native worker thread, see <see cref="QueueBitmapData(string, int, int, float)"/>.
+		/// </summary>
+		/// <param name="text">The text to be rendered.</param>
+		/// <param name="fontSize">Font size in pixels the field is generated at.</param>
+		/// <param name="spread">Distance in pixels the field reaches outside the glyphs.</param>
+		/// <param name="maxWidth">Break the line is this width is exceeded. Resulting width may be smaller than this.</param>
+		/// <param name="lineSpacing">Space between the lines.</param>
+		/// <returns>A <see cref="RenderJob"/> that gives the same <see cref="BitmapData"/> as <see cref="GenerateDistanceFieldData(string, int, int, int, float)"/>.</returns>
+		public RenderJob QueueDistanceFieldData(string text, int fontSize, int spread, int maxWidth, float lineSpacing)
+		{
+			fixed (char* p = text)
+			{
+				return new RenderJob(QueueRender(handle, p, text.Length, fontSize, maxWidth, lineSpacing, Math.Max(spread, 1)));
+			}
+		}
+
+		/// <summary>
+		/// Schedules the string to be rendered for a target on a native worker thread like <see cref="QueueBitmapData(string, int, int, float)"/>,
+		/// replacing the text scheduled for it before. Take the result from <paramref name="target"/> once <see cref="TextTarget.IsCompleted"/> is true.
+		/// </summary>
+		/// <param name="target">What the text is rendered for, such as a text field.</param>
+		/// <param name="text">The text to be rendered.</param>
+		/// <param name="fontSize">Font size in pixels. To convert from pt units use <see cref="PointsToPixels(int)"/>.</param>
+		/// <param name="maxWidth">Break the line is this width is exceeded. Resulting width may be smaller than this.</param>
+		/// <param name="lineSpacing">Space between the lines.</param>
+		public void ScheduleBitmapData(TextTarget target, string text, int fontSize, int maxWidth, float lineSpacing)
+		{
+			fixed (char* p = text)
+			{
+				target.Job = new RenderJob(ScheduleRender(target.Target, handle, p, text.Length, fontSize, maxWidth, lineSpacing, 0));
+			}
+		}
+
+		/// <summary>
+		/// Renders the string on a native worker thread like <see cref="QueueBitmapData(string, int, int, float)"/>. The task completes
+		/// inside <see cref="RenderJob.CompleteTasks"/>, which the game calls once per frame, so code after <c>await</c> runs on the game thread.
+		/// </summary>
+		/// <param name="text">The text to be rendered.</param>
+		/// <param name="fontSize">Font size in pixels. To convert from pt units use <see cref="PointsToPixels(int)"/>.</param>
+		/// <param name="maxWidth">Break the line is this width is exceeded. Resulting width may be smaller than this.</param>
+		/// <param name="lineSpacing">Space between the lines.</param>
+		/// <returns>A task that gives the same <see cref="BitmapData"/> as <see cref="GenerateBitmapData(string, int, int, float)"/>.</returns>
+		public Task<BitmapData> GenerateBitmapDataAsync(string text, int fontSize, int maxWidth, float lineSpacing)
+		{
+			return GenerateBitmapDataAsync(text, fontSize, maxWidth, lineSpacing, CancellationToken.None);
+		}
+
+		/// <summary>
+		/// Renders the string on a native worker thread like <see cref="GenerateBitmapDataAsync(string, int, int, float)"/>. Cancelling the
+		/// token drops the render, and the task is cancelled at the next <see cref="RenderJob.CompleteTasks"/>.
+		/// </summary>
+		/// <param name="text">The text to be rendered.</param>
+		/// <param name="fontSize">Font size in pixels. To convert from pt units use <see cref="PointsToPixels(int)"/>.</param>
+		/// <param name="maxWidth">Break the line is this width is exceeded. Resulting width may be smaller than this.</param>
+		/// <param name="lineSpacing">Space between the lines.</param>
+		/// <param name="cancellationToken">Cancels the render, for example when the text it was for has changed again.</param>
+		/// <returns>A task that gives the same <see cref="BitmapData"/> as <see cref="GenerateBitmapData(string, int, int, float)"/>.</returns>
+		public Task<BitmapData> GenerateBitmapDataAsync(string text, int fontSize, int maxWidth, float lineSpacing, CancellationToken cancellationToken)
+		{
+			return QueueBitmapData(text, fontSize, maxWidth, lineSpacing).ToTask(cancellationToken);
+		}
+
+		/// <summary>
+		/// Measures the text once and keeps the result, so its lines can be rendered separately with <see cref="TextLayout.RenderLines(int, int, byte[], int)"/>.
+		/// </summary>
+		/// <param name="text">The text to be laid out.</param>
+		/// <param name="fontSize">Font size in pixels. To convert from pt units use <see cref="PointsToPixels(int)"/>.</param>
+		/// <param name="maxWidth">Break the line is this width is exceeded. Resulting width may be smaller than this.</param>
+		/// <param name="lineSpacing">Space between the lines.</param>
+		/// <returns>A new <see cref="TextLayout"/>.</returns>
+		public TextLayout CreateLayout(string text, int fontSize, int maxWidth, float lineSpacing)
+		{
+			return new TextLayout(handle, text, fontSize, maxWidth, lineSpacing);
+		}
+
+		/// <summary>
+		/// Creates a <see cref="TextStream"/> for laying out and rendering very long text in chunks.
+		/// </summary>
+		/// <param name="fontSize">Font size in pixels. To convert from pt units use <see cref="PointsToPixels(int)"/>.</param>
+		/// <param name="maxWidth">Break the line is this width is exceeded.</param>
+		/// <param name="lineSpacing">Space between the lines.</param>
+		/// <returns>A new <see cref="TextStream"/>.</returns>
+		public TextStream CreateTextStream(int fontSize, int maxWidth, float lineSpacing)
+		{
+			return new TextStream(handle, fontSize, maxWidth, lineSpacing);
+		}
+
+		/// <summary>
+		/// Sets the fonts that draw the characters this font doesn't have, tried in order. Text in several languages can then be drawn
+		/// with one font instead of showing boxes for missing characters. Fallbacks of the fallback fonts aren't used.
+		/// </summary>
+		/// <param name="fallbacks">Up to 15 fonts, none to remove the fallbacks.</param>
+		public void SetFallbackFonts(params Font[] fallbacks)
+		{
+			if (fallbacks.Length > MaxFallbackFonts)
+				throw new ArgumentException("At most " + MaxFallbackFonts + " fallback fonts are supported", "fallbacks");
+
+			int* handles = stackalloc int[MaxFallbackFonts];
+			for (int i = 0; i < fallbacks.Length; i++)
+				handles[i] = fallbacks[i].handle;
+			SetFallbackFonts(handle, handles, fallbacks.Length);
+		}
+
+		/// <summary>
+		/// Returns true if the font has glyphs for every character of the text. Characters that are never drawn, such as line breaks, are
+		/// ignored, and so are fallback fonts.
+		/// </summary>
+		/// <param name="text">Text to check.</param>
+		public bool CoversText(string text)
+		{
+			return CountMissingCharacters(text) == 0;
+		}
+
+		/// <summary>
+		/// Counts the characters of the text the font has no glyph for, for picking the font that covers a text best. Characters that are
+		/// never drawn, such as line breaks, are ignored, and so are fallback fonts.
+		/// </summary>
+		/// <param name="text">Text to check.</param>
+		public int CountMissingCharacters(string text)
+		{
+			fixed (char* p = text)
+			{
+				return FontCoversText(handle, p, text.Length);
+			}
+		}
+
+		/// <summary>
+		/// Returns the ranges of characters the font has glyphs for, in increasing order.
+		/// </summary>
+		public CoverageRange[] GetCoverageRanges()
+		{
+			CoverageRange[] ranges = new CoverageRange[GetCoverageRanges(handle, null, 0)];
+			fixed (CoverageRange* p = ranges)
+			{
+				GetCoverageRanges(handle, p, ranges.Length);
+			}
+			return ranges;
+		}
+
+		private BitmapData Generate(char* text, int length, int fontSize, int maxWidth, float lineSpacing, bool forceWidth, byte[] buffer)
+		{
+			MeasureBitmapN(handle, text, length, fontSize, out int width, out int height, out int yOffset, maxWidth, lineSpacing);
+			return GenerateMeasured(width, height, yOffset, maxWidth, forceWidth, buffer);
+		}
+
+		private BitmapData GenerateMeasured(int width, int height, int yOffset, int maxWidth, bool forceWidth, byte[] buffer)
+		{
+			if (forceWidth && width < maxWidth)
+				width = maxWidth;
+
+			//The native side expects a cleared buffer
+			if (buffer == null || buffer.Length < width * height)
+				buffer = new byte[width * height];
+			else
+				Array.Clear(buffer, 0, width * height);
+
+			fixed (byte* p = buffer)
+			{
+				GenerateBitmap(handle, p, width);
+			}
+
+			return new BitmapData(width, height, yOffset, buffer);
+		}
+
 		/// <summary>
 		/// Convert from pt units to pixels.
 		/// </summary>
@@ -157,29 +654,125 @@ namespace SimpleMonogameTruetype
 			return pt * 4 / 3;
 		}
 
-		[DllImport("simple-font-lib.dll", CallingConvention = CallingConvention.Cdecl)]
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
 		private static extern int LoadFont([MarshalAs(UnmanagedType.LPWStr)]string filename, int index, out IntPtr actualName);
 
-		[DllImport("simple-font-lib.dll", CallingConvention = CallingConvention.Cdecl)]
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
 		private static extern int LoadFontByName([MarshalAs(UnmanagedType.LPWStr)]string fontname, out IntPtr actualName);
 
-		[DllImport("simple-font-lib.dll", CallingConvention = CallingConvention.Cdecl)]
-		private static extern void MeasureBitmap(int handle, [MarshalAs(UnmanagedType.LPWStr)]string text, int fontSize,
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
+		private static extern void MeasureBitmapN(int handle, char* text, int length, int fontSize,
+			out int width, out int height, out int yOffset, int maxWidth, float lineSpacing);
+
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
+		private static extern void MeasureBitmapUtf8(int handle, byte* text, int length, int fontSize,
 			out int width, out int height, out int yOffset, int maxWidth, float lineSpacing);
 
-		[DllImport("simple-font-lib.dll", CallingConvention = CallingConvention.Cdecl)]
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
 		private static extern void GenerateBitmap(int handle, byte* emptyBitmap, int width);
 
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
+		private static extern void GenerateBitmapFormat(int handle, byte* destination, int stride, int format, int color);
+
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
+		private static extern void GenerateBitmapInto(int handle, byte* destination, int stride, int clipX, int clipY, int clipWidth, int clipHeight,
+			int originX, int originY, int blend);
+
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
+		private static extern int QueueRender(int handle, char* text, int length, int fontSize, int maxWidth, float lineSpacing, int spread);
+
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
+		private static extern int ScheduleRender(int target, int handle, char* text, int length, int fontSize, int maxWidth, float lineSpacing, int spread);
+
+		private const int MaxFallbackFonts = 15;
+
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
+		private static extern int SetFallbackFonts(int handle, int* handles, int count);
+
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
+		private static extern int FontCoversText(int handle, char* text, int length);
+
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
+		private static extern int GetCoverageRanges(int handle, CoverageRange* ranges, int maxRanges);
+
+		private const int RenderCoverage = 0;
+		private const int RenderSDF = 1;
+
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
+		private static extern void SetRenderMode(int mode, int spread);
+
+		/// <summary>
+		/// Selects how text is wrapped when a maximum width is given. Applies to every font, the default is <see cref="WrapMode.Greedy"/>.
+		/// </summary>
+		/// <param name="mode">The wrap mode.</param>
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
+		public static extern void SetWrapMode(WrapMode mode);
+
+		/// <summary>
+		/// Selects how glyphs are rasterized. Applies to every font, the default is <see cref="Rasterizer.List"/>.
+		/// </summary>
+		/// <param name="rasterizer">The rasterizer.</param>
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
+		public static extern void SetRasterizer(Rasterizer rasterizer);
+
+		/// <summary>
+		/// Selects how the edges of a glyph are sorted before they are rasterized. Applies to every font, the default is
+		/// <see cref="EdgeSort.Buckets"/>.
+		/// </summary>
+		/// <param name="sort">The edge sort.</param>
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
+		public static extern void SetEdgeSort(EdgeSort sort);
+
+		/// <summary>
+		/// Selects how the curves of a glyph are flattened into line segments before they are rasterized. Applies to every font and
+		/// rasterizer, the default is <see cref="Flattening.Halving"/>.
+		/// </summary>
+		/// <param name="flattening">The flattening.</param>
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
+		public static extern void SetFlattening(Flattening flattening);
+
+		/// <summary>
+		/// Glyphs at least this many pixels tall are drawn with <see cref="Rasterizer.Tiled"/> whichever rasterizer is selected. Applies to
+		/// every font, the default is 64.
+		/// </summary>
+		/// <param name="pixels">Height of the glyph in pixels, 0 to only use the selected rasterizer.</param>
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
+		public static extern void SetTiledRasterizerThreshold(int pixels);
+
+		/// <summary>
+		/// Sets how many native worker threads render queued text. Applies to every font, the default of 0 uses one less than the number of
+		/// cores and at least one. Waits for the queued jobs to finish.
+		/// </summary>
+		/// <param name="count">Number of worker threads, at most 16.</param>
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
+		public static extern void SetRenderWorkers(int count);
+
+		/// <summary>
+		/// Sets how long text scheduled for a <see cref="TextTarget"/> may wait before it is rendered, so text that keeps changing is rendered
+		/// once it stops changing instead of for every change. The default is 0, a worker starts on it as soon as it is free.
+		/// </summary>
+		/// <param name="microseconds">Longest wait in microseconds.</param>
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
+		public static extern void SetRenderLatencyBudget(int microseconds);
+
+		/// <summary>
+		/// Hints when the textures of the next frame are needed, for example from <c>Update</c> with the time left until the next frame.
+		/// Scheduled text then waits no longer than it can to be rendered by then, assuming it takes as long as the last render of its target.
+		/// </summary>
+		/// <param name="microseconds">Time from now until the frame in microseconds, 0 to remove the hint.</param>
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
+		public static extern void SetFrameDeadline(int microseconds);
+
 		/// <summary>
 		/// Prints all installed fonts.
 		/// </summary>
-		[DllImport("simple-font-lib.dll", CallingConvention = CallingConvention.Cdecl)]
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
 		public static extern void PrintInstalledFonts();
 
 		/// <summary>
 		/// Free all unmanaged resources.
 		/// </summary>
-		[DllImport("simple-font-lib.dll", CallingConvention = CallingConvention.Cdecl)]
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
 		public static extern void FreeAllResources();
 	}
 }
@@ -0,0 +1,202 @@
+﻿using System;
+using System.Runtime.InteropServices;
+
+namespace SimpleMonogameTruetype
+{
+	/// <summary>
+	/// Timed phases of the native library.
+	/// </summary>
+	public enum StatPhase
+	{
+		/// <summary>
+		/// Reading and parsing font files that were not loaded yet.
+		/// </summary>
+		LoadFont = 0,
+		/// <summary>
+		/// Measuring and word wrapping text.
+		/// </summary>
+		Layout = 1,
+		/// <summary>
+		/// Generating bitmaps, rendering layout lines and stream windows.
+		/// </summary>
+		Render = 2,
+		/// <summary>
+		/// Character to glyph lookups.
+		/// </summary>
+		Cmap = 3,
+		/// <summary>
+		/// Kerning lookups.
+		/// </summary>
+		Kern = 4,
+		/// <summary>
+		/// Decoding glyph outlines.
+		/// </summary>
+		Outline = 5,
+		/// <summary>
+		/// Flattening and rasterizing glyph outlines.
+		/// </summary>
+		Rasterize = 6,
+		/// <summary>
+		/// Shaping text with the font's GSUB and GPOS tables, cached runs are not shaped again.
+		/// </summary>
+		Shape = 7
+	}
+
+	/// <summary>
+	/// Counters of the native library.
+	/// </summary>
+	public enum StatCounter
+	{
+		/// <summary>
+		/// Glyphs positioned by layout.
+		/// </summary>
+		GlyphsPlaced = 0,
+		/// <summary>
+		/// Glyphs rasterized.
+		/// </summary>
+		GlyphsRasterized = 1,
+		/// <summary>
+		/// Outline edges processed by the rasterizer.
+		/// </summary>
+		Edges = 2,
+		/// <summary>
+		/// Font loads that found the font already loaded.
+		/// </summary>
+		FontCacheHits = 3,
+		/// <summary>
+		/// Font loads that had to read the font.
+		/// </summary>
+		FontCacheMisses = 4,
+		/// <summary>
+		/// Heap allocations.
+		/// </summary>
+		Allocations = 5,
+		/// <summary>
+		/// Bytes requested from the heap.
+		/// </summary>
+		BytesAllocated = 6,
+		/// <summary>
+		/// Paragraphs found in the shaped run cache.
+		/// </summary>
+		ShapeCacheHits = 7,
+		/// <summary>
+		/// Paragraphs that had to be shaped.
+		/// </summary>
+		ShapeCacheMisses = 8
+	}
+
+	/// <summary>
+	/// Snapshot of the native library's timers and counters. They are only collected when the library is built with SFL_STATS,
+	/// see <see cref="IsAvailable"/>. Time measured around a call minus the native phases is the cost of the call boundary.
+	/// </summary>
+	public class NativeStats
+	{
+		private const int PhaseCount = 8;
+		private const int CounterCount = 9;
+
+		private readonly long[] values;
+
+		/// <summary>
+		/// True if the native library was built with instrumentation.
+		/// </summary>
+		public static bool IsAvailable
+		{
+			get { return GetStats(null, 0) > 0; }
+		}
+
+		private NativeStats(long[] values)
+		{
+			this.values = values;
+		}
+
+		/// <summary>
+		/// Sums the timers and counters of all threads. Every value is zero if the library was built without instrumentation.
+		/// </summary>
+		/// <returns>The current values.</returns>
+		public static NativeStats Capture()
+		{
+			long[] values = new long[PhaseCount * 2 + CounterCount];
+			GetStats(values, values.Length);
+			return new NativeStats(values);
+		}
+
+		/// <summary>
+		/// Sets all timers and counters to zero and discards recorded trace events.
+		/// </summary>
+		public static void Reset()
+		{
+			ResetStats();
+		}
+
+		/// <summary>
+		/// Starts or stops recording every phase as a trace event, see <see cref="WriteTrace"/>.
+		/// </summary>
+		/// <param name="enabled">True to record events.</param>
+		public static void SetTracing(bool enabled)
+		{
+			SetStatsTracing(enabled ? 1 : 0);
+		}
+
+		/// <summary>
+		/// Writes the recorded trace events in the Chrome trace format, viewable in chrome://tracing or Perfetto.
+		/// </summary>
+		/// <param name="filename">File to create.</param>
+		/// <returns>Number of events written.</returns>
+		public static int WriteTrace(string filename)
+		{
+			int written = WriteStatsTrace(filename);
+			if (written < 0)
+				throw new System.IO.IOException("Can't create " + filename);
+			return written;
+		}
+
+		/// <summary>
+		/// Number of times a phase was run.
+		/// </summary>
+		public long GetCalls(StatPhase phase)
+		{
+			return values[(int)phase * 2];
+		}
+
+		/// <summary>
+		/// Total time spent in a phase. Lookups happen inside layout and rendering so phases overlap.
+		/// </summary>
+		public TimeSpan GetTime(StatPhase phase)
+		{
+			return TimeSpan.FromTicks(values[(int)phase * 2 + 1] / 100);
+		}
+
+		/// <summary>
+		/// Value of a counter.
+		/// </summary>
+		public long GetCount(StatCounter counter)
+		{
+			return values[PhaseCount * 2 + (int)counter];
+		}
+
+		/// <summary>
+		/// Gets what happened between an earlier snapshot and this one, for example during a single frame.
+		/// </summary>
+		/// <param name="earlier">Snapshot taken before this one.</param>
+		/// <returns>The differences.</returns>
+		public NativeStats Since(NativeStats earlier)
+		{
+			long[] difference = new long[values.Length];
+			for (int i = 0; i < values.Length; i++)
+				difference[i] = values[i] - earlier.values[i];
+			return new NativeStats(difference);
+		}
+
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
+		private static extern int GetStats(long[] values, int count);
+
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
+		private static extern void ResetStats();
+
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
+		private static extern void SetStatsTracing(int enabled);
+
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
+		private static extern int WriteStatsTrace([MarshalAs(UnmanagedType.LPWStr)]string filename);
+	}
+}
@@ -0,0 +1,23 @@
+﻿namespace SimpleMonogameTruetype
+{
+	/// <summary>
+	/// How glyph outlines are turned into coverage.
+	/// </summary>
+	public enum Rasterizer
+	{
+		/// <summary>
+		/// Row by row, with the outline edges crossing the row kept in a linked list.
+		/// </summary>
+		List = 0,
+		/// <summary>
+		/// Row by row, with the edges kept in contiguous arrays that are added to and compacted once per row, for glyphs with many edges
+		/// such as complex CJK characters at large sizes. Gives the same bitmaps as <see cref="List"/>.
+		/// </summary>
+		EdgeTable = 1,
+		/// <summary>
+		/// Every edge adds the area it covers to a buffer that is summed along each row, in tiles of 16 by 16 pixels that are skipped when
+		/// no edge crosses them. Fastest for large glyphs, pixels may differ from the other rasterizers by one level.
+		/// </summary>
+		Tiled = 2
+	}
+}
@@ -0,0 +1,169 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Runtime.InteropServices;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace SimpleMonogameTruetype
+{
+	/// <summary>
+	/// Text being measured and rendered on a native worker thread, queued with <see cref="Font.QueueBitmapData(string, int, int, float)"/>.
+	/// Check <see cref="IsCompleted"/> from the game loop and take the bitmap with <see cref="TryGetResult(ref BitmapData)"/>, or cancel
+	/// the job when its result is no longer wanted, for example when the window has been resized again before it finished.
+	/// </summary>
+	public unsafe sealed class RenderJob : IDisposable
+	{
+		private const int Invalid = -1;
+		private const int Done = 2;
+
+		private static readonly List<RenderJob> awaited = new List<RenderJob>();
+
+		private int handle;
+		private TaskCompletionSource<BitmapData> completion;
+		private CancellationTokenRegistration registration;
+		private volatile bool cancelRequested;
+
+		internal RenderJob(int handle)
+		{
+			this.handle = handle;
+		}
+
+		/// <summary>
+		/// True once the bitmap has been rendered and can be taken without waiting.
+		/// </summary>
+		public bool IsCompleted
+		{
+			get { return handle != Invalid && GetRenderStatus(handle, out int width, out int height, out int yOffset) == Done; }
+		}
+
+		/// <summary>
+		/// Takes the bitmap if the job has completed, the job can't be used after that. The alpha buffer of <paramref name="data"/> is reused when it is large enough,
+		/// so taking every render into the same <see cref="BitmapData"/> doesn't allocate.
+		/// </summary>
+		/// <param name="data">Receives the result. <see cref="BitmapData.Alphas"/> may be longer than <see cref="BitmapData.Width"/> * <see cref="BitmapData.Height"/>.</param>
+		/// <returns>False if the job hasn't completed, was cancelled or was already taken. <paramref name="data"/> is left unchanged then.</returns>
+		public bool TryGetResult(ref BitmapData data)
+		{
+			if (handle == Invalid || GetRenderStatus(handle, out int width, out int height, out int yOffset) != Done)
+				return false;
+
+			byte[] buffer = data.Alphas;
+			if (buffer == null || buffer.Length < width * height)
+				buffer = new byte[width * height];
+
+			int taken;
+			fixed (byte* p = buffer)
+			{
+				taken = TakeRender(handle, p);
+			}
+			handle = Invalid;
+			if (taken == 0)
+				return false;
+
+			data = new BitmapData(width, height, yOffset, buffer);
+			return true;
+		}
+
+		/// <summary>
+		/// Blocks until the job has completed and takes the bitmap, for example while a loading screen is shown.
+		/// </summary>
+		/// <returns>A <see cref="BitmapData"/> object containing the size and alpha values for the bitmap.</returns>
+		public BitmapData Wait()
+		{
+			if (handle == Invalid)
+				throw new InvalidOperationException("The job was cancelled or its result was already taken");
+
+			WaitRender(handle);
+			BitmapData data = new BitmapData();
+			TryGetResult(ref data);
+			return data;
+		}
+
+		/// <summary>
+		/// Drops the job. If a worker hasn't started it, it is never rendered, otherwise the worker stops as soon as it can.
+		/// </summary>
+		public void Cancel()
+		{
+			if (handle != Invalid)
+				CancelRender(handle);
+			handle = Invalid;
+		}
+
+		/// <summary>
+		/// Cancels the job if its result hasn't been taken.
+		/// </summary>
+		public void Dispose()
+		{
+			Cancel();
+		}
+
+		internal Task<BitmapData> ToTask(CancellationToken cancellationToken)
+		{
+			completion = new TaskCompletionSource<BitmapData>();
+			if (cancellationToken.CanBeCanceled)
+				registration = cancellationToken.Register(() => cancelRequested = true);
+			lock (awaited)
+			{
+				awaited.Add(this);
+			}
+			return completion.Task;
+		}
+
+		/// <summary>
+		/// Completes the tasks of <see cref="Font.GenerateBitmapDataAsync(string, int, int, float)"/> whose bitmaps have been rendered and
+		/// cancels those whose tokens were cancelled or whose jobs were dropped, for example by <see cref="Font.FreeAllResources"/>. Call it once per frame, for example at the start of <c>Update</c>. Continuations of the
+		/// tasks run inside this call on the calling thread, so code after <c>await</c> can create textures.
+		/// </summary>
+		public static void CompleteTasks()
+		{
+			RenderJob[] jobs;
+			lock (awaited)
+			{
+				jobs = awaited.ToArray();
+			}
+
+			foreach (RenderJob job in jobs)
+			{
+				BitmapData data = new BitmapData();
+				if (job.cancelRequested)
+				{
+					job.Cancel();
+					job.Finish();
+					job.completion.SetCanceled();
+				}
+				else if (job.TryGetResult(ref data))
+				{
+					job.Finish();
+					job.completion.SetResult(data);
+				}
+				else if (job.handle == Invalid || GetRenderStatus(job.handle, out int width, out int height, out int yOffset) == Invalid)
+				{
+					job.handle = Invalid;
+					job.Finish();
+					job.completion.SetCanceled();
+				}
+			}
+		}
+
+		private void Finish()
+		{
+			registration.Dispose();
+			lock (awaited)
+			{
+				awaited.Remove(this);
+			}
+		}
+
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
+		private static extern int GetRenderStatus(int job, out int width, out int height, out int yOffset);
+
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
+		private static extern int WaitRender(int job);
+
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
+		private static extern int TakeRender(int job, byte* destination);
+
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
+		private static extern void CancelRender(int job);
+	}
+}
@@ -0,0 +1,116 @@
+﻿using System;
+using System.Runtime.InteropServices;
+
+namespace SimpleMonogameTruetype
+{
+	/// <summary>
+	/// Text that has been measured once and can be rendered line by line, for example into a ring buffered texture of a scrollable text pane.
+	/// </summary>
+	public unsafe class TextLayout : IDisposable
+	{
+		private int handle;
+
+		/// <summary>
+		/// Width of the whole layout in pixels.
+		/// </summary>
+		public int Width
+		{
+			get; private set;
+		}
+
+		/// <summary>
+		/// Height of the whole layout in pixels.
+		/// </summary>
+		public int Height
+		{
+			get; private set;
+		}
+
+		/// <summary>
+		/// Offset of the top-most row, see <see cref="BitmapData.YOffset"/>.
+		/// </summary>
+		public int YOffset
+		{
+			get; private set;
+		}
+
+		/// <summary>
+		/// Number of lines after word wrapping.
+		/// </summary>
+		public int LineCount
+		{
+			get; private set;
+		}
+
+		internal TextLayout(int fontHandle, string text, int fontSize, int maxWidth, float lineSpacing)
+		{
+			handle = CreateLayout(fontHandle, text, fontSize, maxWidth, lineSpacing, out int width, out int height, out int yOffset);
+			Width = width;
+			Height = height;
+			YOffset = yOffset;
+			LineCount = GetLayoutLineCount(handle);
+		}
+
+		/// <summary>
+		/// Gets the top row of a line in the layout. Passing <see cref="LineCount"/> gives the bottom of the last line.
+		/// </summary>
+		/// <param name="line">Index of the line.</param>
+		/// <returns>Row of the layout where the line starts.</returns>
+		public int GetLineTop(int line)
+		{
+			if (line == LineCount)
+				return Height;
+			if (GetLayoutLine(handle, line, out int glyphStart, out int top, out int bottom) == 0)
+				throw new ArgumentOutOfRangeException("line");
+
+			return top;
+		}
+
+		/// <summary>
+		/// Renders a range of lines into a ring buffer where layout row y is stored at buffer row y % <paramref name="bufferHeight"/>.
+		/// Only the rows of these lines are touched, so when scrolling only the newly exposed lines need to be rendered.
+		/// </summary>
+		/// <param name="firstLine">Index of the first line to render.</param>
+		/// <param name="lineCount">Number of lines to render.</param>
+		/// <param name="buffer">Alpha buffer of size <see cref="Width"/> * <paramref name="bufferHeight"/>.</param>
+		/// <param name="bufferHeight">Number of rows in the ring buffer. Must be at least the height of the visible area.</param>
+		public void RenderLines(int firstLine, int lineCount, byte[] buffer, int bufferHeight)
+		{
+			if (buffer.Length < Width * bufferHeight)
+				throw new ArgumentException("Buffer is smaller than Width * bufferHeight");
+
+			fixed (byte* p = buffer)
+			{
+				RenderLines(handle, firstLine, lineCount, p, Width, bufferHeight);
+			}
+		}
+
+		/// <summary>
+		/// Frees the layout.
+		/// </summary>
+		public void Dispose()
+		{
+			if (handle >= 0)
+			{
+				FreeLayout(handle);
+				handle = -1;
+			}
+		}
+
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
+		private static extern int CreateLayout(int handle, [MarshalAs(UnmanagedType.LPWStr)]string text, int fontSize, int maxWidth, float lineSpacing,
+			out int width, out int height, out int yOffset);
+
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
+		private static extern int GetLayoutLineCount(int handle);
+
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
+		private static extern int GetLayoutLine(int handle, int line, out int glyphStart, out int top, out int bottom);
+
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
+		private static extern void RenderLines(int handle, int firstLine, int lineCount, byte* buffer, int width, int bufferHeight);
+
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
+		private static extern void FreeLayout(int handle);
+	}
+}
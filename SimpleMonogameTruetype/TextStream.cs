@@ -0,0 +1,148 @@
+﻿using System;
+using System.Runtime.InteropServices;
+
+namespace SimpleMonogameTruetype
+{
+	/// <summary>
+	/// Position and width of a laid out line in a <see cref="TextStream"/>.
+	/// </summary>
+	public struct LineRecord
+	{
+		/// <summary>
+		/// Index of the first character of the line in the streamed text.
+		/// </summary>
+		public int Start;
+		/// <summary>
+		/// Number of characters in the line, including the line break.
+		/// </summary>
+		public int Length;
+		/// <summary>
+		/// Width of the line in pixels.
+		/// </summary>
+		public int Width;
+	}
+
+	/// <summary>
+	/// Lays out text that is fed in chunks and renders windows of lines into a fixed size buffer.
+	/// Only the unfinished last line is kept in memory, so documents of any length can be streamed.
+	/// </summary>
+	public unsafe class TextStream : IDisposable
+	{
+		private int handle;
+
+		/// <summary>
+		/// Number of completed lines.
+		/// </summary>
+		public int LineCount
+		{
+			get; private set;
+		}
+
+		/// <summary>
+		/// Distance between the tops of two consecutive lines in pixels.
+		/// </summary>
+		public int LineHeight
+		{
+			get; private set;
+		}
+
+		internal TextStream(int fontHandle, int fontSize, int maxWidth, float lineSpacing)
+		{
+			handle = CreateTextStream(fontHandle, fontSize, maxWidth, lineSpacing);
+			LineHeight = GetStreamLineHeight(handle);
+		}
+
+		/// <summary>
+		/// Lays out the next chunk of text. Completed lines become available immediately.
+		/// </summary>
+		/// <param name="text">The next chunk of text.</param>
+		/// <returns>Number of completed lines.</returns>
+		public int Append(string text)
+		{
+			fixed (char* p = text)
+			{
+				LineCount = AppendTextStream(handle, p, text.Length);
+			}
+
+			return LineCount;
+		}
+
+		/// <summary>
+		/// Completes the last line after all text has been appended.
+		/// </summary>
+		/// <returns>Total number of lines.</returns>
+		public int Finish()
+		{
+			return LineCount = FinishTextStream(handle);
+		}
+
+		/// <summary>
+		/// Gets the position and width of a completed line.
+		/// </summary>
+		/// <param name="line">Index of the line.</param>
+		/// <returns>A <see cref="LineRecord"/> for the line.</returns>
+		public LineRecord GetLine(int line)
+		{
+			LineRecord record;
+			if (GetStreamLine(handle, line, out record.Start, out record.Length, out record.Width) == 0)
+				throw new ArgumentOutOfRangeException("line");
+
+			return record;
+		}
+
+		/// <summary>
+		/// Renders a window of lines into an alpha buffer. Glyphs that don't fit the buffer are clipped.
+		/// </summary>
+		/// <param name="text">Text that contains at least the rendered lines.</param>
+		/// <param name="textStart">Index of the first character of <paramref name="text"/> in the streamed text.</param>
+		/// <param name="firstLine">Index of the line drawn at the top of the buffer.</param>
+		/// <param name="lineCount">Number of lines to draw.</param>
+		/// <param name="buffer">Cleared alpha buffer of size <paramref name="width"/> * <paramref name="height"/>.</param>
+		/// <param name="width">Width of the buffer.</param>
+		/// <param name="height">Height of the buffer.</param>
+		public void RenderWindow(string text, int textStart, int firstLine, int lineCount, byte[] buffer, int width, int height)
+		{
+			if (buffer.Length < width * height)
+				throw new ArgumentException("Buffer is smaller than width * height");
+
+			fixed (char* p = text)
+			fixed (byte* b = buffer)
+			{
+				RenderStreamWindow(handle, p, textStart, firstLine, lineCount, b, width, height);
+			}
+		}
+
+		/// <summary>
+		/// Frees the line records of the stream.
+		/// </summary>
+		public void Dispose()
+		{
+			if (handle >= 0)
+			{
+				FreeTextStream(handle);
+				handle = -1;
+			}
+		}
+
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
+		private static extern int CreateTextStream(int handle, int fontSize, int maxWidth, float lineSpacing);
+
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
+		private static extern int AppendTextStream(int handle, char* text, int length);
+
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
+		private static extern int FinishTextStream(int handle);
+
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
+		private static extern int GetStreamLine(int handle, int line, out int start, out int length, out int width);
+
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
+		private static extern int GetStreamLineHeight(int handle);
+
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
+		private static extern void RenderStreamWindow(int handle, char* text, int textStart, int firstLine, int lineCount, byte* buffer, int width, int height);
+
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
+		private static extern void FreeTextStream(int handle);
+	}
+}
@@ -0,0 +1,74 @@
+﻿using System;
+using System.Runtime.InteropServices;
+using System.Threading;
+
+namespace SimpleMonogameTruetype
+{
+	/// <summary>
+	/// Something text is rendered for, such as a text field, that only needs its newest text. Text scheduled with
+	/// <see cref="Font.ScheduleBitmapData(TextTarget, string, int, int, float)"/> replaces the text scheduled before if no worker has started on it,
+	/// and cancels the render if one has. During a burst of changes, such as while a window is resized or text is pasted, the renders that
+	/// would be thrown away are skipped. <see cref="Font.SetRenderLatencyBudget(int)"/> and <see cref="Font.SetFrameDeadline(int)"/> set how long
+	/// scheduled text may wait for newer text.
+	/// </summary>
+	public sealed class TextTarget : IDisposable
+	{
+		private static int lastTarget = -1;
+
+		internal readonly int Target;
+		internal RenderJob Job;
+
+		/// <summary>
+		/// Creates a target with nothing scheduled.
+		/// </summary>
+		public TextTarget()
+		{
+			Target = Interlocked.Increment(ref lastTarget);
+		}
+
+		/// <summary>
+		/// True once the newest scheduled text has been rendered and can be taken without waiting.
+		/// </summary>
+		public bool IsCompleted
+		{
+			get { return Job != null && Job.IsCompleted; }
+		}
+
+		/// <summary>
+		/// Takes the bitmap of the newest scheduled text if it has been rendered. The alpha buffer of <paramref name="data"/> is reused when it
+		/// is large enough.
+		/// </summary>
+		/// <param name="data">Receives the result. <see cref="BitmapData.Alphas"/> may be longer than <see cref="BitmapData.Width"/> * <see cref="BitmapData.Height"/>.</param>
+		/// <returns>False if nothing new has been rendered since the last result was taken. <paramref name="data"/> is left unchanged then.</returns>
+		public bool TryGetResult(ref BitmapData data)
+		{
+			if (Job == null || !Job.TryGetResult(ref data))
+				return false;
+
+			Job = null;
+			return true;
+		}
+
+		/// <summary>
+		/// Cancels the scheduled text, for example when there is no text to show anymore. New text can be scheduled afterwards.
+		/// </summary>
+		public void Cancel()
+		{
+			if (Job != null)
+				Job.Cancel();
+			Job = null;
+		}
+
+		/// <summary>
+		/// Cancels the scheduled text and releases the target.
+		/// </summary>
+		public void Dispose()
+		{
+			Job = null;
+			FreeRenderTarget(Target);
+		}
+
+		[DllImport("simple-font-lib", CallingConvention = CallingConvention.Cdecl)]
+		private static extern void FreeRenderTarget(int target);
+	}
+}
@@ -0,0 +1,18 @@
+﻿namespace SimpleMonogameTruetype
+{
+	/// <summary>
+	/// How text is broken into lines when a maximum width is given.
+	/// </summary>
+	public enum WrapMode
+	{
+		/// <summary>
+		/// Every line is filled before the next one is started. Fastest, but the last line of a paragraph may be left with a single word.
+		/// </summary>
+		Greedy = 0,
+		/// <summary>
+		/// The lines of each paragraph are chosen together so they come out as even as possible, for dialogue boxes and other short paragraphs.
+		/// Every line is penalized, so it doesn't use more lines to even them out.
+		/// </summary>
+		Optimal = 1
+	}
+}
@@ -0,0 +1,482 @@
+//Headless benchmark of simple-font-lib, results are written as JSON
+//
+//Built twice from this file: sfl-benchmark compiles the library in with counting allocators so allocations per call
+//can be reported, sfl-benchmark-shared (SFL_BENCHMARK_SHARED) links the shared library and is used to train PGO builds
+//
+//Usage: sfl-benchmark [--font kind:index:path]... [--sizes 12,16,32,64] [--min-time seconds] [--quick] [--rasterizer list|table|tiled]
+//                     [--edge-sort quicksort|buckets] [--flattening halving|analytic] [--output file]
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <time.h>
+#endif
+
+#ifdef SFL_BENCHMARK_SHARED
+#include "../simple-font-lib/platform.h"
+#include "../simple-font-lib/utf16.h"
+
+//Exports of the shared library
+int LoadFontUtf8(const char* filename, int index, char** actualName);
+void FreeAllResources();
+void MeasureBitmapN(int handle, utf16_t* text, int length, int fontSize, int* width, int* height, int* yOffset, int maxWidth, float lineSpacing);
+void GenerateBitmap(int handle, unsigned char* emptyBitmap, int width);
+void SetWrapMode(int mode);
+void SetRasterizer(int rasterizer);
+void SetEdgeSort(int sort);
+void SetFlattening(int flattening);
+
+#define BUILD_NAME "shared"
+#define COUNTS_ALLOCATIONS 0
+static long long GetAllocationCount() { return 0; }
+#else
+//Count every allocation the library makes, lib.c is compiled into this file after the macros are defined
+static volatile long allocationCount = 0;
+
+#ifdef _WIN32
+#include <intrin.h>
+#define COUNT_ALLOCATION() _InterlockedIncrement(&allocationCount)
+#else
+#define COUNT_ALLOCATION() __sync_fetch_and_add(&allocationCount, 1)
+#endif
+
+static void* CountedMalloc(size_t size) { COUNT_ALLOCATION(); return malloc(size); }
+static void* CountedCalloc(size_t count, size_t size) { COUNT_ALLOCATION(); return calloc(count, size); }
+static void* CountedRealloc(void* block, size_t size) { COUNT_ALLOCATION(); return realloc(block, size); }
+
+#define malloc(size) CountedMalloc(size)
+#define calloc(count, size) CountedCalloc(count, size)
+#define realloc(block, size) CountedRealloc(block, size)
+#include "../simple-font-lib/lib.c"
+#undef malloc
+#undef calloc
+#undef realloc
+
+#define BUILD_NAME "static"
+#define COUNTS_ALLOCATIONS 1
+static long long GetAllocationCount() { return allocationCount; }
+#endif
+
+#include "corpus.h"
+
+//------------------------------------ TIMING -------------------------------------
+static double GetSeconds()
+{
+#ifdef _WIN32
+	LARGE_INTEGER counter, frequency;
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+	return (double)counter.QuadPart / frequency.QuadPart;
+#else
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec * 1e-9;
+#endif
+}
+
+static int CompareDoubles(const void* a, const void* b)
+{
+	double x = *(const double*)a, y = *(const double*)b;
+	return (x > y) - (x < y);
+}
+
+//Nearest rank percentile of sorted values
+static double Percentile(const double* sorted, size_t count, double percentile)
+{
+	size_t rank = (size_t)(percentile / 100 * count + 0.999999);
+	if (rank < 1)
+		rank = 1;
+	if (rank > count)
+		rank = count;
+	return sorted[rank - 1];
+}
+
+//------------------------------------- FONTS -------------------------------------
+typedef struct
+{
+	const char* kind;
+	int index;
+	const char* path;
+} fontspec_t;
+
+//Tried in order when no fonts are given, fonts that aren't installed are skipped
+static const fontspec_t defaultFonts[] =
+{
+#if defined(_WIN32)
+	{ "ttf", 0, "C:\\Windows\\Fonts\\arial.ttf" },
+	{ "ttf", 0, "C:\\Windows\\Fonts\\segoeui.ttf" },
+	{ "ttf", 0, "C:\\Windows\\Fonts\\seguiemj.ttf" },
+	{ "ttc", 0, "C:\\Windows\\Fonts\\msyh.ttc" },
+	{ "ttc", 0, "C:\\Windows\\Fonts\\msgothic.ttc" },
+	{ "otf", 0, "C:\\Windows\\Fonts\\SourceSansPro-Regular.otf" },
+#elif defined(__APPLE__)
+	{ "ttf", 0, "/System/Library/Fonts/Supplemental/Arial.ttf" },
+	{ "ttc", 0, "/System/Library/Fonts/Helvetica.ttc" },
+	{ "ttc", 0, "/System/Library/Fonts/Hiragino Sans GB.ttc" },
+	{ "otf", 0, "/Library/Fonts/SourceSansPro-Regular.otf" },
+#else
+	{ "ttf", 0, "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf" },
+	{ "ttf", 0, "/usr/share/fonts/TTF/DejaVuSans.ttf" },
+	{ "ttf", 0, "/usr/share/fonts/dejavu/DejaVuSans.ttf" },
+	{ "ttc", 0, "/usr/share/fonts/opentype/noto/NotoSansCJK-Regular.ttc" },
+	{ "ttc", 0, "/usr/share/fonts/noto-cjk/NotoSansCJK-Regular.ttc" },
+	{ "otf", 0, "/usr/share/fonts/opentype/cantarell/Cantarell-Regular.otf" },
+	{ "otf", 0, "/usr/share/fonts/opentype/urw-base35/NimbusSans-Regular.otf" },
+#endif
+};
+
+//kind:index:path, the path may contain colons
+static int ParseFontSpec(char* argument, fontspec_t* spec)
+{
+	char* first = strchr(argument, ':');
+	char* second = first != NULL ? strchr(first + 1, ':') : NULL;
+	if (second == NULL)
+		return 0;
+
+	*first = 0;
+	spec->kind = argument;
+	spec->index = atoi(first + 1);
+	spec->path = second + 1;
+	return 1;
+}
+
+//------------------------------------ OUTPUT -------------------------------------
+static void WriteJsonString(FILE* output, const char* string)
+{
+	fputc('"', output);
+	for (const unsigned char* c = (const unsigned char*)string; *c; c++)
+	{
+		if (*c == '"' || *c == '\\')
+			fprintf(output, "\\%c", *c);
+		else if (*c < 0x20)
+			fprintf(output, "\\u%04x", *c);
+		else
+			fputc(*c, output);
+	}
+	fputc('"', output);
+}
+
+//----------------------------------- BENCHMARK -----------------------------------
+typedef struct
+{
+	utf16_t* text;
+	int length;
+	int glyphs;
+} sample_t;
+
+typedef struct
+{
+	size_t calls;
+	size_t chars;
+	size_t glyphs;
+	double layoutSeconds;
+	double renderSeconds;
+	long long allocations;
+	double p50;
+	double p99;
+} result_t;
+
+static sample_t* PrepareSamples(const corpus_t* corpus)
+{
+	sample_t* samples = calloc(corpus->numTexts, sizeof(sample_t));
+	for (int i = 0; i < corpus->numTexts; i++)
+	{
+		size_t length = strlen(corpus->texts[i]);
+		char* repeated = malloc(length * corpus->repeat + 1);
+		for (int r = 0; r < corpus->repeat; r++)
+			memcpy(repeated + length * r, corpus->texts[i], length);
+		repeated[length * corpus->repeat] = 0;
+
+		samples[i].text = Utf8ToUtf16(repeated);
+		samples[i].length = (int)Utf16Length(samples[i].text);
+		free(repeated);
+
+		//Glyphs drawn, whitespace and the second half of surrogate pairs don't count
+		for (int j = 0; j < samples[i].length; j++)
+		{
+			utf16_t c = samples[i].text[j];
+			if (c != ' ' && c != '\n' && c != '\r' && c != '\t' && !(c >= 0xDC00 && c <= 0xDFFF))
+				samples[i].glyphs++;
+		}
+	}
+	return samples;
+}
+
+static void RunCase(int handle, const corpus_t* corpus, const sample_t* samples, int fontSize, double minTime, result_t* result)
+{
+	unsigned char* bitmap = NULL;
+	size_t bitmapSize = 0;
+	double* latencies = NULL;
+	size_t allocLatencies = 0;
+	memset(result, 0, sizeof(result_t));
+	SetWrapMode(corpus->wrapMode);
+
+	//One untimed pass so the first calls don't pay for page faults and cold caches
+	for (int pass = 0; pass < 2; pass++)
+	{
+		int warmup = pass == 0;
+		double start = GetSeconds();
+		for (size_t call = 0; warmup ? call < (size_t)corpus->numTexts : (call < (size_t)corpus->numTexts || GetSeconds() - start < minTime); call++)
+		{
+			const sample_t* sample = samples + call % corpus->numTexts;
+			int width, height, yOffset;
+
+			long long allocations = GetAllocationCount();
+			double t0 = GetSeconds();
+			MeasureBitmapN(handle, sample->text, sample->length, fontSize, &width, &height, &yOffset, corpus->maxWidth, 1.0f);
+			double t1 = GetSeconds();
+			allocations = GetAllocationCount() - allocations;
+
+			//The bitmap has to be empty, clearing it is the caller's cost and not timed
+			size_t size = (size_t)width * height;
+			if (size > bitmapSize)
+				bitmap = realloc(bitmap, bitmapSize = size);
+			memset(bitmap, 0, size);
+
+			long long renderAllocations = GetAllocationCount();
+			double t2 = GetSeconds();
+			GenerateBitmap(handle, bitmap, width);
+			double t3 = GetSeconds();
+			allocations += GetAllocationCount() - renderAllocations;
+
+			if (warmup)
+				continue;
+
+			if (result->calls == allocLatencies)
+			{
+				allocLatencies = allocLatencies == 0 ? 1024 : allocLatencies * 2;
+				latencies = realloc(latencies, sizeof(double) * allocLatencies);
+			}
+			latencies[result->calls++] = (t1 - t0) + (t3 - t2);
+			result->chars += sample->length;
+			result->glyphs += sample->glyphs;
+			result->layoutSeconds += t1 - t0;
+			result->renderSeconds += t3 - t2;
+			result->allocations += allocations;
+		}
+	}
+
+	SetWrapMode(0);
+	qsort(latencies, result->calls, sizeof(double), CompareDoubles);
+	result->p50 = Percentile(latencies, result->calls, 50);
+	result->p99 = Percentile(latencies, result->calls, 99);
+	free(latencies);
+	free(bitmap);
+}
+
+//Loading a font from disk, the cache is emptied with FreeAllResources between loads
+static double BenchmarkLoad(const fontspec_t* font, double minTime, size_t* calls, double* p50, double* p99)
+{
+	double* latencies = NULL;
+	size_t count = 0, allocated = 0;
+	double total = 0, start = GetSeconds();
+	do
+	{
+		char* name = NULL;
+		double t0 = GetSeconds();
+		LoadFontUtf8(font->path, font->index, &name);
+		double t1 = GetSeconds();
+		FreeAllResources();
+
+		if (count == allocated)
+		{
+			allocated = allocated == 0 ? 256 : allocated * 2;
+			latencies = realloc(latencies, sizeof(double) * allocated);
+		}
+		latencies[count++] = t1 - t0;
+		total += t1 - t0;
+	} while (count < 8 || GetSeconds() - start < minTime);
+
+	qsort(latencies, count, sizeof(double), CompareDoubles);
+	*calls = count;
+	*p50 = Percentile(latencies, count, 50);
+	*p99 = Percentile(latencies, count, 99);
+	free(latencies);
+	return total / count;
+}
+
+static const char* const rasterizers[] = { "list", "table", "tiled" };
+static const char* const edgeSorts[] = { "quicksort", "buckets" };
+static const char* const flattenings[] = { "halving", "analytic" };
+
+//Index of the name as SetRasterizer, SetEdgeSort or SetFlattening takes it, -1 if there is none
+static int FindName(const char* const* names, int count, const char* name)
+{
+	for (int i = 0; i < count; i++)
+	{
+		if (strcmp(name, names[i]) == 0)
+			return i;
+	}
+	return -1;
+}
+
+#define FIND_NAME(names, name) FindName(names, (int)(sizeof(names) / sizeof(names[0])), name)
+
+int main(int argc, char** argv)
+{
+	fontspec_t fonts[32];
+	int numFonts = 0;
+	int sizes[16] = { 12, 16, 32, 64 };
+	int numSizes = 4;
+	double minTime = 0.25;
+	const char* outputPath = NULL;
+	const char* rasterizer = "list";
+	const char* edgeSort = "buckets";
+	const char* flattening = "halving";
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--font") == 0 && i + 1 < argc && numFonts < 32)
+		{
+			if (!ParseFontSpec(argv[++i], &fonts[numFonts++]))
+			{
+				fprintf(stderr, "Font must be given as kind:index:path, for example ttf:0:arial.ttf\n");
+				return 1;
+			}
+		}
+		else if (strcmp(argv[i], "--sizes") == 0 && i + 1 < argc)
+		{
+			numSizes = 0;
+			for (char* size = strtok(argv[++i], ","); size != NULL && numSizes < 16; size = strtok(NULL, ","))
+				sizes[numSizes++] = atoi(size);
+		}
+		else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc)
+		{
+			minTime = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--quick") == 0)
+		{
+			minTime = 0.02;
+		}
+		else if (strcmp(argv[i], "--rasterizer") == 0 && i + 1 < argc && FIND_NAME(rasterizers, argv[i + 1]) >= 0)
+		{
+			rasterizer = argv[++i];
+		}
+		else if (strcmp(argv[i], "--edge-sort") == 0 && i + 1 < argc && FIND_NAME(edgeSorts, argv[i + 1]) >= 0)
+		{
+			edgeSort = argv[++i];
+		}
+		else if (strcmp(argv[i], "--flattening") == 0 && i + 1 < argc && FIND_NAME(flattenings, argv[i + 1]) >= 0)
+		{
+			flattening = argv[++i];
+		}
+		else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+		{
+			outputPath = argv[++i];
+		}
+		else
+		{
+			fprintf(stderr, "Usage: %s [--font kind:index:path]... [--sizes 12,16,32,64] [--min-time seconds] [--quick] [--rasterizer list|table|tiled] "
+				"[--edge-sort quicksort|buckets] [--flattening halving|analytic] [--output file]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	if (numFonts == 0)
+	{
+		for (int i = 0; i < (int)(sizeof(defaultFonts) / sizeof(defaultFonts[0])); i++)
+			fonts[numFonts++] = defaultFonts[i];
+	}
+
+	FILE* output = outputPath != NULL ? fopen(outputPath, "w") : stdout;
+	if (output == NULL)
+	{
+		fprintf(stderr, "Can't write %s\n", outputPath);
+		return 1;
+	}
+
+	SetRasterizer(FIND_NAME(rasterizers, rasterizer));
+	SetEdgeSort(FIND_NAME(edgeSorts, edgeSort));
+	SetFlattening(FIND_NAME(flattenings, flattening));
+	fprintf(output, "{\n\t\"schema\": 1,\n\t\"build\": \"%s\",\n\t\"min_time\": %g,\n\t\"rasterizer\": \"%s\",\n\t\"edge_sort\": \"%s\",\n\t"
+		"\"flattening\": \"%s\",\n\t\"load\": [", BUILD_NAME, minTime, rasterizer, edgeSort, flattening);
+	int firstLoad = 1;
+	int loadable[32];
+	for (int f = 0; f < numFonts; f++)
+	{
+		char* name = NULL;
+		loadable[f] = LoadFontUtf8(fonts[f].path, fonts[f].index, &name) >= 0;
+		FreeAllResources();
+		if (!loadable[f])
+		{
+			fprintf(stderr, "Skipping %s, it can't be loaded\n", fonts[f].path);
+			continue;
+		}
+
+		size_t calls;
+		double p50, p99;
+		double mean = BenchmarkLoad(&fonts[f], minTime, &calls, &p50, &p99);
+		fprintf(output, "%s\n\t\t{ \"font\": ", firstLoad ? "" : ",");
+		WriteJsonString(output, fonts[f].path);
+		fprintf(output, ", \"kind\": ");
+		WriteJsonString(output, fonts[f].kind);
+		fprintf(output, ", \"index\": %d, \"calls\": %zu, \"mean_us\": %.3f, \"p50_us\": %.3f, \"p99_us\": %.3f }",
+			fonts[f].index, calls, mean * 1e6, p50 * 1e6, p99 * 1e6);
+		firstLoad = 0;
+	}
+	fprintf(output, "\n\t],\n\t\"results\": [");
+
+	sample_t* samples[NUM_CORPORA];
+	for (int c = 0; c < NUM_CORPORA; c++)
+		samples[c] = PrepareSamples(&corpora[c]);
+
+	fprintf(stderr, "%-40s %-16s %5s %12s %14s %10s %10s %10s\n", "font", "corpus", "size", "layout ns/ch", "glyphs/s", "allocs", "p50 us", "p99 us");
+	int firstResult = 1;
+	for (int f = 0; f < numFonts; f++)
+	{
+		if (!loadable[f])
+			continue;
+
+		char* name = NULL;
+		int handle = LoadFontUtf8(fonts[f].path, fonts[f].index, &name);
+		for (int c = 0; c < NUM_CORPORA; c++)
+		{
+			for (int s = 0; s < numSizes; s++)
+			{
+				result_t result;
+				RunCase(handle, &corpora[c], samples[c], sizes[s], minTime, &result);
+
+				double layoutNsPerChar = result.layoutSeconds * 1e9 / result.chars;
+				double glyphsPerSecond = result.renderSeconds > 0 ? result.glyphs / result.renderSeconds : 0;
+				double allocsPerCall = (double)result.allocations / result.calls;
+
+				fprintf(output, "%s\n\t\t{ \"font\": ", firstResult ? "" : ",");
+				WriteJsonString(output, fonts[f].path);
+				fprintf(output, ", \"kind\": ");
+				WriteJsonString(output, fonts[f].kind);
+				fprintf(output, ", \"corpus\": \"%s\", \"size\": %d, \"chars\": %zu, \"glyphs\": %zu, \"calls\": %zu, "
+					"\"layout_ns_per_char\": %.3f, \"glyphs_per_second\": %.1f, ", corpora[c].name, sizes[s], result.chars, result.glyphs, result.calls,
+					layoutNsPerChar, glyphsPerSecond);
+				if (COUNTS_ALLOCATIONS)
+					fprintf(output, "\"allocs_per_call\": %.3f, ", allocsPerCall);
+				else
+					fprintf(output, "\"allocs_per_call\": null, ");
+				fprintf(output, "\"p50_us\": %.3f, \"p99_us\": %.3f }", result.p50 * 1e6, result.p99 * 1e6);
+				firstResult = 0;
+
+				const char* shortName = strrchr(fonts[f].path, '/') != NULL ? strrchr(fonts[f].path, '/') + 1 : fonts[f].path;
+				char allocs[32] = "-";
+				if (COUNTS_ALLOCATIONS)
+					snprintf(allocs, sizeof(allocs), "%.2f", allocsPerCall);
+				fprintf(stderr, "%-40.40s %-16s %5d %12.1f %14.0f %10s %10.2f %10.2f\n", shortName, corpora[c].name, sizes[s],
+					layoutNsPerChar, glyphsPerSecond, allocs, result.p50 * 1e6, result.p99 * 1e6);
+			}
+		}
+		FreeAllResources();
+	}
+	fprintf(output, "\n\t]\n}\n");
+
+	if (output != stdout)
+		fclose(output);
+	for (int c = 0; c < NUM_CORPORA; c++)
+	{
+		for (int i = 0; i < corpora[c].numTexts; i++)
+			free(samples[c][i].text);
+		free(samples[c]);
+	}
+	return 0;
+}
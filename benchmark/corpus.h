@@ -0,0 +1,100 @@
+#ifndef CORPUS_H
+#define CORPUS_H
+
+//Fixed benchmark texts in UTF-8. Changing them makes results incomparable with earlier runs, add new corpora instead
+
+typedef struct
+{
+	const char* name;
+	//Texts rendered one per call, in turn
+	const char* const* texts;
+	int numTexts;
+	//Number of times each text is repeated to make one call, for long documents
+	int repeat;
+	int maxWidth;
+	//Passed to SetWrapMode, 0 is greedy and 1 optimal
+	int wrapMode;
+} corpus_t;
+
+static const char* const asciiLabels[] =
+{
+	"OK",
+	"Cancel",
+	"Settings",
+	"New Game",
+	"Load Game",
+	"Options",
+	"Quit to Desktop",
+	"Player 1: 12500 pts",
+	"HP 87/100",
+	"Level 14 - The Frozen Caverns",
+	"Press [Space] to continue",
+	"Volume: 75%",
+	"Resolution 1920x1080",
+	"FPS: 144",
+	"Inventory (23/40)",
+	"Gold: 1,337",
+};
+
+static const char* const latinParagraphs[] =
+{
+	"The quick brown fox jumps over the lazy dog while the five boxing wizards jump quickly. "
+	"Voix ambiguë d'un cœur qui, au zéphyr, préfère les jattes de kiwis. "
+	"Falsches Üben von Xylophonmusik quält jeden größeren Zwerg. "
+	"El pingüino Wenceslao hizo kilómetros bajo exhaustiva lluvia y frío, añoraba a su querido cachorro. "
+	"Pchnąć w tę łódź jeża lub ośm skrzyń fig. Příliš žluťoučký kůň úpěl ďábelské ódy. "
+	"Sphinx of black quartz, judge my vow; how vexingly quick daft zebras jump! "
+	"Jackdaws love my big sphinx of quartz, and pack my box with five dozen liquor jugs.\n",
+};
+
+//One paragraph, repeated to about 10000 characters without a line break to compare the wrap modes
+static const char* const longParagraph[] =
+{
+	"The quick brown fox jumps over the lazy dog while the five boxing wizards jump quickly. "
+	"Voix ambiguÃ« d'un cÅur qui, au zÃ©phyr, prÃ©" "fÃ¨re les jattes de kiwis. "
+	"Sphinx of black quartz, judge my vow; how vexingly quick daft zebras jump! "
+	"Jackdaws love my big sphinx of quartz, and pack my box with five dozen liquor jugs. "
+	"Falsches Ã" "ben von Xylophonmusik quÃ¤lt jeden grÃ¶Ã" "eren Zwerg. ",
+};
+
+static const char* const cjkParagraphs[] =
+{
+	"吾輩は猫である。名前はまだ無い。どこで生れたかとんと見当がつかぬ。何でも薄暗いじめじめした所でニャーニャー泣いていた事だけは記憶している。"
+	"吾輩はここで始めて人間というものを見た。しかもあとで聞くとそれは書生という人間中で一番獰悪な種族であったそうだ。\n"
+	"天地玄黄，宇宙洪荒。日月盈昃，辰宿列張。寒來暑往，秋收冬藏。閏餘成歲，律呂調陽。雲騰致雨，露結為霜。金生麗水，玉出崑岡。\n"
+	"키스의 고유조건은 입술끼리 만나야 하고 특별한 기술은 필요치 않다. 다람쥐 헌 쳇바퀴에 타고파.\n",
+};
+
+static const char* const emojiTexts[] =
+{
+	"Great job! 🎉🎉 You reached level 10 🏆 Keep going 💪🔥",
+	"😀😃😄😁😆😅🤣😂🙂🙃😉😊😇🥰😍🤩😘😗😚😙",
+	"Weather: ☀️ 24°C → 🌧️ tomorrow, ❄️ on Sunday ⛄",
+	"👍👍🏻👍🏽👍🏿 👨‍👩‍👧‍👦 🏳️‍🌈 🇫🇮🇯🇵🇧🇷",
+	"Chat: ok 👌 see you at 8 🕗 bring 🍕 and 🍺!",
+};
+
+static const char* const mixedTexts[] =
+{
+	"English, Ελληνικά, Русский, 中文, 日本語, 한국어 and العربية on one line.",
+	"Price: 12,99 € / £10.50 / ¥1,480 — “quoted” ‘text’ … ½ ¼ ™ © ®",
+	"Москва — столица России. Αθήνα είναι η πρωτεύουσα της Ελλάδας. 東京は日本の首都です。",
+	"Mixed ✓ symbols ✗ arrows ← ↑ → ↓ math ∑ ∫ √ ∞ ≈ ≠ ≤ ≥ and 🙂 emoji",
+};
+
+#define CORPUS_ENTRY(name, texts, repeat, maxWidth, wrapMode) { name, texts, (int)(sizeof(texts) / sizeof(texts[0])), repeat, maxWidth, wrapMode }
+
+static const corpus_t corpora[] =
+{
+	CORPUS_ENTRY("ascii-labels", asciiLabels, 1, 0, 0),
+	CORPUS_ENTRY("latin-paragraphs", latinParagraphs, 4, 800, 0),
+	CORPUS_ENTRY("cjk", cjkParagraphs, 2, 800, 0),
+	CORPUS_ENTRY("emoji", emojiTexts, 1, 800, 0),
+	CORPUS_ENTRY("mixed", mixedTexts, 1, 800, 0),
+	CORPUS_ENTRY("wrap-10k-greedy", longParagraph, 27, 800, 0),
+	CORPUS_ENTRY("wrap-10k-optimal", longParagraph, 27, 800, 1),
+};
+
+#define NUM_CORPORA (int)(sizeof(corpora) / sizeof(corpora[0]))
+
+#endif
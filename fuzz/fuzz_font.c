@@ -0,0 +1,167 @@
+//libFuzzer target for font loading, measuring and rendering. The input is written to a temporary file and loaded
+//through LoadFontUtf8 like any font, then measured and rendered in every mode
+//
+//Built with SFL_FUZZ_STANDALONE it gets a main that replays the files given on the command line instead, for
+//reproducing crashes and for compilers without libFuzzer
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+//Compiled in so the sanitizers see the whole library
+#include "../simple-font-lib/lib.c"
+
+//Bitmaps larger than this are measured but not rendered, the caller allocates them
+#define MAX_FUZZ_PIXELS (1 << 22)
+
+static const char* const fuzzTexts[] =
+{
+	"AVAWATToLTYaWaVaFa,.",
+	"The quick brown fox\njumps over the lazy dog",
+	"\xc3\x84\xc3\xb6\xc3\xbc \xce\xb1\xce\xb2\xce\xb3 \xd0\xb6\xd1\x8f \xe4\xb8\xad\xe6\x96\x87 \xf0\x9f\x99\x82 \xef\xbf\xbf",
+	"office ffl a\xcc\x81\xcc\xa3o\xcc\x82\xcc\x83 e\xcc\x88\xe2\x83\x9d",
+	"\xd8\xb3\xd9\x84\xd8\xa7\xd9\x85 \xd8\xb9\xd9\x84\xd9\x8a\xd9\x83\xd9\x85 123 (\xd8\xa8\xd9\x90\xd8\xb3\xd9\x92\xd9\x85\xd9\x90) \xd9\x80\xd9\x84\xd8\xa7\xe2\x80\x8d",
+	"\xd7\xa9\xd7\x81\xd6\xb8\xd7\x9c\xd7\x95\xd6\xb9\xd7\x9d abc \xe0\xa4\xb0\xe0\xa5\x8d\xe0\xa4\x95\xe0\xa4\xbf \xe0\xa4\x95\xe0\xa5\x8d\xe0\xa4\xb7 \xe0\xa4\xa8\xe0\xa4\xae\xe0\xa4\xb8\xe0\xa5\x8d\xe0\xa4\xa4\xe0\xa5\x87 \xe0\xa4\x95\xe0\xa5\x8d\xe2\x80\x8d",
+	"\xf0\x9f\x98\x80\xf0\x9f\x91\x8d\xed\xa0\x80x\xed\xb0\x80 A\xf0\x90\x90\x80V\xed\xa0\x80",
+	"a\rb\r\nc\vd\xe2\x80\xa8" "e \xe2\x80\x8b" " f-g\xc2\xa0h \xf0\x9f\x87\xab\xf0\x9f\x87\xae\xf0\x9f\x87\xaa \xcc\x81\xe2\x80\x8d\xe3\x80\x82\xe3\x80\x8c" "\xe4\xb8\xad\xe3\x80\x8d",
+};
+
+static char fontPath[256];
+
+static void RenderText(int handle, const char* text, int fontSize, int maxWidth)
+{
+	utf16_t* utf16 = Utf8ToUtf16(text);
+	int width, height, yOffset;
+	FontCoversText(handle, utf16, (int)Utf16Length(utf16));
+
+	//Coverage into a cleared bitmap
+	MeasureBitmap(handle, utf16, fontSize, &width, &height, &yOffset, maxWidth, 1.0f);
+	if (width > 0 && height > 0 && (long long)width * height <= MAX_FUZZ_PIXELS)
+	{
+		unsigned char* bitmap = calloc((size_t)width * height, 1);
+		GenerateBitmap(handle, bitmap, width);
+		free(bitmap);
+
+		//Expanded into RGBA, rasterized with the edge table from edges sorted by quicksort
+		unsigned char* rgba = malloc((size_t)width * height * 4);
+		SetRasterizer(RASTERIZER_EDGE_TABLE);
+		SetEdgeSort(EDGE_SORT_QUICKSORT);
+		MeasureBitmap(handle, utf16, fontSize, &width, &height, &yOffset, maxWidth, 1.0f);
+		GenerateBitmapFormat(handle, rgba, width * 4, FORMAT_RGBA8, 0xffffffff);
+		SetRasterizer(RASTERIZER_LIST);
+		SetEdgeSort(EDGE_SORT_BUCKETS);
+		free(rgba);
+
+		//Clipped into a shared buffer, rasterized in tiles from curves flattened analytically
+		unsigned char into[64 * 64] = { 0 };
+		SetRasterizer(RASTERIZER_TILED);
+		SetFlattening(FLATTEN_ANALYTIC);
+		MeasureBitmap(handle, utf16, fontSize, &width, &height, &yOffset, maxWidth, 1.0f);
+		GenerateBitmapInto(handle, into, 64, 0, 0, 64, 64, -width / 4, -height / 4, BLEND_MAX);
+		SetRasterizer(RASTERIZER_LIST);
+		SetFlattening(FLATTEN_HALVING);
+
+		//On a render worker, with a distance field queued after it and cancelled whether it has started or not
+		int job = QueueRender(handle, utf16, (int)Utf16Length(utf16), fontSize, maxWidth, 1.0f, 0);
+		CancelRender(QueueRender(handle, utf16, (int)Utf16Length(utf16), fontSize, maxWidth, 1.0f, 4));
+		bitmap = malloc((size_t)width * height);
+		if (WaitRender(job) == RENDER_JOB_DONE && GetRenderStatus(job, &width, &height, &yOffset) == RENDER_JOB_DONE)
+			TakeRender(job, bitmap);
+		free(bitmap);
+
+		//Scheduled twice for one target, the second replaces or cancels the first
+		ScheduleRender(0, handle, utf16, (int)Utf16Length(utf16), fontSize, 0, 1.0f, 0);
+		job = ScheduleRender(0, handle, utf16, (int)Utf16Length(utf16), fontSize, maxWidth, 1.0f, 0);
+		WaitRender(job);
+		FreeRenderTarget(0);
+	}
+
+	//Distance field, wrapped optimally and with the font as its own fallback
+	SetRenderMode(RENDER_SDF, 4);
+	SetWrapMode(WRAP_OPTIMAL);
+	SetFallbackFonts(handle, &handle, 1);
+	MeasureBitmap(handle, utf16, fontSize, &width, &height, &yOffset, maxWidth, 1.5f);
+	if (width > 0 && height > 0 && (long long)width * height <= MAX_FUZZ_PIXELS)
+	{
+		unsigned char* bitmap = calloc((size_t)width * height, 1);
+		GenerateBitmap(handle, bitmap, width);
+		free(bitmap);
+	}
+	SetRenderMode(RENDER_COVERAGE, 0);
+	SetWrapMode(WRAP_GREEDY);
+	SetFallbackFonts(handle, NULL, 0);
+
+	free(utf16);
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	if (fontPath[0] == 0)
+	{
+		const char* directory = getenv("TMPDIR");
+		snprintf(fontPath, sizeof(fontPath), "%s/sfl-fuzz-%d.ttf", directory != NULL ? directory : ".", (int)getpid());
+	}
+
+	FILE* file = fopen(fontPath, "wb");
+	if (file == NULL)
+		return 0;
+	fwrite(data, 1, size, file);
+	fclose(file);
+
+	//Collections also try their second font
+	int numIndices = size >= 4 && memcmp(data, "ttcf", 4) == 0 ? 2 : 1;
+	for (int index = 0; index < numIndices; index++)
+	{
+		char* name = NULL;
+		int handle = LoadFontUtf8(fontPath, index, &name);
+		if (handle < 0)
+			continue;
+
+		int ranges[2 * 16];
+		GetCoverageRanges(handle, ranges, 16);
+
+		for (size_t i = 0; i < sizeof(fuzzTexts) / sizeof(fuzzTexts[0]); i++)
+		{
+			RenderText(handle, fuzzTexts[i], 13, 0);
+			RenderText(handle, fuzzTexts[i], 40, 120);
+		}
+	}
+
+	FreeAllResources();
+	remove(fontPath);
+	return 0;
+}
+
+#ifdef SFL_FUZZ_STANDALONE
+int main(int argc, char** argv)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		FILE* file = fopen(argv[i], "rb");
+		if (file == NULL)
+		{
+			fprintf(stderr, "Can't open %s\n", argv[i]);
+			return 1;
+		}
+		fseek(file, 0, SEEK_END);
+		long size = ftell(file);
+		fseek(file, 0, SEEK_SET);
+		uint8_t* data = malloc(size > 0 ? size : 1);
+		size_t read = fread(data, 1, size > 0 ? size : 0, file);
+		fclose(file);
+
+		LLVMFuzzerTestOneInput(data, read);
+		free(data);
+	}
+	printf("Ran %d inputs\n", argc - 1);
+	return 0;
+}
+#endif
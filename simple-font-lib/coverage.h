@@ -0,0 +1,145 @@
+#ifndef COVERAGE_H
+#define COVERAGE_H
+
+#include <stdlib.h>
+
+//Characters a font has glyphs for, as sorted ranges that neither overlap nor touch. The cmap subtable is walked once
+//when the font is loaded and coverage queries never look at it again. Fonts are validated before this, so the subtable
+//is in bounds and its segments and groups are sorted
+
+typedef struct
+{
+	int first;
+	int last;
+} coveragerange_t;
+
+typedef struct
+{
+	coveragerange_t* ranges;
+	int count;
+} coverage_t;
+
+//Characters come in increasing order, so a range either extends the last one or follows it
+void AddCoverage(coverage_t* coverage, int* capacity, int first, int last)
+{
+	if (coverage->count > 0 && first <= coverage->ranges[coverage->count - 1].last + 1)
+	{
+		coverage->ranges[coverage->count - 1].last = last;
+		return;
+	}
+	if (coverage->count == *capacity)
+	{
+		*capacity = *capacity > 0 ? *capacity * 2 : 64;
+		coverage->ranges = realloc(coverage->ranges, sizeof(coveragerange_t) * *capacity);
+	}
+	coverage->ranges[coverage->count].first = first;
+	coverage->ranges[coverage->count].last = last;
+	coverage->count++;
+}
+
+//Walks the cmap subtable stb_truetype looks glyphs up in, characters mapped to glyph 0 aren't covered
+void BuildCoverage(const stbtt_fontinfo* info, coverage_t* coverage)
+{
+	stbtt_uint8* map = info->data + info->index_map;
+	int capacity = 0;
+	coverage->ranges = NULL;
+	coverage->count = 0;
+
+	switch (ttUSHORT(map))
+	{
+		case 0:
+		{
+			int count = ttUSHORT(map + 2) - 6;
+			for (int c = 0; c < count; c++)
+			{
+				if (map[6 + c] != 0)
+					AddCoverage(coverage, &capacity, c, c);
+			}
+			break;
+		}
+
+		case 6:
+		{
+			int first = ttUSHORT(map + 6), count = ttUSHORT(map + 8);
+			for (int c = 0; c < count; c++)
+			{
+				if (ttUSHORT(map + 10 + 2 * c) != 0)
+					AddCoverage(coverage, &capacity, first + c, first + c);
+			}
+			break;
+		}
+
+		case 4:
+		{
+			int segments = ttUSHORT(map + 6) / 2;
+			stbtt_uint8* endCount = map + 14;
+			stbtt_uint8* startCount = endCount + 2 * segments + 2;
+			stbtt_uint8* idDelta = startCount + 2 * segments;
+			stbtt_uint8* idRangeOffset = idDelta + 2 * segments;
+			for (int i = 0; i < segments; i++)
+			{
+				int first = ttUSHORT(startCount + 2 * i), last = ttUSHORT(endCount + 2 * i);
+				int delta = ttSHORT(idDelta + 2 * i), offset = ttUSHORT(idRangeOffset + 2 * i);
+				stbtt_uint8* glyphs = idRangeOffset + 2 * i + offset;
+				for (int c = first; c <= last; c++)
+				{
+					int glyph = offset == 0 ? (c + delta) & 0xFFFF : ttUSHORT(glyphs + 2 * (c - first));
+					if (glyph != 0)
+						AddCoverage(coverage, &capacity, c, c);
+				}
+			}
+			break;
+		}
+
+		case 12:
+		case 13:
+		{
+			//Only the first character of a group can map to glyph 0 in format 12, all of them in format 13
+			int groups = (int)ttULONG(map + 12);
+			for (int i = 0; i < groups; i++)
+			{
+				stbtt_uint8* group = map + 16 + 12 * i;
+				int first = (int)ttULONG(group), last = (int)ttULONG(group + 4);
+				if (ttULONG(group + 8) == 0)
+				{
+					if (ttUSHORT(map) == 13)
+						continue;
+					first++;
+				}
+				if (first <= last)
+					AddCoverage(coverage, &capacity, first, last);
+			}
+			break;
+		}
+	}
+}
+
+//Index of the first range that ends at or after the character, count if there is none
+int FindCoverageRange(const coverage_t* coverage, int codepoint)
+{
+	int low = 0, high = coverage->count;
+	while (low < high)
+	{
+		int middle = (low + high) / 2;
+		if (coverage->ranges[middle].last < codepoint)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+	return low;
+}
+
+int CoversCodepoint(const coverage_t* coverage, int codepoint)
+{
+	int range = FindCoverageRange(coverage, codepoint);
+	return range < coverage->count && coverage->ranges[range].first <= codepoint;
+}
+
+void FreeCoverage(coverage_t* coverage)
+{
+	free(coverage->ranges);
+	coverage->ranges = NULL;
+	coverage->count = 0;
+}
+
+#endif
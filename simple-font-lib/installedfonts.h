@@ -1,15 +1,16 @@
 #ifndef INSTALLEDFONTS_H
 #define INSTALLEDFONTS_H
 
+#include "platform.h"
 #include "levenshtein.h"
 #include "wcsutil.h"
 
 #include <stdlib.h>
 
 typedef struct {
-	wchar_t* name;
+	utf16_t* name;
 	int fontIndex;
-	wchar_t* filename;
+	utf16_t* filename;
 } installedfont_t;
 
 installedfont_t* instFonts = NULL;
@@ -107,15 +108,17 @@ int LoadInstalledFonts()
 
 #else
 
+#define ERROR_SUCCESS 0
+
 //No implementation for non-Windows operating systems
-void LoadInstalledFonts()
+int LoadInstalledFonts()
 {
-
+	return -1;
 }
 
 #endif
 
-installedfont_t* GetFontByName(const wchar_t* name)
+installedfont_t* GetFontByName(const utf16_t* name)
 {
 	//Load installed fonts only once
 	if (instFonts == NULL)
@@ -144,15 +147,17 @@ installedfont_t* GetFontByName(const wchar_t* name)
 	return font;
 }
 
-__declspec(dllexport) void PrintInstalledFonts()
+EXPORT void PrintInstalledFonts()
 {
 	//Load installed fonts only once
 	if (instFonts == NULL)
 		if (LoadInstalledFonts() != ERROR_SUCCESS)
 			return;
 
+#ifdef _WIN32
 	for (size_t i = 0; i < numInstFonts; i++)
 		wprintf(L"%s (%s)\n", instFonts[i].name, instFonts[i].filename);
+#endif
 }
 
 /*__declspec(dllexport) wchar_t** GetNClosestMatches(const wchar_t* name, size_t n)
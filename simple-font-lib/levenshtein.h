@@ -4,7 +4,9 @@
 #include <stdlib.h>
 #include <string.h>
 
-size_t levenshtein_n(const wchar_t* a, const size_t length, const wchar_t* b, const size_t bLength)
+#include "platform.h"
+
+size_t levenshtein_n(const utf16_t* a, const size_t length, const utf16_t* b, const size_t bLength)
 {
 	size_t* cache = malloc(sizeof(size_t) * length);
 	size_t index = 0;
@@ -12,7 +14,7 @@ size_t levenshtein_n(const wchar_t* a, const size_t length, const wchar_t* b, co
 	size_t distance;
 	size_t bDistance;
 	size_t result;
-	wchar_t code;
+	utf16_t code;
 
 	//Shortcut optimizations / degenerate cases
 	if (a == b)
@@ -52,9 +54,9 @@ size_t levenshtein_n(const wchar_t* a, const size_t length, const wchar_t* b, co
 	return result;
 }
 
-size_t levenshtein(const wchar_t* a, const wchar_t* b)
+size_t levenshtein(const utf16_t* a, const utf16_t* b)
 {
-	return levenshtein_n(a, wcslen(a), b, wcslen(b));
+	return levenshtein_n(a, Utf16Length(a), b, Utf16Length(b));
 }
 
 #endif
\ No newline at end of file
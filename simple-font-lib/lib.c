@@ -2,31 +2,255 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "platform.h"
+#include "stats.h"
+
 #define STB_TRUETYPE_IMPLEMENTATION 
 #include "stb_truetype.h"
 
 #include "installedfonts.h"
+#include "sdf.h"
+#include "pixelformat.h"
+#include "utf16.h"
+#include "linebreak.h"
+#include "shaping.h"
+#include "coverage.h"
+#include "tiledraster.h"
+
+#ifdef SFL_STATS
+//Count the allocations of this file, defined after the includes so system headers are left alone
+#define malloc(size) StatsMalloc(size)
+#define calloc(count, size) StatsCalloc(count, size)
+#define realloc(block, size) StatsRealloc(block, size)
+#endif
 
 //---------------------------------- DATA TYPES -----------------------------------
 typedef struct
 {
 	stbtt_fontinfo info;
-	wchar_t* filename;
+	int dataSize;
+	utf16_t* filename;
 	int fontIndex;
 	int ascent;
 	int descent;
 	int lineGap;
+	shaper_t shaper;
+	coverage_t coverage;
+
+	//This font followed by the fonts tried in order for characters it doesn't have
+	shaper_t* chain[MAX_SHAPE_FONTS];
+	const coverage_t* chainCoverage[MAX_SHAPE_FONTS];
+	int chainLength;
+
+	//Index into chain of the font that draws each character. Pages of 256 characters are filled when one of their
+	//characters is first looked up from the coverage of the fonts
+	unsigned char** fallbackPages;
 } font_t;
 
 typedef struct
 {
-	int codepoint;
+	int glyph; //Glyph index, -1 for glyphs that aren't drawn
+	int font;  //Index into the fonts of the layout
 	int offsetX;
 	int offsetY;
 	int width;
 	int height;
 } glyph_t;
 
+typedef struct
+{
+	size_t glyphStart;
+	int y;
+} lineinfo_t;
+
+typedef struct
+{
+	int handle;
+	float scale;
+
+	//The font and its fallbacks, with their scales at the size
+	const stbtt_fontinfo* fontInfos[MAX_SHAPE_FONTS];
+	float fontScales[MAX_SHAPE_FONTS];
+
+	glyph_t* glyphs;
+	size_t numGlyphs;
+	int extraYOffset;
+	int width;
+	int height;
+	int sdfSpread;
+
+	//Line index built by the measure pass
+	lineinfo_t* lines;
+	size_t numLines;
+	size_t allocLines;
+
+	//Number of rows glyphs reach outside their own line
+	int overhang;
+
+	//Scratch space for glyphs that are blended or converted
+	unsigned char* scratch;
+	size_t scratchSize;
+} layout_t;
+
+typedef struct
+{
+	int start;
+	int length;
+	int width;
+} linerecord_t;
+
+typedef struct
+{
+	font_t* font;
+	float scale;
+	float lineYIncrement;
+	int maxWidth;
+
+	//Completed lines
+	linerecord_t* lines;
+	size_t numLines;
+	size_t allocLines;
+
+	//Text of the line that has not been completed yet from where it may still be broken, pendingStart is the stream
+	//offset of its first code unit. Line break flags are found for the text up to classified
+	utf16_t* pending;
+	unsigned char* pendingFlags;
+	size_t pendingLength;
+	size_t allocPending;
+	int pendingStart;
+	int classified;
+	linebreakstate_t lineBreak;
+
+	//The unfinished line starts at lineStart and is measured up to measured. breakAt is its last break opportunity and
+	//clusterStart the start of its last cluster, with the width of the line before them
+	int lineStart;
+	int measured;
+	int breakAt;
+	int widthAtBreak;
+	int clusterStart;
+	int widthAtCluster;
+	float x;
+	int lineMaxX;
+} textstream_t;
+
+//How glyphs are rasterized, with the values SetRasterizer, SetEdgeSort, SetFlattening and SetTiledRasterizerThreshold take
+typedef struct
+{
+	int rasterizer;
+	int edgeSort;
+	int flattening;
+	int tiledThreshold;
+} rasteroptions_t;
+
+//Text queued for a render worker, with its bitmap once it is done
+typedef struct
+{
+	int handle;
+	utf16_t* text;
+	size_t length;
+	int fontSize;
+	int maxWidth;
+	float lineSpacing;
+	int spread;
+	int wrapMode;
+	rasteroptions_t raster;
+
+	int state;
+	int cancelled;
+	unsigned long long order;
+
+	//Handle of the job. Handles aren't reused, so one kept after its job is gone never finds another job
+	int id;
+
+	//Scheduled for a target, -1 if it was queued. requested is when the target's oldest text in the job was scheduled
+	int target;
+	long long requested;
+	int waited;
+
+	int width;
+	int height;
+	int yOffset;
+	unsigned char* bitmap;
+} renderjob_t;
+
+//Something text is scheduled for, such as a text field, with the handle of its newest job or -1
+typedef struct
+{
+	int target;
+	int job;
+
+	//Nanoseconds its last render took
+	long long renderTime;
+} rendertarget_t;
+
+typedef struct
+{
+	float scale; //Of the font the glyph comes from
+	int advanceWidth;
+	int leftSideBearing;
+	int x0;
+	int y0;
+	int x1;
+	int y1;
+
+	//Advance in pixels including kerning, and the sum of the advances of the glyphs before it in the paragraph
+	int advance;
+	int pen;
+
+	//Right edge of the ink from the pen position after the glyph
+	int inkRight;
+
+	//LINEBREAK_* flags, only the first glyph of a cluster may start a line
+	unsigned char lineBreak;
+} glyphmetrics_t;
+
+typedef struct
+{
+	//Key, the text is kept to tell hash collisions apart
+	int handle;
+	int fontSize;
+	unsigned long long hash;
+	utf16_t* text;
+	size_t length;
+	size_t allocText;
+
+	//Glyphs and their metrics at the size
+	shapebuffer_t shaped;
+	glyphmetrics_t* metrics;
+	size_t allocMetrics;
+} shapedrun_t;
+
+//Pen position and advance of a glyph in its paragraph, lines with right to left text are reordered with them
+typedef struct
+{
+	int pen;
+	int advance;
+	int level;
+	size_t order;
+} glyphpen_t;
+
+//A place a line may start at in optimal wrapping, with the lowest demerits of the lines before it and where the last
+//of them started
+typedef struct
+{
+	size_t glyph;
+	size_t previous;
+	long long demerits;
+} wrapnode_t;
+
+//Larger files are rejected before they are read
+#define MAX_FONT_FILE_SIZE (256 << 20)
+
+//Pages of 256 characters up to U+10FFFF
+#define FALLBACK_PAGES (0x110000 >> 8)
+
+//Glyphs at least this many pixels tall are rasterized in tiles unless SetTiledRasterizerThreshold changes it
+#define DEFAULT_TILED_THRESHOLD 64
+
+//Shaped paragraphs up to MAX_CACHED_RUN_LENGTH code units are cached by font, size and text
+#define SHAPE_CACHE_SIZE 256
+#define MAX_CACHED_RUN_LENGTH 512
+
 enum
 {
 	FILE_NOT_FOUND = -1,
@@ -34,85 +258,387 @@ enum
 	WINDOWS_ONLY = -3
 };
 
-//------------------------------ LOADING AND FREEING ------------------------------
-font_t** fonts = NULL;
-size_t numFonts = 0;
-wchar_t* lastFontName = NULL;
+enum
+{
+	RENDER_COVERAGE = 0,
+	RENDER_SDF = 1
+};
 
-wchar_t* GetFontName(stbtt_fontinfo* info)
+enum
 {
-	int length;
-	unsigned char* fontNameStr = (unsigned char*)stbtt_GetFontNameString(info, &length, STBTT_PLATFORM_ID_MICROSOFT, STBTT_MS_EID_UNICODE_BMP, STBTT_MS_LANG_ENGLISH, 4);
+	WRAP_GREEDY = 0,
+	WRAP_OPTIMAL = 1
+};
+
+enum
+{
+	RASTERIZER_LIST = 0,
+	RASTERIZER_EDGE_TABLE = 1,
+	RASTERIZER_TILED = 2
+};
+
+enum
+{
+	EDGE_SORT_QUICKSORT = 0,
+	EDGE_SORT_BUCKETS = 1
+};
+
+enum
+{
+	FLATTEN_HALVING = 0,
+	FLATTEN_ANALYTIC = 1
+};
+
+enum
+{
+	RENDER_JOB_INVALID = -1,
+	RENDER_JOB_PENDING = 0,
+	RENDER_JOB_RUNNING = 1,
+	RENDER_JOB_DONE = 2
+};
+
+//------------------------------------ LOCKING ------------------------------------
+//Render workers lay text out on their own threads. Fonts, shaped runs and the scratch buffers of layout are used by them
+//and by the exports that load fonts or measure text only while holding libraryLock. Rendering a finished layout only
+//reads the font data, so it doesn't need the lock
+mutex_t libraryLock;
+
+//Guards the render jobs and the workers, it is never held while waiting for libraryLock
+mutex_t renderQueueLock;
+condition_t renderJobQueued;
+condition_t renderJobFinished;
+
+once_t locksOnce = ONCE_INIT;
+
+void InitLocks()
+{
+	InitMutex(&libraryLock);
+	InitMutex(&renderQueueLock);
+	InitCondition(&renderJobQueued);
+	InitCondition(&renderJobFinished);
+}
+
+void LockLibrary()
+{
+	RunOnce(&locksOnce, InitLocks);
+	LockMutex(&libraryLock);
+}
+
+void UnlockLibrary()
+{
+	UnlockMutex(&libraryLock);
+}
+
+void LockRenderQueue()
+{
+	RunOnce(&locksOnce, InitLocks);
+	LockMutex(&renderQueueLock);
+}
+
+void UnlockRenderQueue()
+{
+	UnlockMutex(&renderQueueLock);
+}
+
+//------------------------------------ SHAPING ------------------------------------
+shapedrun_t shapeCache[SHAPE_CACHE_SIZE];
+shapedrun_t uncachedRun;
+glyphpen_t* glyphPens = NULL;
+size_t allocGlyphPens = 0;
+
+//UTF-8 text is decoded into this before it is laid out
+utf16_t* decodedText = NULL;
+size_t allocDecodedText = 0;
+
+//Break opportunities of the code units of the paragraph being shaped
+unsigned char* lineBreakFlags = NULL;
+size_t allocLineBreakFlags = 0;
+
+//Font of every code unit of the paragraph being shaped, when it has fallbacks
+unsigned char* unitFonts = NULL;
+size_t allocUnitFonts = 0;
+
+//Optimal wrapping of the paragraph being laid out
+wrapnode_t* wrapNodes = NULL;
+size_t* wrapBreaks = NULL;
+size_t allocWrapNodes = 0;
+
+//FNV-1a over the key
+unsigned long long HashShapeKey(int handle, int fontSize, const utf16_t* text, size_t length)
+{
+	unsigned long long hash = 14695981039346656037ULL;
+	hash = (hash ^ (unsigned int)handle) * 1099511628211ULL;
+	hash = (hash ^ (unsigned int)fontSize) * 1099511628211ULL;
+	for (size_t i = 0; i < length; i++)
+		hash = (hash ^ (unsigned int)text[i]) * 1099511628211ULL;
+	return hash;
+}
+
+//Index into the chain of the first font that has the character, fonts that have none of them give 0
+int GetChainFont(font_t* font, int codepoint)
+{
+	unsigned char** page = font->fallbackPages + (codepoint >> 8);
+	if (*page == NULL)
+	{
+		//Each font takes the characters of the page it covers that no font before it did, 0xFF marks those left
+		*page = memset(malloc(256), 0xFF, 256);
+		int first = codepoint & ~255;
+		for (int k = 0; k < font->chainLength; k++)
+		{
+			const coverage_t* coverage = font->chainCoverage[k];
+			for (int r = FindCoverageRange(coverage, first); r < coverage->count && coverage->ranges[r].first <= first + 255; r++)
+			{
+				int end = min(coverage->ranges[r].last, first + 255) - first;
+				for (int c = max(coverage->ranges[r].first, first) - first; c <= end; c++)
+				{
+					if ((*page)[c] == 0xFF)
+						(*page)[c] = (unsigned char)k;
+				}
+			}
+		}
+		for (int c = 0; c < 256; c++)
+		{
+			if ((*page)[c] == 0xFF)
+				(*page)[c] = 0;
+		}
+	}
+	return (*page)[codepoint & 255];
+}
+
+//Picks the font of every code unit of a paragraph into unitFonts. Clusters aren't split between fonts: default
+//ignorables such as joiners stay with the character before them, and so do marks when its font has them. Otherwise the
+//cluster moves to the font of the mark if that font has its base
+void ResolveUnitFonts(font_t* font, const utf16_t* text, size_t length)
+{
+	if (length > allocUnitFonts)
+	{
+		allocUnitFonts = max(length, allocUnitFonts * 2);
+		unitFonts = realloc(unitFonts, allocUnitFonts);
+	}
+
+	int previous = 0, base = 0;
+	size_t clusterStart = 0;
+	for (size_t i = 0, next; i < length; i = next)
+	{
+		next = i;
+		int codepoint = NextCodepoint(text, length, &next);
+		int chainFont = GetChainFont(font, codepoint);
+		if (i > 0 && chainFont != previous && IsDefaultIgnorable(codepoint))
+		{
+			chainFont = previous;
+		}
+		else if (i > 0 && chainFont != previous && IsCombiningMark(codepoint))
+		{
+			if (CoversCodepoint(font->chainCoverage[previous], codepoint))
+				chainFont = previous;
+			else if (CoversCodepoint(font->chainCoverage[chainFont], base))
+				memset(unitFonts + clusterStart, chainFont, i - clusterStart);
+		}
+		else if (!IsCombiningMark(codepoint))
+		{
+			clusterStart = i;
+			base = codepoint;
+		}
+		memset(unitFonts + i, chainFont, next - i);
+		previous = chainFont;
+	}
+}
+
+//Scales of the fonts of the chain at the pixel height
+void GetChainScales(const font_t* font, int fontSize, float* scales)
+{
+	for (int i = 0; i < font->chainLength; i++)
+		scales[i] = stbtt_ScaleForPixelHeight(font->chain[i]->info, (float)fontSize);
+}
+
+//Shapes a paragraph and measures its glyphs at the size, repeated paragraphs such as labels come from the cache
+//The run is valid until the next call
+shapedrun_t* GetShapedRun(font_t* font, int handle, int fontSize, const utf16_t* text, size_t length)
+{
+	unsigned long long hash = HashShapeKey(handle, fontSize, text, length);
+	shapedrun_t* run = &uncachedRun;
+	if (length <= MAX_CACHED_RUN_LENGTH)
+	{
+		run = &shapeCache[hash % SHAPE_CACHE_SIZE];
+		if (run->text != NULL && run->hash == hash && run->handle == handle && run->fontSize == fontSize && run->length == length &&
+			memcmp(run->text, text, sizeof(utf16_t) * length) == 0)
+		{
+			STATS_COUNT(STAT_SHAPE_CACHE_HITS, 1);
+			return run;
+		}
+		STATS_COUNT(STAT_SHAPE_CACHE_MISSES, 1);
+	}
+
+	STATS_BEGIN(STAT_SHAPE);
+	if (length + 1 > run->allocText)
+	{
+		run->allocText = max(length + 1, run->allocText * 2);
+		run->text = realloc(run->text, sizeof(utf16_t) * run->allocText);
+	}
+	memcpy(run->text, text, sizeof(utf16_t) * length);
+	run->handle = handle;
+	run->fontSize = fontSize;
+	run->hash = hash;
+	run->length = length;
 
-	//Swap endianness
-	for (size_t i = 0; i < length / sizeof(wchar_t); i++)
+	if (font->chainLength > 1)
+		ResolveUnitFonts(font, text, length);
+	ShapeText(font->chain, font->chainLength > 1 ? unitFonts : NULL, text, length, &run->shaped);
+	if (run->shaped.numGlyphs > run->allocMetrics)
 	{
-		unsigned char temp = fontNameStr[i * 2];
-		fontNameStr[i * 2] = fontNameStr[i * 2 + 1];
-		fontNameStr[i * 2 + 1] = temp;
+		run->allocMetrics = max(run->shaped.numGlyphs, run->allocMetrics * 2);
+		run->metrics = realloc(run->metrics, sizeof(glyphmetrics_t) * run->allocMetrics);
 	}
+	if (length > allocLineBreakFlags)
+	{
+		allocLineBreakFlags = max(length, allocLineBreakFlags * 2);
+		lineBreakFlags = realloc(lineBreakFlags, allocLineBreakFlags);
+	}
+	FindLineBreaks(text, length, lineBreakFlags);
+
+	//Pens add up the rounded advances, so a line starting anywhere in the paragraph is measured without placing it again
+	float scales[MAX_SHAPE_FONTS];
+	GetChainScales(font, fontSize, scales);
+	int pen = 0;
+	for (size_t i = 0; i < run->shaped.numGlyphs; i++)
+	{
+		glyphmetrics_t* metrics = run->metrics + i;
+		const shapedglyph_t* shaped = run->shaped.glyphs + i;
+		const stbtt_fontinfo* info = font->chain[shaped->font]->info;
+		float scale = metrics->scale = scales[shaped->font];
+		stbtt_GetGlyphHMetrics(info, shaped->glyph, &metrics->advanceWidth, &metrics->leftSideBearing);
+		stbtt_GetGlyphBitmapBox(info, shaped->glyph, scale, scale, &metrics->x0, &metrics->y0, &metrics->x1, &metrics->y1);
+		metrics->advance = (int)floorf(shaped->advance * scale + 0.5f);
+		metrics->inkRight = metrics->x1 - (int)(metrics->advanceWidth * scale);
+		metrics->pen = pen;
+		pen += metrics->advance;
+
+		unsigned char flags = lineBreakFlags[shaped->cluster];
+		metrics->lineBreak = i == 0 || shaped->cluster != shaped[-1].cluster ? flags : flags & LINEBREAK_SPACE;
+	}
+	STATS_END(STAT_SHAPE);
+	return run;
+}
+
+void FreeShapedRun(shapedrun_t* run)
+{
+	free(run->text);
+	free(run->metrics);
+	FreeShapeBuffer(&run->shaped);
+	memset(run, 0, sizeof(shapedrun_t));
+}
+
+//------------------------------ LOADING AND FREEING ------------------------------
+font_t** fonts = NULL;
+size_t numFonts = 0;
+utf16_t* lastFontName = NULL;
+char* lastFontNameUtf8 = NULL;
+layout_t** layouts = NULL;
+size_t numLayouts = 0;
+textstream_t** streams = NULL;
+size_t numStreams = 0;
+
+utf16_t* GetFontName(stbtt_fontinfo* info)
+{
+	int length = 0;
+	const unsigned char* fontNameStr = (const unsigned char*)stbtt_GetFontNameString(info, &length, STBTT_PLATFORM_ID_MICROSOFT, STBTT_MS_EID_UNICODE_BMP, STBTT_MS_LANG_ENGLISH, 4);
+	if (fontNameStr == NULL)
+		length = 0;
 
-	lastFontName = memcpy(realloc(lastFontName, length + sizeof(wchar_t)), fontNameStr, length);
-	lastFontName[length / sizeof(wchar_t)] = 0;
+	//Stored as big endian UTF-16, decoded into a copy so the font data isn't modified
+	size_t count = length / 2;
+	lastFontName = realloc(lastFontName, sizeof(utf16_t) * (count + 1));
+	for (size_t i = 0; i < count; i++)
+		lastFontName[i] = (utf16_t)(fontNameStr[i * 2] << 8 | fontNameStr[i * 2 + 1]);
+	lastFontName[count] = 0;
 
 	return lastFontName;
 }
 
-//Returns a handle to the loaded font
-__declspec(dllexport) int LoadFont(wchar_t* filename, int index, wchar_t** actualName)
+int OpenFont(utf16_t* filename, int index, utf16_t** actualName)
 {
 	//Check if font is already loaded
 	unsigned char* fontBuffer = NULL;
+	int fontSize = 0;
 	for (size_t i = 0; i < numFonts; i++)
 	{
-		if (wcscmp(fonts[i]->filename, filename) == 0)
+		if (Utf16Compare(fonts[i]->filename, filename) == 0)
 		{
 			if (fonts[i]->fontIndex == index)
 			{
 				if (*actualName == NULL)
 					*actualName = GetFontName(&fonts[i]->info);
+				STATS_COUNT(STAT_FONT_CACHE_HITS, 1);
 				return i;
 			}
 			else
 			{
 				fontBuffer = fonts[i]->info.data;
+				fontSize = fonts[i]->dataSize;
 			}
 		}
 	}
 
-	if (fontBuffer == NULL)
+	STATS_COUNT(STAT_FONT_CACHE_MISSES, 1);
+	STATS_BEGIN(STAT_LOAD);
+	int ownsBuffer = fontBuffer == NULL;
+	if (ownsBuffer)
 	{
 		//Open for reading
-		FILE* fontFile = _wfopen(filename, L"rb");
+		FILE* fontFile = OpenFileUtf16(filename, "rb");
 		if (fontFile == NULL)
+		{
+			STATS_END(STAT_LOAD);
 			return FILE_NOT_FOUND;
+		}
 
-		//Get length
+		//Get length, ftell fails with -1
 		fseek(fontFile, 0, SEEK_END);
-		size_t size = ftell(fontFile);
+		long length = ftell(fontFile);
 		fseek(fontFile, 0, SEEK_SET);
+		if (length < 12 || length > MAX_FONT_FILE_SIZE)
+		{
+			fclose(fontFile);
+			STATS_END(STAT_LOAD);
+			return INVALID_FONT;
+		}
 
 		//Allocate, read and close
-		fontBuffer = malloc(size);
-		fread(fontBuffer, size, 1, fontFile);
+		fontSize = (int)length;
+		fontBuffer = malloc(fontSize);
+		size_t read = fontBuffer != NULL ? fread(fontBuffer, fontSize, 1, fontFile) : 0;
 		fclose(fontFile);
+		if (read != 1)
+		{
+			free(fontBuffer);
+			STATS_END(STAT_LOAD);
+			return INVALID_FONT;
+		}
 	}
 
-	//Initialize font
+	//Initialize font, the whole file is validated once so rendering never reads outside it
 	font_t* font = malloc(sizeof(font_t));
 	font->fontIndex = index;
-	int fontOffset = stbtt_GetFontOffsetForIndex(fontBuffer, index);
-	if (!stbtt_InitFont(&font->info, fontBuffer, fontOffset))
+	font->dataSize = fontSize;
+	if (!stbtt_InitFontChecked(&font->info, fontBuffer, fontSize, index))
 	{
-		//Invalid font
+		//Invalid font, the buffer may belong to another index of the same file
 		free(font);
-		free(fontBuffer);
+		if (ownsBuffer)
+			free(fontBuffer);
+		STATS_END(STAT_LOAD);
 		return INVALID_FONT;
 	}
 
 	//Get vertical metrics and set filename
 	stbtt_GetFontVMetrics(&font->info, &font->ascent, &font->descent, &font->lineGap);
-	size_t size = sizeof(wchar_t) * (wcslen(filename) + 1);
+	InitShaper(&font->shaper, &font->info);
+	BuildCoverage(&font->info, &font->coverage);
+	font->chain[0] = &font->shaper;
+	font->chainCoverage[0] = &font->coverage;
+	font->chainLength = 1;
+	font->fallbackPages = NULL;
+	size_t size = sizeof(utf16_t) * (Utf16Length(filename) + 1);
 	font->filename = memcpy(malloc(size), filename, size);
 
 	//Array needs to be extended
@@ -120,16 +646,43 @@ __declspec(dllexport) int LoadFont(wchar_t* filename, int index, wchar_t** actua
 	fonts[numFonts - 1] = font;
 	if (*actualName == NULL)
 		*actualName = GetFontName(&font->info);
+	STATS_END(STAT_LOAD);
 	return numFonts - 1;
 }
 
-__declspec(dllexport) int LoadFontByName(wchar_t* fontname, wchar_t** actualName)
+//Returns a handle to the loaded font
+EXPORT int LoadFont(utf16_t* filename, int index, utf16_t** actualName)
+{
+	LockLibrary();
+	int handle = OpenFont(filename, index, actualName);
+	UnlockLibrary();
+	return handle;
+}
+
+//Same as LoadFont for UTF-8 file names, actualName receives the name of the font in UTF-8
+EXPORT int LoadFontUtf8(const char* filename, int index, char** actualName)
+{
+	utf16_t* path = Utf8ToUtf16(filename);
+	utf16_t* name = NULL;
+	int handle = LoadFont(path, index, &name);
+	free(path);
+
+	if (handle >= 0)
+	{
+		free(lastFontNameUtf8);
+		*actualName = lastFontNameUtf8 = Utf16ToUtf8(name, Utf16Length(name));
+	}
+	return handle;
+}
+
+EXPORT int LoadFontByName(utf16_t* fontname, utf16_t** actualName)
 {
 	//Use winapi to find the correct font file
 	installedfont_t* font = GetFontByName(fontname);
 	if (font == NULL)
 		return WINDOWS_ONLY;
 
+#ifdef _WIN32
 	//Create path
 	wchar_t path[MAX_PATH];
 	GetWindowsDirectoryW(path, MAX_PATH);
@@ -139,135 +692,1890 @@ __declspec(dllexport) int LoadFontByName(wchar_t* fontname, wchar_t** actualName
 	*actualName = font->name;
 
 	return LoadFont(path, font->fontIndex, actualName);
+#else
+	return WINDOWS_ONLY;
+#endif
 }
 
-__declspec(dllexport) void FreeAllResources()
+void FreeFallbackPages(font_t* font)
 {
-	//lib.c
-	for (size_t i = 0; i < numFonts; i++)
+	if (font->fallbackPages == NULL)
+		return;
+	for (int page = 0; page < FALLBACK_PAGES; page++)
+		free(font->fallbackPages[page]);
+	free(font->fallbackPages);
+	font->fallbackPages = NULL;
+}
+
+//Characters the font doesn't have are drawn with the first of count fallback fonts that has them. A font may have up to
+//MAX_SHAPE_FONTS - 1 fallbacks, the rest are ignored, and a count of 0 removes them. Returns 0 if a handle is invalid
+EXPORT int SetFallbackFonts(int handle, const int* handles, int count)
+{
+	count = min(max(count, 0), MAX_SHAPE_FONTS - 1);
+	LockLibrary();
+	if (handle < 0 || (size_t)handle >= numFonts)
 	{
-		//fonts[i]->info.data may be used by multiple so make sure not to free it twice
-		for (size_t j = i; j < numFonts; j++)
-			if (fonts[i]->info.data == fonts[j]->info.data)
-				break;
-			else if (j == numFonts - 1)
-				free(fonts[i]->info.data);
+		UnlockLibrary();
+		return 0;
+	}
+	for (int i = 0; i < count; i++)
+	{
+		if (handles[i] < 0 || (size_t)handles[i] >= numFonts)
+		{
+			UnlockLibrary();
+			return 0;
+		}
+	}
 
-		free(fonts[i]->filename);
-		free(fonts[i]);
+	font_t* font = fonts[handle];
+	for (int i = 0; i < count; i++)
+	{
+		font->chain[i + 1] = &fonts[handles[i]]->shaper;
+		font->chainCoverage[i + 1] = &fonts[handles[i]]->coverage;
 	}
-	free(fonts);
-	free(lastFontName);
+	font->chainLength = count + 1;
+	FreeFallbackPages(font);
+	if (count > 0)
+		font->fallbackPages = calloc(FALLBACK_PAGES, sizeof(unsigned char*));
 
-	//installedfonts.h
-	for (size_t i = 0; i < numInstFonts; i++)
+	//Runs shaped with the old chain must not be found again
+	for (size_t i = 0; i < SHAPE_CACHE_SIZE; i++)
 	{
-		free(instFonts[i].name);
-		free(instFonts[i].filename);
+		if (shapeCache[i].handle == handle)
+			shapeCache[i].length = SIZE_MAX;
 	}
-	free(instFonts);
+	UnlockLibrary();
+	return 1;
 }
 
-//------------------------------- GENERATING BITMAP -------------------------------
-glyph_t* glyphs = NULL;
-size_t numGlyphs;
-int extraYOffset;
-float scale;
-
-__declspec(dllexport) void MeasureBitmap(int handle, wchar_t* text, int fontSize, int* width, int* height, int* yOffset, int maxWidth, float lineSpacing)
+//Characters that are never drawn, such as line breaks and joiners, don't need a glyph
+int IsInvisibleCharacter(int codepoint)
 {
-	size_t lastSpaceAt = 0;
-	int lineMaxXAtSpace = 0;
-	if (maxWidth == 0)
-		maxWidth = INT_MAX;
+	return codepoint < 0x20 || (codepoint >= 0x7F && codepoint < 0xA0) || codepoint == 0x2028 || codepoint == 0x2029 ||
+		IsDefaultIgnorable(codepoint);
+}
 
-	numGlyphs = wcslen(text);
-	glyphs = malloc(sizeof(glyph_t) * numGlyphs);
-	memset(glyphs, 0, sizeof(glyph_t) * numGlyphs);
+//Number of characters of the text the font has no glyph for, fallback fonts aren't counted. Returns -1 if the handle is
+//invalid
+EXPORT int FontCoversText(int handle, const utf16_t* text, int length)
+{
+	LockLibrary();
+	if (handle < 0 || (size_t)handle >= numFonts)
+	{
+		UnlockLibrary();
+		return -1;
+	}
 
-	stbtt_fontinfo* info = &fonts[handle]->info;
-	scale = stbtt_ScaleForPixelHeight(info, (float)fontSize);
-	extraYOffset = 0;
+	//Text tends to stay within a few ranges, so the range of the last character is tried before searching
+	const coverage_t* coverage = &fonts[handle]->coverage;
+	size_t textLength = length > 0 ? (size_t)length : 0;
+	int missing = 0, range = 0;
+	for (size_t i = 0; i < textLength;)
+	{
+		int codepoint = NextCodepoint(text, textLength, &i);
+		if (range >= coverage->count || codepoint < coverage->ranges[range].first || codepoint > coverage->ranges[range].last)
+			range = FindCoverageRange(coverage, codepoint);
+		if ((range == coverage->count || codepoint < coverage->ranges[range].first) && !IsInvisibleCharacter(codepoint))
+			missing++;
+	}
+	UnlockLibrary();
+	return missing;
+}
 
-	float x = 0, y = 0, maxX = 0, maxY = 0;
-	float lineYIncrement = fontSize / 2 + fontSize / 2 * lineSpacing;
-	float ascent = fonts[handle]->ascent * scale;
-	int advanceWidth = 0, x1 = 0, lineMaxX = 0;
-	for (size_t i = 0; i < numGlyphs + 1; i++)
+//Writes up to maxRanges of the ranges of characters the font has glyphs for as first and last character pairs in
+//increasing order. Returns the number of ranges the font has, or -1 if the handle is invalid
+EXPORT int GetCoverageRanges(int handle, int* ranges, int maxRanges)
+{
+	LockLibrary();
+	if (handle < 0 || (size_t)handle >= numFonts)
 	{
-		if (text[i] == L'\r') continue;
-		if (text[i] == L'\n' || text[i] == L'\0')
-		{
-			maxX = max(lineMaxX, maxX);
-			x = 0;
-			y += lineYIncrement;
-			continue;
-		}
+		UnlockLibrary();
+		return -1;
+	}
 
-		int kern = stbtt_GetCodepointKernAdvance(info, text[i], text[i + 1]);
+	const coverage_t* coverage = &fonts[handle]->coverage;
+	for (int i = 0; i < min(maxRanges, coverage->count); i++)
+	{
+		ranges[2 * i] = coverage->ranges[i].first;
+		ranges[2 * i + 1] = coverage->ranges[i].last;
+	}
+	int count = coverage->count;
+	UnlockLibrary();
+	return count;
+}
 
-		int leftSideBearing;
-		stbtt_GetCodepointHMetrics(info, text[i], &advanceWidth, &leftSideBearing);
+//Cancels the queued renders and stops the workers, defined with the render queue
+void FreeRenderJobs();
 
-		int x0, y0, y1;
-		stbtt_GetCodepointBitmapBox(info, text[i], scale, scale, &x0, &y0, &x1, &y1);
+EXPORT void FreeAllResources()
+{
+	//Workers may be using the fonts
+	FreeRenderJobs();
+	LockLibrary();
 
-		glyphs[i].codepoint = text[i];
-		glyphs[i].width = x1 - x0;
-		glyphs[i].height = y1 - y0;
-		glyphs[i].offsetY = y0 + (int)(y + ascent);
+	//lib.c
+	for (size_t i = 0; i < numFonts; i++)
+	{
+		//fonts[i]->info.data may be used by multiple so only the last font using it frees it
+		size_t j = i + 1;
+		while (j < numFonts && fonts[j]->info.data != fonts[i]->info.data)
+			j++;
+		if (j == numFonts)
+			free(fonts[i]->info.data);
 
-		//If the a character on the first line exceeds top of the bitmap, bring all characters down by extraYOffset
-		if (glyphs[i].offsetY < 0 && extraYOffset < -glyphs[i].offsetY)
-			extraYOffset = -glyphs[i].offsetY;
+		FreeShaper(&fonts[i]->shaper);
+		FreeCoverage(&fonts[i]->coverage);
+		FreeFallbackPages(fonts[i]);
+		free(fonts[i]->filename);
+		free(fonts[i]);
+	}
+	free(fonts);
+	fonts = NULL;
+	numFonts = 0;
+	free(lastFontName);
+	free(lastFontNameUtf8);
+	lastFontName = NULL;
+	lastFontNameUtf8 = NULL;
 
-		int lastX = (int)x;
-		if (x == 0 && leftSideBearing < 0)
-		{
-			//Glyph is the first character of a line with a negative left side bearing
-			glyphs[i].offsetX = (int)x;
-			x += (advanceWidth + kern - leftSideBearing) * scale;
-		}
-		else
+	for (size_t i = 0; i < numLayouts; i++)
+	{
+		if (layouts[i] != NULL)
 		{
-			glyphs[i].offsetX = (int)(x + leftSideBearing * scale);
-			x += (advanceWidth + kern) * scale;
+			free(layouts[i]->glyphs);
+			free(layouts[i]->lines);
+			free(layouts[i]->scratch);
+			free(layouts[i]);
 		}
-		x = (float)(int)(x + 0.5f);
-
-		lineMaxX = (int)x - ((int)(advanceWidth * scale) - x1);
-		maxY = max((int)(y + ascent) + y1, maxY);
+	}
+	free(layouts);
+	layouts = NULL;
+	numLayouts = 0;
 
-		if (text[i] == L' ')
-		{
-			lineMaxXAtSpace = min(lineMaxX, maxWidth);
-			lastSpaceAt = i;
-		}
-		if (lineMaxX > maxWidth)
+	for (size_t i = 0; i < numStreams; i++)
+	{
+		if (streams[i] != NULL)
 		{
-			maxX = max(lineMaxXAtSpace, maxX);
-			x = 0;
-			y += lineYIncrement;
-			if (lastX != 0)
-				i = lastSpaceAt;
-			continue;
+			free(streams[i]->lines);
+			free(streams[i]->pending);
+			free(streams[i]->pendingFlags);
+			free(streams[i]);
 		}
 	}
+	free(streams);
+	streams = NULL;
+	numStreams = 0;
 
-	*width = (int)maxX;
-	*height = (int)maxY + extraYOffset;
-	*yOffset = -extraYOffset;
-}
+	//Handles are reused by the next fonts, shaped runs of the old ones must not match them
+	for (size_t i = 0; i < SHAPE_CACHE_SIZE; i++)
+		FreeShapedRun(shapeCache + i);
+	FreeShapedRun(&uncachedRun);
+	free(glyphPens);
+	glyphPens = NULL;
+	allocGlyphPens = 0;
+	free(decodedText);
+	decodedText = NULL;
+	allocDecodedText = 0;
+	free(lineBreakFlags);
+	lineBreakFlags = NULL;
+	allocLineBreakFlags = 0;
+	free(unitFonts);
+	unitFonts = NULL;
+	allocUnitFonts = 0;
+	free(wrapNodes);
+	free(wrapBreaks);
+	wrapNodes = NULL;
+	wrapBreaks = NULL;
+	allocWrapNodes = 0;
 
-__declspec(dllexport) void GenerateBitmap(int handle, unsigned char* emptyBitmap, int width)
-{
-	for (size_t i = 0; i < numGlyphs; i++)
+	//shaping.h
+	FreeShapingScratch();
+
+	//tiledraster.h
+	FreeTiledRasterizer(&tiledRasterizer);
+
+	//installedfonts.h
+	for (size_t i = 0; i < numInstFonts; i++)
 	{
-		if (glyphs[i].codepoint != 0)
-		{
-			int offset = (glyphs[i].offsetY + extraYOffset) * width + glyphs[i].offsetX;
-			stbtt_MakeCodepointBitmap(&fonts[handle]->info, emptyBitmap + offset, glyphs[i].width, glyphs[i].height, width, scale, scale, glyphs[i].codepoint);
-		}
-	}
-	free(glyphs);
-}
\ No newline at end of file
+		free(instFonts[i].name);
+		free(instFonts[i].filename);
+	}
+	free(instFonts);
+	instFonts = NULL;
+	numInstFonts = 0;
+	UnlockLibrary();
+}
+
+//------------------------------- GENERATING BITMAP -------------------------------
+layout_t lastLayout;
+int renderMode = RENDER_COVERAGE;
+int sdfSpread = 0;
+int wrapMode = WRAP_GREEDY;
+rasteroptions_t rasterOptions = { RASTERIZER_LIST, EDGE_SORT_BUCKETS, FLATTEN_HALVING, DEFAULT_TILED_THRESHOLD };
+
+//Render workers rasterize in tiles into their own buffers, other threads use tiledRasterizer
+THREAD_LOCAL tiledrasterizer_t* workerRasterizer = NULL;
+
+//Selects what GenerateBitmap writes: coverage (default) or a signed distance field reaching spread pixels outside the glyphs
+EXPORT void SetRenderMode(int mode, int spread)
+{
+	renderMode = mode;
+	sdfSpread = mode == RENDER_SDF ? max(spread, 1) : 0;
+}
+
+//Selects how text is wrapped at maxWidth: greedily, filling every line before starting the next (default), or optimally,
+//evening out the lines of a paragraph
+EXPORT void SetWrapMode(int mode)
+{
+	wrapMode = mode;
+}
+
+//Selects how coverage is rasterized: with the active edges in a linked list (default) or in a contiguous edge table,
+//which is faster for glyphs with many edges and gives the same bitmaps, or by accumulating area in tiles, which is
+//faster for large glyphs and differs from the others by rounding
+EXPORT void SetRasterizer(int mode)
+{
+	rasterOptions.rasterizer = mode;
+}
+
+//Selects how the edges of a glyph are ordered for the list and edge table rasterizers: by quicksort or by counting them
+//into one bucket per row (default), which is linear in the edges. Both give the same bitmaps
+EXPORT void SetEdgeSort(int mode)
+{
+	rasterOptions.edgeSort = mode;
+}
+
+//Selects how curves are flattened for every rasterizer and for SDFs: by halving them until they are flat (default) or
+//with the segments each needs computed from its control points. Bitmaps differ slightly along curves
+EXPORT void SetFlattening(int mode)
+{
+	rasterOptions.flattening = mode;
+}
+
+//Glyphs at least pixels tall (64 by default) are rasterized in tiles whichever rasterizer is selected, 0 turns this off
+EXPORT void SetTiledRasterizerThreshold(int pixels)
+{
+	rasterOptions.tiledThreshold = max(pixels, 0);
+}
+
+//The flattening as stbtt_FlattenCurves takes it
+int GetStbFlattening(const rasteroptions_t* options)
+{
+	return options->flattening == FLATTEN_ANALYTIC ? STBTT_FLATTEN_ANALYTIC : STBTT_FLATTEN_HALVING;
+}
+
+//stbtt_MakeGlyphBitmapClipped with the given options, which are passed down rather than read from the settings so render
+//workers use the ones their job was queued with
+void MakeGlyphBitmap(const rasteroptions_t* options, const stbtt_fontinfo* info, unsigned char* output, int width, int height, int stride,
+	float scale, int clipX0, int clipY0, int clipX1, int clipY1, int glyph)
+{
+	if (options->rasterizer == RASTERIZER_TILED || (options->tiledThreshold > 0 && height >= options->tiledThreshold))
+	{
+		RasterizeTiled(workerRasterizer != NULL ? workerRasterizer : &tiledRasterizer, info, output, width, height, stride, scale, clipX0, clipY0, clipX1, clipY1,
+			glyph, GetStbFlattening(options));
+		return;
+	}
+
+	stbtt_raster_options stbOptions;
+	stbOptions.rasterizer = options->rasterizer == RASTERIZER_EDGE_TABLE ? STBTT_RASTERIZER_EDGE_TABLE : STBTT_RASTERIZER_LIST;
+	stbOptions.edge_sort = options->edgeSort == EDGE_SORT_QUICKSORT ? STBTT_SORT_QUICKSORT : STBTT_SORT_BUCKETS;
+	stbOptions.flattening = GetStbFlattening(options);
+	stbtt_MakeGlyphBitmapClippedOptions(info, output, width, height, stride, scale, scale, clipX0, clipY0, clipX1, clipY1, glyph, &stbOptions);
+}
+
+//Advance in pixels of the glyph that starts a line, one with a negative left side bearing is moved right to the start
+int GetFirstAdvance(const shapedglyph_t* shaped, const glyphmetrics_t* metrics)
+{
+	if (metrics->leftSideBearing < 0)
+		return (int)floorf((shaped->advance - metrics->leftSideBearing) * metrics->scale + 0.5f);
+	return metrics->advance;
+}
+
+//Place a shaped glyph at pen position x and advance the pen, offsetY of the glyph is relative to the baseline
+//lineMaxX is set to the right edge of the glyph's ink
+void PlaceGlyph(const shapedglyph_t* shaped, const glyphmetrics_t* metrics, int first, float* x, int* lineMaxX, glyph_t* glyph)
+{
+	float scale = metrics->scale;
+	glyph->glyph = shaped->glyph;
+	glyph->font = shaped->font;
+	glyph->width = metrics->x1 - metrics->x0;
+	glyph->height = metrics->y1 - metrics->y0;
+	glyph->offsetY = metrics->y0 - (int)floorf(shaped->offsetY * scale + 0.5f);
+
+	if (first)
+	{
+		glyph->offsetX = metrics->leftSideBearing < 0 ? (int)*x : (int)(*x + metrics->leftSideBearing * scale);
+		*x += GetFirstAdvance(shaped, metrics);
+	}
+	else
+	{
+		glyph->offsetX = (int)(*x + metrics->leftSideBearing * scale);
+		*x += metrics->advance;
+	}
+	glyph->offsetX += (int)floorf(shaped->offsetX * scale + 0.5f);
+
+	//Marks sit on the glyph before them and don't pull the edge back
+	if (shaped->glyphClass == GLYPH_MARK && shaped->advance == 0)
+		*lineMaxX = max(*lineMaxX, glyph->offsetX + glyph->width);
+	else
+		*lineMaxX = (int)*x + metrics->inkRight;
+}
+
+//Streams are laid out a character at a time, they are kerned but not shaped
+void PlaceCodepoint(stbtt_fontinfo* info, float scale, int codepoint, int nextCodepoint, float* x, int* lineMaxX, glyph_t* glyph)
+{
+	shapedglyph_t shaped;
+	glyphmetrics_t metrics;
+	memset(&shaped, 0, sizeof(shapedglyph_t));
+	shaped.glyph = stbtt_FindGlyphIndex(info, codepoint);
+	shaped.glyphClass = GLYPH_BASE;
+	metrics.scale = scale;
+	stbtt_GetGlyphHMetrics(info, shaped.glyph, &metrics.advanceWidth, &metrics.leftSideBearing);
+	stbtt_GetGlyphBitmapBox(info, shaped.glyph, scale, scale, &metrics.x0, &metrics.y0, &metrics.x1, &metrics.y1);
+	shaped.advance = metrics.advanceWidth + stbtt_GetCodepointKernAdvance(info, codepoint, nextCodepoint);
+	metrics.advance = (int)floorf(shaped.advance * scale + 0.5f);
+	metrics.inkRight = metrics.x1 - (int)(metrics.advanceWidth * scale);
+	STATS_COUNT(STAT_GLYPHS_PLACED, 1);
+	PlaceGlyph(&shaped, &metrics, *x == 0, x, lineMaxX, glyph);
+}
+
+//Rasterize the part [x0, x1) x [y0, y1) of a glyph's box into scratch space of that size, the space grows when needed
+unsigned char* RasterizeGlyphScratch(const rasteroptions_t* options, const stbtt_fontinfo* info, float scale, glyph_t* glyph, int x0, int y0, int x1, int y1, unsigned char** scratch, size_t* scratchSize)
+{
+	size_t size = (size_t)(x1 - x0) * (y1 - y0);
+	if (size > *scratchSize)
+		*scratch = realloc(*scratch, *scratchSize = size);
+	memset(*scratch, 0, size);
+	MakeGlyphBitmap(options, info, *scratch, glyph->width, glyph->height, x1 - x0, scale, x0, y0, x1, y1, glyph->glyph);
+	return *scratch;
+}
+
+//Rasterize a glyph whose box starts at row top into a width * height bitmap with rows stride bytes apart, clipped to it
+//Glyphs only reach outside the bitmap they were measured for when the font's metrics don't match its outlines
+void RasterizeGlyphClipped(const rasteroptions_t* options, const stbtt_fontinfo* info, float scale, glyph_t* glyph, int top, unsigned char* bitmap, int width, int height, size_t stride)
+{
+	int x0 = max(glyph->offsetX, 0), y0 = max(top, 0);
+	int x1 = min(glyph->offsetX + glyph->width, width), y1 = min(top + glyph->height, height);
+	if (x0 >= x1 || y0 >= y1)
+		return;
+
+	MakeGlyphBitmap(options, info, bitmap + (size_t)y0 * stride + x0, glyph->width, glyph->height, (int)stride, scale,
+		x0 - glyph->offsetX, y0 - top, x1 - glyph->offsetX, y1 - top, glyph->glyph);
+}
+
+void AddLineInfo(layout_t* layout, size_t glyphStart, float y)
+{
+	if (layout->numLines == layout->allocLines)
+	{
+		layout->allocLines = layout->allocLines == 0 ? 16 : layout->allocLines * 2;
+		layout->lines = realloc(layout->lines, sizeof(lineinfo_t) * layout->allocLines);
+	}
+
+	layout->lines[layout->numLines].glyphStart = glyphStart;
+	layout->lines[layout->numLines].y = (int)y;
+	layout->numLines++;
+}
+
+//Top row of a line in the bitmap, numLines gives the bottom of the last line
+int GetLineTop(layout_t* layout, size_t line)
+{
+	if (line >= layout->numLines)
+		return layout->height;
+
+	//Empty lines at the end may start below the bitmap
+	return min(layout->lines[line].y + layout->extraYOffset, layout->height);
+}
+
+//Puts a line placed in logical order into visual order. From the highest level down to the lowest odd one, every
+//sequence of glyphs at that level or above is reversed. Lines are left aligned, so whitespace at the end of a line stays
+//on the right where it doesn't count towards the width
+void ReorderLine(glyph_t* glyphs, const shapedrun_t* run, size_t first, size_t lineStart, size_t lineEnd)
+{
+	size_t count = lineEnd - lineStart;
+	glyphpen_t* pens = glyphPens + (lineStart - first);
+	const shapedglyph_t* shaped = run->shaped.glyphs + (lineStart - first);
+	const glyphmetrics_t* metrics = run->metrics + (lineStart - first);
+	int maxLevel = 0, minOddLevel = INT_MAX, trailing = 1;
+	for (size_t k = count; k-- > 0;)
+	{
+		trailing = trailing && (metrics[k].lineBreak & LINEBREAK_SPACE);
+		pens[k].level = trailing ? 0 : shaped[k].level;
+		pens[k].order = k;
+		maxLevel = max(maxLevel, pens[k].level);
+		if (pens[k].level & 1)
+			minOddLevel = min(minOddLevel, pens[k].level);
+	}
+
+	for (int level = maxLevel; level >= minOddLevel; level--)
+	{
+		for (size_t k = 0; k < count;)
+		{
+			size_t end = k;
+			while (end < count && pens[pens[end].order].level >= level)
+				end++;
+			for (size_t a = k, b = end; a + 1 < b; a++, b--)
+			{
+				size_t order = pens[a].order;
+				pens[a].order = pens[b - 1].order;
+				pens[b - 1].order = order;
+			}
+			k = end + 1;
+		}
+	}
+
+	//Every glyph keeps its offset from its own pen position
+	int pen = count > 0 ? pens[0].pen : 0;
+	for (size_t k = 0; k < count; k++)
+	{
+		size_t g = pens[k].order;
+		glyphs[lineStart + g].offsetX += pen - pens[g].pen;
+		pen += pens[g].advance;
+	}
+}
+
+//Pen position of glyph j of a shaped run on a line that starts at glyph start
+int GetLinePen(const shapedrun_t* run, size_t start, size_t j)
+{
+	if (j == start)
+		return 0;
+	int firstAdvance = GetFirstAdvance(run->shaped.glyphs + start, run->metrics + start);
+	return firstAdvance + run->metrics[j].pen - run->metrics[start + 1].pen;
+}
+
+//Right edge of the ink of a line that starts at glyph start of a shaped run once glyph j is added to it, lineMaxX is
+//the edge before it. Only marks are placed to find it
+int GetGlyphMaxX(const shapedrun_t* run, size_t start, size_t j, int lineMaxX)
+{
+	const shapedglyph_t* shaped = run->shaped.glyphs + j;
+	const glyphmetrics_t* metrics = run->metrics + j;
+	int pen = GetLinePen(run, start, j);
+	if (shaped->glyphClass == GLYPH_MARK && shaped->advance == 0)
+	{
+		glyph_t glyph;
+		float x = (float)pen;
+		PlaceGlyph(shaped, metrics, j == start, &x, &lineMaxX, &glyph);
+		return lineMaxX;
+	}
+	return pen + (j == start ? GetFirstAdvance(shaped, metrics) : metrics->advance) + metrics->inkRight;
+}
+
+//Right edge of the ink of glyphs [start, end) of a shaped run as a line, only the last glyph and the marks on it are looked at
+int GetLineMaxX(const shapedrun_t* run, size_t start, size_t end)
+{
+	size_t last = end;
+	while (last > start + 1 && run->shaped.glyphs[last - 1].glyphClass == GLYPH_MARK && run->shaped.glyphs[last - 1].advance == 0)
+		last--;
+
+	int lineMaxX = 0;
+	for (size_t j = last > start ? last - 1 : end; j < end; j++)
+		lineMaxX = GetGlyphMaxX(run, start, j, lineMaxX);
+	return lineMaxX;
+}
+
+//Line starts of a paragraph that minimize the sum of the squared space left over on its lines, the last line included,
+//so the lines come out even. Every line also costs as much as an empty one, so more lines than needed aren't used.
+//Mandatory breaks split the paragraph into parts that are wrapped on their own. Lines only look back as far as they fit,
+//which keeps this linear in the number of glyphs times the break opportunities on a line. Returns the glyphs lines start
+//at in order, followed by SIZE_MAX
+size_t* FindOptimalBreaks(const shapedrun_t* run, int maxWidth)
+{
+	size_t numShaped = run->shaped.numGlyphs, numBreaks = 0;
+	if (numShaped + 2 > allocWrapNodes)
+	{
+		allocWrapNodes = max(numShaped + 2, allocWrapNodes * 2);
+		wrapNodes = realloc(wrapNodes, sizeof(wrapnode_t) * allocWrapNodes);
+		wrapBreaks = realloc(wrapBreaks, sizeof(size_t) * allocWrapNodes);
+	}
+
+	long long linePenalty = (long long)maxWidth * maxWidth;
+	for (size_t start = 0, end; start < numShaped; start = end)
+	{
+		//The part starts a line, every break opportunity in it may and its end does
+		size_t numNodes = 1;
+		wrapNodes[0].glyph = start;
+		wrapNodes[0].demerits = 0;
+		for (end = start + 1; end < numShaped && !(run->metrics[end].lineBreak & LINEBREAK_MANDATORY); end++)
+		{
+			if (run->metrics[end].lineBreak & LINEBREAK_ALLOWED)
+				wrapNodes[numNodes++].glyph = end;
+		}
+		wrapNodes[numNodes++].glyph = end;
+
+		for (size_t b = 1; b < numNodes; b++)
+		{
+			wrapNodes[b].demerits = LLONG_MAX;
+			for (size_t a = b; a-- > 0;)
+			{
+				//Lines that overflow are only taken when there's no break opportunity in them, the overflowing cluster is
+				//then broken off like in greedy wrapping
+				int width = GetLineMaxX(run, wrapNodes[a].glyph, wrapNodes[b].glyph);
+				if (width > maxWidth && a + 1 < b)
+					break;
+
+				long long slack = maxWidth - width;
+				long long demerits = wrapNodes[a].demerits + slack * slack + linePenalty;
+				if (demerits < wrapNodes[b].demerits)
+				{
+					wrapNodes[b].demerits = demerits;
+					wrapNodes[b].previous = a;
+				}
+			}
+		}
+
+		//The lines are found from the last one back
+		size_t firstBreak = numBreaks;
+		for (size_t b = wrapNodes[numNodes - 1].previous; b > 0; b = wrapNodes[b].previous)
+			wrapBreaks[numBreaks++] = wrapNodes[b].glyph;
+		for (size_t a = firstBreak, b = numBreaks; a + 1 < b; a++, b--)
+		{
+			size_t glyph = wrapBreaks[a];
+			wrapBreaks[a] = wrapBreaks[b - 1];
+			wrapBreaks[b - 1] = glyph;
+		}
+	}
+
+	wrapBreaks[numBreaks] = SIZE_MAX;
+	return wrapBreaks;
+}
+
+//Place glyphs [start, end) of a shaped run as a line at y, they go to the layout from index first + start on
+void PlaceLine(layout_t* layout, const shapedrun_t* run, size_t first, size_t start, size_t end, float y, float ascent, int bidi, int* extraYOffset, float* maxY)
+{
+	float x = 0;
+	int lineMaxX = 0;
+	glyph_t* placed = layout->glyphs + first;
+	for (size_t j = start; j < end; j++)
+	{
+		int lastX = (int)x;
+		PlaceGlyph(run->shaped.glyphs + j, run->metrics + j, j == start, &x, &lineMaxX, placed + j);
+		placed[j].offsetY += (int)(y + ascent);
+		if (bidi)
+		{
+			glyphPens[j].pen = lastX;
+			glyphPens[j].advance = (int)x - lastX;
+		}
+
+		//If the a character on the first line exceeds top of the bitmap, bring all characters down by extraYOffset
+		if (placed[j].offsetY < 0 && *extraYOffset < -placed[j].offsetY)
+			*extraYOffset = -placed[j].offsetY;
+
+		*maxY = max(placed[j].offsetY + placed[j].height, *maxY);
+	}
+	if (bidi)
+		ReorderLine(layout->glyphs, run, first, first + start, first + end);
+}
+
+//text doesn't need to be null terminated, exactly length code units are read. Paragraphs are shaped one at a time and
+//wrapped in logical order at the break opportunities of UAX #14, lines with right to left text are then put into visual
+//order. Advances and break opportunities come with the shaped run, so every glyph is placed once. With wrap WRAP_OPTIMAL
+//the lines of a paragraph are chosen before it is walked and only the clusters that don't fit on a line of their own are
+//broken during the walk
+void MeasureLayout(layout_t* layout, int handle, const utf16_t* text, size_t length, int fontSize, int maxWidth, float lineSpacing, int spread, int wrap)
+{
+	if (maxWidth == 0)
+		maxWidth = INT_MAX;
+
+	STATS_BEGIN(STAT_LAYOUT);
+	memset(layout, 0, sizeof(layout_t));
+	layout->handle = handle;
+	layout->sdfSpread = spread;
+
+	//Shaping usually gives at most a glyph per code unit, the array grows for fonts that make more
+	size_t allocGlyphs = max(length, 1);
+	layout->glyphs = malloc(sizeof(glyph_t) * allocGlyphs);
+
+	font_t* font = fonts[handle];
+	GetChainScales(font, fontSize, layout->fontScales);
+	for (int i = 0; i < font->chainLength; i++)
+		layout->fontInfos[i] = font->chain[i]->info;
+	layout->scale = layout->fontScales[0];
+	int extraYOffset = 0;
+
+	float y = 0, maxX = 0, maxY = 0;
+	float lineYIncrement = fontSize / 2 + fontSize / 2 * lineSpacing;
+	float ascent = font->ascent * layout->scale;
+	AddLineInfo(layout, 0, y);
+	for (size_t paragraph = 0; paragraph <= length;)
+	{
+		//Line breaks end paragraphs, so does a null character but it doesn't start a line
+		size_t paragraphEnd = FindSimpleRun(text, paragraph, length);
+		while (paragraphEnd < length && text[paragraphEnd] != L'\n' && text[paragraphEnd] != L'\0')
+			paragraphEnd = FindSimpleRun(text, paragraphEnd + 1, length);
+
+		shapedrun_t* run = GetShapedRun(font, handle, fontSize, text + paragraph, paragraphEnd - paragraph);
+		size_t first = layout->numGlyphs, numShaped = run->shaped.numGlyphs;
+		if (first + numShaped > allocGlyphs)
+		{
+			allocGlyphs = max(first + numShaped, allocGlyphs * 2);
+			layout->glyphs = realloc(layout->glyphs, sizeof(glyph_t) * allocGlyphs);
+		}
+		int bidi = run->shaped.maxLevel > 0;
+		if (bidi && numShaped > allocGlyphPens)
+		{
+			allocGlyphPens = max(numShaped, allocGlyphPens * 2);
+			glyphPens = realloc(glyphPens, sizeof(glyphpen_t) * allocGlyphPens);
+		}
+
+		//The line from lineStart is measured as it grows and placed once it ends. Lines end at the last break opportunity
+		//that fits, or before the cluster that overflows when there is none
+		STATS_COUNT(STAT_GLYPHS_PLACED, numShaped);
+		size_t lineStart = 0, lastBreak = 0, clusterStart = 0;
+		int lineMaxX = 0, widthAtBreak = 0;
+		const size_t* breaks = wrap == WRAP_OPTIMAL && maxWidth != INT_MAX ? FindOptimalBreaks(run, maxWidth) : NULL;
+		for (size_t j = 0; j < numShaped; j++)
+		{
+			const glyphmetrics_t* metrics = run->metrics + j;
+			int endLine = (metrics->lineBreak & LINEBREAK_MANDATORY) != 0;
+			if (breaks != NULL && j == *breaks)
+			{
+				endLine = 1;
+				breaks++;
+			}
+			if (endLine)
+			{
+				PlaceLine(layout, run, first, lineStart, j, y, ascent, bidi, &extraYOffset, &maxY);
+				maxX = max(lineMaxX, maxX);
+				y += lineYIncrement;
+				AddLineInfo(layout, first + (lineStart = j), y);
+				lineMaxX = 0;
+			}
+			if ((metrics->lineBreak & LINEBREAK_ALLOWED) && breaks == NULL)
+			{
+				lastBreak = j;
+				widthAtBreak = min(lineMaxX, maxWidth);
+			}
+			if (j == 0 || run->shaped.glyphs[j].cluster != run->shaped.glyphs[j - 1].cluster)
+				clusterStart = j;
+
+			lineMaxX = GetGlyphMaxX(run, lineStart, j, lineMaxX);
+
+			//Spaces hang past the end of the line
+			while (lineMaxX > maxWidth && !(metrics->lineBreak & LINEBREAK_SPACE))
+			{
+				size_t lineEnd;
+				int width;
+				if (lastBreak > lineStart)
+				{
+					lineEnd = lastBreak;
+					width = widthAtBreak;
+				}
+				else if (clusterStart > lineStart)
+				{
+					lineEnd = clusterStart;
+					width = min(GetLineMaxX(run, lineStart, clusterStart), maxWidth);
+				}
+				else
+				{
+					break;
+				}
+
+				PlaceLine(layout, run, first, lineStart, lineEnd, y, ascent, bidi, &extraYOffset, &maxY);
+				maxX = max(width, maxX);
+				y += lineYIncrement;
+				AddLineInfo(layout, first + (lineStart = lineEnd), y);
+				lineMaxX = GetLineMaxX(run, lineStart, j + 1);
+			}
+		}
+		PlaceLine(layout, run, first, lineStart, numShaped, y, ascent, bidi, &extraYOffset, &maxY);
+
+		layout->numGlyphs = first + numShaped;
+		maxX = max(lineMaxX, maxX);
+		y += lineYIncrement;
+		if (paragraphEnd < length && text[paragraphEnd] == L'\n')
+			AddLineInfo(layout, layout->numGlyphs, y);
+		paragraph = paragraphEnd + 1;
+	}
+
+	glyph_t* glyphs = layout->glyphs;
+
+	//Distance fields extend spread pixels past every glyph box, make room for them on all sides
+	if (spread > 0)
+	{
+		for (size_t i = 0; i < layout->numGlyphs; i++)
+		{
+			glyphs[i].offsetX += spread;
+			glyphs[i].width += spread * 2;
+			glyphs[i].height += spread * 2;
+		}
+		extraYOffset += spread;
+		maxX += spread * 2;
+		maxY += spread;
+	}
+
+	layout->extraYOffset = extraYOffset;
+	layout->width = (int)maxX;
+	layout->height = (int)maxY + extraYOffset;
+
+	//How far glyphs reach out of their own line, so rendering a range of lines knows which neighbours to include
+	for (size_t l = 0; l < layout->numLines; l++)
+	{
+		size_t end = l + 1 < layout->numLines ? layout->lines[l + 1].glyphStart : layout->numGlyphs;
+		int top = GetLineTop(layout, l), bottom = GetLineTop(layout, l + 1);
+		for (size_t i = layout->lines[l].glyphStart; i < end; i++)
+		{
+			if (glyphs[i].glyph < 0)
+				continue;
+			int glyphTop = glyphs[i].offsetY + extraYOffset;
+			layout->overhang = max(layout->overhang, top - glyphTop);
+			layout->overhang = max(layout->overhang, glyphTop + glyphs[i].height - bottom);
+		}
+	}
+	STATS_END(STAT_LAYOUT);
+}
+
+void FreeLayoutData(layout_t* layout)
+{
+	free(layout->glyphs);
+	free(layout->lines);
+	free(layout->scratch);
+	memset(layout, 0, sizeof(layout_t));
+}
+
+//Same as MeasureBitmap for text that is not null terminated, so callers can pass a slice of a larger buffer without copying
+EXPORT void MeasureBitmapN(int handle, utf16_t* text, int length, int fontSize, int* width, int* height, int* yOffset, int maxWidth, float lineSpacing)
+{
+	//In case the previous measurement was never rendered
+	FreeLayoutData(&lastLayout);
+	LockLibrary();
+	MeasureLayout(&lastLayout, handle, text, (size_t)max(length, 0), fontSize, maxWidth, lineSpacing, sdfSpread, wrapMode);
+	UnlockLibrary();
+
+	*width = lastLayout.width;
+	*height = lastLayout.height;
+	*yOffset = -lastLayout.extraYOffset;
+}
+
+//Same as MeasureBitmapN for length bytes of UTF-8, for callers that keep their strings as UTF-8. GenerateBitmap and the
+//other generating functions then render it as usual
+EXPORT void MeasureBitmapUtf8(int handle, const char* text, int length, int fontSize, int* width, int* height, int* yOffset, int maxWidth, float lineSpacing)
+{
+	//UTF-8 never takes fewer bytes than UTF-16 takes code units. The decoded text is a scratch buffer like the others
+	size_t size = (size_t)max(length, 0);
+	LockLibrary();
+	if (size > allocDecodedText)
+	{
+		allocDecodedText = max(size, allocDecodedText * 2);
+		decodedText = realloc(decodedText, sizeof(utf16_t) * allocDecodedText);
+	}
+
+	size_t count = DecodeUtf8((const unsigned char*)text, size, decodedText);
+	MeasureBitmapN(handle, decodedText, (int)count, fontSize, width, height, yOffset, maxWidth, lineSpacing);
+	UnlockLibrary();
+}
+
+EXPORT void MeasureBitmap(int handle, utf16_t* text, int fontSize, int* width, int* height, int* yOffset, int maxWidth, float lineSpacing)
+{
+	MeasureBitmapN(handle, text, (int)Utf16Length(text), fontSize, width, height, yOffset, maxWidth, lineSpacing);
+}
+
+void RenderLayoutSDF(layout_t* layout, const rasteroptions_t* options, unsigned char* emptyBitmap, int width)
+{
+	glyph_t* glyphs = layout->glyphs;
+	int spread = layout->sdfSpread;
+	sdfshape_t* shapes = malloc(sizeof(sdfshape_t) * max(layout->numGlyphs, 1));
+	int numShapes = 0;
+
+	for (size_t i = 0; i < layout->numGlyphs; i++)
+	{
+		if (glyphs[i].glyph >= 0)
+		{
+			int glyph = glyphs[i].glyph, ix0, iy0;
+			const stbtt_fontinfo* info = layout->fontInfos[glyphs[i].font];
+			float scale = layout->fontScales[glyphs[i].font];
+			stbtt_GetGlyphBitmapBox(info, glyph, scale, scale, &ix0, &iy0, NULL, NULL);
+
+			//offsetX and offsetY point to the unpadded box, the whole layout was moved by spread
+			if (CreateSDFShape(shapes + numShapes, info, glyph, scale, ix0, iy0, glyphs[i].offsetX - spread,
+				glyphs[i].offsetY + layout->extraYOffset - spread, glyphs[i].width, glyphs[i].height, spread, GetStbFlattening(options)))
+				numShapes++;
+			else
+				FreeSDFShape(shapes + numShapes);
+		}
+	}
+
+	GenerateSDF(shapes, numShapes, emptyBitmap, width, layout->height, spread);
+
+	for (int i = 0; i < numShapes; i++)
+		FreeSDFShape(shapes + i);
+	free(shapes);
+}
+
+void RenderLayout(layout_t* layout, const rasteroptions_t* options, unsigned char* emptyBitmap, int width)
+{
+	if (layout->sdfSpread > 0)
+	{
+		RenderLayoutSDF(layout, options, emptyBitmap, width);
+		return;
+	}
+
+	glyph_t* glyphs = layout->glyphs;
+	for (size_t i = 0; i < layout->numGlyphs; i++)
+	{
+		if (glyphs[i].glyph >= 0)
+			RasterizeGlyphClipped(options, layout->fontInfos[glyphs[i].font], layout->fontScales[glyphs[i].font], glyphs + i,
+				glyphs[i].offsetY + layout->extraYOffset, emptyBitmap, width, layout->height, width);
+	}
+}
+
+EXPORT void GenerateBitmap(int handle, unsigned char* emptyBitmap, int width)
+{
+	STATS_BEGIN(STAT_RENDER);
+	RenderLayout(&lastLayout, &rasterOptions, emptyBitmap, width);
+	FreeLayoutData(&lastLayout);
+	STATS_END(STAT_RENDER);
+}
+
+//Renders the last measured text straight into destination in the given format, rows are stride bytes apart
+//Every pixel of the bitmap is written so destination doesn't need to be cleared
+EXPORT void GenerateBitmapFormat(int handle, unsigned char* destination, int stride, int format, unsigned int color)
+{
+	layout_t* layout = &lastLayout;
+	int width = layout->width, height = layout->height;
+	STATS_BEGIN(STAT_RENDER);
+
+	//Alpha8 only needs clearing, the rasterizer writes with a stride
+	if (format == FORMAT_ALPHA8 && layout->sdfSpread == 0)
+	{
+		for (int y = 0; y < height; y++)
+			memset(destination + (size_t)y * stride, 0, width);
+
+		glyph_t* glyphs = layout->glyphs;
+		for (size_t i = 0; i < layout->numGlyphs; i++)
+		{
+			if (glyphs[i].glyph >= 0)
+				RasterizeGlyphClipped(&rasterOptions, layout->fontInfos[glyphs[i].font], layout->fontScales[glyphs[i].font], glyphs + i,
+					glyphs[i].offsetY + layout->extraYOffset, destination, width, height, stride);
+		}
+		FreeLayoutData(layout);
+		STATS_END(STAT_RENDER);
+		return;
+	}
+
+	//Distance fields are generated for the whole bitmap at once
+	if (layout->sdfSpread > 0)
+	{
+		unsigned char* alphas = calloc(max((size_t)width * height, 1), 1);
+		RenderLayout(layout, &rasterOptions, alphas, width);
+		ExpandBitmapRows(alphas, width, height, destination, stride, format, color);
+		free(alphas);
+		FreeLayoutData(layout);
+		STATS_END(STAT_RENDER);
+		return;
+	}
+
+	for (int y = 0; y < height; y++)
+		FillRow(destination + (size_t)y * stride, width, format, color);
+
+	//Each glyph is rasterized into scratch space the size of the glyph and expanded into place
+	int bytesPerPixel = GetBytesPerPixel(format);
+	glyph_t* glyphs = layout->glyphs;
+	for (size_t i = 0; i < layout->numGlyphs; i++)
+	{
+		if (glyphs[i].glyph < 0 || glyphs[i].width <= 0 || glyphs[i].height <= 0)
+			continue;
+
+		//Clipped to the bitmap like RasterizeGlyphClipped
+		int top = glyphs[i].offsetY + layout->extraYOffset;
+		int x0 = max(glyphs[i].offsetX, 0), y0 = max(top, 0);
+		int x1 = min(glyphs[i].offsetX + glyphs[i].width, width), y1 = min(top + glyphs[i].height, height);
+		if (x0 >= x1 || y0 >= y1)
+			continue;
+
+		unsigned char* scratch = RasterizeGlyphScratch(&rasterOptions, layout->fontInfos[glyphs[i].font], layout->fontScales[glyphs[i].font], glyphs + i, x0 - glyphs[i].offsetX, y0 - top,
+			x1 - glyphs[i].offsetX, y1 - top, &layout->scratch, &layout->scratchSize);
+		unsigned char* output = destination + (size_t)y0 * stride + (size_t)x0 * bytesPerPixel;
+		ExpandBitmapRows(scratch, x1 - x0, y1 - y0, output, stride, format, color);
+	}
+	FreeLayoutData(layout);
+	STATS_END(STAT_RENDER);
+}
+
+//Expands an alpha bitmap into another format without generating it again
+EXPORT void ExpandBitmap(unsigned char* alphas, int width, int height, unsigned char* destination, int stride, int format, unsigned int color)
+{
+	ExpandBitmapRows(alphas, width, height, destination, stride, format, color);
+}
+
+//Renders the last measured text into a region of a larger alpha buffer that is not cleared, such as a staging buffer
+//shared by many strings. Bitmap pixel (x, y) lands on destination pixel (originX + x, originY + y), rows are stride bytes
+//apart and only pixels inside the clip rectangle are touched. BLEND_REPLACE overwrites the area of the bitmap the way
+//GenerateBitmap fills a cleared buffer, BLEND_MAX and BLEND_ADD combine glyphs with what is already there
+EXPORT void GenerateBitmapInto(int handle, unsigned char* destination, int stride, int clipX, int clipY, int clipWidth, int clipHeight,
+	int originX, int originY, int blend)
+{
+	layout_t* layout = &lastLayout;
+	STATS_BEGIN(STAT_RENDER);
+
+	//Clip rectangle in bitmap coordinates
+	int cx0 = max(clipX - originX, 0), cy0 = max(clipY - originY, 0);
+	int cx1 = min(clipX + clipWidth - originX, layout->width), cy1 = min(clipY + clipHeight - originY, layout->height);
+	if (cx0 >= cx1 || cy0 >= cy1)
+	{
+		FreeLayoutData(layout);
+		STATS_END(STAT_RENDER);
+		return;
+	}
+
+	//Distance fields are generated for the whole bitmap at once
+	if (layout->sdfSpread > 0)
+	{
+		unsigned char* alphas = calloc((size_t)layout->width * layout->height, 1);
+		RenderLayout(layout, &rasterOptions, alphas, layout->width);
+		for (int y = cy0; y < cy1; y++)
+			BlendRow(destination + (size_t)(originY + y) * stride + originX + cx0, alphas + (size_t)y * layout->width + cx0, cx1 - cx0, blend);
+		free(alphas);
+		FreeLayoutData(layout);
+		STATS_END(STAT_RENDER);
+		return;
+	}
+
+	if (blend == BLEND_REPLACE)
+	{
+		for (int y = cy0; y < cy1; y++)
+			memset(destination + (size_t)(originY + y) * stride + originX + cx0, 0, cx1 - cx0);
+	}
+
+	glyph_t* glyphs = layout->glyphs;
+	for (size_t i = 0; i < layout->numGlyphs; i++)
+	{
+		glyph_t* glyph = glyphs + i;
+		if (glyph->glyph < 0 || glyph->width <= 0 || glyph->height <= 0)
+			continue;
+
+		int top = glyph->offsetY + layout->extraYOffset;
+		int x0 = max(glyph->offsetX, cx0), y0 = max(top, cy0);
+		int x1 = min(glyph->offsetX + glyph->width, cx1), y1 = min(top + glyph->height, cy1);
+		if (x0 >= x1 || y0 >= y1)
+			continue;
+
+		//Only the visible rows and columns are rasterized, replaced glyphs go straight into the destination
+		int gx0 = x0 - glyph->offsetX, gy0 = y0 - top, gx1 = x1 - glyph->offsetX, gy1 = y1 - top;
+		const stbtt_fontinfo* info = layout->fontInfos[glyph->font];
+		float scale = layout->fontScales[glyph->font];
+		if (blend == BLEND_REPLACE)
+		{
+			unsigned char* output = destination + (size_t)(originY + y0) * stride + originX + x0;
+			MakeGlyphBitmap(&rasterOptions, info, output, glyph->width, glyph->height, stride, scale, gx0, gy0, gx1, gy1, glyph->glyph);
+			continue;
+		}
+
+		unsigned char* scratch = RasterizeGlyphScratch(&rasterOptions, info, scale, glyph, gx0, gy0, gx1, gy1, &layout->scratch, &layout->scratchSize);
+		for (int y = y0; y < y1; y++)
+			BlendRow(destination + (size_t)(originY + y) * stride + originX + x0, scratch + (size_t)(y - y0) * (x1 - x0), x1 - x0, blend);
+	}
+	FreeLayoutData(layout);
+	STATS_END(STAT_RENDER);
+}
+
+//---------------------------------- LINE INDEX -----------------------------------
+//Returns a handle to a layout that is kept until FreeLayout so its lines can be rendered in any order
+EXPORT int CreateLayout(int handle, utf16_t* text, int fontSize, int maxWidth, float lineSpacing, int* width, int* height, int* yOffset)
+{
+	layout_t* layout = malloc(sizeof(layout_t));
+	LockLibrary();
+	MeasureLayout(layout, handle, text, Utf16Length(text), fontSize, maxWidth, lineSpacing, 0, wrapMode);
+	UnlockLibrary();
+
+	*width = layout->width;
+	*height = layout->height;
+	*yOffset = -layout->extraYOffset;
+
+	//Reuse a freed slot
+	for (size_t i = 0; i < numLayouts; i++)
+	{
+		if (layouts[i] == NULL)
+		{
+			layouts[i] = layout;
+			return (int)i;
+		}
+	}
+
+	layouts = realloc(layouts, sizeof(layout_t*) * ++numLayouts);
+	layouts[numLayouts - 1] = layout;
+	return (int)numLayouts - 1;
+}
+
+EXPORT int GetLayoutLineCount(int handle)
+{
+	return (int)layouts[handle]->numLines;
+}
+
+//Returns 0 if the line does not exist
+EXPORT int GetLayoutLine(int handle, int line, int* glyphStart, int* top, int* bottom)
+{
+	layout_t* layout = layouts[handle];
+	if (line < 0 || (size_t)line >= layout->numLines)
+		return 0;
+
+	*glyphStart = (int)layout->lines[line].glyphStart;
+	*top = GetLineTop(layout, line);
+	*bottom = GetLineTop(layout, line + 1);
+	return 1;
+}
+
+//Renders lines [firstLine, firstLine + lineCount) into a ring buffer of bufferHeight rows: bitmap row y goes to buffer
+//row y % bufferHeight. The rows of those lines are cleared first and glyphs of neighbouring lines are clipped to them,
+//so scrolling only needs the newly exposed lines and the rest of the buffer stays valid
+EXPORT void RenderLines(int handle, int firstLine, int lineCount, unsigned char* buffer, int width, int bufferHeight)
+{
+	layout_t* layout = layouts[handle];
+	glyph_t* glyphs = layout->glyphs;
+
+	size_t first = (size_t)max(firstLine, 0);
+	size_t last = min(first + (size_t)max(lineCount, 0), layout->numLines);
+	if (first >= last)
+		return;
+
+	STATS_BEGIN(STAT_RENDER);
+	int rowStart = GetLineTop(layout, first);
+	int rowEnd = min(GetLineTop(layout, last), rowStart + bufferHeight);
+	for (int row = rowStart; row < rowEnd; row++)
+		memset(buffer + (size_t)(row % bufferHeight) * width, 0, width);
+
+	//Include neighbouring lines whose glyphs reach into the rows
+	while (first > 0 && GetLineTop(layout, first) + layout->overhang > rowStart)
+		first--;
+	while (last < layout->numLines && GetLineTop(layout, last) - layout->overhang < rowEnd)
+		last++;
+
+	size_t end = last < layout->numLines ? layout->lines[last].glyphStart : layout->numGlyphs;
+	for (size_t i = layout->lines[first].glyphStart; i < end; i++)
+	{
+		glyph_t* glyph = glyphs + i;
+		if (glyph->glyph < 0 || glyph->width <= 0 || glyph->height <= 0)
+			continue;
+
+		int top = glyph->offsetY + layout->extraYOffset;
+		int y0 = max(top, rowStart), y1 = min(top + glyph->height, rowEnd);
+		int x0 = max(glyph->offsetX, 0), x1 = min(glyph->offsetX + glyph->width, width);
+		if (y0 >= y1 || x0 >= x1)
+			continue;
+
+		//Rasterize only the visible rows straight into the buffer, in two parts if they wrap around
+		for (int y = y0; y < y1;)
+		{
+			int wrapAt = min(y1, y - y % bufferHeight + bufferHeight);
+			unsigned char* output = buffer + (size_t)(y % bufferHeight) * width + x0;
+			float scale = layout->fontScales[glyph->font];
+			MakeGlyphBitmap(&rasterOptions, layout->fontInfos[glyph->font], output, glyph->width, glyph->height, width, scale,
+				x0 - glyph->offsetX, y - top, x1 - glyph->offsetX, wrapAt - top, glyph->glyph);
+			y = wrapAt;
+		}
+	}
+	STATS_END(STAT_RENDER);
+}
+
+EXPORT void FreeLayout(int handle)
+{
+	FreeLayoutData(layouts[handle]);
+	free(layouts[handle]);
+	layouts[handle] = NULL;
+}
+
+//-------------------------------- STREAMING LAYOUT -------------------------------
+//Measure the unfinished line further with the text that has arrived since the last call, returns the number of code
+//units that belong to it (including the line break) or 0 if more text is needed to tell where the line ends. Lines are
+//broken like MeasureLayout breaks them, but characters are only kerned and not shaped
+size_t MeasureLine(textstream_t* stream, int final, int* lineWidth)
+{
+	stbtt_fontinfo* info = &stream->font->info;
+	const utf16_t* text = stream->pending;
+	const unsigned char* flags = stream->pendingFlags;
+	size_t length = (size_t)(stream->classified - stream->pendingStart);
+	int base = stream->pendingStart;
+
+	glyph_t glyph;
+	for (size_t i = stream->measured - base, next; i < length; i = next)
+	{
+		next = i;
+		int codepoint = NextCodepoint(text, length, &next);
+		int lineBreak = GetLineBreakClass(codepoint);
+		int at = base + (int)i;
+
+		//A carriage return not followed by a line feed ends its line at the next character, other hard breaks end it
+		//right after them
+		if ((flags[i] & LINEBREAK_MANDATORY) && at > stream->lineStart)
+		{
+			*lineWidth = stream->lineMaxX;
+			return at - stream->lineStart;
+		}
+		if (lineBreak >= LB_BK)
+		{
+			stream->measured = base + (int)next;
+			if (lineBreak == LB_CR)
+				continue;
+			*lineWidth = stream->lineMaxX;
+			return stream->measured - stream->lineStart;
+		}
+
+		//Kerning needs the next character, which may not have arrived yet
+		if (!final && next == length)
+			return 0;
+
+		if (flags[i] & LINEBREAK_ALLOWED)
+		{
+			stream->breakAt = at;
+			stream->widthAtBreak = min(stream->lineMaxX, stream->maxWidth);
+		}
+		if (lineBreak != LB_CM && lineBreak != LB_ZWJ)
+		{
+			stream->clusterStart = at;
+			stream->widthAtCluster = min(stream->lineMaxX, stream->maxWidth);
+		}
+		PlaceCodepoint(info, stream->scale, codepoint, PeekCodepoint(text, length, next), &stream->x, &stream->lineMaxX, &glyph);
+		stream->measured = base + (int)next;
+
+		//Break at the last opportunity, or before the cluster that overflows. Spaces hang past the end of the line and
+		//a cluster wider than the line keeps it to itself
+		if (stream->lineMaxX > stream->maxWidth && !(flags[i] & LINEBREAK_SPACE))
+		{
+			if (stream->breakAt > stream->lineStart)
+			{
+				*lineWidth = stream->widthAtBreak;
+				return stream->breakAt - stream->lineStart;
+			}
+			if (stream->clusterStart > stream->lineStart)
+			{
+				*lineWidth = stream->widthAtCluster;
+				return stream->clusterStart - stream->lineStart;
+			}
+		}
+	}
+
+	if (!final || stream->measured == stream->lineStart)
+		return 0;
+
+	*lineWidth = stream->lineMaxX;
+	return stream->measured - stream->lineStart;
+}
+
+//Starts measuring the next line at the stream offset where the last one ended
+void StartStreamLine(textstream_t* stream, int start)
+{
+	stream->lineStart = start;
+	stream->measured = start;
+	stream->breakAt = start;
+	stream->clusterStart = start;
+	stream->x = 0;
+	stream->lineMaxX = 0;
+}
+
+void AddLineRecord(textstream_t* stream, size_t length, int width)
+{
+	if (stream->numLines == stream->allocLines)
+	{
+		stream->allocLines = stream->allocLines == 0 ? 256 : stream->allocLines * 2;
+		stream->lines = realloc(stream->lines, sizeof(linerecord_t) * stream->allocLines);
+	}
+
+	linerecord_t* line = stream->lines + stream->numLines++;
+	line->start = stream->lineStart;
+	line->length = (int)length;
+	line->width = width;
+}
+
+//Cut completed lines from the pending text, only the text after the last break opportunity or cluster of the unfinished
+//line is kept since the rest of it is never measured again
+void FlushLines(textstream_t* stream, int final)
+{
+	size_t length;
+	int width;
+	STATS_BEGIN(STAT_LAYOUT);
+
+	//Break flags only depend on the text before them, a high surrogate waits for the unit after it
+	for (size_t i = stream->classified - stream->pendingStart, next; i < stream->pendingLength; i = next)
+	{
+		if (!final && i + 1 == stream->pendingLength && (stream->pending[i] & 0xFC00) == 0xD800)
+			break;
+		next = i;
+		int codepoint = NextCodepoint(stream->pending, stream->pendingLength, &next);
+		stream->pendingFlags[i] = (unsigned char)NextLineBreak(&stream->lineBreak, GetLineBreakClass(codepoint));
+		if (next > i + 1)
+			stream->pendingFlags[i + 1] = 0;
+		stream->classified = stream->pendingStart + (int)next;
+	}
+
+	while ((length = MeasureLine(stream, final, &width)) != 0)
+	{
+		AddLineRecord(stream, length, width);
+		StartStreamLine(stream, stream->lineStart + (int)length);
+	}
+
+	int keep = stream->breakAt > stream->lineStart ? stream->breakAt : stream->clusterStart;
+	size_t consumed = (size_t)(keep - stream->pendingStart);
+	stream->pendingLength -= consumed;
+	stream->pendingStart = keep;
+	memmove(stream->pending, stream->pending + consumed, sizeof(utf16_t) * stream->pendingLength);
+	memmove(stream->pendingFlags, stream->pendingFlags + consumed, stream->pendingLength);
+	STATS_END(STAT_LAYOUT);
+}
+
+//Returns a handle to a new stream, text is then fed with AppendTextStream in chunks of any size. Returns -1 if the font
+//handle is invalid
+EXPORT int CreateTextStream(int handle, int fontSize, int maxWidth, float lineSpacing)
+{
+	LockLibrary();
+	if (handle < 0 || (size_t)handle >= numFonts)
+	{
+		UnlockLibrary();
+		return -1;
+	}
+
+	//Fonts are freed together with the streams, so the stream keeps its font and doesn't look at fonts again
+	textstream_t* stream = calloc(1, sizeof(textstream_t));
+	stream->font = fonts[handle];
+	stream->scale = stbtt_ScaleForPixelHeight(&stream->font->info, (float)fontSize);
+	stream->lineYIncrement = fontSize / 2 + fontSize / 2 * lineSpacing;
+	stream->maxWidth = maxWidth == 0 ? INT_MAX : maxWidth;
+	StartLineBreaks(&stream->lineBreak);
+
+	//Reuse a freed slot
+	size_t slot = 0;
+	while (slot < numStreams && streams[slot] != NULL)
+		slot++;
+	if (slot == numStreams)
+		streams = realloc(streams, sizeof(textstream_t*) * ++numStreams);
+	streams[slot] = stream;
+	UnlockLibrary();
+	return (int)slot;
+}
+
+//Only the unfinished last line is kept, returns the number of completed lines
+EXPORT int AppendTextStream(int handle, utf16_t* text, int length)
+{
+	textstream_t* stream = streams[handle];
+	if (stream->pendingLength + length > stream->allocPending)
+	{
+		stream->allocPending = max(stream->pendingLength + length, stream->allocPending * 2);
+		stream->pending = realloc(stream->pending, sizeof(utf16_t) * stream->allocPending);
+		stream->pendingFlags = realloc(stream->pendingFlags, stream->allocPending);
+	}
+	memcpy(stream->pending + stream->pendingLength, text, sizeof(utf16_t) * length);
+	stream->pendingLength += length;
+
+	FlushLines(stream, 0);
+	return (int)stream->numLines;
+}
+
+//Completes the last line, returns the total number of lines
+EXPORT int FinishTextStream(int handle)
+{
+	FlushLines(streams[handle], 1);
+	return (int)streams[handle]->numLines;
+}
+
+//Returns 0 if the line does not exist (yet)
+EXPORT int GetStreamLine(int handle, int line, int* start, int* length, int* width)
+{
+	textstream_t* stream = streams[handle];
+	if (line < 0 || (size_t)line >= stream->numLines)
+		return 0;
+
+	*start = stream->lines[line].start;
+	*length = stream->lines[line].length;
+	*width = stream->lines[line].width;
+	return 1;
+}
+
+EXPORT int GetStreamLineHeight(int handle)
+{
+	return (int)streams[handle]->lineYIncrement;
+}
+
+//Renders lines [firstLine, firstLine + lineCount) into a width * height buffer, glyphs outside it are clipped
+//text only needs to hold those lines, textStart is the stream offset of its first code unit
+EXPORT void RenderStreamWindow(int handle, utf16_t* text, int textStart, int firstLine, int lineCount, unsigned char* buffer, int width, int height)
+{
+	textstream_t* stream = streams[handle];
+	stbtt_fontinfo* info = &stream->font->info;
+	float ascent = stream->font->ascent * stream->scale;
+	STATS_BEGIN(STAT_RENDER);
+
+	int lastLine = min(firstLine + lineCount, (int)stream->numLines);
+	for (int l = max(firstLine, 0); l < lastLine; l++)
+	{
+		const utf16_t* line = text + (stream->lines[l].start - textStart);
+		size_t length = stream->lines[l].length;
+		float y = (l - firstLine) * stream->lineYIncrement;
+		float x = 0;
+		int lineMaxX;
+		glyph_t glyph;
+
+		for (size_t i = 0; i < length;)
+		{
+			int codepoint = NextCodepoint(line, length, &i);
+			if (GetLineBreakClass(codepoint) >= LB_BK) continue;
+
+			PlaceCodepoint(info, stream->scale, codepoint, PeekCodepoint(line, length, i), &x, &lineMaxX, &glyph);
+			glyph.offsetY += (int)(y + ascent);
+			if (glyph.width <= 0 || glyph.height <= 0)
+				continue;
+
+			//Glyphs on the edges of the window are only rasterized over their visible rows and columns
+			int x0 = max(glyph.offsetX, 0), y0 = max(glyph.offsetY, 0);
+			int x1 = min(glyph.offsetX + glyph.width, width), y1 = min(glyph.offsetY + glyph.height, height);
+			if (x0 >= x1 || y0 >= y1)
+				continue;
+
+			MakeGlyphBitmap(&rasterOptions, info, buffer + (size_t)y0 * width + x0, glyph.width, glyph.height, width, stream->scale,
+				x0 - glyph.offsetX, y0 - glyph.offsetY, x1 - glyph.offsetX, y1 - glyph.offsetY, glyph.glyph);
+		}
+	}
+	STATS_END(STAT_RENDER);
+}
+
+EXPORT void FreeTextStream(int handle)
+{
+	textstream_t* stream = streams[handle];
+	free(stream->lines);
+	free(stream->pending);
+	free(stream->pendingFlags);
+	free(stream);
+	streams[handle] = NULL;
+}
+
+//---------------------------------- RENDER QUEUE ---------------------------------
+//Jobs are kept in renderJobs from QueueRender or ScheduleRender until they are taken or cancelled, their slots are
+//reused but their handles aren't. Workers take the oldest pending job, lay it out under libraryLock and render it without the
+//lock, so jobs are rendered in parallel and the caller waits at most for a layout when it measures text itself
+renderjob_t** renderJobs = NULL;
+size_t numRenderJobs = 0;
+unsigned long long renderJobsQueued = 0;
+int nextRenderJobId = 0;
+thread_t renderWorkers[MAX_THREADS];
+int numRenderWorkers = 0;
+int renderWorkerCount = 0;
+int stopRenderWorkers = 0;
+
+//Scheduled jobs are held up to renderLatencyBudget nanoseconds, or until they have to start to be done by frameDeadline
+rendertarget_t* renderTargets = NULL;
+size_t numRenderTargets = 0;
+long long renderLatencyBudget = 0;
+long long frameDeadline = 0;
+
+//Returns the slot of a job in renderJobs, or numRenderJobs if the handle isn't a job. The queue must be locked
+size_t FindRenderJob(int job)
+{
+	size_t slot = 0;
+	while (slot < numRenderJobs && (renderJobs[slot] == NULL || renderJobs[slot]->id != job))
+		slot++;
+	return slot;
+}
+
+//Returns NULL if the handle isn't a job, the queue must be locked
+renderjob_t* GetRenderJob(int job)
+{
+	size_t slot = FindRenderJob(job);
+	return slot < numRenderJobs ? renderJobs[slot] : NULL;
+}
+
+//Returns NULL if nothing was scheduled for the target, the queue must be locked
+rendertarget_t* FindRenderTarget(int target)
+{
+	for (size_t i = 0; i < numRenderTargets; i++)
+	{
+		if (renderTargets[i].target == target)
+			return renderTargets + i;
+	}
+	return NULL;
+}
+
+//Takes a job out of renderJobs, its target no longer has it. The queue must be locked
+void RemoveRenderJob(int job)
+{
+	size_t slot = FindRenderJob(job);
+	rendertarget_t* target = FindRenderTarget(renderJobs[slot]->target);
+	if (target != NULL && target->job == job)
+		target->job = -1;
+	renderJobs[slot] = NULL;
+}
+
+//When a worker may start a job. Scheduled jobs are held for the latency budget, so newer text for their target can
+//replace them, but no longer than they can be if they are to be done by the frame deadline, taking as long as the last
+//render of their target did. The queue must be locked
+long long GetRenderJobStart(const renderjob_t* job)
+{
+	if (job->target < 0 || job->waited || stopRenderWorkers)
+		return 0;
+
+	//Deadlines that had passed when the text was scheduled are for frames long gone
+	long long start = job->requested + renderLatencyBudget;
+	if (frameDeadline > job->requested)
+	{
+		rendertarget_t* target = FindRenderTarget(job->target);
+		start = min(start, frameDeadline - (target != NULL ? target->renderTime : 0));
+	}
+	return start;
+}
+
+//The oldest job no worker has taken that may start at now, the queue must be locked. startAt is set to when the next
+//held job may start, or 0 if there is none
+renderjob_t* NextRenderJob(long long now, long long* startAt)
+{
+	renderjob_t* next = NULL;
+	*startAt = 0;
+	for (size_t i = 0; i < numRenderJobs; i++)
+	{
+		renderjob_t* job = renderJobs[i];
+		if (job == NULL || job->state != RENDER_JOB_PENDING)
+			continue;
+
+		long long start = GetRenderJobStart(job);
+		if (start > now)
+			*startAt = *startAt == 0 ? start : min(*startAt, start);
+		else if (next == NULL || job->order < next->order)
+			next = job;
+	}
+	return next;
+}
+
+void FreeRenderJob(renderjob_t* job)
+{
+	free(job->text);
+	free(job->bitmap);
+	free(job);
+}
+
+int IsRenderJobCancelled(renderjob_t* job)
+{
+	LockRenderQueue();
+	int cancelled = job->cancelled;
+	UnlockRenderQueue();
+	return cancelled;
+}
+
+//Whether handle is a loaded font, checked under libraryLock
+int IsFontLoaded(int handle)
+{
+	LockLibrary();
+	int loaded = handle >= 0 && (size_t)handle < numFonts;
+	UnlockLibrary();
+	return loaded;
+}
+
+//Runs without renderQueueLock. A cancelled job is left as soon as the next step would start
+void RunRenderJob(renderjob_t* job)
+{
+	if (IsRenderJobCancelled(job))
+		return;
+
+	//The fonts may have been freed since the job was queued, it is then done without a bitmap
+	layout_t layout;
+	LockLibrary();
+	if (job->handle < 0 || (size_t)job->handle >= numFonts)
+	{
+		UnlockLibrary();
+		job->width = job->height = job->yOffset = 0;
+		return;
+	}
+	MeasureLayout(&layout, job->handle, job->text, job->length, job->fontSize, job->maxWidth, job->lineSpacing, job->spread, job->wrapMode);
+	UnlockLibrary();
+
+	//Nobody else looks at the result until the job is done
+	job->width = layout.width;
+	job->height = layout.height;
+	job->yOffset = -layout.extraYOffset;
+	if (layout.width > 0 && layout.height > 0 && !IsRenderJobCancelled(job))
+	{
+		STATS_BEGIN(STAT_RENDER);
+		job->bitmap = calloc((size_t)layout.width * layout.height, 1);
+		RenderLayout(&layout, &job->raster, job->bitmap, layout.width);
+		STATS_END(STAT_RENDER);
+	}
+	FreeLayoutData(&layout);
+}
+
+//Marks a job that was run without renderQueueLock as done, started is when it was taken. A job that was cancelled or
+//freed meanwhile is no longer in renderJobs, it is freed instead. The queue must be locked
+void FinishRenderJob(renderjob_t* job, long long started)
+{
+	if (job->cancelled || GetRenderJob(job->id) != job)
+	{
+		FreeRenderJob(job);
+		return;
+	}
+
+	job->state = RENDER_JOB_DONE;
+	rendertarget_t* target = FindRenderTarget(job->target);
+	if (target != NULL)
+		target->renderTime = GetNanoseconds() - started;
+}
+
+//Runs jobs until the workers are stopped and no job is left, large glyphs are rasterized into buffers of the worker
+void RunRenderWorker()
+{
+	tiledrasterizer_t rasterizer;
+	memset(&rasterizer, 0, sizeof(tiledrasterizer_t));
+	workerRasterizer = &rasterizer;
+
+	LockRenderQueue();
+	for (;;)
+	{
+		long long now = GetNanoseconds(), startAt;
+		renderjob_t* job = NextRenderJob(now, &startAt);
+		if (job == NULL)
+		{
+			if (stopRenderWorkers)
+				break;
+			if (startAt != 0)
+				WaitConditionFor(&renderJobQueued, &renderQueueLock, (int)min((startAt - now + 999999) / 1000000, INT_MAX));
+			else
+				WaitCondition(&renderJobQueued, &renderQueueLock);
+			continue;
+		}
+
+		job->state = RENDER_JOB_RUNNING;
+		UnlockRenderQueue();
+		RunRenderJob(job);
+		LockRenderQueue();
+		FinishRenderJob(job, now);
+		WakeAllWaiting(&renderJobFinished);
+	}
+	UnlockRenderQueue();
+
+	workerRasterizer = NULL;
+	FreeTiledRasterizer(&rasterizer);
+}
+
+#ifdef _WIN32
+DWORD WINAPI RenderWorkerThread(LPVOID unused)
+{
+	RunRenderWorker();
+	return 0;
+}
+#else
+void* RenderWorkerThread(void* unused)
+{
+	RunRenderWorker();
+	return NULL;
+}
+#endif
+
+//Lets the workers finish the pending jobs and waits for them to exit, the next job queued starts them again
+void StopRenderWorkers()
+{
+	thread_t workers[MAX_THREADS];
+	LockRenderQueue();
+	int count = numRenderWorkers;
+	memcpy(workers, renderWorkers, sizeof(thread_t) * count);
+	numRenderWorkers = 0;
+	stopRenderWorkers = 1;
+	WakeAllWaiting(&renderJobQueued);
+	UnlockRenderQueue();
+
+	for (int i = 0; i < count; i++)
+		JoinThread(workers[i]);
+
+	LockRenderQueue();
+	stopRenderWorkers = 0;
+	UnlockRenderQueue();
+}
+
+void FreeRenderJobs()
+{
+	//Running jobs are freed by their workers
+	LockRenderQueue();
+	for (size_t i = 0; i < numRenderJobs; i++)
+	{
+		renderjob_t* job = renderJobs[i];
+		if (job != NULL && job->state == RENDER_JOB_RUNNING)
+			job->cancelled = 1;
+		else if (job != NULL)
+			FreeRenderJob(job);
+	}
+	free(renderJobs);
+	renderJobs = NULL;
+	numRenderJobs = 0;
+	free(renderTargets);
+	renderTargets = NULL;
+	numRenderTargets = 0;
+	frameDeadline = 0;
+	UnlockRenderQueue();
+
+	StopRenderWorkers();
+}
+
+//Copies the text to render and the settings to render it with into a job
+void SetRenderJobText(renderjob_t* job, int handle, const utf16_t* text, int length, int fontSize, int maxWidth, float lineSpacing, int spread)
+{
+	job->handle = handle;
+	job->length = (size_t)max(length, 0);
+	job->text = realloc(job->text, sizeof(utf16_t) * max(job->length, 1));
+	memcpy(job->text, text, sizeof(utf16_t) * job->length);
+	job->fontSize = fontSize;
+	job->maxWidth = maxWidth;
+	job->lineSpacing = lineSpacing;
+	job->spread = max(spread, 0);
+	job->wrapMode = wrapMode;
+	job->raster = rasterOptions;
+}
+
+//Puts a new job into renderJobs and starts the workers if they aren't running, the queue must be locked. Returns the
+//job's handle
+int AddRenderJob(renderjob_t* job)
+{
+	job->state = RENDER_JOB_PENDING;
+	job->order = renderJobsQueued++;
+	job->id = nextRenderJobId;
+	nextRenderJobId = nextRenderJobId < INT_MAX ? nextRenderJobId + 1 : 0;
+
+	//Reuse a freed slot
+	size_t slot = 0;
+	while (slot < numRenderJobs && renderJobs[slot] != NULL)
+		slot++;
+	if (slot == numRenderJobs)
+		renderJobs = realloc(renderJobs, sizeof(renderjob_t*) * ++numRenderJobs);
+	renderJobs[slot] = job;
+
+	int count = renderWorkerCount > 0 ? renderWorkerCount : max(GetNumCores() - 1, 1);
+	while (numRenderWorkers < count && StartThread(&renderWorkers[numRenderWorkers], RenderWorkerThread, NULL))
+		numRenderWorkers++;
+
+	//Without a worker the job is run before returning, it may be cancelled or freed meanwhile
+	int id = job->id;
+	if (numRenderWorkers == 0)
+	{
+		long long started = GetNanoseconds();
+		job->state = RENDER_JOB_RUNNING;
+		UnlockRenderQueue();
+		RunRenderJob(job);
+		LockRenderQueue();
+		FinishRenderJob(job, started);
+		WakeAllWaiting(&renderJobFinished);
+	}
+	WakeAllWaiting(&renderJobQueued);
+	return id;
+}
+
+//Queues text to be measured and rendered by a worker thread as MeasureBitmapN and GenerateBitmap would with the current
+//wrap mode, as coverage if spread is 0 or as a distance field reaching spread pixels. The text is copied. Returns a
+//handle for GetRenderStatus, TakeRender and CancelRender, or -1 if the font handle is invalid
+EXPORT int QueueRender(int handle, const utf16_t* text, int length, int fontSize, int maxWidth, float lineSpacing, int spread)
+{
+	if (!IsFontLoaded(handle))
+		return -1;
+
+	renderjob_t* job = calloc(1, sizeof(renderjob_t));
+	SetRenderJobText(job, handle, text, length, fontSize, maxWidth, lineSpacing, spread);
+	job->target = -1;
+
+	LockRenderQueue();
+	int id = AddRenderJob(job);
+	UnlockRenderQueue();
+	return id;
+}
+
+//Same as QueueRender for a target, such as a text field, that only needs its newest text rendered. Targets are numbers
+//the caller picks and can't be negative. Text scheduled before for the target is replaced if no worker has started on
+//it, and the job keeps its handle. Otherwise a new job is queued, and the old one is cancelled if it is running or
+//dropped if its bitmap wasn't taken. Returns the target's job, or -1 if the target or the font handle is invalid
+EXPORT int ScheduleRender(int target, int handle, const utf16_t* text, int length, int fontSize, int maxWidth, float lineSpacing, int spread)
+{
+	if (target < 0 || !IsFontLoaded(handle))
+		return -1;
+
+	LockRenderQueue();
+	rendertarget_t* renderTarget = FindRenderTarget(target);
+	if (renderTarget == NULL)
+	{
+		renderTargets = realloc(renderTargets, sizeof(rendertarget_t) * ++numRenderTargets);
+		renderTarget = renderTargets + numRenderTargets - 1;
+		renderTarget->target = target;
+		renderTarget->job = -1;
+		renderTarget->renderTime = 0;
+	}
+
+	int id = renderTarget->job;
+	renderjob_t* job = GetRenderJob(id);
+	if (job != NULL && job->state == RENDER_JOB_PENDING)
+	{
+		SetRenderJobText(job, handle, text, length, fontSize, maxWidth, lineSpacing, spread);
+		UnlockRenderQueue();
+		return id;
+	}
+
+	if (job != NULL)
+	{
+		RemoveRenderJob(id);
+		if (job->state == RENDER_JOB_RUNNING)
+			job->cancelled = 1;
+		else
+			FreeRenderJob(job);
+	}
+
+	job = calloc(1, sizeof(renderjob_t));
+	SetRenderJobText(job, handle, text, length, fontSize, maxWidth, lineSpacing, spread);
+	job->target = target;
+	job->requested = GetNanoseconds();
+	id = AddRenderJob(job);
+
+	//Found again, the target may have moved or been freed while AddRenderJob ran the job without the lock
+	renderTarget = FindRenderTarget(target);
+	if (renderTarget != NULL)
+		renderTarget->job = id;
+	UnlockRenderQueue();
+	return id;
+}
+
+//Scheduled jobs wait up to microseconds (0 by default) before a worker starts them, so text that keeps changing in a
+//burst, such as while a window is resized, is rendered once it stops changing instead of for every change
+EXPORT void SetRenderLatencyBudget(int microseconds)
+{
+	LockRenderQueue();
+	renderLatencyBudget = (long long)max(microseconds, 0) * 1000;
+	WakeAllWaiting(&renderJobQueued);
+	UnlockRenderQueue();
+}
+
+//Hints that the textures of the next frame are needed in microseconds, 0 removes the hint. Scheduled jobs then wait no
+//longer than they can to be done by then, assuming they take as long as the last render of their target
+EXPORT void SetFrameDeadline(int microseconds)
+{
+	LockRenderQueue();
+	frameDeadline = microseconds > 0 ? GetNanoseconds() + (long long)microseconds * 1000 : 0;
+	WakeAllWaiting(&renderJobQueued);
+	UnlockRenderQueue();
+}
+
+//Cancels the job of a target and forgets the target
+EXPORT void FreeRenderTarget(int target)
+{
+	LockRenderQueue();
+	rendertarget_t* renderTarget = FindRenderTarget(target);
+	if (renderTarget != NULL)
+	{
+		renderjob_t* job = GetRenderJob(renderTarget->job);
+		if (job != NULL)
+		{
+			RemoveRenderJob(renderTarget->job);
+			if (job->state == RENDER_JOB_RUNNING)
+				job->cancelled = 1;
+			else
+				FreeRenderJob(job);
+		}
+		*renderTarget = renderTargets[--numRenderTargets];
+	}
+	UnlockRenderQueue();
+}
+
+//Returns RENDER_JOB_PENDING, RENDER_JOB_RUNNING or RENDER_JOB_DONE, or RENDER_JOB_INVALID for handles that were taken,
+//cancelled or never queued. Once the job is done, width, height and yOffset are set as MeasureBitmap sets them
+EXPORT int GetRenderStatus(int job, int* width, int* height, int* yOffset)
+{
+	LockRenderQueue();
+	renderjob_t* renderJob = GetRenderJob(job);
+	int state = renderJob != NULL ? renderJob->state : RENDER_JOB_INVALID;
+	if (state == RENDER_JOB_DONE)
+	{
+		*width = renderJob->width;
+		*height = renderJob->height;
+		*yOffset = renderJob->yOffset;
+	}
+	UnlockRenderQueue();
+	return state;
+}
+
+//Waits until the job is done, for example on a loading screen, and returns its status. A scheduled job is no longer held
+EXPORT int WaitRender(int job)
+{
+	LockRenderQueue();
+	renderjob_t* renderJob = GetRenderJob(job);
+	if (renderJob != NULL && !renderJob->waited)
+	{
+		renderJob->waited = 1;
+		WakeAllWaiting(&renderJobQueued);
+	}
+	while ((renderJob = GetRenderJob(job)) != NULL && renderJob->state != RENDER_JOB_DONE)
+		WaitCondition(&renderJobFinished, &renderQueueLock);
+	int state = renderJob != NULL ? renderJob->state : RENDER_JOB_INVALID;
+	UnlockRenderQueue();
+	return state;
+}
+
+//Copies the bitmap of a finished job into width * height bytes of destination and frees the job. Returns 0 and keeps
+//the job if it isn't done
+EXPORT int TakeRender(int job, unsigned char* destination)
+{
+	LockRenderQueue();
+	renderjob_t* renderJob = GetRenderJob(job);
+	if (renderJob == NULL || renderJob->state != RENDER_JOB_DONE)
+	{
+		UnlockRenderQueue();
+		return 0;
+	}
+	RemoveRenderJob(job);
+	UnlockRenderQueue();
+
+	if (renderJob->bitmap != NULL)
+		memcpy(destination, renderJob->bitmap, (size_t)renderJob->width * renderJob->height);
+	FreeRenderJob(renderJob);
+	return 1;
+}
+
+//Drops a job whose result is no longer wanted, such as the render for a window size that has changed again. A pending
+//job never runs, a running one stops before its next step and a finished one is freed
+EXPORT void CancelRender(int job)
+{
+	LockRenderQueue();
+	renderjob_t* renderJob = GetRenderJob(job);
+	if (renderJob != NULL)
+	{
+		RemoveRenderJob(job);
+		if (renderJob->state == RENDER_JOB_RUNNING)
+			renderJob->cancelled = 1;
+		else
+			FreeRenderJob(renderJob);
+	}
+	UnlockRenderQueue();
+}
+
+//Number of worker threads for queued jobs, up to MAX_THREADS. 0 (default) uses one less than the number of cores and at
+//least one. Waits for the pending jobs, the next job queued starts the new workers
+EXPORT void SetRenderWorkers(int count)
+{
+	StopRenderWorkers();
+	LockRenderQueue();
+	renderWorkerCount = min(max(count, 0), MAX_THREADS);
+	UnlockRenderQueue();
+}
+
+//---------------------------------- STATISTICS -----------------------------------
+//Writes up to count values, calls and nanoseconds of every phase followed by the counters in the order of stats.h
+//Returns the number of values there are, 0 if the library was built without SFL_STATS
+EXPORT int GetStats(long long* values, int count)
+{
+#ifdef SFL_STATS
+	return CollectStats(values, count);
+#else
+	return 0;
+#endif
+}
+
+EXPORT void ResetStats()
+{
+#ifdef SFL_STATS
+	ClearStats();
+#endif
+}
+
+//Starts or stops recording the phases as trace events
+EXPORT void SetStatsTracing(int enabled)
+{
+#ifdef SFL_STATS
+	statsTracing = enabled;
+#endif
+}
+
+//Writes the recorded trace events as Chrome trace JSON, returns the number of events or FILE_NOT_FOUND if the file can't be created
+EXPORT int WriteStatsTrace(utf16_t* filename)
+{
+#ifdef SFL_STATS
+	FILE* file = OpenFileUtf16(filename, "wb");
+	if (file == NULL)
+		return FILE_NOT_FOUND;
+	int written = WriteTrace(file);
+	fclose(file);
+	return written;
+#else
+	return 0;
+#endif
+}
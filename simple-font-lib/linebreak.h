@@ -0,0 +1,373 @@
+#ifndef LINEBREAK_H
+#define LINEBREAK_H
+
+#include <string.h>
+
+//Line breaking classes of UAX #14 after LB1: AI, SA, SG and XX are letters, CJ is a nonstarter, Hangul and emoji bases
+//are ideographs and emoji modifiers and the marks of SA scripts are combining marks. The first LB_NUM_PAIRS classes are
+//looked up in the pair table, hard breaks come last
+enum
+{
+	LB_OP, LB_CL, LB_CP, LB_QU, LB_GL, LB_NS, LB_EX, LB_SY, LB_IS, LB_PR, LB_PO, LB_NU,
+	LB_AL, LB_HL, LB_ID, LB_IN, LB_HY, LB_BA, LB_BB, LB_B2, LB_ZW, LB_WJ, LB_CB, LB_RI,
+	LB_NUM_PAIRS,
+	LB_SP = LB_NUM_PAIRS, LB_CM, LB_ZWJ,
+	LB_BK, LB_CR, LB_LF, LB_NL,
+	LB_NONE = -1
+};
+
+//Flags of a code unit
+enum
+{
+	LINEBREAK_ALLOWED = 1, //A line may start here
+	LINEBREAK_MANDATORY = 2, //A line must start here
+	LINEBREAK_SPACE = 4 //Hangs past the end of a line
+};
+
+//Classes of LineBreak.txt (Unicode 14) as ranges, each entry is the first codepoint of a range shifted left by 5 and
+//its class. A range ends where the next one starts
+const unsigned int lineBreakClasses[] =
+{
+	0x00000019, 0x00000131, 0x0000015D, 0x0000017B, 0x000001BC, 0x000001D9, 0x00000418, 0x00000426,
+	0x00000443, 0x0000046C, 0x00000489, 0x000004AA, 0x000004CC, 0x000004E3, 0x00000500, 0x00000522,
+	0x0000054C, 0x00000569, 0x00000588, 0x000005B0, 0x000005C8, 0x000005E7, 0x0000060B, 0x00000748,
+	0x0000078C, 0x000007E6, 0x0000080C, 0x00000B60, 0x00000B89, 0x00000BA2, 0x00000BCC, 0x00000F60,
+	0x00000F91, 0x00000FA1, 0x00000FCC, 0x00000FF9, 0x000010BE, 0x000010D9, 0x00001404, 0x00001420,
+	0x0000144A, 0x00001469, 0x000014CC, 0x00001563, 0x0000158C, 0x000015B1, 0x000015CC, 0x0000160A,
+	0x00001629, 0x0000164C, 0x00001692, 0x000016AC, 0x00001763, 0x0000178C, 0x000017E0, 0x0000180C,
+	0x00005912, 0x0000592C, 0x00005992, 0x000059AC, 0x00005BF2, 0x00005C0C, 0x00006019, 0x000069E4,
+	0x00006A19, 0x00006B84, 0x00006C79, 0x00006E0C, 0x00006FC8, 0x00006FEC, 0x00009079, 0x0000914C,
+	0x0000B128, 0x0000B151, 0x0000B16C, 0x0000B1E9, 0x0000B20C, 0x0000B239, 0x0000B7D1, 0x0000B7F9,
+	0x0000B80C, 0x0000B839, 0x0000B86C, 0x0000B899, 0x0000B8C6, 0x0000B8F9, 0x0000B90C, 0x0000BA0D,
+	0x0000BD6C, 0x0000BDED, 0x0000BE6C, 0x0000C12A, 0x0000C188, 0x0000C1CC, 0x0000C219, 0x0000C366,
+	0x0000C399, 0x0000C3A6, 0x0000C40C, 0x0000C979, 0x0000CC0B, 0x0000CD4A, 0x0000CD6B, 0x0000CDAC,
+	0x0000CE19, 0x0000CE2C, 0x0000DA86, 0x0000DAAC, 0x0000DAD9, 0x0000DBAC, 0x0000DBF9, 0x0000DCAC,
+	0x0000DCF9, 0x0000DD2C, 0x0000DD59, 0x0000DDCC, 0x0000DE0B, 0x0000DF4C, 0x0000E239, 0x0000E24C,
+	0x0000E619, 0x0000E96C, 0x0000F4D9, 0x0000F62C, 0x0000F80B, 0x0000F94C, 0x0000FD79, 0x0000FE8C,
+	0x0000FF08, 0x0000FF26, 0x0000FF4C, 0x0000FFB9, 0x0000FFC9, 0x0001000C, 0x000102D9, 0x0001034C,
+	0x00010379, 0x0001048C, 0x000104B9, 0x0001050C, 0x00010539, 0x000105CC, 0x00010B39, 0x00010B8C,
+	0x00011319, 0x0001140C, 0x00011959, 0x00011C4C, 0x00011C79, 0x0001208C, 0x00012759, 0x000127AC,
+	0x000127D9, 0x00012A0C, 0x00012A39, 0x00012B0C, 0x00012C59, 0x00012C91, 0x00012CCB, 0x00012E0C,
+	0x00013039, 0x0001308C, 0x00013799, 0x000137AC, 0x000137D9, 0x000138AC, 0x000138F9, 0x0001392C,
+	0x00013979, 0x000139CC, 0x00013AF9, 0x00013B0C, 0x00013C59, 0x00013C8C, 0x00013CCB, 0x00013E0C,
+	0x00013E4A, 0x00013E8C, 0x00013F2A, 0x00013F4C, 0x00013F69, 0x00013F8C, 0x00013FD9, 0x00013FEC,
+	0x00014039, 0x0001408C, 0x00014799, 0x000147AC, 0x000147D9, 0x0001486C, 0x000148F9, 0x0001492C,
+	0x00014979, 0x000149CC, 0x00014A39, 0x00014A4C, 0x00014CCB, 0x00014E19, 0x00014E4C, 0x00014EB9,
+	0x00014ECC, 0x00015039, 0x0001508C, 0x00015799, 0x000157AC, 0x000157D9, 0x000158CC, 0x000158F9,
+	0x0001594C, 0x00015979, 0x000159CC, 0x00015C59, 0x00015C8C, 0x00015CCB, 0x00015E0C, 0x00015E29,
+	0x00015E4C, 0x00015F59, 0x0001600C, 0x00016039, 0x0001608C, 0x00016799, 0x000167AC, 0x000167D9,
+	0x000168AC, 0x000168F9, 0x0001692C, 0x00016979, 0x000169CC, 0x00016AB9, 0x00016B0C, 0x00016C59,
+	0x00016C8C, 0x00016CCB, 0x00016E0C, 0x00017059, 0x0001706C, 0x000177D9, 0x0001786C, 0x000178D9,
+	0x0001792C, 0x00017959, 0x000179CC, 0x00017AF9, 0x00017B0C, 0x00017CCB, 0x00017E0C, 0x00017F29,
+	0x00017F4C, 0x00018019, 0x000180AC, 0x00018799, 0x000187AC, 0x000187D9, 0x000188AC, 0x000188D9,
+	0x0001892C, 0x00018959, 0x000189CC, 0x00018AB9, 0x00018AEC, 0x00018C59, 0x00018C8C, 0x00018CCB,
+	0x00018E0C, 0x00018EF2, 0x00018F0C, 0x00019039, 0x00019092, 0x000190AC, 0x00019799, 0x000197AC,
+	0x000197D9, 0x000198AC, 0x000198D9, 0x0001992C, 0x00019959, 0x000199CC, 0x00019AB9, 0x00019AEC,
+	0x00019C59, 0x00019C8C, 0x00019CCB, 0x00019E0C, 0x0001A019, 0x0001A08C, 0x0001A779, 0x0001A7AC,
+	0x0001A7D9, 0x0001A8AC, 0x0001A8D9, 0x0001A92C, 0x0001A959, 0x0001A9CC, 0x0001AAF9, 0x0001AB0C,
+	0x0001AC59, 0x0001AC8C, 0x0001ACCB, 0x0001AE0C, 0x0001AF2A, 0x0001AF4C, 0x0001B039, 0x0001B08C,
+	0x0001B959, 0x0001B96C, 0x0001B9F9, 0x0001BAAC, 0x0001BAD9, 0x0001BAEC, 0x0001BB19, 0x0001BC0C,
+	0x0001BCCB, 0x0001BE0C, 0x0001BE59, 0x0001BE8C, 0x0001C639, 0x0001C64C, 0x0001C699, 0x0001C76C,
+	0x0001C7E9, 0x0001C80C, 0x0001C8F9, 0x0001C9EC, 0x0001CA0B, 0x0001CB51, 0x0001CB8C, 0x0001D639,
+	0x0001D64C, 0x0001D699, 0x0001D7AC, 0x0001D919, 0x0001D9CC, 0x0001DA0B, 0x0001DB4C, 0x0001E032,
+	0x0001E0AC, 0x0001E0D2, 0x0001E104, 0x0001E132, 0x0001E171, 0x0001E184, 0x0001E1A6, 0x0001E244,
+	0x0001E26C, 0x0001E286, 0x0001E2AC, 0x0001E319, 0x0001E34C, 0x0001E40B, 0x0001E54C, 0x0001E691,
+	0x0001E6B9, 0x0001E6CC, 0x0001E6F9, 0x0001E70C, 0x0001E739, 0x0001E740, 0x0001E761, 0x0001E780,
+	0x0001E7A1, 0x0001E7D9, 0x0001E80C, 0x0001EE39, 0x0001EFF1, 0x0001F019, 0x0001F0B1, 0x0001F0D9,
+	0x0001F10C, 0x0001F1B9, 0x0001F30C, 0x0001F339, 0x0001F7AC, 0x0001F7D1, 0x0001F80C, 0x0001F8D9,
+	0x0001F8EC, 0x0001FA12, 0x0001FA51, 0x0001FA72, 0x0001FA8C, 0x0001FB24, 0x0001FB6C, 0x00020579,
+	0x000207EC, 0x0002080B, 0x00020951, 0x0002098C, 0x00020AD9, 0x00020B4C, 0x00020BD9, 0x00020C2C,
+	0x00020C59, 0x00020CAC, 0x00020CF9, 0x00020DCC, 0x00020E39, 0x00020EAC, 0x00021059, 0x000211CC,
+	0x000211F9, 0x0002120B, 0x00021359, 0x000213CC, 0x0002200E, 0x0002400C, 0x00026BB9, 0x00026C0C,
+	0x00026C31, 0x00026C4C, 0x00028011, 0x0002802C, 0x0002D011, 0x0002D02C, 0x0002D360, 0x0002D381,
+	0x0002D3AC, 0x0002DD71, 0x0002DDCC, 0x0002E259, 0x0002E2CC, 0x0002E659, 0x0002E6B1, 0x0002E6EC,
+	0x0002EA59, 0x0002EA8C, 0x0002EE59, 0x0002EE8C, 0x0002F699, 0x0002FA91, 0x0002FAC5, 0x0002FAEC,
+	0x0002FB11, 0x0002FB2C, 0x0002FB51, 0x0002FB69, 0x0002FB8C, 0x0002FBB9, 0x0002FBCC, 0x0002FC0B,
+	0x0002FD4C, 0x00030046, 0x00030091, 0x000300D2, 0x000300EC, 0x00030106, 0x0003014C, 0x00030179,
+	0x000301C4, 0x000301F9, 0x0003020B, 0x0003034C, 0x000310B9, 0x000310EC, 0x00031539, 0x0003154C,
+	0x00032419, 0x0003258C, 0x00032619, 0x0003278C, 0x00032886, 0x000328CB, 0x00032A0C, 0x00033A0B,
+	0x00033B4C, 0x000342F9, 0x0003438C, 0x00034AB9, 0x00034BEC, 0x00034C19, 0x00034FAC, 0x00034FF9,
+	0x0003500B, 0x0003514C, 0x0003520B, 0x0003534C, 0x00035619, 0x000359EC, 0x00036019, 0x000360AC,
+	0x00036699, 0x000368AC, 0x00036A0B, 0x00036B51, 0x00036B8C, 0x00036BB1, 0x00036C2C, 0x00036D79,
+	0x00036E8C, 0x00036FB1, 0x00036FEC, 0x00037019, 0x0003706C, 0x00037439, 0x000375CC, 0x0003760B,
+	0x0003774C, 0x00037CD9, 0x00037E8C, 0x00038499, 0x0003870C, 0x00038771, 0x0003880B, 0x0003894C,
+	0x00038A0B, 0x00038B4C, 0x00038FD1, 0x0003900C, 0x00039A19, 0x00039A6C, 0x00039A99, 0x00039D2C,
+	0x00039DB9, 0x00039DCC, 0x00039E99, 0x00039EAC, 0x00039EF9, 0x00039F4C, 0x0003B819, 0x0003C00C,
+	0x0003FFB2, 0x0003FFCC, 0x00040011, 0x000400E4, 0x00040111, 0x00040174, 0x00040199, 0x000401BA,
+	0x000401D9, 0x00040211, 0x00040224, 0x00040251, 0x00040293, 0x000402AC, 0x00040303, 0x00040340,
+	0x00040363, 0x000403C0, 0x000403E3, 0x0004040C, 0x0004048F, 0x000404F1, 0x0004051B, 0x00040559,
+	0x000405E4, 0x0004060A, 0x0004070C, 0x00040723, 0x0004076C, 0x00040785, 0x000407CC, 0x00040888,
+	0x000408A0, 0x000408C1, 0x000408E5, 0x0004094C, 0x00040AD1, 0x00040AEC, 0x00040B11, 0x00040B8C,
+	0x00040BB1, 0x00040C15, 0x00040C2C, 0x00040CD9, 0x00040E0C, 0x00040FA0, 0x00040FC1, 0x00040FEC,
+	0x000411A0, 0x000411C1, 0x000411EC, 0x00041409, 0x000414EA, 0x00041509, 0x000416CA, 0x000416E9,
+	0x0004176A, 0x00041789, 0x000417CA, 0x000417E9, 0x0004180A, 0x00041829, 0x00041A19, 0x00041E2C,
+	0x0004206A, 0x0004208C, 0x0004212A, 0x0004214C, 0x000422C9, 0x000422EC, 0x00044249, 0x0004428C,
+	0x00045DEF, 0x00045E0C, 0x00046100, 0x00046121, 0x00046140, 0x00046161, 0x0004618C, 0x0004634E,
+	0x0004638C, 0x00046520, 0x00046541, 0x0004656C, 0x00047E0E, 0x00047E8C, 0x0004C00E, 0x0004C08C,
+	0x0004C28E, 0x0004C2CC, 0x0004C30E, 0x0004C32C, 0x0004C34E, 0x0004C40C, 0x0004C72E, 0x0004C78C,
+	0x0004CD0E, 0x0004CD2C, 0x0004CFEE, 0x0004D00C, 0x0004D7AE, 0x0004D92C, 0x0004D9AE, 0x0004D9CC,
+	0x0004D9EE, 0x0004DA4C, 0x0004DA6E, 0x0004DAAC, 0x0004DB0E, 0x0004DB4C, 0x0004DB8E, 0x0004DBAC,
+	0x0004DBEE, 0x0004DC4C, 0x0004DD4E, 0x0004DD6C, 0x0004DE2E, 0x0004DECC, 0x0004DEEE, 0x0004DF6C,
+	0x0004DFAE, 0x0004E0AC, 0x0004E10E, 0x0004E1CC, 0x0004EB63, 0x0004EC2C, 0x0004EC46, 0x0004EC8E,
+	0x0004ECAC, 0x0004ED00, 0x0004ED21, 0x0004ED40, 0x0004ED61, 0x0004ED80, 0x0004EDA1, 0x0004EDC0,
+	0x0004EDE1, 0x0004EE00, 0x0004EE21, 0x0004EE40, 0x0004EE61, 0x0004EE80, 0x0004EEA1, 0x0004EECC,
+	0x0004F8A0, 0x0004F8C1, 0x0004F8EC, 0x0004FCC0, 0x0004FCE1, 0x0004FD00, 0x0004FD21, 0x0004FD40,
+	0x0004FD61, 0x0004FD80, 0x0004FDA1, 0x0004FDC0, 0x0004FDE1, 0x0004FE0C, 0x00053060, 0x00053081,
+	0x000530A0, 0x000530C1, 0x000530E0, 0x00053101, 0x00053120, 0x00053141, 0x00053160, 0x00053181,
+	0x000531A0, 0x000531C1, 0x000531E0, 0x00053201, 0x00053220, 0x00053241, 0x00053260, 0x00053281,
+	0x000532A0, 0x000532C1, 0x000532E0, 0x00053301, 0x0005332C, 0x00053B00, 0x00053B21, 0x00053B40,
+	0x00053B61, 0x00053B8C, 0x00053F80, 0x00053FA1, 0x00053FCC, 0x00059DF9, 0x00059E4C, 0x00059F26,
+	0x00059F51, 0x00059FAC, 0x00059FC6, 0x00059FF1, 0x0005A00C, 0x0005AE11, 0x0005AE2C, 0x0005AFF9,
+	0x0005B00C, 0x0005BC19, 0x0005C003, 0x0005C1D1, 0x0005C2CC, 0x0005C2F1, 0x0005C300, 0x0005C331,
+	0x0005C34C, 0x0005C383, 0x0005C3CC, 0x0005C403, 0x0005C440, 0x0005C461, 0x0005C480, 0x0005C4A1,
+	0x0005C4C0, 0x0005C4E1, 0x0005C500, 0x0005C521, 0x0005C551, 0x0005C5C6, 0x0005C5EC, 0x0005C611,
+	0x0005C64C, 0x0005C671, 0x0005C6AC, 0x0005C753, 0x0005C791, 0x0005C7EC, 0x0005C811, 0x0005C840,
+	0x0005C871, 0x0005C96C, 0x0005C991, 0x0005C9AC, 0x0005C9D1, 0x0005CA0C, 0x0005CA66, 0x0005CAA0,
+	0x0005CAC1, 0x0005CAE0, 0x0005CB01, 0x0005CB20, 0x0005CB41, 0x0005CB60, 0x0005CB81, 0x0005CBB1,
+	0x0005CBCC, 0x0005D00E, 0x0005D34C, 0x0005D36E, 0x0005DE8C, 0x0005E00E, 0x0005FACC, 0x0005FE0E,
+	0x0005FF8C, 0x00060011, 0x00060021, 0x0006006E, 0x000600A5, 0x000600CE, 0x00060100, 0x00060121,
+	0x00060140, 0x00060161, 0x00060180, 0x000601A1, 0x000601C0, 0x000601E1, 0x00060200, 0x00060221,
+	0x0006024E, 0x00060280, 0x000602A1, 0x000602C0, 0x000602E1, 0x00060300, 0x00060321, 0x00060340,
+	0x00060361, 0x00060385, 0x000603A0, 0x000603C1, 0x0006040E, 0x00060559, 0x0006060E, 0x000606B9,
+	0x000606CE, 0x00060765, 0x000607AE, 0x0006080C, 0x00060825, 0x0006084E, 0x00060865, 0x0006088E,
+	0x000608A5, 0x000608CE, 0x000608E5, 0x0006090E, 0x00060925, 0x0006094E, 0x00060C65, 0x00060C8E,
+	0x00061065, 0x0006108E, 0x000610A5, 0x000610CE, 0x000610E5, 0x0006110E, 0x000611C5, 0x000611EE,
+	0x000612A5, 0x000612EC, 0x00061339, 0x00061365, 0x000613EE, 0x00061405, 0x0006144E, 0x00061465,
+	0x0006148E, 0x000614A5, 0x000614CE, 0x000614E5, 0x0006150E, 0x00061525, 0x0006154E, 0x00061865,
+	0x0006188E, 0x00061C65, 0x00061C8E, 0x00061CA5, 0x00061CCE, 0x00061CE5, 0x00061D0E, 0x00061DC5,
+	0x00061DEE, 0x00061EA5, 0x00061EEE, 0x00061F65, 0x00061FEE, 0x0006200C, 0x000620AE, 0x0006260C,
+	0x0006262E, 0x000631EC, 0x0006320E, 0x00063C8C, 0x00063E05, 0x0006400E, 0x000643EC, 0x0006440E,
+	0x0006490C, 0x00064A0E, 0x0009B80C, 0x0009C00E, 0x001402A5, 0x001402CE, 0x001491AC, 0x0014920E,
+	0x001498EC, 0x00149FD1, 0x0014A00C, 0x0014C1B1, 0x0014C1C6, 0x0014C1F1, 0x0014C20C, 0x0014C40B,
+	0x0014C54C, 0x0014CDF9, 0x0014CE6C, 0x0014CE99, 0x0014CFCC, 0x0014D3D9, 0x0014D40C, 0x0014DE19,
+	0x0014DE4C, 0x0014DE71, 0x0014DF0C, 0x00150059, 0x0015006C, 0x001500D9, 0x001500EC, 0x00150179,
+	0x0015018C, 0x00150479, 0x0015050C, 0x00150599, 0x001505AC, 0x0015070A, 0x0015072C, 0x00150E92,
+	0x00150EC6, 0x00150F0C, 0x00151019, 0x0015104C, 0x00151699, 0x001518CC, 0x001519D1, 0x00151A0B,
+	0x00151B4C, 0x00151C19, 0x00151E4C, 0x00151F92, 0x00151FAC, 0x00151FF9, 0x0015200B, 0x0015214C,
+	0x001524D9, 0x001525D1, 0x0015260C, 0x001528F9, 0x00152A8C, 0x00152C0E, 0x00152FAC, 0x00153019,
+	0x0015308C, 0x00153679, 0x0015382C, 0x001538F1, 0x0015394C, 0x00153A0B, 0x00153B4C, 0x00153CB9,
+	0x00153CCC, 0x00153E0B, 0x00153F4C, 0x00154539, 0x001546EC, 0x00154879, 0x0015488C, 0x00154999,
+	0x001549CC, 0x00154A0B, 0x00154B4C, 0x00154BB1, 0x00154C0C, 0x00154F79, 0x00154FCC, 0x00155619,
+	0x0015562C, 0x00155659, 0x001556AC, 0x001556F9, 0x0015572C, 0x001557D9, 0x0015580C, 0x00155839,
+	0x0015584C, 0x00155D79, 0x00155E11, 0x00155E4C, 0x00155EB9, 0x00155EEC, 0x00157C79, 0x00157D71,
+	0x00157D99, 0x00157DCC, 0x00157E0B, 0x00157F4C, 0x0015800E, 0x001AF48C, 0x001AF60E, 0x001AF8EC,
+	0x001AF96E, 0x001AFF8C, 0x001F200E, 0x001F600C, 0x001F63AD, 0x001F63D9, 0x001F63ED, 0x001F652C,
+	0x001F654D, 0x001F66EC, 0x001F670D, 0x001F67AC, 0x001F67CD, 0x001F67EC, 0x001F680D, 0x001F684C,
+	0x001F686D, 0x001F68AC, 0x001F68CD, 0x001F6A0C, 0x001FA7C1, 0x001FA7E0, 0x001FA80C, 0x001FBF8A,
+	0x001FBFAC, 0x001FC019, 0x001FC208, 0x001FC221, 0x001FC268, 0x001FC2A6, 0x001FC2E0, 0x001FC301,
+	0x001FC32F, 0x001FC34C, 0x001FC419, 0x001FC60E, 0x001FC6A0, 0x001FC6C1, 0x001FC6E0, 0x001FC701,
+	0x001FC720, 0x001FC741, 0x001FC760, 0x001FC781, 0x001FC7A0, 0x001FC7C1, 0x001FC7E0, 0x001FC801,
+	0x001FC820, 0x001FC841, 0x001FC860, 0x001FC881, 0x001FC8AE, 0x001FC8E0, 0x001FC901, 0x001FC92E,
+	0x001FCA01, 0x001FCA2E, 0x001FCA41, 0x001FCA6C, 0x001FCA85, 0x001FCAC6, 0x001FCB0E, 0x001FCB20,
+	0x001FCB41, 0x001FCB60, 0x001FCB81, 0x001FCBA0, 0x001FCBC1, 0x001FCBEE, 0x001FCCEC, 0x001FCD0E,
+	0x001FCD29, 0x001FCD4A, 0x001FCD6E, 0x001FCD8C, 0x001FDFF5, 0x001FE00C, 0x001FE026, 0x001FE04E,
+	0x001FE089, 0x001FE0AA, 0x001FE0CE, 0x001FE100, 0x001FE121, 0x001FE14E, 0x001FE181, 0x001FE1AE,
+	0x001FE1C1, 0x001FE1EE, 0x001FE345, 0x001FE38E, 0x001FE3E6, 0x001FE40E, 0x001FE760, 0x001FE78E,
+	0x001FE7A1, 0x001FE7CE, 0x001FEB60, 0x001FEB8E, 0x001FEBA1, 0x001FEBCE, 0x001FEBE0, 0x001FEC01,
+	0x001FEC40, 0x001FEC61, 0x001FECA5, 0x001FECCE, 0x001FECE5, 0x001FEE2E, 0x001FF3C5, 0x001FF40E,
+	0x001FF7EC, 0x001FF84E, 0x001FF90C, 0x001FF94E, 0x001FFA0C, 0x001FFA4E, 0x001FFB0C, 0x001FFB4E,
+	0x001FFBAC, 0x001FFC0A, 0x001FFC29, 0x001FFC4E, 0x001FFCA9, 0x001FFCEC, 0x001FFF39, 0x001FFF96,
+	0x001FFFAC, 0x00202011, 0x0020206C, 0x00203FB9, 0x00203FCC, 0x00205C19, 0x00205C2C, 0x00206ED9,
+	0x00206F6C, 0x002073F1, 0x0020740C, 0x00207A11, 0x00207A2C, 0x0020940B, 0x0020954C, 0x00210AF1,
+	0x00210B0C, 0x002123F1, 0x0021240C, 0x00214039, 0x0021408C, 0x002140B9, 0x002140EC, 0x00214199,
+	0x0021420C, 0x00214719, 0x0021476C, 0x002147F9, 0x0021480C, 0x00214A11, 0x00214B0C, 0x00215CB9,
+	0x00215CEC, 0x00215E11, 0x00215ECF, 0x00215EEC, 0x00216731, 0x0021680C, 0x0021A499, 0x0021A50C,
+	0x0021A60B, 0x0021A74C, 0x0021D579, 0x0021D5B1, 0x0021D5CC, 0x0021E8D9, 0x0021EA2C, 0x0021F059,
+	0x0021F0CC, 0x00220019, 0x0022006C, 0x00220719, 0x002208F1, 0x0022092C, 0x00220CCB, 0x00220E19,
+	0x00220E2C, 0x00220E79, 0x00220EAC, 0x00220FF9, 0x0022106C, 0x00221619, 0x0022176C, 0x002217D1,
+	0x00221859, 0x0022186C, 0x00221E0B, 0x00221F4C, 0x00222019, 0x0022206C, 0x002224F9, 0x002226AC,
+	0x002226CB, 0x00222811, 0x0022288C, 0x002228B9, 0x002228EC, 0x00222E79, 0x00222E8C, 0x00222EB2,
+	0x00222ECC, 0x00223019, 0x0022306C, 0x00223679, 0x0022382C, 0x002238B1, 0x002238EC, 0x00223911,
+	0x00223939, 0x002239AC, 0x002239D9, 0x00223A0B, 0x00223B4C, 0x00223B72, 0x00223B8C, 0x00223BB1,
+	0x00223C0C, 0x00224599, 0x00224711, 0x0022474C, 0x00224771, 0x002247AC, 0x002247D9, 0x002247EC,
+	0x00225531, 0x0022554C, 0x00225BF9, 0x00225D6C, 0x00225E0B, 0x00225F4C, 0x00226019, 0x0022608C,
+	0x00226779, 0x002267AC, 0x002267D9, 0x002268AC, 0x002268F9, 0x0022692C, 0x00226979, 0x002269CC,
+	0x00226AF9, 0x00226B0C, 0x00226C59, 0x00226C8C, 0x00226CD9, 0x00226DAC, 0x00226E19, 0x00226EAC,
+	0x002286B9, 0x002288EC, 0x00228971, 0x002289EC, 0x00228A0B, 0x00228B51, 0x00228B8C, 0x00228BD9,
+	0x00228BEC, 0x00229619, 0x0022988C, 0x00229A0B, 0x00229B4C, 0x0022B5F9, 0x0022B6CC, 0x0022B719,
+	0x0022B832, 0x0022B851, 0x0022B886, 0x0022B8CC, 0x0022B931, 0x0022BB0C, 0x0022BB99, 0x0022BBCC,
+	0x0022C619, 0x0022C831, 0x0022C86C, 0x0022CA0B, 0x0022CB4C, 0x0022CC12, 0x0022CDAC, 0x0022D579,
+	0x0022D70C, 0x0022D80B, 0x0022D94C, 0x0022E3B9, 0x0022E58C, 0x0022E60B, 0x0022E74C, 0x0022E791,
+	0x0022E7EC, 0x00230599, 0x0023076C, 0x00231C0B, 0x00231D4C, 0x00232619, 0x002326CC, 0x002326F9,
+	0x0023272C, 0x00232779, 0x002327EC, 0x00232819, 0x0023282C, 0x00232859, 0x00232891, 0x002328EC,
+	0x00232A0B, 0x00232B4C, 0x00233A39, 0x00233B0C, 0x00233B59, 0x00233C2C, 0x00233C52, 0x00233C6C,
+	0x00233C99, 0x00233CAC, 0x00234039, 0x0023416C, 0x00234679, 0x0023474C, 0x00234779, 0x002347F2,
+	0x0023480C, 0x00234831, 0x002348B2, 0x002348CC, 0x002348F9, 0x0023490C, 0x00234A39, 0x00234B8C,
+	0x00235159, 0x00235351, 0x002353AC, 0x002353D2, 0x00235431, 0x0023546C, 0x002385F9, 0x002386EC,
+	0x00238719, 0x0023880C, 0x00238831, 0x002388CC, 0x00238A0B, 0x00238B4C, 0x00238E12, 0x00238E26,
+	0x00238E4C, 0x00239259, 0x0023950C, 0x00239539, 0x002396EC, 0x0023A639, 0x0023A6EC, 0x0023A759,
+	0x0023A76C, 0x0023A799, 0x0023A7CC, 0x0023A7F9, 0x0023A8CC, 0x0023A8F9, 0x0023A90C, 0x0023AA0B,
+	0x0023AB4C, 0x0023B159, 0x0023B1EC, 0x0023B219, 0x0023B24C, 0x0023B279, 0x0023B30C, 0x0023B40B,
+	0x0023B54C, 0x0023DE79, 0x0023DEEC, 0x0023FBAA, 0x0023FC2C, 0x0023FFF1, 0x0024000C, 0x00248E11,
+	0x00248EAC, 0x00264B00, 0x00264B61, 0x00264BCC, 0x00265041, 0x0026506C, 0x002650C0, 0x002650E1,
+	0x00265100, 0x00265121, 0x0026514C, 0x00266F20, 0x00266F41, 0x00266F8C, 0x00268604, 0x002686E0,
+	0x00268701, 0x0026872C, 0x0028B9C0, 0x0028B9E1, 0x0028BA0C, 0x002D4C0B, 0x002D4D4C, 0x002D4DD1,
+	0x002D4E0C, 0x002D580B, 0x002D594C, 0x002D5E19, 0x002D5EB1, 0x002D5ECC, 0x002D6619, 0x002D66F1,
+	0x002D674C, 0x002D6891, 0x002D68AC, 0x002D6A0B, 0x002D6B4C, 0x002DD2F1, 0x002DD32C, 0x002DE9F9,
+	0x002DEA0C, 0x002DEA39, 0x002DF10C, 0x002DF1F9, 0x002DF26C, 0x002DFC05, 0x002DFC84, 0x002DFCAC,
+	0x002DFE19, 0x002DFE4C, 0x002E000E, 0x0030FF0C, 0x0031000E, 0x0031600C, 0x0031A00E, 0x0031A12C,
+	0x0036000E, 0x0036246C, 0x00362A05, 0x00362A6C, 0x00362C85, 0x00362D0C, 0x00362E0E, 0x00365F8C,
+	0x003793B9, 0x003793F1, 0x00379419, 0x0037948C, 0x0039E019, 0x0039E5CC, 0x0039E619, 0x0039E8EC,
+	0x003A2CB9, 0x003A2D4C, 0x003A2DB9, 0x003A306C, 0x003A30B9, 0x003A318C, 0x003A3559, 0x003A35CC,
+	0x003A4859, 0x003A48AC, 0x003AF9CB, 0x003B000C, 0x003B4019, 0x003B46EC, 0x003B4779, 0x003B4DAC,
+	0x003B4EB9, 0x003B4ECC, 0x003B5099, 0x003B50AC, 0x003B50F1, 0x003B516C, 0x003B5379, 0x003B540C,
+	0x003B5439, 0x003B560C, 0x003C0019, 0x003C00EC, 0x003C0119, 0x003C032C, 0x003C0379, 0x003C044C,
+	0x003C0479, 0x003C04AC, 0x003C04D9, 0x003C056C, 0x003C2619, 0x003C26EC, 0x003C280B, 0x003C294C,
+	0x003C55D9, 0x003C55EC, 0x003C5D99, 0x003C5E0B, 0x003C5F4C, 0x003C5FE9, 0x003C600C, 0x003D1A19,
+	0x003D1AEC, 0x003D2899, 0x003D296C, 0x003D2A0B, 0x003D2B4C, 0x003D2BC0, 0x003D2C0C, 0x003D958A,
+	0x003D95AC, 0x003D960A, 0x003D962C, 0x003E000E, 0x003E200C, 0x003E21AE, 0x003E220C, 0x003E2DAE,
+	0x003E2E0C, 0x003E35AE, 0x003E3CD7, 0x003E400E, 0x003E738C, 0x003E73CE, 0x003E76AC, 0x003E76EE,
+	0x003E778C, 0x003E77AE, 0x003E7F79, 0x003E800E, 0x003E940C, 0x003E942E, 0x003E944C, 0x003E946E,
+	0x003E948C, 0x003E94AE, 0x003E95EC, 0x003E960E, 0x003E962C, 0x003E966E, 0x003EA00C, 0x003EA0EE,
+	0x003EA2EC, 0x003EA4AE, 0x003EA64C, 0x003EA94E, 0x003EBA8C, 0x003EBB8E, 0x003EBE8C, 0x003EBF4E,
+	0x003ECA0C, 0x003ECEC3, 0x003ECF25, 0x003ECF8C, 0x003ED00E, 0x003EE00C, 0x003EEE8E, 0x003EF00C,
+	0x003EFAAE, 0x003F000C, 0x003F018E, 0x003F020C, 0x003F090E, 0x003F0A0C, 0x003F0B4E, 0x003F0C0C,
+	0x003F110E, 0x003F120C, 0x003F15CE, 0x003F200C, 0x003F218E, 0x003F400C, 0x003F4A8E, 0x003F600C,
+	0x003F7E0B, 0x003F7F4C, 0x003F800E, 0x003FFFCC, 0x0040000E, 0x005FFFCC, 0x0060000E, 0x007FFFCC,
+	0x01C00039, 0x01C0004C, 0x01C00419, 0x01C0100C, 0x01C02019, 0x01C03E0C
+};
+
+//Whether a line may start between two classes: _ always, % only when spaces come between them, ^ never. Built from
+//rules LB7 to LB30 of UAX #14, the rules that look further than a pair (LB15a-b, LB21a, LB25 and LB28a) are left out
+const char* const lineBreakPairs[LB_NUM_PAIRS] =
+{
+	//OP CL CP QU GL NS EX SY IS PR PO NU AL HL ID IN HY BA BB B2 ZW WJ CB RI
+	"^^^^^^^^^^^^^^^^^^^^^^^^", //OP
+	"_^^%%^^^^%%____%%%__^^__", //CL
+	"_^^%%^^^^%%%%%_%%%__^^__", //CP
+	"^^^%%%^^^%%%%%%%%%%%^^%%", //QU
+	"%^^%%%^^^%%%%%%%%%%%^^%%", //GL
+	"_^^%%%^^^______%%%__^^__", //NS
+	"_^^%%%^^^______%%%__^^__", //EX
+	"_^^%%%^^^__%_%_%%%__^^__", //SY
+	"_^^%%%^^^__%%%_%%%__^^__", //IS
+	"%^^%%%^^^__%%%%%%%__^^__", //PR
+	"%^^%%%^^^__%%%_%%%__^^__", //PO
+	"%^^%%%^^^%%%%%_%%%__^^__", //NU
+	"%^^%%%^^^%%%%%_%%%__^^__", //AL
+	"%^^%%%^^^%%%%%_%%%__^^__", //HL
+	"_^^%%%^^^_%____%%%__^^__", //ID
+	"_^^%%%^^^______%%%__^^__", //IN
+	"_^^%_%^^^__%___%%%__^^__", //HY
+	"_^^%_%^^^______%%%__^^__", //BA
+	"%^^%%%^^^%%%%%%%%%%%^^_%", //BB
+	"_^^%%%^^^______%%%_^^^__", //B2
+	"____________________^___", //ZW
+	"%^^%%%^^^%%%%%%%%%%%^^%%", //WJ
+	"_^^%%_^^^___________^^__", //CB
+	"_^^%%%^^^______%%%__^^_%"  //RI
+};
+
+//Classes of ASCII, which most text is made of, without the search
+const unsigned char lineBreakAscii[128] =
+{
+	LB_CM, LB_CM, LB_CM, LB_CM, LB_CM, LB_CM, LB_CM, LB_CM, LB_CM, LB_BA, LB_LF, LB_BK, LB_BK, LB_CR, LB_CM, LB_CM,
+	LB_CM, LB_CM, LB_CM, LB_CM, LB_CM, LB_CM, LB_CM, LB_CM, LB_CM, LB_CM, LB_CM, LB_CM, LB_CM, LB_CM, LB_CM, LB_CM,
+	LB_SP, LB_EX, LB_QU, LB_AL, LB_PR, LB_PO, LB_AL, LB_QU, LB_OP, LB_CP, LB_AL, LB_PR, LB_IS, LB_HY, LB_IS, LB_SY,
+	LB_NU, LB_NU, LB_NU, LB_NU, LB_NU, LB_NU, LB_NU, LB_NU, LB_NU, LB_NU, LB_IS, LB_IS, LB_AL, LB_AL, LB_AL, LB_EX,
+	LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL,
+	LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_OP, LB_PR, LB_CP, LB_AL, LB_AL,
+	LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL,
+	LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_OP, LB_BA, LB_CL, LB_AL, LB_CM
+};
+
+int GetLineBreakClass(int codepoint)
+{
+	if (codepoint < 128)
+		return lineBreakAscii[codepoint];
+
+	int low = 0, high = (int)(sizeof(lineBreakClasses) / sizeof(lineBreakClasses[0])) - 1;
+	while (low < high)
+	{
+		int middle = (low + high + 1) / 2;
+		if ((int)(lineBreakClasses[middle] >> 5) <= codepoint)
+			low = middle;
+		else
+			high = middle - 1;
+	}
+	return lineBreakClasses[low] & 31;
+}
+
+//Where FindLineBreaks is in the text, so text that arrives in pieces can be broken a character at a time
+typedef struct
+{
+	int current;
+	int afterSpace;
+	int afterJoiner;
+	int regional;
+} linebreakstate_t;
+
+void StartLineBreaks(linebreakstate_t* state)
+{
+	state->current = LB_NONE;
+	state->afterSpace = 0;
+	state->afterJoiner = 0;
+	state->regional = 0;
+}
+
+//Flags of the next character of the text, given its class
+int NextLineBreak(linebreakstate_t* state, int lineBreak)
+{
+	int flags = 0;
+
+	//LB4, LB5: lines end after hard breaks, a line feed after a carriage return belongs to it
+	if (state->current >= LB_BK && !(state->current == LB_CR && lineBreak == LB_LF))
+	{
+		flags |= LINEBREAK_MANDATORY;
+		state->current = LB_NONE;
+	}
+
+	//LB7: spaces never start a line, what follows them decides. Leading spaces stay with the line
+	if (lineBreak == LB_SP)
+	{
+		state->afterSpace = state->current != LB_NONE;
+		state->afterJoiner = 0;
+		state->regional = 0;
+		return flags | LINEBREAK_SPACE;
+	}
+
+	//LB9, LB10: marks and joiners belong to the character before them, after spaces or at the start they are letters
+	int joiner = lineBreak == LB_ZWJ;
+	if (lineBreak == LB_CM || lineBreak == LB_ZWJ)
+	{
+		if (state->current != LB_NONE && state->current != LB_ZW && !state->afterSpace)
+		{
+			state->afterJoiner = joiner;
+			return flags;
+		}
+		lineBreak = LB_AL;
+	}
+
+	//LB6: hard breaks end the line they are on. LB8a: nothing breaks after a zero width joiner. LB30a: regional
+	//indicators pair up
+	if (state->current != LB_NONE && lineBreak < LB_NUM_PAIRS && !state->afterJoiner)
+	{
+		char pair = lineBreakPairs[state->current][lineBreak];
+		if (state->current == LB_RI && lineBreak == LB_RI && !state->afterSpace)
+			pair = state->regional % 2 == 0 ? '_' : '^';
+		if (pair == '_' || (pair == '%' && state->afterSpace))
+			flags |= LINEBREAK_ALLOWED;
+	}
+
+	state->regional = lineBreak == LB_RI ? state->regional + 1 : 0;
+	state->current = lineBreak;
+	state->afterSpace = 0;
+	state->afterJoiner = joiner;
+	return flags;
+}
+
+//Break opportunities of length code units of text in one pass, flags are set on the unit a line would start at. The
+//text is a paragraph, it never breaks at its start. The second unit of a surrogate pair gets no flags
+void FindLineBreaks(const utf16_t* text, size_t length, unsigned char* flags)
+{
+	linebreakstate_t state;
+	memset(flags, 0, length);
+	StartLineBreaks(&state);
+	for (size_t i = 0, next; i < length; i = next)
+	{
+		next = i;
+		flags[i] = (unsigned char)NextLineBreak(&state, GetLineBreakClass(NextCodepoint(text, length, &next)));
+	}
+}
+
+#endif
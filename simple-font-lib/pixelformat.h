@@ -0,0 +1,178 @@
+#ifndef PIXELFORMAT_H
+#define PIXELFORMAT_H
+
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PIXELFORMAT_SSE2
+#include <emmintrin.h>
+#endif
+
+//Output formats, colors are given as 0xRRGGBB
+enum
+{
+	FORMAT_ALPHA8 = 0,
+	FORMAT_RGBA8 = 1,
+	FORMAT_BGRA8 = 2,
+	FORMAT_RGBA8_PREMULTIPLIED = 3
+};
+
+//How coverage is combined with what is already in the destination
+enum
+{
+	BLEND_REPLACE = 0,
+	BLEND_MAX = 1,
+	BLEND_ADD = 2
+};
+
+int GetBytesPerPixel(int format)
+{
+	return format == FORMAT_ALPHA8 ? 1 : 4;
+}
+
+//Color channels in memory order packed into a little endian 32-bit value, alpha left empty
+unsigned int PackColor(int format, unsigned int color)
+{
+	unsigned int r = (color >> 16) & 0xFF, g = (color >> 8) & 0xFF, b = color & 0xFF;
+	if (format == FORMAT_BGRA8)
+		return b | g << 8 | r << 16;
+	return r | g << 8 | b << 16;
+}
+
+//Exact x / 255 rounded to nearest for x <= 255 * 255
+unsigned int Divide255(unsigned int x)
+{
+	x += 128;
+	return (x + (x >> 8)) >> 8;
+}
+
+//Transparent pixels, non-premultiplied formats keep the color so filtering doesn't bleed black into the edges
+void FillRow(unsigned char* destination, int count, int format, unsigned int color)
+{
+	if (format == FORMAT_ALPHA8 || format == FORMAT_RGBA8_PREMULTIPLIED)
+	{
+		memset(destination, 0, (size_t)count * GetBytesPerPixel(format));
+		return;
+	}
+
+	unsigned int packed = PackColor(format, color);
+	for (int i = 0; i < count; i++)
+		memcpy(destination + i * 4, &packed, 4);
+}
+
+#ifdef PIXELFORMAT_SSE2
+//(x + 128) / 255 for 16-bit lanes
+__m128i Divide255x8(__m128i x)
+{
+	x = _mm_add_epi16(x, _mm_set1_epi16(128));
+	return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+//Expand 16 alpha values to 16 pixels
+void ExpandPixels16(unsigned char* destination, __m128i alphas, int format, __m128i packed, __m128i channels)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i lo = _mm_unpacklo_epi8(alphas, zero);
+	__m128i hi = _mm_unpackhi_epi8(alphas, zero);
+	__m128i a[4];
+	a[0] = _mm_unpacklo_epi16(lo, zero);
+	a[1] = _mm_unpackhi_epi16(lo, zero);
+	a[2] = _mm_unpacklo_epi16(hi, zero);
+	a[3] = _mm_unpackhi_epi16(hi, zero);
+
+	for (int i = 0; i < 4; i++)
+	{
+		__m128i pixels;
+		if (format == FORMAT_RGBA8_PREMULTIPLIED)
+		{
+			//Broadcast alpha to all four channels as 16-bit lanes, multiply the color and put alpha back in the top byte
+			__m128i a4 = _mm_or_si128(a[i], _mm_slli_epi32(a[i], 16));
+			__m128i alo = _mm_unpacklo_epi32(a4, a4);
+			__m128i ahi = _mm_unpackhi_epi32(a4, a4);
+			__m128i clo = Divide255x8(_mm_mullo_epi16(alo, channels));
+			__m128i chi = Divide255x8(_mm_mullo_epi16(ahi, channels));
+			pixels = _mm_packus_epi16(clo, chi);
+			pixels = _mm_or_si128(pixels, _mm_slli_epi32(a[i], 24));
+		}
+		else
+		{
+			pixels = _mm_or_si128(packed, _mm_slli_epi32(a[i], 24));
+		}
+		_mm_storeu_si128((__m128i*)(destination + i * 16), pixels);
+	}
+}
+#endif
+
+//Write count pixels of the given coverage in the color
+void ExpandRow(unsigned char* destination, const unsigned char* alphas, int count, int format, unsigned int color)
+{
+	if (format == FORMAT_ALPHA8)
+	{
+		memcpy(destination, alphas, count);
+		return;
+	}
+
+	unsigned int packed = PackColor(format, color);
+	int i = 0;
+
+#ifdef PIXELFORMAT_SSE2
+	__m128i packed4 = _mm_set1_epi32((int)packed);
+	__m128i zero = _mm_setzero_si128();
+	__m128i channels = _mm_unpacklo_epi8(_mm_set1_epi32((int)packed), zero);
+	for (; i + 16 <= count; i += 16)
+		ExpandPixels16(destination + i * 4, _mm_loadu_si128((const __m128i*)(alphas + i)), format, packed4, channels);
+#endif
+
+	for (; i < count; i++)
+	{
+		unsigned int a = alphas[i];
+		unsigned int pixel;
+		if (format == FORMAT_RGBA8_PREMULTIPLIED)
+		{
+			pixel = Divide255((packed & 0xFF) * a) |
+				Divide255(((packed >> 8) & 0xFF) * a) << 8 |
+				Divide255(((packed >> 16) & 0xFF) * a) << 16;
+		}
+		else
+		{
+			pixel = packed;
+		}
+		pixel |= a << 24;
+		memcpy(destination + i * 4, &pixel, 4);
+	}
+}
+
+//Combine count coverage values with the destination, additive blending saturates at 255
+void BlendRow(unsigned char* destination, const unsigned char* source, int count, int blend)
+{
+	if (blend == BLEND_REPLACE)
+	{
+		memcpy(destination, source, count);
+		return;
+	}
+
+	int i = 0;
+#ifdef PIXELFORMAT_SSE2
+	for (; i + 16 <= count; i += 16)
+	{
+		__m128i d = _mm_loadu_si128((const __m128i*)(destination + i));
+		__m128i s = _mm_loadu_si128((const __m128i*)(source + i));
+		_mm_storeu_si128((__m128i*)(destination + i), blend == BLEND_MAX ? _mm_max_epu8(d, s) : _mm_adds_epu8(d, s));
+	}
+#endif
+
+	for (; i < count; i++)
+	{
+		int value = blend == BLEND_MAX ? max(destination[i], source[i]) : min(destination[i] + source[i], 255);
+		destination[i] = (unsigned char)value;
+	}
+}
+
+//Expand a whole alpha bitmap, rows of destination are stride bytes apart
+void ExpandBitmapRows(const unsigned char* alphas, int width, int height, unsigned char* destination, int stride, int format, unsigned int color)
+{
+	for (int y = 0; y < height; y++)
+		ExpandRow(destination + (size_t)y * stride, alphas + (size_t)y * width, width, format, color);
+}
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+
+//Functions the library exports, everything else is hidden on platforms that support it
+#ifdef _WIN32
+#define EXPORT __declspec(dllexport)
+#else
+#define EXPORT __attribute__((visibility("default")))
+#endif
+
+//Variables with a copy per thread
+#ifdef _MSC_VER
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL _Thread_local
+#endif
+
+//One UTF-16 code unit, the same as a C# char. wchar_t is 32 bits wide outside Windows so it can't be used there
+#ifdef _WIN32
+typedef wchar_t utf16_t;
+#else
+#include <uchar.h>
+typedef char16_t utf16_t;
+#endif
+
+//Windows.h defines these
+#ifndef max
+#define max(a, b) (((a) > (b)) ? (a) : (b))
+#endif
+#ifndef min
+#define min(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+
+size_t Utf16Length(const utf16_t* string)
+{
+	const utf16_t* end = string;
+	while (*end)
+		end++;
+	return end - string;
+}
+
+int Utf16Compare(const utf16_t* a, const utf16_t* b)
+{
+	while (*a && *a == *b)
+		a++, b++;
+	return (int)*a - (int)*b;
+}
+
+//Returns a null terminated UTF-8 copy of length code units that has to be freed, unpaired surrogates become U+FFFD
+char* Utf16ToUtf8(const utf16_t* string, size_t length)
+{
+	char* result = malloc(length * 3 + 1);
+	unsigned char* out = (unsigned char*)result;
+	for (size_t i = 0; i < length; i++)
+	{
+		unsigned int c = string[i];
+		if (c >= 0xD800 && c <= 0xDBFF && i + 1 < length && string[i + 1] >= 0xDC00 && string[i + 1] <= 0xDFFF)
+			c = 0x10000 + ((c - 0xD800) << 10) + (string[++i] - 0xDC00);
+		else if (c >= 0xD800 && c <= 0xDFFF)
+			c = 0xFFFD;
+
+		if (c < 0x80)
+		{
+			*out++ = (unsigned char)c;
+		}
+		else if (c < 0x800)
+		{
+			*out++ = (unsigned char)(0xC0 | c >> 6);
+			*out++ = (unsigned char)(0x80 | (c & 0x3F));
+		}
+		else if (c < 0x10000)
+		{
+			*out++ = (unsigned char)(0xE0 | c >> 12);
+			*out++ = (unsigned char)(0x80 | (c >> 6 & 0x3F));
+			*out++ = (unsigned char)(0x80 | (c & 0x3F));
+		}
+		else
+		{
+			*out++ = (unsigned char)(0xF0 | c >> 18);
+			*out++ = (unsigned char)(0x80 | (c >> 12 & 0x3F));
+			*out++ = (unsigned char)(0x80 | (c >> 6 & 0x3F));
+			*out++ = (unsigned char)(0x80 | (c & 0x3F));
+		}
+	}
+	*out = 0;
+	return result;
+}
+
+//fopen for UTF-16 file names, mode is ASCII such as "rb"
+FILE* OpenFileUtf16(const utf16_t* filename, const char* mode)
+{
+#ifdef _WIN32
+	wchar_t wideMode[8] = { 0 };
+	for (int i = 0; i < 7 && mode[i]; i++)
+		wideMode[i] = mode[i];
+	return _wfopen(filename, wideMode);
+#else
+	char* path = Utf16ToUtf8(filename, Utf16Length(filename));
+	FILE* file = fopen(path, mode);
+	free(path);
+	return file;
+#endif
+}
+
+#endif
@@ -0,0 +1,280 @@
+#ifndef SDF_H
+#define SDF_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "threads.h"
+
+//Signed distance field generator. stbtt_GetGlyphSDF tests every pixel against every curve, here the outline is
+//flattened once, the segments are binned into a grid of spread sized cells and each pixel only looks at the 3x3
+//cells around it. Inside/outside comes from a single crossing pass per row instead of a ray cast per pixel.
+
+typedef struct
+{
+	float x0, y0, x1, y1;
+} sdfsegment_t;
+
+typedef struct
+{
+	//Box in the output bitmap, padding included
+	int x, y, width, height;
+
+	sdfsegment_t* segments;
+	int numSegments;
+
+	//Segment indices per cell, cell i owns cellSegments[cellStart[i]] to cellSegments[cellStart[i + 1] - 1]
+	int cellSize, cellsX, cellsY;
+	int* cellStart;
+	int* cellSegments;
+} sdfshape_t;
+
+typedef struct
+{
+	float x;
+	int direction;
+} sdfcrossing_t;
+
+typedef struct
+{
+	sdfshape_t* shapes;
+	int numShapes;
+	unsigned char* bitmap;
+	int width;
+	int spread;
+	int maxSegments;
+} sdfjob_t;
+
+void AddSDFSegment(sdfshape_t* shape, float x0, float y0, float x1, float y1)
+{
+	if (x0 == x1 && y0 == y1)
+		return;
+
+	sdfsegment_t* segment = shape->segments + shape->numSegments++;
+	segment->x0 = x0;
+	segment->y0 = y0;
+	segment->x1 = x1;
+	segment->y1 = y1;
+}
+
+void GetSDFSegmentCells(sdfshape_t* shape, sdfsegment_t* segment, int* cx0, int* cy0, int* cx1, int* cy1)
+{
+	*cx0 = (int)floorf(min(segment->x0, segment->x1) / shape->cellSize);
+	*cy0 = (int)floorf(min(segment->y0, segment->y1) / shape->cellSize);
+	*cx1 = (int)floorf(max(segment->x0, segment->x1) / shape->cellSize);
+	*cy1 = (int)floorf(max(segment->y0, segment->y1) / shape->cellSize);
+
+	*cx0 = max(*cx0, 0), *cy0 = max(*cy0, 0);
+	*cx1 = min(*cx1, shape->cellsX - 1), *cy1 = min(*cy1, shape->cellsY - 1);
+}
+
+//Flatten the glyph outline into line segments relative to the box at (x, y) and bin them into cells
+//ix0 and iy0 are the top left corner of the unpadded glyph box as returned by stbtt_GetGlyphBitmapBox
+//flattening is the STBTT_FLATTEN_* value curves are flattened with. Returns 0 if the glyph has no outline
+int CreateSDFShape(sdfshape_t* shape, const stbtt_fontinfo* info, int glyph, float scale, int ix0, int iy0, int x, int y, int width, int height, int spread,
+	int flattening)
+{
+	memset(shape, 0, sizeof(sdfshape_t));
+	shape->x = x;
+	shape->y = y;
+	shape->width = width;
+	shape->height = height;
+
+	stbtt_vertex* vertices;
+	int numVertices = stbtt_GetGlyphShape(info, glyph, &vertices);
+	if (numVertices == 0)
+	{
+		//CFF outlines allocate even when empty
+		STBTT_free(vertices, info->userdata);
+		return 0;
+	}
+
+	int numContours = 0;
+	int* contourLengths = NULL;
+	stbtt__point* points = stbtt_FlattenCurves(vertices, numVertices, 0.35f / scale, &contourLengths, &numContours, info->userdata, flattening);
+	STBTT_free(vertices, info->userdata);
+	if (points == NULL)
+		return 0;
+
+	//Every point starts one segment (the last point of a contour closes it)
+	int numPoints = 0;
+	for (int i = 0; i < numContours; i++)
+		numPoints += contourLengths[i];
+	shape->segments = malloc(sizeof(sdfsegment_t) * max(numPoints, 1));
+
+	float offsetX = spread - (float)ix0;
+	float offsetY = spread - (float)iy0;
+	stbtt__point* contour = points;
+	for (int i = 0; i < numContours; i++)
+	{
+		for (int j = 0, k = contourLengths[i] - 1; j < contourLengths[i]; k = j++)
+		{
+			AddSDFSegment(shape,
+				contour[k].x * scale + offsetX, -contour[k].y * scale + offsetY,
+				contour[j].x * scale + offsetX, -contour[j].y * scale + offsetY);
+		}
+		contour += contourLengths[i];
+	}
+	STBTT_free(contourLengths, info->userdata);
+	STBTT_free(points, info->userdata);
+
+	//Cells at least as large as the spread so any segment within reach is in the surrounding 3x3 cells
+	shape->cellSize = max(spread, 4);
+	shape->cellsX = (width + shape->cellSize - 1) / shape->cellSize;
+	shape->cellsY = (height + shape->cellSize - 1) / shape->cellSize;
+	size_t numCells = (size_t)shape->cellsX * shape->cellsY;
+
+	//Count, prefix sum, fill
+	shape->cellStart = calloc(numCells + 1, sizeof(int));
+	int cx0, cy0, cx1, cy1;
+	for (int i = 0; i < shape->numSegments; i++)
+	{
+		GetSDFSegmentCells(shape, shape->segments + i, &cx0, &cy0, &cx1, &cy1);
+		for (int cy = cy0; cy <= cy1; cy++)
+			for (int cx = cx0; cx <= cx1; cx++)
+				shape->cellStart[cy * shape->cellsX + cx + 1]++;
+	}
+	for (size_t i = 0; i < numCells; i++)
+		shape->cellStart[i + 1] += shape->cellStart[i];
+
+	shape->cellSegments = malloc(sizeof(int) * max(shape->cellStart[numCells], 1));
+	int* fill = malloc(sizeof(int) * numCells);
+	memcpy(fill, shape->cellStart, sizeof(int) * numCells);
+	for (int i = 0; i < shape->numSegments; i++)
+	{
+		GetSDFSegmentCells(shape, shape->segments + i, &cx0, &cy0, &cx1, &cy1);
+		for (int cy = cy0; cy <= cy1; cy++)
+			for (int cx = cx0; cx <= cx1; cx++)
+				shape->cellSegments[fill[cy * shape->cellsX + cx]++] = i;
+	}
+	free(fill);
+
+	return shape->numSegments > 0;
+}
+
+void FreeSDFShape(sdfshape_t* shape)
+{
+	free(shape->segments);
+	free(shape->cellStart);
+	free(shape->cellSegments);
+	memset(shape, 0, sizeof(sdfshape_t));
+}
+
+float SegmentDistanceSquared(sdfsegment_t* segment, float x, float y)
+{
+	float dx = segment->x1 - segment->x0, dy = segment->y1 - segment->y0;
+	float px = x - segment->x0, py = y - segment->y0;
+
+	float t = (px * dx + py * dy) / (dx * dx + dy * dy);
+	if (t < 0.0f) t = 0.0f;
+	else if (t > 1.0f) t = 1.0f;
+
+	px -= t * dx;
+	py -= t * dy;
+	return px * px + py * py;
+}
+
+//Compute columns [x0, x1) of one row of the distance field for a single shape, output points at column 0
+void GenerateSDFShapeRow(sdfshape_t* shape, int row, int x0, int x1, unsigned char* output, int spread, sdfcrossing_t* crossings)
+{
+	float sy = row + 0.5f;
+
+	//Collect crossings of the scanline with the outline
+	int numCrossings = 0;
+	for (int i = 0; i < shape->numSegments; i++)
+	{
+		sdfsegment_t* s = shape->segments + i;
+		if ((s->y0 <= sy) != (s->y1 <= sy))
+		{
+			crossings[numCrossings].x = s->x0 + (sy - s->y0) * (s->x1 - s->x0) / (s->y1 - s->y0);
+			crossings[numCrossings].direction = s->y1 > s->y0 ? 1 : -1;
+			numCrossings++;
+		}
+	}
+
+	//Insertion sort, rows rarely cross the outline more than a dozen times
+	for (int i = 1; i < numCrossings; i++)
+	{
+		sdfcrossing_t c = crossings[i];
+		int j = i;
+		for (; j > 0 && crossings[j - 1].x > c.x; j--)
+			crossings[j] = crossings[j - 1];
+		crossings[j] = c;
+	}
+
+	float maxDistance = (float)spread;
+	float valueScale = 128.0f / spread;
+	int cy = row / shape->cellSize;
+	int nextCrossing = 0, winding = 0;
+	for (int x = x0; x < x1; x++)
+	{
+		float sx = x + 0.5f;
+
+		//Non-zero winding rule
+		while (nextCrossing < numCrossings && crossings[nextCrossing].x < sx)
+			winding += crossings[nextCrossing++].direction;
+
+		//Closest segment in the neighbouring cells
+		float minDistance2 = maxDistance * maxDistance;
+		int cx = x / shape->cellSize;
+		for (int ny = max(cy - 1, 0); ny <= min(cy + 1, shape->cellsY - 1); ny++)
+		{
+			for (int nx = max(cx - 1, 0); nx <= min(cx + 1, shape->cellsX - 1); nx++)
+			{
+				int cell = ny * shape->cellsX + nx;
+				for (int i = shape->cellStart[cell]; i < shape->cellStart[cell + 1]; i++)
+				{
+					float distance2 = SegmentDistanceSquared(shape->segments + shape->cellSegments[i], sx, sy);
+					if (distance2 < minDistance2)
+						minDistance2 = distance2;
+				}
+			}
+		}
+
+		float distance = sqrtf(minDistance2);
+		float value = 128.0f + (winding != 0 ? distance : -distance) * valueScale;
+		if (value < 0.0f) value = 0.0f;
+		else if (value > 255.0f) value = 255.0f;
+
+		//Padded boxes of neighbouring glyphs overlap, keep the larger value
+		unsigned char v = (unsigned char)value;
+		if (output[x] < v)
+			output[x] = v;
+	}
+}
+
+void GenerateSDFRow(void* context, int row)
+{
+	sdfjob_t* job = context;
+	sdfcrossing_t* crossings = malloc(sizeof(sdfcrossing_t) * max(job->maxSegments, 1));
+
+	//All shapes touching this row are handled by the same thread so overlapping boxes never race
+	for (int i = 0; i < job->numShapes; i++)
+	{
+		sdfshape_t* shape = job->shapes + i;
+		//Boxes are clipped to the bitmap, they only reach outside it when the font's metrics don't match its outlines
+		int x0 = max(-shape->x, 0), x1 = min(shape->width, job->width - shape->x);
+		if (row >= shape->y && row < shape->y + shape->height && x0 < x1)
+			GenerateSDFShapeRow(shape, row - shape->y, x0, x1, job->bitmap + (size_t)row * job->width + shape->x, job->spread, crossings);
+	}
+
+	free(crossings);
+}
+
+//Generate the distance fields of all shapes into a width * height bitmap, rows are processed in parallel
+void GenerateSDF(sdfshape_t* shapes, int numShapes, unsigned char* bitmap, int width, int height, int spread)
+{
+	sdfjob_t job = { shapes, numShapes, bitmap, width, spread, 0 };
+
+	int rows = 0;
+	for (int i = 0; i < numShapes; i++)
+	{
+		rows = max(rows, shapes[i].y + shapes[i].height);
+		job.maxSegments = max(job.maxSegments, shapes[i].numSegments);
+	}
+
+	ParallelFor(min(rows, height), GenerateSDFRow, &job, 16);
+}
+
+#endif
@@ -0,0 +1,1956 @@
+#ifndef SHAPING_H
+#define SHAPING_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "platform.h"
+
+//OpenType shaping between the text and layout: characters are mapped to glyphs, GSUB substitutes ligatures, positional
+//and contextual forms, GPOS attaches marks and joins cursive glyphs. Pair kerning still comes from stb, which reads the
+//kern table or the pair adjustments of GPOS. Glyphs stay in logical order, each keeps its bidi level so layout can put
+//lines into visual order. GSUB, GPOS and GDEF aren't validated when a font is loaded, every read is checked against the
+//table instead and reads outside it give 0, which the tables treat as an empty count or a missing subtable
+
+//Longest input sequence of a ligature or contextual rule
+#define MAX_CONTEXT_LENGTH 64
+//Contextual lookups calling contextual lookups
+#define MAX_LOOKUP_NESTING 8
+//Lookups the features of one script may use
+#define MAX_PLAN_LOOKUPS 1024
+//Subtables tried per glyph before shaping gives up, fonts can make contextual matching quadratic
+#define SHAPE_BUDGET_PER_GLYPH 2048
+//Multiple substitutions can't grow a run past this many glyphs per character
+#define MAX_GLYPHS_PER_CHARACTER 8
+//A paragraph is shaped with a font and at most this many fallbacks of it
+#define MAX_SHAPE_FONTS 16
+
+enum
+{
+	SCRIPT_COMMON = 0,
+	SCRIPT_LATIN,
+	SCRIPT_GREEK,
+	SCRIPT_CYRILLIC,
+	SCRIPT_HEBREW,
+	SCRIPT_ARABIC,
+	SCRIPT_DEVANAGARI,
+	NUM_SCRIPTS
+};
+
+//Glyph classes of GDEF
+enum
+{
+	GLYPH_BASE = 1,
+	GLYPH_LIGATURE = 2,
+	GLYPH_MARK = 3,
+	GLYPH_COMPONENT = 4
+};
+
+enum
+{
+	LOOKUP_RIGHT_TO_LEFT = 0x1,
+	LOOKUP_IGNORE_BASE_GLYPHS = 0x2,
+	LOOKUP_IGNORE_LIGATURES = 0x4,
+	LOOKUP_IGNORE_MARKS = 0x8,
+	LOOKUP_USE_MARK_FILTERING_SET = 0x10
+};
+
+//Glyphs a feature applies to, features of the global mask apply everywhere
+enum
+{
+	FEATURE_GLOBAL = 0x1,
+	FEATURE_ISOL = 0x2,
+	FEATURE_FINA = 0x4,
+	FEATURE_MEDI = 0x8,
+	FEATURE_INIT = 0x10,
+	FEATURE_RPHF = 0x20,
+	FEATURE_HALF = 0x40
+};
+
+enum
+{
+	SHAPED_SUBSTITUTED = 0x1,
+	SHAPED_REPH = 0x2,
+	SHAPED_RESOLVED = 0x4
+};
+
+enum
+{
+	ATTACH_NONE = 0,
+	ATTACH_MARK = 1,
+	ATTACH_CURSIVE = 2
+};
+
+typedef struct
+{
+	const unsigned char* data;
+	unsigned int length;
+} otftable_t;
+
+typedef struct
+{
+	int glyph;
+	int codepoint;        //Character the glyph was mapped from, the first one of a ligature
+	int cluster;          //Index of the first code unit of that character in the shaped text
+
+	//Font units, offsetY points up
+	int advance;
+	int offsetX;
+	int offsetY;
+
+	int attachTo;         //Glyph this one is attached to until attachments are resolved
+	unsigned int mask;    //Features that apply to the glyph
+	unsigned char glyphClass;
+	unsigned char level;  //Bidi level, odd levels run right to left
+	unsigned char font;   //Shaper the glyph comes from
+	unsigned char attachType;
+	unsigned char flags;
+
+	//Marks remember the ligature that skipped over them and the component they follow
+	unsigned char ligatureId;
+	unsigned char component;
+} shapedglyph_t;
+
+typedef struct
+{
+	shapedglyph_t* glyphs;
+	size_t numGlyphs;
+	size_t allocGlyphs;
+	int paragraphLevel;
+	int maxLevel;
+	unsigned char nextLigatureId;
+} shapebuffer_t;
+
+typedef struct
+{
+	unsigned short lookup;
+	unsigned short stage;
+	unsigned int mask;
+	int firstGlyph; //Glyphs outside the range can't start a match
+	int lastGlyph;
+} planlookup_t;
+
+//Lookups of the features a script uses, sorted by stage and then by lookup index
+typedef struct
+{
+	int built;
+	planlookup_t* lookups;
+	int numLookups;
+} shapeplan_t;
+
+typedef struct
+{
+	const stbtt_fontinfo* info;
+	otftable_t gsub;
+	otftable_t gpos;
+	otftable_t gdef;
+	unsigned int glyphClassDef;
+	unsigned int markAttachClassDef;
+	unsigned int markGlyphSets;
+
+	//Built when a script is first shaped, [script][0] for GSUB and [script][1] for GPOS
+	shapeplan_t plans[NUM_SCRIPTS][2];
+} shaper_t;
+
+typedef struct
+{
+	unsigned int tag;
+	unsigned int mask;
+	int stage;
+} shapefeature_t;
+
+typedef struct
+{
+	int codepoint;
+	int cluster;
+	unsigned char script;
+	unsigned char level;
+	unsigned char direction;
+	unsigned char font;
+} shapechar_t;
+
+typedef struct
+{
+	shaper_t* shaper;
+	const otftable_t* table;
+	int positioning;
+	shapebuffer_t* buffer;
+	size_t start;
+	size_t maxGlyphs;
+
+	//Of the lookup being applied
+	unsigned int lookupFlag;
+	unsigned int markFilteringSet;
+
+	//Where the lookup continues after a subtable applied
+	size_t next;
+	int depth;
+	long long budget;
+} shapecontext_t;
+
+typedef struct
+{
+	int first;
+	int last;
+	int value;
+} coderange_t;
+
+#define OTF_TAG(a, b, c, d) ((unsigned int)(a) << 24 | (unsigned int)(b) << 16 | (unsigned int)(c) << 8 | (unsigned int)(d))
+
+//Reused between calls so shaping doesn't allocate once it has warmed up
+shapechar_t* shapeChars = NULL;
+size_t allocShapeChars = 0;
+size_t* attachChain = NULL;
+size_t allocAttachChain = 0;
+
+unsigned int ReadU16(const otftable_t* table, unsigned int offset)
+{
+	if (table->length < 2 || offset > table->length - 2)
+		return 0;
+	return (unsigned int)table->data[offset] << 8 | table->data[offset + 1];
+}
+
+int ReadS16(const otftable_t* table, unsigned int offset)
+{
+	return (short)ReadU16(table, offset);
+}
+
+unsigned int ReadU32(const otftable_t* table, unsigned int offset)
+{
+	return ReadU16(table, offset) << 16 | ReadU16(table, offset + 2);
+}
+
+//Offsets are relative to base, 0 means the subtable is missing
+unsigned int ReadOffset(const otftable_t* table, unsigned int base, unsigned int at)
+{
+	unsigned int offset = ReadU16(table, at);
+	return offset == 0 ? 0 : base + offset;
+}
+
+//Index of a glyph in a coverage table, -1 if it isn't covered
+int GetCoverage(const otftable_t* table, unsigned int coverage, int glyph)
+{
+	if (coverage == 0)
+		return -1;
+
+	unsigned int format = ReadU16(table, coverage);
+	int low = 0, high = (int)ReadU16(table, coverage + 2) - 1;
+	while (low <= high)
+	{
+		int middle = (low + high) / 2;
+		if (format == 1)
+		{
+			int value = (int)ReadU16(table, coverage + 4 + 2 * middle);
+			if (glyph < value)
+				high = middle - 1;
+			else if (glyph > value)
+				low = middle + 1;
+			else
+				return middle;
+		}
+		else if (format == 2)
+		{
+			unsigned int range = coverage + 4 + 6 * middle;
+			int first = (int)ReadU16(table, range), last = (int)ReadU16(table, range + 2);
+			if (glyph < first)
+				high = middle - 1;
+			else if (glyph > last)
+				low = middle + 1;
+			else
+				return (int)ReadU16(table, range + 4) + glyph - first;
+		}
+		else
+		{
+			return -1;
+		}
+	}
+	return -1;
+}
+
+//Smallest and largest glyph of a coverage table, an empty range if it can't be read
+void GetCoverageRange(const otftable_t* table, unsigned int coverage, int* first, int* last)
+{
+	unsigned int format = ReadU16(table, coverage), count = ReadU16(table, coverage + 2);
+	if (coverage == 0 || count == 0 || (format != 1 && format != 2))
+		return;
+
+	int low = (int)ReadU16(table, coverage + 4);
+	int high = format == 1 ? (int)ReadU16(table, coverage + 4 + 2 * (count - 1)) : (int)ReadU16(table, coverage + 4 + 6 * (count - 1) + 2);
+	*first = min(*first, low);
+	*last = max(*last, high);
+}
+
+//Class of a glyph in a class definition table, 0 if it isn't listed
+int GetGlyphClass(const otftable_t* table, unsigned int classDef, int glyph)
+{
+	if (classDef == 0)
+		return 0;
+
+	unsigned int format = ReadU16(table, classDef);
+	if (format == 1)
+	{
+		int start = (int)ReadU16(table, classDef + 2), count = (int)ReadU16(table, classDef + 4);
+		return glyph >= start && glyph < start + count ? (int)ReadU16(table, classDef + 6 + 2 * (glyph - start)) : 0;
+	}
+	if (format == 2)
+	{
+		int low = 0, high = (int)ReadU16(table, classDef + 2) - 1;
+		while (low <= high)
+		{
+			int middle = (low + high) / 2;
+			unsigned int range = classDef + 4 + 6 * middle;
+			if (glyph < (int)ReadU16(table, range))
+				high = middle - 1;
+			else if (glyph > (int)ReadU16(table, range + 2))
+				low = middle + 1;
+			else
+				return (int)ReadU16(table, range + 4);
+		}
+	}
+	return 0;
+}
+
+//------------------------------- CHARACTER PROPERTIES ------------------------------
+//Nonspacing and enclosing marks of the supported scripts, for fonts without GDEF
+const coderange_t combiningMarks[] =
+{
+	{ 0x0300, 0x036F, 0 }, { 0x0483, 0x0489, 0 }, { 0x0591, 0x05BD, 0 }, { 0x05BF, 0x05BF, 0 }, { 0x05C1, 0x05C2, 0 },
+	{ 0x05C4, 0x05C5, 0 }, { 0x05C7, 0x05C7, 0 }, { 0x0610, 0x061A, 0 }, { 0x064B, 0x065F, 0 }, { 0x0670, 0x0670, 0 },
+	{ 0x06D6, 0x06DC, 0 }, { 0x06DF, 0x06E4, 0 }, { 0x06E7, 0x06E8, 0 }, { 0x06EA, 0x06ED, 0 }, { 0x08D3, 0x08E1, 0 },
+	{ 0x08E3, 0x08FF, 0 }, { 0x0900, 0x0902, 0 }, { 0x093A, 0x093A, 0 }, { 0x093C, 0x093C, 0 }, { 0x0941, 0x0948, 0 },
+	{ 0x094D, 0x094D, 0 }, { 0x0951, 0x0957, 0 }, { 0x0962, 0x0963, 0 }, { 0x1AB0, 0x1ACE, 0 }, { 0x1DC0, 0x1DFF, 0 },
+	{ 0x20D0, 0x20F0, 0 }, { 0xFE20, 0xFE2F, 0 }
+};
+
+enum
+{
+	JOINING_NONE = 0,
+	JOINING_RIGHT,
+	JOINING_DUAL,
+	JOINING_CAUSING,
+	JOINING_TRANSPARENT
+};
+
+//Joining types of the Arabic letters from ArabicShaping.txt, letters that aren't listed don't join
+const coderange_t arabicJoining[] =
+{
+	{ 0x0620, 0x0620, JOINING_DUAL }, { 0x0622, 0x0625, JOINING_RIGHT }, { 0x0626, 0x0626, JOINING_DUAL },
+	{ 0x0627, 0x0627, JOINING_RIGHT }, { 0x0628, 0x0628, JOINING_DUAL }, { 0x0629, 0x0629, JOINING_RIGHT },
+	{ 0x062A, 0x062E, JOINING_DUAL }, { 0x062F, 0x0632, JOINING_RIGHT }, { 0x0633, 0x063F, JOINING_DUAL },
+	{ 0x0640, 0x0640, JOINING_CAUSING }, { 0x0641, 0x0647, JOINING_DUAL }, { 0x0648, 0x0648, JOINING_RIGHT },
+	{ 0x0649, 0x064A, JOINING_DUAL }, { 0x066E, 0x066F, JOINING_DUAL }, { 0x0671, 0x0673, JOINING_RIGHT },
+	{ 0x0675, 0x0677, JOINING_RIGHT }, { 0x0678, 0x0687, JOINING_DUAL }, { 0x0688, 0x0699, JOINING_RIGHT },
+	{ 0x069A, 0x06BF, JOINING_DUAL }, { 0x06C0, 0x06C0, JOINING_RIGHT }, { 0x06C1, 0x06C2, JOINING_DUAL },
+	{ 0x06C3, 0x06CB, JOINING_RIGHT }, { 0x06CC, 0x06CC, JOINING_DUAL }, { 0x06CD, 0x06CD, JOINING_RIGHT },
+	{ 0x06CE, 0x06CE, JOINING_DUAL }, { 0x06CF, 0x06CF, JOINING_RIGHT }, { 0x06D0, 0x06D1, JOINING_DUAL },
+	{ 0x06D2, 0x06D3, JOINING_RIGHT }, { 0x06D5, 0x06D5, JOINING_RIGHT }, { 0x06EE, 0x06EF, JOINING_RIGHT },
+	{ 0x06FA, 0x06FC, JOINING_DUAL }, { 0x06FF, 0x06FF, JOINING_DUAL }, { 0x0750, 0x0758, JOINING_DUAL },
+	{ 0x0759, 0x075B, JOINING_RIGHT }, { 0x075C, 0x076A, JOINING_DUAL }, { 0x076B, 0x076C, JOINING_RIGHT },
+	{ 0x076D, 0x0770, JOINING_DUAL }, { 0x0771, 0x0771, JOINING_RIGHT }, { 0x0772, 0x0772, JOINING_DUAL },
+	{ 0x0773, 0x0774, JOINING_RIGHT }, { 0x0775, 0x0777, JOINING_DUAL }, { 0x0778, 0x0779, JOINING_RIGHT },
+	{ 0x077A, 0x077F, JOINING_DUAL }
+};
+
+//Range holding codepoint in a sorted table, NULL if there is none
+const coderange_t* FindCodeRange(const coderange_t* ranges, int count, int codepoint)
+{
+	int low = 0, high = count - 1;
+	while (low <= high)
+	{
+		int middle = (low + high) / 2;
+		if (codepoint < ranges[middle].first)
+			high = middle - 1;
+		else if (codepoint > ranges[middle].last)
+			low = middle + 1;
+		else
+			return ranges + middle;
+	}
+	return NULL;
+}
+
+int IsCombiningMark(int codepoint)
+{
+	return FindCodeRange(combiningMarks, sizeof(combiningMarks) / sizeof(coderange_t), codepoint) != NULL;
+}
+
+int GetJoiningType(int codepoint)
+{
+	if (codepoint == 0x200D)
+		return JOINING_CAUSING;
+	if (IsCombiningMark(codepoint))
+		return JOINING_TRANSPARENT;
+	const coderange_t* range = FindCodeRange(arabicJoining, sizeof(arabicJoining) / sizeof(coderange_t), codepoint);
+	return range != NULL ? range->value : JOINING_NONE;
+}
+
+//Characters that are never drawn unless the font uses them in a substitution
+int IsDefaultIgnorable(int codepoint)
+{
+	return codepoint == 0x00AD || codepoint == 0x034F || (codepoint >= 0x180B && codepoint <= 0x180E) ||
+		(codepoint >= 0x200B && codepoint <= 0x200F) || (codepoint >= 0x202A && codepoint <= 0x202E) ||
+		(codepoint >= 0x2060 && codepoint <= 0x206F) || (codepoint >= 0xFE00 && codepoint <= 0xFE0F) || codepoint == 0xFEFF;
+}
+
+//Characters of no particular script, such as digits, spaces and punctuation, are SCRIPT_COMMON and join the run around them
+int GetScript(int c)
+{
+	if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= 0x00C0 && c <= 0x024F && c != 0x00D7 && c != 0x00F7) ||
+		(c >= 0x1E00 && c <= 0x1EFF) || (c >= 0xFB00 && c <= 0xFB06))
+		return SCRIPT_LATIN;
+	if ((c >= 0x0370 && c <= 0x03FF) || (c >= 0x1F00 && c <= 0x1FFF))
+		return SCRIPT_GREEK;
+	if (c >= 0x0400 && c <= 0x052F)
+		return SCRIPT_CYRILLIC;
+	if ((c >= 0x0591 && c <= 0x05FF) || (c >= 0xFB1D && c <= 0xFB4F))
+		return SCRIPT_HEBREW;
+	if ((c >= 0x0600 && c <= 0x06FF) || (c >= 0x0750 && c <= 0x077F) || (c >= 0x08A0 && c <= 0x08FF) ||
+		(c >= 0xFB50 && c <= 0xFDFF) || (c >= 0xFE70 && c <= 0xFEFF))
+		return SCRIPT_ARABIC;
+	if ((c >= 0x0900 && c <= 0x097F) || (c >= 0xA8E0 && c <= 0xA8FF))
+		return SCRIPT_DEVANAGARI;
+	return SCRIPT_COMMON;
+}
+
+//Directions the bidi levels are resolved from, a subset of the classes of the Unicode bidi algorithm
+enum
+{
+	BIDI_LEFT = 0,
+	BIDI_RIGHT,
+	BIDI_NUMBER,
+	BIDI_NEUTRAL,
+	BIDI_MARK
+};
+
+int GetBidiClass(int c)
+{
+	if ((c >= '0' && c <= '9') || (c >= 0x0660 && c <= 0x0669) || (c >= 0x06F0 && c <= 0x06F9))
+		return BIDI_NUMBER;
+	if (c == 0x200E)
+		return BIDI_LEFT;
+	if (c == 0x200F)
+		return BIDI_RIGHT;
+	if (IsCombiningMark(c))
+		return BIDI_MARK;
+	if (c == 0x060C)
+		return BIDI_NEUTRAL;
+	if ((c >= 0x0590 && c <= 0x08FF) || (c >= 0xFB1D && c <= 0xFDFF) || (c >= 0xFE70 && c <= 0xFEFF) ||
+		(c >= 0x10800 && c <= 0x10FFF) || (c >= 0x1E800 && c <= 0x1EFFF))
+		return BIDI_RIGHT;
+	if (c < 0x80)
+		return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') ? BIDI_LEFT : BIDI_NEUTRAL;
+	if (c <= 0xBF)
+		return c == 0xAA || c == 0xB5 || c == 0xBA ? BIDI_LEFT : BIDI_NEUTRAL;
+	if (c == 0xD7 || c == 0xF7 || (c >= 0x2000 && c <= 0x2BFF) || (c >= 0x3000 && c <= 0x303F) ||
+		(c >= 0xFE30 && c <= 0xFE4F) || (c >= 0xFF00 && c <= 0xFF20) || (c >= 0x1F000 && c <= 0x1FAFF))
+		return BIDI_NEUTRAL;
+	return BIDI_LEFT;
+}
+
+//Brackets are drawn mirrored in right to left text
+int GetMirroredCodepoint(int c)
+{
+	switch (c)
+	{
+	case '(': return ')';
+	case ')': return '(';
+	case '<': return '>';
+	case '>': return '<';
+	case '[': return ']';
+	case ']': return '[';
+	case '{': return '}';
+	case '}': return '{';
+	case 0x00AB: return 0x00BB;
+	case 0x00BB: return 0x00AB;
+	case 0x2039: return 0x203A;
+	case 0x203A: return 0x2039;
+	}
+	return c;
+}
+
+enum
+{
+	INDIC_OTHER = 0,
+	INDIC_CONSONANT,
+	INDIC_VOWEL,
+	INDIC_NUKTA,
+	INDIC_HALANT,
+	INDIC_MATRA,
+	INDIC_MODIFIER,
+	INDIC_JOINER
+};
+
+int GetDevanagariCategory(int c)
+{
+	if (c == 0x200C || c == 0x200D)
+		return INDIC_JOINER;
+	if ((c >= 0x0915 && c <= 0x0939) || (c >= 0x0958 && c <= 0x095F) || (c >= 0x0978 && c <= 0x097F))
+		return INDIC_CONSONANT;
+	if ((c >= 0x0904 && c <= 0x0914) || c == 0x0960 || c == 0x0961 || (c >= 0x0972 && c <= 0x0977))
+		return INDIC_VOWEL;
+	if (c == 0x093C)
+		return INDIC_NUKTA;
+	if (c == 0x094D)
+		return INDIC_HALANT;
+	if ((c >= 0x093A && c <= 0x094F && c != 0x093D) || (c >= 0x0955 && c <= 0x0957) || c == 0x0962 || c == 0x0963)
+		return INDIC_MATRA;
+	if ((c >= 0x0900 && c <= 0x0903) || (c >= 0x0951 && c <= 0x0954))
+		return INDIC_MODIFIER;
+	return INDIC_OTHER;
+}
+
+//--------------------------------- FEATURE PLANS ---------------------------------
+//Features in the order they are applied, the lookups of one stage are applied together in lookup list order
+const shapefeature_t defaultSubstitutions[] =
+{
+	{ OTF_TAG('c', 'c', 'm', 'p'), FEATURE_GLOBAL, 0 }, { OTF_TAG('l', 'o', 'c', 'l'), FEATURE_GLOBAL, 0 },
+	{ OTF_TAG('r', 'l', 'i', 'g'), FEATURE_GLOBAL, 1 }, { OTF_TAG('r', 'c', 'l', 't'), FEATURE_GLOBAL, 1 },
+	{ OTF_TAG('c', 'a', 'l', 't'), FEATURE_GLOBAL, 1 }, { OTF_TAG('l', 'i', 'g', 'a'), FEATURE_GLOBAL, 1 },
+	{ OTF_TAG('c', 'l', 'i', 'g'), FEATURE_GLOBAL, 1 }
+};
+
+const shapefeature_t arabicSubstitutions[] =
+{
+	{ OTF_TAG('c', 'c', 'm', 'p'), FEATURE_GLOBAL, 0 }, { OTF_TAG('l', 'o', 'c', 'l'), FEATURE_GLOBAL, 0 },
+	{ OTF_TAG('i', 's', 'o', 'l'), FEATURE_ISOL, 1 }, { OTF_TAG('f', 'i', 'n', 'a'), FEATURE_FINA, 2 },
+	{ OTF_TAG('m', 'e', 'd', 'i'), FEATURE_MEDI, 3 }, { OTF_TAG('i', 'n', 'i', 't'), FEATURE_INIT, 4 },
+	{ OTF_TAG('r', 'l', 'i', 'g'), FEATURE_GLOBAL, 5 }, { OTF_TAG('r', 'c', 'l', 't'), FEATURE_GLOBAL, 6 },
+	{ OTF_TAG('c', 'a', 'l', 't'), FEATURE_GLOBAL, 6 }, { OTF_TAG('l', 'i', 'g', 'a'), FEATURE_GLOBAL, 6 },
+	{ OTF_TAG('c', 'l', 'i', 'g'), FEATURE_GLOBAL, 6 }, { OTF_TAG('m', 's', 'e', 't'), FEATURE_GLOBAL, 6 }
+};
+
+//Reph is moved into place between the basic and the presentation features
+#define DEVANAGARI_REORDER_STAGE 10
+
+const shapefeature_t devanagariSubstitutions[] =
+{
+	{ OTF_TAG('l', 'o', 'c', 'l'), FEATURE_GLOBAL, 0 }, { OTF_TAG('c', 'c', 'm', 'p'), FEATURE_GLOBAL, 0 },
+	{ OTF_TAG('n', 'u', 'k', 't'), FEATURE_GLOBAL, 1 }, { OTF_TAG('a', 'k', 'h', 'n'), FEATURE_GLOBAL, 2 },
+	{ OTF_TAG('r', 'p', 'h', 'f'), FEATURE_RPHF, 3 }, { OTF_TAG('r', 'k', 'r', 'f'), FEATURE_GLOBAL, 4 },
+	{ OTF_TAG('b', 'l', 'w', 'f'), FEATURE_GLOBAL, 5 }, { OTF_TAG('h', 'a', 'l', 'f'), FEATURE_HALF, 6 },
+	{ OTF_TAG('p', 's', 't', 'f'), FEATURE_GLOBAL, 7 }, { OTF_TAG('v', 'a', 't', 'u'), FEATURE_GLOBAL, 8 },
+	{ OTF_TAG('c', 'j', 'c', 't'), FEATURE_GLOBAL, 9 }, { OTF_TAG('p', 'r', 'e', 's'), FEATURE_GLOBAL, 10 },
+	{ OTF_TAG('a', 'b', 'v', 's'), FEATURE_GLOBAL, 10 }, { OTF_TAG('b', 'l', 'w', 's'), FEATURE_GLOBAL, 10 },
+	{ OTF_TAG('p', 's', 't', 's'), FEATURE_GLOBAL, 10 }, { OTF_TAG('h', 'a', 'l', 'n'), FEATURE_GLOBAL, 10 },
+	{ OTF_TAG('c', 'a', 'l', 't'), FEATURE_GLOBAL, 10 }, { OTF_TAG('c', 'l', 'i', 'g'), FEATURE_GLOBAL, 10 }
+};
+
+const shapefeature_t positionings[] =
+{
+	{ OTF_TAG('a', 'b', 'v', 'm'), FEATURE_GLOBAL, 0 }, { OTF_TAG('b', 'l', 'w', 'm'), FEATURE_GLOBAL, 0 },
+	{ OTF_TAG('c', 'u', 'r', 's'), FEATURE_GLOBAL, 0 }, { OTF_TAG('d', 'i', 's', 't'), FEATURE_GLOBAL, 0 },
+	{ OTF_TAG('m', 'a', 'r', 'k'), FEATURE_GLOBAL, 0 }, { OTF_TAG('m', 'k', 'm', 'k'), FEATURE_GLOBAL, 0 }
+};
+
+//Script tags to look for in order, DFLT and latn are tried after them
+const unsigned int scriptTags[NUM_SCRIPTS][2] =
+{
+	{ OTF_TAG('D', 'F', 'L', 'T'), 0 },
+	{ OTF_TAG('l', 'a', 't', 'n'), 0 },
+	{ OTF_TAG('g', 'r', 'e', 'k'), 0 },
+	{ OTF_TAG('c', 'y', 'r', 'l'), 0 },
+	{ OTF_TAG('h', 'e', 'b', 'r'), 0 },
+	{ OTF_TAG('a', 'r', 'a', 'b'), 0 },
+	{ OTF_TAG('d', 'e', 'v', '2'), OTF_TAG('d', 'e', 'v', 'a') }
+};
+
+//Default language system of the script, or its first one if there is no default
+unsigned int FindLangSys(const otftable_t* table, int script)
+{
+	unsigned int scriptList = ReadOffset(table, 0, 4);
+	if (scriptList == 0)
+		return 0;
+
+	unsigned int tags[4] = { scriptTags[script][0], scriptTags[script][1], OTF_TAG('D', 'F', 'L', 'T'), OTF_TAG('l', 'a', 't', 'n') };
+	unsigned int count = ReadU16(table, scriptList);
+	for (int t = 0; t < 4; t++)
+	{
+		for (unsigned int i = 0; tags[t] != 0 && i < count; i++)
+		{
+			if (ReadU32(table, scriptList + 2 + 6 * i) != tags[t])
+				continue;
+
+			unsigned int scriptTable = ReadOffset(table, scriptList, scriptList + 6 + 6 * i);
+			if (scriptTable == 0)
+				return 0;
+			unsigned int langSys = ReadOffset(table, scriptTable, scriptTable);
+			if (langSys == 0 && ReadU16(table, scriptTable + 2) > 0)
+				langSys = ReadOffset(table, scriptTable, scriptTable + 8);
+			return langSys;
+		}
+	}
+	return 0;
+}
+
+unsigned int GetLookup(const otftable_t* table, unsigned int lookupIndex)
+{
+	unsigned int lookupList = ReadOffset(table, 0, 8);
+	if (lookupList == 0 || lookupIndex >= ReadU16(table, lookupList))
+		return 0;
+	return ReadOffset(table, lookupList, lookupList + 2 + 2 * lookupIndex);
+}
+
+//Glyphs the subtables of a lookup start on. Every subtable but the third context format has its coverage first
+void GetLookupGlyphRange(const otftable_t* table, int positioning, planlookup_t* entry)
+{
+	entry->firstGlyph = INT_MAX;
+	entry->lastGlyph = -1;
+	unsigned int lookup = GetLookup(table, entry->lookup);
+	if (lookup == 0)
+		return;
+
+	unsigned int type = ReadU16(table, lookup), count = ReadU16(table, lookup + 4);
+	unsigned int extension = positioning ? 9 : 7, context = positioning ? 7 : 5;
+	for (unsigned int i = 0; i < count; i++)
+	{
+		unsigned int subtable = ReadOffset(table, lookup, lookup + 6 + 2 * i), subtableType = type;
+		if (subtable == 0)
+			continue;
+		if (type == extension)
+		{
+			subtableType = ReadU16(table, subtable + 2);
+			subtable += ReadU32(table, subtable + 4);
+		}
+
+		if ((subtableType == context || subtableType == context + 1) && ReadU16(table, subtable) == 3)
+		{
+			entry->firstGlyph = 0;
+			entry->lastGlyph = INT_MAX;
+			return;
+		}
+		GetCoverageRange(table, ReadOffset(table, subtable, subtable + 2), &entry->firstGlyph, &entry->lastGlyph);
+	}
+}
+
+void AddPlanLookup(shapeplan_t* plan, unsigned int lookup, unsigned int mask, int stage)
+{
+	planlookup_t* entry = plan->lookups + plan->numLookups++;
+	entry->lookup = (unsigned short)lookup;
+	entry->stage = (unsigned short)stage;
+	entry->mask = mask;
+}
+
+int ComparePlanLookups(const void* a, const void* b)
+{
+	const planlookup_t* first = a;
+	const planlookup_t* second = b;
+	if (first->stage != second->stage)
+		return first->stage < second->stage ? -1 : 1;
+	return first->lookup < second->lookup ? -1 : first->lookup > second->lookup;
+}
+
+//Collects the lookups of the features the script uses, the required feature applies everywhere
+void BuildShapePlan(const otftable_t* table, int positioning, int script, const shapefeature_t* features, int numFeatures, shapeplan_t* plan)
+{
+	plan->built = 1;
+	unsigned int featureList = ReadOffset(table, 0, 6);
+	unsigned int langSys = FindLangSys(table, script);
+	if (featureList == 0 || langSys == 0)
+		return;
+
+	plan->lookups = malloc(sizeof(planlookup_t) * MAX_PLAN_LOOKUPS);
+	unsigned int numFeatureRecords = ReadU16(table, featureList);
+	unsigned int required = ReadU16(table, langSys + 2), count = ReadU16(table, langSys + 4);
+	for (unsigned int i = 0; i <= count && plan->numLookups < MAX_PLAN_LOOKUPS; i++)
+	{
+		unsigned int index = i < count ? ReadU16(table, langSys + 6 + 2 * i) : required;
+		if (index >= numFeatureRecords)
+			continue;
+
+		unsigned int record = featureList + 2 + 6 * index, tag = ReadU32(table, record);
+		unsigned int mask = FEATURE_GLOBAL;
+		int stage = 0, found = i == count;
+		for (int f = 0; f < numFeatures && !found; f++)
+		{
+			if (features[f].tag == tag)
+			{
+				mask = features[f].mask;
+				stage = features[f].stage;
+				found = 1;
+			}
+		}
+		if (!found)
+			continue;
+
+		unsigned int feature = ReadOffset(table, featureList, record + 4);
+		unsigned int lookupCount = feature != 0 ? ReadU16(table, feature + 2) : 0;
+		for (unsigned int l = 0; l < lookupCount && plan->numLookups < MAX_PLAN_LOOKUPS; l++)
+			AddPlanLookup(plan, ReadU16(table, feature + 4 + 2 * l), mask, stage);
+	}
+
+	//A lookup shared by features of the same stage is applied once with their masks combined
+	qsort(plan->lookups, plan->numLookups, sizeof(planlookup_t), ComparePlanLookups);
+	int merged = 0;
+	for (int i = 0; i < plan->numLookups; i++)
+	{
+		if (merged > 0 && plan->lookups[merged - 1].lookup == plan->lookups[i].lookup && plan->lookups[merged - 1].stage == plan->lookups[i].stage)
+			plan->lookups[merged - 1].mask |= plan->lookups[i].mask;
+		else
+			plan->lookups[merged++] = plan->lookups[i];
+	}
+	plan->numLookups = merged;
+	for (int i = 0; i < plan->numLookups; i++)
+		GetLookupGlyphRange(table, positioning, plan->lookups + i);
+}
+
+shapeplan_t* GetShapePlan(shaper_t* shaper, int script, int positioning)
+{
+	shapeplan_t* plan = &shaper->plans[script][positioning];
+	if (plan->built)
+		return plan;
+
+	if (positioning)
+		BuildShapePlan(&shaper->gpos, 1, script, positionings, sizeof(positionings) / sizeof(shapefeature_t), plan);
+	else if (script == SCRIPT_ARABIC)
+		BuildShapePlan(&shaper->gsub, 0, script, arabicSubstitutions, sizeof(arabicSubstitutions) / sizeof(shapefeature_t), plan);
+	else if (script == SCRIPT_DEVANAGARI)
+		BuildShapePlan(&shaper->gsub, 0, script, devanagariSubstitutions, sizeof(devanagariSubstitutions) / sizeof(shapefeature_t), plan);
+	else
+		BuildShapePlan(&shaper->gsub, 0, script, defaultSubstitutions, sizeof(defaultSubstitutions) / sizeof(shapefeature_t), plan);
+	return plan;
+}
+
+void LoadLayoutTable(const stbtt_fontinfo* info, const char* tag, otftable_t* table)
+{
+	stbtt_uint32 length = 0;
+	stbtt_uint32 offset = stbtt__find_table_length(info->data, info->fontstart, tag, &length);
+	table->data = info->data + offset;
+	table->length = offset != 0 ? length : 0;
+
+	//Only version 1 of the layout tables is known
+	if (ReadU16(table, 0) != 1)
+		table->length = 0;
+}
+
+void InitShaper(shaper_t* shaper, const stbtt_fontinfo* info)
+{
+	memset(shaper, 0, sizeof(shaper_t));
+	shaper->info = info;
+	LoadLayoutTable(info, "GSUB", &shaper->gsub);
+	LoadLayoutTable(info, "GPOS", &shaper->gpos);
+	LoadLayoutTable(info, "GDEF", &shaper->gdef);
+
+	shaper->glyphClassDef = ReadOffset(&shaper->gdef, 0, 4);
+	shaper->markAttachClassDef = ReadOffset(&shaper->gdef, 0, 10);
+	if (ReadU16(&shaper->gdef, 2) >= 2)
+		shaper->markGlyphSets = ReadOffset(&shaper->gdef, 0, 12);
+}
+
+void FreeShaper(shaper_t* shaper)
+{
+	for (int s = 0; s < NUM_SCRIPTS; s++)
+	{
+		free(shaper->plans[s][0].lookups);
+		free(shaper->plans[s][1].lookups);
+	}
+	memset(shaper, 0, sizeof(shaper_t));
+}
+
+void FreeShapingScratch()
+{
+	free(shapeChars);
+	free(attachChain);
+	shapeChars = NULL;
+	attachChain = NULL;
+	allocShapeChars = 0;
+	allocAttachChain = 0;
+}
+
+//----------------------------------- BUFFER ------------------------------------
+void ReserveShapeBuffer(shapebuffer_t* buffer, size_t count)
+{
+	if (count <= buffer->allocGlyphs)
+		return;
+	buffer->allocGlyphs = max(count, buffer->allocGlyphs * 2);
+	buffer->glyphs = realloc(buffer->glyphs, sizeof(shapedglyph_t) * buffer->allocGlyphs);
+}
+
+void FreeShapeBuffer(shapebuffer_t* buffer)
+{
+	free(buffer->glyphs);
+	memset(buffer, 0, sizeof(shapebuffer_t));
+}
+
+//GDEF classes when the font has them, otherwise marks are told apart by their character
+int GetInitialClass(const shaper_t* shaper, int glyph, int codepoint)
+{
+	if (shaper->glyphClassDef != 0)
+		return GetGlyphClass(&shaper->gdef, shaper->glyphClassDef, glyph);
+	return IsCombiningMark(codepoint) ? GLYPH_MARK : GLYPH_BASE;
+}
+
+//Replaces a glyph, substitutions can't reach glyphs the font doesn't have
+void SetGlyph(shapecontext_t* context, size_t index, int glyph)
+{
+	shapedglyph_t* shaped = context->buffer->glyphs + index;
+	shaped->glyph = glyph < context->shaper->info->numGlyphs ? glyph : 0;
+	shaped->flags |= SHAPED_SUBSTITUTED;
+	if (context->shaper->glyphClassDef != 0)
+		shaped->glyphClass = (unsigned char)GetGlyphClass(&context->shaper->gdef, context->shaper->glyphClassDef, shaped->glyph);
+}
+
+//Makes room for count copies of the glyph at index after it, fails when the run would grow too long
+int InsertGlyphs(shapecontext_t* context, size_t index, size_t count)
+{
+	shapebuffer_t* buffer = context->buffer;
+	if (buffer->numGlyphs + count > context->maxGlyphs)
+		return 0;
+
+	ReserveShapeBuffer(buffer, buffer->numGlyphs + count);
+	memmove(buffer->glyphs + index + 1 + count, buffer->glyphs + index + 1, sizeof(shapedglyph_t) * (buffer->numGlyphs - index - 1));
+	for (size_t i = 0; i < count; i++)
+		buffer->glyphs[index + 1 + i] = buffer->glyphs[index];
+	buffer->numGlyphs += count;
+	return 1;
+}
+
+void RemoveGlyph(shapebuffer_t* buffer, size_t index)
+{
+	memmove(buffer->glyphs + index, buffer->glyphs + index + 1, sizeof(shapedglyph_t) * (buffer->numGlyphs - index - 1));
+	buffer->numGlyphs--;
+}
+
+//Moves the glyph at from to position to, the glyphs between shift by one
+void MoveGlyph(shapebuffer_t* buffer, size_t from, size_t to)
+{
+	shapedglyph_t glyph = buffer->glyphs[from];
+	if (from < to)
+		memmove(buffer->glyphs + from, buffer->glyphs + from + 1, sizeof(shapedglyph_t) * (to - from));
+	else
+		memmove(buffer->glyphs + to + 1, buffer->glyphs + to, sizeof(shapedglyph_t) * (from - to));
+	buffer->glyphs[to] = glyph;
+}
+
+//----------------------------------- LOOKUPS -----------------------------------
+void SetLookupFlags(shapecontext_t* context, unsigned int lookup)
+{
+	const otftable_t* table = context->table;
+	context->lookupFlag = ReadU16(table, lookup + 2);
+	context->markFilteringSet = 0;
+
+	//The set index follows the subtable offsets, the sets are coverage tables listed in GDEF
+	shaper_t* shaper = context->shaper;
+	if ((context->lookupFlag & LOOKUP_USE_MARK_FILTERING_SET) && shaper->markGlyphSets != 0)
+	{
+		unsigned int set = ReadU16(table, lookup + 6 + 2 * ReadU16(table, lookup + 4));
+		if (set < ReadU16(&shaper->gdef, shaper->markGlyphSets + 2))
+			context->markFilteringSet = shaper->markGlyphSets + ReadU32(&shaper->gdef, shaper->markGlyphSets + 4 + 4 * set);
+	}
+}
+
+//Lookups skip glyphs by class as their flags say, skipped glyphs are invisible to matching
+int IsGlyphSkipped(const shapecontext_t* context, const shapedglyph_t* glyph)
+{
+	unsigned int flag = context->lookupFlag;
+	const shaper_t* shaper = context->shaper;
+	switch (glyph->glyphClass)
+	{
+	case GLYPH_BASE:
+		return (flag & LOOKUP_IGNORE_BASE_GLYPHS) != 0;
+	case GLYPH_LIGATURE:
+		return (flag & LOOKUP_IGNORE_LIGATURES) != 0;
+	case GLYPH_MARK:
+		if (flag & LOOKUP_IGNORE_MARKS)
+			return 1;
+		if (flag & LOOKUP_USE_MARK_FILTERING_SET)
+			return GetCoverage(&shaper->gdef, context->markFilteringSet, glyph->glyph) < 0;
+		if (flag & 0xFF00)
+			return GetGlyphClass(&shaper->gdef, shaper->markAttachClassDef, glyph->glyph) != (int)(flag >> 8);
+		return 0;
+	}
+	return 0;
+}
+
+//Next glyph after index the lookup doesn't skip, numGlyphs if there is none
+size_t NextGlyph(const shapecontext_t* context, size_t index)
+{
+	while (++index < context->buffer->numGlyphs && IsGlyphSkipped(context, context->buffer->glyphs + index));
+	return index;
+}
+
+//Previous glyph before index the lookup doesn't skip, SIZE_MAX if there is none
+size_t PreviousGlyph(const shapecontext_t* context, size_t index)
+{
+	while (index-- > context->start)
+	{
+		if (!IsGlyphSkipped(context, context->buffer->glyphs + index))
+			return index;
+	}
+	return SIZE_MAX;
+}
+
+int ApplySubtable(shapecontext_t* context, unsigned int type, unsigned int subtable, size_t index);
+
+//Tries the subtables of a lookup at index until one applies
+int ApplyLookupSubtables(shapecontext_t* context, unsigned int lookup, size_t index)
+{
+	const otftable_t* table = context->table;
+	unsigned int type = ReadU16(table, lookup), count = ReadU16(table, lookup + 4);
+	for (unsigned int i = 0; i < count; i++)
+	{
+		if (--context->budget < 0)
+			return 0;
+
+		unsigned int subtable = ReadOffset(table, lookup, lookup + 6 + 2 * i);
+		if (subtable != 0 && ApplySubtable(context, type, subtable, index))
+			return 1;
+	}
+	return 0;
+}
+
+//A lookup called by a contextual rule applies once at index with its own flags
+void ApplyNestedLookup(shapecontext_t* context, unsigned int lookupIndex, size_t index)
+{
+	unsigned int lookup = GetLookup(context->table, lookupIndex);
+	if (lookup == 0 || index >= context->buffer->numGlyphs || context->depth >= MAX_LOOKUP_NESTING)
+		return;
+
+	unsigned int lookupFlag = context->lookupFlag, markFilteringSet = context->markFilteringSet;
+	SetLookupFlags(context, lookup);
+	context->depth++;
+	ApplyLookupSubtables(context, lookup, index);
+	context->depth--;
+	context->lookupFlag = lookupFlag;
+	context->markFilteringSet = markFilteringSet;
+}
+
+//Applies a lookup across the run to the glyphs the mask selects
+void ApplyLookup(shapecontext_t* context, const planlookup_t* entry)
+{
+	unsigned int lookup = GetLookup(context->table, entry->lookup);
+	if (lookup == 0)
+		return;
+
+	//Reverse chaining substitutions run from the end of the run and aren't supported
+	if (!context->positioning && ReadU16(context->table, lookup) == 8)
+		return;
+
+	SetLookupFlags(context, lookup);
+	shapebuffer_t* buffer = context->buffer;
+	for (size_t i = context->start; i < buffer->numGlyphs && context->budget > 0;)
+	{
+		const shapedglyph_t* glyph = buffer->glyphs + i;
+		if ((glyph->mask & entry->mask) && glyph->glyph >= entry->firstGlyph && glyph->glyph <= entry->lastGlyph &&
+			!IsGlyphSkipped(context, glyph) && ApplyLookupSubtables(context, lookup, i))
+			i = context->next;
+		else
+			i++;
+	}
+}
+
+void ApplyShapePlan(shapecontext_t* context, const shapeplan_t* plan, int firstStage, int endStage)
+{
+	for (int i = 0; i < plan->numLookups; i++)
+	{
+		if (plan->lookups[i].stage >= firstStage && plan->lookups[i].stage < endStage)
+			ApplyLookup(context, plan->lookups + i);
+	}
+}
+
+//-------------------------------- SUBSTITUTION ---------------------------------
+int ApplySingleSubstitution(shapecontext_t* context, unsigned int subtable, size_t index)
+{
+	const otftable_t* table = context->table;
+	int glyph = context->buffer->glyphs[index].glyph;
+	int coverage = GetCoverage(table, ReadOffset(table, subtable, subtable + 2), glyph);
+	if (coverage < 0)
+		return 0;
+
+	unsigned int format = ReadU16(table, subtable);
+	if (format == 1)
+		glyph = (glyph + ReadS16(table, subtable + 4)) & 0xFFFF;
+	else if (format == 2 && (unsigned int)coverage < ReadU16(table, subtable + 4))
+		glyph = (int)ReadU16(table, subtable + 6 + 2 * coverage);
+	else
+		return 0;
+
+	SetGlyph(context, index, glyph);
+	context->next = index + 1;
+	return 1;
+}
+
+//Replaces a glyph with a sequence, an empty sequence deletes it
+int ApplyMultipleSubstitution(shapecontext_t* context, unsigned int subtable, size_t index)
+{
+	const otftable_t* table = context->table;
+	int coverage = GetCoverage(table, ReadOffset(table, subtable, subtable + 2), context->buffer->glyphs[index].glyph);
+	if (coverage < 0 || ReadU16(table, subtable) != 1 || (unsigned int)coverage >= ReadU16(table, subtable + 4))
+		return 0;
+
+	unsigned int sequence = ReadOffset(table, subtable, subtable + 6 + 2 * coverage);
+	unsigned int count = ReadU16(table, sequence);
+	if (sequence == 0)
+		return 0;
+	if (count == 0)
+	{
+		RemoveGlyph(context->buffer, index);
+		context->next = index;
+		return 1;
+	}
+	if (!InsertGlyphs(context, index, count - 1))
+		return 0;
+
+	for (unsigned int i = 0; i < count; i++)
+		SetGlyph(context, index + i, (int)ReadU16(table, sequence + 2 + 2 * i));
+	context->next = index + count;
+	return 1;
+}
+
+//The first alternate is used, features that pick others aren't applied
+int ApplyAlternateSubstitution(shapecontext_t* context, unsigned int subtable, size_t index)
+{
+	const otftable_t* table = context->table;
+	int coverage = GetCoverage(table, ReadOffset(table, subtable, subtable + 2), context->buffer->glyphs[index].glyph);
+	if (coverage < 0 || ReadU16(table, subtable) != 1 || (unsigned int)coverage >= ReadU16(table, subtable + 4))
+		return 0;
+
+	unsigned int alternates = ReadOffset(table, subtable, subtable + 6 + 2 * coverage);
+	if (alternates == 0 || ReadU16(table, alternates) == 0)
+		return 0;
+
+	SetGlyph(context, index, (int)ReadU16(table, alternates + 2));
+	context->next = index + 1;
+	return 1;
+}
+
+//Marks between the components stay in place, they remember which component they followed for mark to ligature attachment
+int ApplyLigatureSubstitution(shapecontext_t* context, unsigned int subtable, size_t index)
+{
+	const otftable_t* table = context->table;
+	shapebuffer_t* buffer = context->buffer;
+	int coverage = GetCoverage(table, ReadOffset(table, subtable, subtable + 2), buffer->glyphs[index].glyph);
+	if (coverage < 0 || ReadU16(table, subtable) != 1 || (unsigned int)coverage >= ReadU16(table, subtable + 4))
+		return 0;
+
+	unsigned int ligatureSet = ReadOffset(table, subtable, subtable + 6 + 2 * coverage);
+	unsigned int count = ligatureSet != 0 ? ReadU16(table, ligatureSet) : 0;
+	size_t positions[MAX_CONTEXT_LENGTH];
+	for (unsigned int l = 0; l < count; l++)
+	{
+		unsigned int ligature = ReadOffset(table, ligatureSet, ligatureSet + 2 + 2 * l);
+		unsigned int components = ReadU16(table, ligature + 2);
+		if (ligature == 0 || components == 0 || components > MAX_CONTEXT_LENGTH)
+			continue;
+
+		positions[0] = index;
+		unsigned int matched = 1;
+		while (matched < components)
+		{
+			size_t next = NextGlyph(context, positions[matched - 1]);
+			if (next >= buffer->numGlyphs || buffer->glyphs[next].glyph != (int)ReadU16(table, ligature + 4 + 2 * (matched - 1)))
+				break;
+			positions[matched++] = next;
+		}
+		if (matched < components)
+			continue;
+
+		buffer->nextLigatureId = buffer->nextLigatureId == 255 ? 1 : buffer->nextLigatureId + 1;
+		unsigned char ligatureId = buffer->nextLigatureId;
+		int cluster = buffer->glyphs[index].cluster;
+		for (unsigned int c = 1; c < components; c++)
+		{
+			cluster = min(cluster, buffer->glyphs[positions[c]].cluster);
+			for (size_t m = positions[c - 1] + 1; m < positions[c]; m++)
+			{
+				buffer->glyphs[m].ligatureId = ligatureId;
+				buffer->glyphs[m].component = (unsigned char)c;
+			}
+		}
+
+		//Components after the first are removed from the back so the positions before them stay valid
+		for (unsigned int c = components - 1; c > 0; c--)
+			RemoveGlyph(buffer, positions[c]);
+
+		SetGlyph(context, index, (int)ReadU16(table, ligature));
+		shapedglyph_t* glyph = buffer->glyphs + index;
+		glyph->cluster = cluster;
+		glyph->ligatureId = ligatureId;
+		glyph->component = 0;
+		if (context->shaper->glyphClassDef == 0)
+			glyph->glyphClass = GLYPH_LIGATURE;
+		context->next = index + 1;
+		return 1;
+	}
+	return 0;
+}
+
+//---------------------------------- CONTEXTS -----------------------------------
+//Rules name glyphs by glyph index, by class or by coverage table
+enum
+{
+	MATCH_GLYPH = 0,
+	MATCH_CLASS,
+	MATCH_COVERAGE
+};
+
+typedef struct
+{
+	int type;
+	unsigned int classDef;
+	unsigned int base;
+} matcher_t;
+
+int MatchGlyph(const shapecontext_t* context, const matcher_t* matcher, unsigned int value, int glyph)
+{
+	switch (matcher->type)
+	{
+	case MATCH_GLYPH:
+		return glyph == (int)value;
+	case MATCH_CLASS:
+		return GetGlyphClass(context->table, matcher->classDef, glyph) == (int)value;
+	default:
+		return value != 0 && GetCoverage(context->table, matcher->base + value, glyph) >= 0;
+	}
+}
+
+//Matches the input after the glyph at index, which the caller has matched, and stores the position of every input glyph
+int MatchInput(const shapecontext_t* context, const matcher_t* matcher, unsigned int values, unsigned int count, size_t index, size_t* positions)
+{
+	if (count == 0 || count > MAX_CONTEXT_LENGTH)
+		return 0;
+
+	positions[0] = index;
+	for (unsigned int i = 1; i < count; i++)
+	{
+		size_t next = NextGlyph(context, positions[i - 1]);
+		if (next >= context->buffer->numGlyphs || !MatchGlyph(context, matcher, ReadU16(context->table, values + 2 * (i - 1)), context->buffer->glyphs[next].glyph))
+			return 0;
+		positions[i] = next;
+	}
+	return 1;
+}
+
+//Backtrack sequences list the glyph closest to the input first
+int MatchBacktrack(const shapecontext_t* context, const matcher_t* matcher, unsigned int values, unsigned int count, size_t index)
+{
+	for (unsigned int i = 0; i < count; i++)
+	{
+		index = PreviousGlyph(context, index);
+		if (index == SIZE_MAX || !MatchGlyph(context, matcher, ReadU16(context->table, values + 2 * i), context->buffer->glyphs[index].glyph))
+			return 0;
+	}
+	return 1;
+}
+
+int MatchLookahead(const shapecontext_t* context, const matcher_t* matcher, unsigned int values, unsigned int count, size_t index)
+{
+	for (unsigned int i = 0; i < count; i++)
+	{
+		index = NextGlyph(context, index);
+		if (index >= context->buffer->numGlyphs || !MatchGlyph(context, matcher, ReadU16(context->table, values + 2 * i), context->buffer->glyphs[index].glyph))
+			return 0;
+	}
+	return 1;
+}
+
+//Applies the lookups of a matched rule at its input glyphs, later positions move when a lookup changes the glyph count
+void ApplyNestedLookups(shapecontext_t* context, size_t* positions, unsigned int inputCount, unsigned int records, unsigned int recordCount)
+{
+	size_t end = positions[inputCount - 1] + 1;
+	for (unsigned int r = 0; r < recordCount; r++)
+	{
+		unsigned int sequenceIndex = ReadU16(context->table, records + 4 * r);
+		if (sequenceIndex >= inputCount)
+			continue;
+
+		size_t before = context->buffer->numGlyphs;
+		ApplyNestedLookup(context, ReadU16(context->table, records + 4 * r + 2), positions[sequenceIndex]);
+		size_t after = context->buffer->numGlyphs;
+		if (after == before)
+			continue;
+
+		for (unsigned int i = sequenceIndex + 1; i < inputCount; i++)
+			positions[i] = after > before ? positions[i] + (after - before) : max(positions[i] - min(before - after, positions[i]), positions[sequenceIndex]);
+		end = after > before ? end + (after - before) : end - min(before - after, end);
+	}
+	context->next = max(end, positions[0] + 1);
+}
+
+//Matches one rule, sequences start at their offsets and the input values leave out the first glyph
+int ApplyRule(shapecontext_t* context, size_t index, const matcher_t* backtrackMatcher, unsigned int backtrack, unsigned int backtrackCount,
+	const matcher_t* inputMatcher, unsigned int input, unsigned int inputCount, const matcher_t* lookaheadMatcher, unsigned int lookahead,
+	unsigned int lookaheadCount, unsigned int records, unsigned int recordCount)
+{
+	size_t positions[MAX_CONTEXT_LENGTH];
+	if (!MatchInput(context, inputMatcher, input, inputCount, index, positions) ||
+		!MatchBacktrack(context, backtrackMatcher, backtrack, backtrackCount, index) ||
+		!MatchLookahead(context, lookaheadMatcher, lookahead, lookaheadCount, positions[inputCount - 1]))
+		return 0;
+
+	ApplyNestedLookups(context, positions, inputCount, records, recordCount);
+	return 1;
+}
+
+//Rule sets of format 1 and 2 subtables, chained rules have backtrack and lookahead sequences
+int ApplyRuleSet(shapecontext_t* context, unsigned int ruleSet, int chained, const matcher_t* backtrackMatcher, const matcher_t* inputMatcher,
+	const matcher_t* lookaheadMatcher, size_t index)
+{
+	const otftable_t* table = context->table;
+	unsigned int count = ruleSet != 0 ? ReadU16(table, ruleSet) : 0;
+	for (unsigned int r = 0; r < count; r++)
+	{
+		unsigned int rule = ReadOffset(table, ruleSet, ruleSet + 2 + 2 * r);
+		if (rule == 0)
+			continue;
+
+		unsigned int backtrackCount = 0, backtrack = 0, lookaheadCount = 0, lookahead = 0, inputCount, input, recordCount, records;
+		if (chained)
+		{
+			backtrackCount = ReadU16(table, rule);
+			backtrack = rule + 2;
+			rule = backtrack + 2 * backtrackCount;
+		}
+		inputCount = ReadU16(table, rule);
+		if (inputCount == 0)
+			continue;
+
+		if (chained)
+		{
+			input = rule + 2;
+			lookaheadCount = ReadU16(table, input + 2 * (inputCount - 1));
+			lookahead = input + 2 * (inputCount - 1) + 2;
+			recordCount = ReadU16(table, lookahead + 2 * lookaheadCount);
+			records = lookahead + 2 * lookaheadCount + 2;
+		}
+		else
+		{
+			recordCount = ReadU16(table, rule + 2);
+			input = rule + 4;
+			records = input + 2 * (inputCount - 1);
+		}
+
+		if (ApplyRule(context, index, backtrackMatcher, backtrack, backtrackCount, inputMatcher, input, inputCount,
+			lookaheadMatcher, lookahead, lookaheadCount, records, recordCount))
+			return 1;
+	}
+	return 0;
+}
+
+int ApplyContext(shapecontext_t* context, unsigned int subtable, size_t index)
+{
+	const otftable_t* table = context->table;
+	int glyph = context->buffer->glyphs[index].glyph;
+	switch (ReadU16(table, subtable))
+	{
+	case 1:
+	{
+		int coverage = GetCoverage(table, ReadOffset(table, subtable, subtable + 2), glyph);
+		if (coverage < 0 || (unsigned int)coverage >= ReadU16(table, subtable + 4))
+			return 0;
+		matcher_t matcher = { MATCH_GLYPH, 0, 0 };
+		return ApplyRuleSet(context, ReadOffset(table, subtable, subtable + 6 + 2 * coverage), 0, &matcher, &matcher, &matcher, index);
+	}
+	case 2:
+	{
+		if (GetCoverage(table, ReadOffset(table, subtable, subtable + 2), glyph) < 0)
+			return 0;
+		matcher_t matcher = { MATCH_CLASS, ReadOffset(table, subtable, subtable + 4), 0 };
+		unsigned int glyphClass = (unsigned int)GetGlyphClass(table, matcher.classDef, glyph);
+		if (glyphClass >= ReadU16(table, subtable + 6))
+			return 0;
+		return ApplyRuleSet(context, ReadOffset(table, subtable, subtable + 8 + 2 * glyphClass), 0, &matcher, &matcher, &matcher, index);
+	}
+	case 3:
+	{
+		unsigned int inputCount = ReadU16(table, subtable + 2), recordCount = ReadU16(table, subtable + 4);
+		matcher_t matcher = { MATCH_COVERAGE, 0, subtable };
+		if (inputCount == 0 || !MatchGlyph(context, &matcher, ReadU16(table, subtable + 6), glyph))
+			return 0;
+		return ApplyRule(context, index, &matcher, 0, 0, &matcher, subtable + 8, inputCount, &matcher, 0, 0,
+			subtable + 6 + 2 * inputCount, recordCount);
+	}
+	}
+	return 0;
+}
+
+int ApplyChainedContext(shapecontext_t* context, unsigned int subtable, size_t index)
+{
+	const otftable_t* table = context->table;
+	int glyph = context->buffer->glyphs[index].glyph;
+	switch (ReadU16(table, subtable))
+	{
+	case 1:
+	{
+		int coverage = GetCoverage(table, ReadOffset(table, subtable, subtable + 2), glyph);
+		if (coverage < 0 || (unsigned int)coverage >= ReadU16(table, subtable + 4))
+			return 0;
+		matcher_t matcher = { MATCH_GLYPH, 0, 0 };
+		return ApplyRuleSet(context, ReadOffset(table, subtable, subtable + 6 + 2 * coverage), 1, &matcher, &matcher, &matcher, index);
+	}
+	case 2:
+	{
+		if (GetCoverage(table, ReadOffset(table, subtable, subtable + 2), glyph) < 0)
+			return 0;
+		matcher_t backtrack = { MATCH_CLASS, ReadOffset(table, subtable, subtable + 4), 0 };
+		matcher_t input = { MATCH_CLASS, ReadOffset(table, subtable, subtable + 6), 0 };
+		matcher_t lookahead = { MATCH_CLASS, ReadOffset(table, subtable, subtable + 8), 0 };
+		unsigned int glyphClass = (unsigned int)GetGlyphClass(table, input.classDef, glyph);
+		if (glyphClass >= ReadU16(table, subtable + 10))
+			return 0;
+		return ApplyRuleSet(context, ReadOffset(table, subtable, subtable + 12 + 2 * glyphClass), 1, &backtrack, &input, &lookahead, index);
+	}
+	case 3:
+	{
+		matcher_t matcher = { MATCH_COVERAGE, 0, subtable };
+		unsigned int backtrackCount = ReadU16(table, subtable + 2), backtrack = subtable + 4;
+		unsigned int inputCount = ReadU16(table, backtrack + 2 * backtrackCount), input = backtrack + 2 * backtrackCount + 2;
+		unsigned int lookaheadCount = ReadU16(table, input + 2 * inputCount), lookahead = input + 2 * inputCount + 2;
+		unsigned int recordCount = ReadU16(table, lookahead + 2 * lookaheadCount), records = lookahead + 2 * lookaheadCount + 2;
+		if (inputCount == 0 || !MatchGlyph(context, &matcher, ReadU16(table, input), glyph))
+			return 0;
+		return ApplyRule(context, index, &matcher, backtrack, backtrackCount, &matcher, input + 2, inputCount, &matcher, lookahead,
+			lookaheadCount, records, recordCount);
+	}
+	}
+	return 0;
+}
+
+//--------------------------------- POSITIONING ---------------------------------
+//Placement and advance of a value record, device tables and vertical advances are skipped
+void ApplyValueRecord(const otftable_t* table, unsigned int format, unsigned int record, shapedglyph_t* glyph)
+{
+	if (format & 0x1)
+	{
+		glyph->offsetX += ReadS16(table, record);
+		record += 2;
+	}
+	if (format & 0x2)
+	{
+		glyph->offsetY += ReadS16(table, record);
+		record += 2;
+	}
+	if (format & 0x4)
+		glyph->advance += ReadS16(table, record);
+}
+
+unsigned int GetValueRecordSize(unsigned int format)
+{
+	unsigned int size = 0;
+	for (unsigned int bit = 1; bit < 0x100; bit <<= 1)
+		size += format & bit ? 2 : 0;
+	return size;
+}
+
+int ApplySinglePositioning(shapecontext_t* context, unsigned int subtable, size_t index)
+{
+	const otftable_t* table = context->table;
+	shapedglyph_t* glyph = context->buffer->glyphs + index;
+	int coverage = GetCoverage(table, ReadOffset(table, subtable, subtable + 2), glyph->glyph);
+	if (coverage < 0)
+		return 0;
+
+	unsigned int format = ReadU16(table, subtable), valueFormat = ReadU16(table, subtable + 4);
+	if (format == 1)
+		ApplyValueRecord(table, valueFormat, subtable + 6, glyph);
+	else if (format == 2 && (unsigned int)coverage < ReadU16(table, subtable + 6))
+		ApplyValueRecord(table, valueFormat, subtable + 8 + GetValueRecordSize(valueFormat) * coverage, glyph);
+	else
+		return 0;
+
+	context->next = index + 1;
+	return 1;
+}
+
+//Anchors of all formats are read as plain coordinates
+int ReadAnchor(const otftable_t* table, unsigned int anchor, int* x, int* y)
+{
+	if (anchor == 0)
+		return 0;
+	*x = ReadS16(table, anchor + 2);
+	*y = ReadS16(table, anchor + 4);
+	return 1;
+}
+
+//The exit anchor of the previous glyph meets the entry anchor of this one. Horizontally the advances change right away,
+//vertically the child glyph of the chain is moved when attachments are resolved
+int ApplyCursivePositioning(shapecontext_t* context, unsigned int subtable, size_t index)
+{
+	const otftable_t* table = context->table;
+	shapedglyph_t* glyphs = context->buffer->glyphs;
+	unsigned int coverage = ReadOffset(table, subtable, subtable + 2), count = ReadU16(table, subtable + 4);
+	int current = GetCoverage(table, coverage, glyphs[index].glyph);
+	if (ReadU16(table, subtable) != 1 || current < 0 || (unsigned int)current >= count)
+		return 0;
+
+	size_t previous = PreviousGlyph(context, index);
+	int before = previous != SIZE_MAX ? GetCoverage(table, coverage, glyphs[previous].glyph) : -1;
+	if (before < 0 || (unsigned int)before >= count)
+		return 0;
+
+	int entryX, entryY, exitX, exitY;
+	if (!ReadAnchor(table, ReadOffset(table, subtable, subtable + 6 + 4 * current), &entryX, &entryY) ||
+		!ReadAnchor(table, ReadOffset(table, subtable, subtable + 8 + 4 * before), &exitX, &exitY))
+		return 0;
+
+	shapedglyph_t* first = glyphs + previous;
+	shapedglyph_t* second = glyphs + index;
+	if (second->level & 1)
+	{
+		int distance = exitX + first->offsetX;
+		first->advance -= distance;
+		first->offsetX -= distance;
+		second->advance = entryX + second->offsetX;
+	}
+	else
+	{
+		first->advance = exitX + first->offsetX;
+		int distance = entryX + second->offsetX;
+		second->advance -= distance;
+		second->offsetX -= distance;
+	}
+
+	size_t child = index, parent = previous;
+	int offsetY = exitY - entryY;
+	if (context->lookupFlag & LOOKUP_RIGHT_TO_LEFT)
+	{
+		child = previous;
+		parent = index;
+		offsetY = -offsetY;
+	}
+
+	//A parent attached to its own child would make a loop
+	if (glyphs[parent].attachTo == (int)child)
+		glyphs[parent].attachType = ATTACH_NONE;
+	glyphs[child].attachType = ATTACH_CURSIVE;
+	glyphs[child].attachTo = (int)parent;
+	glyphs[child].offsetY = offsetY;
+	context->next = index + 1;
+	return 1;
+}
+
+//Moves the mark at index onto the anchor of its class on the glyph at parent, anchors points to that glyph's anchor offsets
+int AttachMark(shapecontext_t* context, unsigned int markArray, int markIndex, unsigned int classCount, unsigned int anchorBase,
+	unsigned int anchors, size_t index, size_t parent)
+{
+	const otftable_t* table = context->table;
+	if ((unsigned int)markIndex >= ReadU16(table, markArray))
+		return 0;
+
+	unsigned int record = markArray + 2 + 4 * markIndex;
+	unsigned int markClass = ReadU16(table, record);
+	int markX, markY, parentX, parentY;
+	if (markClass >= classCount || !ReadAnchor(table, ReadOffset(table, markArray, record + 2), &markX, &markY) ||
+		!ReadAnchor(table, ReadOffset(table, anchorBase, anchors + 2 * markClass), &parentX, &parentY))
+		return 0;
+
+	shapedglyph_t* mark = context->buffer->glyphs + index;
+	mark->offsetX = parentX - markX;
+	mark->offsetY = parentY - markY;
+	mark->attachType = ATTACH_MARK;
+	mark->attachTo = (int)parent;
+	context->next = index + 1;
+	return 1;
+}
+
+enum
+{
+	MARK_TO_BASE = 4,
+	MARK_TO_LIGATURE = 5,
+	MARK_TO_MARK = 6
+};
+
+//The three mark attachment subtables share their layout, they differ in the glyph the mark attaches to
+int ApplyMarkPositioning(shapecontext_t* context, unsigned int subtable, size_t index, int type)
+{
+	const otftable_t* table = context->table;
+	shapedglyph_t* glyphs = context->buffer->glyphs;
+	int markIndex = GetCoverage(table, ReadOffset(table, subtable, subtable + 2), glyphs[index].glyph);
+	if (ReadU16(table, subtable) != 1 || markIndex < 0)
+		return 0;
+
+	//Bases and ligatures are found past any other marks, marks attach to the one right before them
+	size_t parent = index;
+	do
+		parent = PreviousGlyph(context, parent);
+	while (type != MARK_TO_MARK && parent != SIZE_MAX && glyphs[parent].glyphClass == GLYPH_MARK);
+	if (parent == SIZE_MAX || (type == MARK_TO_MARK && glyphs[parent].glyphClass != GLYPH_MARK))
+		return 0;
+
+	int parentIndex = GetCoverage(table, ReadOffset(table, subtable, subtable + 4), glyphs[parent].glyph);
+	unsigned int classCount = ReadU16(table, subtable + 6);
+	unsigned int markArray = ReadOffset(table, subtable, subtable + 8), parentArray = ReadOffset(table, subtable, subtable + 10);
+	if (parentIndex < 0 || markArray == 0 || parentArray == 0 || (unsigned int)parentIndex >= ReadU16(table, parentArray))
+		return 0;
+
+	if (type == MARK_TO_LIGATURE)
+	{
+		//The mark goes on the component it followed when the ligature formed, otherwise on the last one
+		unsigned int attach = ReadOffset(table, parentArray, parentArray + 2 + 2 * parentIndex);
+		unsigned int components = ReadU16(table, attach);
+		if (attach == 0 || components == 0)
+			return 0;
+		shapedglyph_t* mark = glyphs + index;
+		unsigned int component = components - 1;
+		if (mark->ligatureId != 0 && mark->ligatureId == glyphs[parent].ligatureId && mark->component > 0)
+			component = min((unsigned int)mark->component, components) - 1;
+		return AttachMark(context, markArray, markIndex, classCount, attach, attach + 2 + 2 * classCount * component, index, parent);
+	}
+
+	if (type == MARK_TO_MARK)
+	{
+		//Both marks have to belong to the same ligature component, or neither to a ligature
+		shapedglyph_t* mark = glyphs + index;
+		shapedglyph_t* other = glyphs + parent;
+		if (mark->ligatureId != other->ligatureId ? (mark->ligatureId == 0 || mark->component != 0) && (other->ligatureId == 0 || other->component != 0) :
+			mark->component != other->component)
+			return 0;
+	}
+	return AttachMark(context, markArray, markIndex, classCount, parentArray, parentArray + 2 + 2 * classCount * parentIndex, index, parent);
+}
+
+int ApplySubtable(shapecontext_t* context, unsigned int type, unsigned int subtable, size_t index)
+{
+	const otftable_t* table = context->table;
+	unsigned int extension = context->positioning ? 9 : 7;
+
+	//Extension subtables hold the real type and a 32-bit offset to the subtable
+	if (type == extension)
+	{
+		if (ReadU16(table, subtable) != 1)
+			return 0;
+		type = ReadU16(table, subtable + 2);
+		subtable += ReadU32(table, subtable + 4);
+		if (type == extension)
+			return 0;
+	}
+
+	//Pair adjustments are left to stb, layout kerns with them
+	if (context->positioning)
+	{
+		switch (type)
+		{
+		case 1: return ApplySinglePositioning(context, subtable, index);
+		case 3: return ApplyCursivePositioning(context, subtable, index);
+		case 4: return ApplyMarkPositioning(context, subtable, index, MARK_TO_BASE);
+		case 5: return ApplyMarkPositioning(context, subtable, index, MARK_TO_LIGATURE);
+		case 6: return ApplyMarkPositioning(context, subtable, index, MARK_TO_MARK);
+		case 7: return ApplyContext(context, subtable, index);
+		case 8: return ApplyChainedContext(context, subtable, index);
+		}
+		return 0;
+	}
+
+	switch (type)
+	{
+	case 1: return ApplySingleSubstitution(context, subtable, index);
+	case 2: return ApplyMultipleSubstitution(context, subtable, index);
+	case 3: return ApplyAlternateSubstitution(context, subtable, index);
+	case 4: return ApplyLigatureSubstitution(context, subtable, index);
+	case 5: return ApplyContext(context, subtable, index);
+	case 6: return ApplyChainedContext(context, subtable, index);
+	}
+	return 0;
+}
+
+//Adds the offsets of the glyphs each glyph is attached to. Chains are followed to their root first so every glyph is
+//resolved once, a mark also moves back over the advances between it and its base
+void ResolveAttachments(shapebuffer_t* buffer, size_t start)
+{
+	shapedglyph_t* glyphs = buffer->glyphs;
+	size_t count = buffer->numGlyphs - start;
+	if (count > allocAttachChain)
+	{
+		allocAttachChain = max(count, allocAttachChain * 2);
+		attachChain = realloc(attachChain, sizeof(size_t) * allocAttachChain);
+	}
+
+	for (size_t i = start; i < buffer->numGlyphs; i++)
+	{
+		size_t length = 0;
+		for (size_t g = i; length < count && glyphs[g].attachType != ATTACH_NONE && !(glyphs[g].flags & SHAPED_RESOLVED); g = (size_t)glyphs[g].attachTo)
+		{
+			glyphs[g].flags |= SHAPED_RESOLVED;
+			attachChain[length++] = g;
+		}
+
+		while (length > 0)
+		{
+			shapedglyph_t* glyph = glyphs + attachChain[--length];
+			size_t index = (size_t)(glyph - glyphs), parent = (size_t)glyph->attachTo;
+			glyph->offsetY += glyphs[parent].offsetY;
+			if (glyph->attachType == ATTACH_MARK)
+			{
+				glyph->offsetX += glyphs[parent].offsetX;
+				if (!(glyph->level & 1))
+				{
+					for (size_t k = parent; k < index; k++)
+						glyph->offsetX -= glyphs[k].advance;
+				}
+				else
+				{
+					for (size_t k = index; k > parent; k--)
+						glyph->offsetX += glyphs[k].advance;
+				}
+			}
+			glyph->attachType = ATTACH_NONE;
+		}
+	}
+
+	for (size_t i = start; i < buffer->numGlyphs; i++)
+	{
+		glyphs[i].flags &= ~SHAPED_RESOLVED;
+		glyphs[i].attachTo = -1;
+	}
+}
+
+//----------------------------------- SCRIPTS -----------------------------------
+//Positional forms from the joining types around each letter, transparent marks are skipped
+void SetupArabicForms(shapebuffer_t* buffer, size_t start)
+{
+	size_t previous = SIZE_MAX;
+	int previousType = JOINING_NONE;
+	for (size_t i = start; i < buffer->numGlyphs; i++)
+	{
+		shapedglyph_t* glyph = buffer->glyphs + i;
+		int type = GetJoiningType(glyph->codepoint);
+		if (type == JOINING_TRANSPARENT)
+			continue;
+
+		int joins = previous != SIZE_MAX && (previousType == JOINING_DUAL || previousType == JOINING_CAUSING) &&
+			(type == JOINING_RIGHT || type == JOINING_DUAL || type == JOINING_CAUSING);
+		if (joins)
+		{
+			//An isolated letter becomes initial, a final one medial
+			shapedglyph_t* before = buffer->glyphs + previous;
+			if (before->mask & FEATURE_ISOL)
+				before->mask ^= FEATURE_ISOL | FEATURE_INIT;
+			else if (before->mask & FEATURE_FINA)
+				before->mask ^= FEATURE_FINA | FEATURE_MEDI;
+		}
+		if (type == JOINING_RIGHT || type == JOINING_DUAL)
+			glyph->mask |= joins ? FEATURE_FINA : FEATURE_ISOL;
+
+		previous = i;
+		previousType = type;
+	}
+}
+
+//A syllable is a consonant cluster joined by viramas or an independent vowel, followed by vowel signs and modifiers
+size_t FindDevanagariSyllable(const shapebuffer_t* buffer, size_t i)
+{
+	const shapedglyph_t* glyphs = buffer->glyphs;
+	size_t n = buffer->numGlyphs;
+	int category = GetDevanagariCategory(glyphs[i].codepoint);
+	if (category == INDIC_CONSONANT)
+	{
+		i++;
+		for (;;)
+		{
+			if (i < n && GetDevanagariCategory(glyphs[i].codepoint) == INDIC_NUKTA)
+				i++;
+			if (i >= n || GetDevanagariCategory(glyphs[i].codepoint) != INDIC_HALANT)
+				break;
+
+			size_t next = i + 1;
+			if (next < n && GetDevanagariCategory(glyphs[next].codepoint) == INDIC_JOINER)
+				next++;
+			if (next >= n || GetDevanagariCategory(glyphs[next].codepoint) != INDIC_CONSONANT)
+			{
+				//Dead consonant at the end of the syllable
+				i = next;
+				break;
+			}
+			i = next + 1;
+		}
+	}
+	else if (category == INDIC_VOWEL)
+	{
+		i++;
+		if (i < n && GetDevanagariCategory(glyphs[i].codepoint) == INDIC_NUKTA)
+			i++;
+	}
+	else
+	{
+		return i + 1;
+	}
+
+	while (i < n && (GetDevanagariCategory(glyphs[i].codepoint) == INDIC_MATRA || GetDevanagariCategory(glyphs[i].codepoint) == INDIC_NUKTA))
+		i++;
+	while (i < n && GetDevanagariCategory(glyphs[i].codepoint) == INDIC_MODIFIER)
+		i++;
+	return i;
+}
+
+//Marks ra and virama at the start of a syllable for rphf and the consonants before the base for half forms, the base
+//being the last consonant. Pre-base vowel signs move in front of the consonants, a reordered syllable becomes one cluster
+void SetupDevanagari(shapebuffer_t* buffer, size_t start)
+{
+	shapedglyph_t* glyphs = buffer->glyphs;
+	for (size_t i = start, end; i < buffer->numGlyphs; i = end)
+	{
+		end = FindDevanagariSyllable(buffer, i);
+		if (GetDevanagariCategory(glyphs[i].codepoint) != INDIC_CONSONANT)
+			continue;
+
+		size_t base = i;
+		for (size_t k = i; k < end; k++)
+		{
+			if (GetDevanagariCategory(glyphs[k].codepoint) == INDIC_CONSONANT)
+				base = k;
+		}
+
+		size_t first = i;
+		int reordered = 0;
+		if (base > i + 1 && glyphs[i].codepoint == 0x0930 && glyphs[i + 1].codepoint == 0x094D &&
+			GetDevanagariCategory(glyphs[i + 2].codepoint) == INDIC_CONSONANT)
+		{
+			glyphs[i].mask |= FEATURE_RPHF;
+			glyphs[i + 1].mask |= FEATURE_RPHF;
+			glyphs[i].flags |= SHAPED_REPH;
+			first = i + 2;
+			reordered = 1;
+		}
+		for (size_t k = first; k < base; k++)
+			glyphs[k].mask |= FEATURE_HALF;
+
+		for (size_t k = base + 1; k < end; k++)
+		{
+			if (glyphs[k].codepoint == 0x093F)
+			{
+				MoveGlyph(buffer, k, first);
+				reordered = 1;
+			}
+		}
+
+		if (reordered)
+		{
+			int cluster = glyphs[i].cluster;
+			for (size_t k = i; k < end; k++)
+				cluster = min(cluster, glyphs[k].cluster);
+			for (size_t k = i; k < end; k++)
+				glyphs[k].cluster = cluster;
+		}
+	}
+}
+
+//A reph the font formed moves to the end of its syllable, before the vowel modifiers
+void ReorderDevanagariReph(shapebuffer_t* buffer, size_t start)
+{
+	shapedglyph_t* glyphs = buffer->glyphs;
+	for (size_t i = start; i < buffer->numGlyphs; i++)
+	{
+		if (!(glyphs[i].flags & SHAPED_REPH))
+			continue;
+
+		glyphs[i].flags &= ~SHAPED_REPH;
+		if (!(glyphs[i].flags & SHAPED_SUBSTITUTED))
+			continue;
+
+		size_t end = i + 1;
+		while (end < buffer->numGlyphs && glyphs[end].cluster == glyphs[i].cluster)
+			end++;
+		while (end > i + 1 && GetDevanagariCategory(glyphs[end - 1].codepoint) == INDIC_MODIFIER)
+			end--;
+		MoveGlyph(buffer, i, end - 1);
+	}
+}
+
+//Default ignorable characters that no substitution used are dropped
+void RemoveDefaultIgnorables(shapebuffer_t* buffer, size_t start)
+{
+	for (size_t i = start; i < buffer->numGlyphs;)
+	{
+		if (IsDefaultIgnorable(buffer->glyphs[i].codepoint) && !(buffer->glyphs[i].flags & SHAPED_SUBSTITUTED))
+			RemoveGlyph(buffer, i);
+		else
+			i++;
+	}
+}
+
+//----------------------------------- SHAPING -----------------------------------
+//Bidi levels without explicit embeddings: the paragraph takes the direction of its first strong character, numbers after
+//left to right text go with it, marks take the direction before them and neutrals between two runs of the same direction
+//join them. Everything else takes the paragraph direction
+void ResolveLevels(shapechar_t* chars, size_t count, shapebuffer_t* output)
+{
+	int paragraph = BIDI_LEFT;
+	for (size_t i = 0; i < count; i++)
+	{
+		int bidiClass = GetBidiClass(chars[i].codepoint);
+		if (bidiClass == BIDI_LEFT || bidiClass == BIDI_RIGHT)
+		{
+			paragraph = bidiClass;
+			break;
+		}
+	}
+
+	int previousStrong = paragraph;
+	for (size_t i = 0; i < count; i++)
+	{
+		int direction = GetBidiClass(chars[i].codepoint);
+		if (direction == BIDI_LEFT || direction == BIDI_RIGHT)
+			previousStrong = direction;
+		else if (direction == BIDI_NUMBER && previousStrong == BIDI_LEFT)
+			direction = BIDI_LEFT;
+		else if (direction == BIDI_MARK)
+			direction = i > 0 ? chars[i - 1].direction : paragraph;
+		chars[i].direction = (unsigned char)direction;
+	}
+
+	for (size_t i = 0; i < count;)
+	{
+		if (chars[i].direction != BIDI_NEUTRAL)
+		{
+			i++;
+			continue;
+		}
+
+		size_t end = i;
+		while (end < count && chars[end].direction == BIDI_NEUTRAL)
+			end++;
+		int before = i > 0 ? chars[i - 1].direction : paragraph, after = end < count ? chars[end].direction : paragraph;
+		before = before == BIDI_NUMBER ? BIDI_RIGHT : before;
+		after = after == BIDI_NUMBER ? BIDI_RIGHT : after;
+		for (; i < end; i++)
+			chars[i].direction = (unsigned char)(before == after ? before : paragraph);
+	}
+
+	output->paragraphLevel = paragraph == BIDI_RIGHT;
+	output->maxLevel = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		int level = chars[i].direction == BIDI_RIGHT ? 1 : chars[i].direction == BIDI_NUMBER || paragraph == BIDI_RIGHT ? 2 : 0;
+		chars[i].level = (unsigned char)level;
+		output->maxLevel = max(output->maxLevel, level);
+	}
+}
+
+//Characters without a script of their own go with the run before them, or the one after them at the start
+void ResolveScripts(shapechar_t* chars, size_t count)
+{
+	int script = SCRIPT_COMMON;
+	for (size_t i = 0; i < count && script == SCRIPT_COMMON; i++)
+		script = GetScript(chars[i].codepoint);
+
+	for (size_t i = 0; i < count; i++)
+	{
+		int own = GetScript(chars[i].codepoint);
+		if (own != SCRIPT_COMMON)
+			script = own;
+		chars[i].script = (unsigned char)script;
+	}
+}
+
+//Shapes characters of one script, direction and font onto the end of output
+void ShapeRun(shaper_t* shaper, const shapechar_t* chars, size_t count, int script, shapebuffer_t* output)
+{
+	size_t start = output->numGlyphs;
+	ReserveShapeBuffer(output, start + count);
+	for (size_t i = 0; i < count; i++)
+	{
+		shapedglyph_t* glyph = output->glyphs + start + i;
+		memset(glyph, 0, sizeof(shapedglyph_t));
+		glyph->glyph = stbtt_FindGlyphIndex(shaper->info, chars[i].level & 1 ? GetMirroredCodepoint(chars[i].codepoint) : chars[i].codepoint);
+		glyph->codepoint = chars[i].codepoint;
+		glyph->cluster = chars[i].cluster;
+		glyph->mask = FEATURE_GLOBAL;
+		glyph->level = chars[i].level;
+		glyph->font = chars[i].font;
+		glyph->attachTo = -1;
+		glyph->glyphClass = (unsigned char)GetInitialClass(shaper, glyph->glyph, glyph->codepoint);
+	}
+	output->numGlyphs = start + count;
+
+	shapecontext_t context;
+	memset(&context, 0, sizeof(shapecontext_t));
+	context.shaper = shaper;
+	context.buffer = output;
+	context.start = start;
+	context.maxGlyphs = start + count * MAX_GLYPHS_PER_CHARACTER;
+	context.budget = (long long)count * SHAPE_BUDGET_PER_GLYPH + 65536;
+
+	context.table = &shaper->gsub;
+	shapeplan_t* plan = GetShapePlan(shaper, script, 0);
+	if (script == SCRIPT_ARABIC)
+		SetupArabicForms(output, start);
+	if (script == SCRIPT_DEVANAGARI)
+	{
+		SetupDevanagari(output, start);
+		ApplyShapePlan(&context, plan, 0, DEVANAGARI_REORDER_STAGE);
+		ReorderDevanagariReph(output, start);
+		ApplyShapePlan(&context, plan, DEVANAGARI_REORDER_STAGE, INT_MAX);
+	}
+	else
+	{
+		ApplyShapePlan(&context, plan, 0, INT_MAX);
+	}
+	RemoveDefaultIgnorables(output, start);
+
+	//Marks don't advance the pen, GPOS places them
+	for (size_t i = start; i < output->numGlyphs; i++)
+	{
+		shapedglyph_t* glyph = output->glyphs + i;
+		stbtt_GetGlyphHMetrics(shaper->info, glyph->glyph, &glyph->advance, NULL);
+		if (glyph->glyphClass == GLYPH_MARK)
+			glyph->advance = 0;
+	}
+
+	context.table = &shaper->gpos;
+	context.positioning = 1;
+	ApplyShapePlan(&context, GetShapePlan(shaper, script, 1), 0, INT_MAX);
+	ResolveAttachments(output, start);
+}
+
+//Pair kerning between neighbouring glyphs of the same direction and font, marks sit on their base and are left out
+void ApplyKerning(shaper_t* const* shapers, shapebuffer_t* buffer)
+{
+	shapedglyph_t* previous = NULL;
+	for (size_t i = 0; i < buffer->numGlyphs; i++)
+	{
+		shapedglyph_t* glyph = buffer->glyphs + i;
+		if (glyph->glyphClass == GLYPH_MARK)
+			continue;
+		if (previous != NULL && previous->level == glyph->level && previous->font == glyph->font)
+			previous->advance += stbtt_GetGlyphKernAdvance(shapers[glyph->font]->info, previous->glyph, glyph->glyph);
+		previous = glyph;
+	}
+}
+
+//Shapes a paragraph of UTF-16 text into output, carriage returns are dropped. Runs of one script, direction and font are
+//shaped separately and the glyphs stay in logical order. fonts gives the shaper of every code unit, with NULL all of the
+//text is shaped with the first one
+void ShapeText(shaper_t* const* shapers, const unsigned char* fonts, const utf16_t* text, size_t length, shapebuffer_t* output)
+{
+	output->numGlyphs = 0;
+	if (length > allocShapeChars)
+	{
+		allocShapeChars = max(length, allocShapeChars * 2);
+		shapeChars = realloc(shapeChars, sizeof(shapechar_t) * allocShapeChars);
+	}
+
+	//Surrogate pairs become one character, the cluster is the index of its first code unit. Runs of units that are
+	//characters of their own are copied without decoding
+	size_t count = 0;
+	for (size_t i = 0; i < length;)
+	{
+		for (size_t end = FindSimpleRun(text, i, length); i < end; i++, count++)
+		{
+			shapeChars[count].cluster = (int)i;
+			shapeChars[count].codepoint = text[i];
+			shapeChars[count].font = fonts != NULL ? fonts[i] : 0;
+		}
+		if (i == length)
+			break;
+
+		int cluster = (int)i, codepoint = NextCodepoint(text, length, &i);
+		if (codepoint == L'\r')
+			continue;
+		shapeChars[count].cluster = cluster;
+		shapeChars[count].codepoint = codepoint;
+		shapeChars[count++].font = fonts != NULL ? fonts[cluster] : 0;
+	}
+
+	ResolveLevels(shapeChars, count, output);
+	ResolveScripts(shapeChars, count);
+	for (size_t i = 0, end; i < count; i = end)
+	{
+		end = i + 1;
+		while (end < count && shapeChars[end].script == shapeChars[i].script && shapeChars[end].level == shapeChars[i].level &&
+			shapeChars[end].font == shapeChars[i].font)
+			end++;
+		ShapeRun(shapers[shapeChars[i].font], shapeChars + i, end - i, shapeChars[i].script, output);
+	}
+	ApplyKerning(shapers, output);
+}
+
+#endif
@@ -0,0 +1,308 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include "platform.h"
+
+//Optional instrumentation of the hot paths, compiled in when SFL_STATS is defined. Every thread counts into its own
+//block so the hot paths don't contend, GetStats sums the blocks. Without SFL_STATS the macros compile to nothing
+
+//Timed phases, the order is shared with StatPhase in the C# wrapper
+enum
+{
+	STAT_LOAD = 0,
+	STAT_LAYOUT = 1,
+	STAT_RENDER = 2,
+	STAT_CMAP = 3,
+	STAT_KERN = 4,
+	STAT_OUTLINE = 5,
+	STAT_RASTERIZE = 6,
+	STAT_SHAPE = 7,
+	NUM_STAT_PHASES
+};
+
+//Counters, the order is shared with StatCounter in the C# wrapper
+enum
+{
+	STAT_GLYPHS_PLACED = 0,
+	STAT_GLYPHS_RASTERIZED = 1,
+	STAT_EDGES = 2,
+	STAT_FONT_CACHE_HITS = 3,
+	STAT_FONT_CACHE_MISSES = 4,
+	STAT_ALLOCATIONS = 5,
+	STAT_BYTES_ALLOCATED = 6,
+	STAT_SHAPE_CACHE_HITS = 7,
+	STAT_SHAPE_CACHE_MISSES = 8,
+	NUM_STAT_COUNTERS
+};
+
+//GetStats writes calls and nanoseconds of every phase followed by the counters
+#define NUM_STAT_VALUES (NUM_STAT_PHASES * 2 + NUM_STAT_COUNTERS)
+
+#ifdef SFL_STATS
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <pthread.h>
+#include <time.h>
+#endif
+
+//Threads beyond this share the last block, their counts may then be slightly off
+#define MAX_STATS_THREADS 64
+#define MAX_TRACE_EVENTS (1 << 18)
+
+typedef struct
+{
+	int phase;
+	long long start;
+	long long duration;
+} traceevent_t;
+
+typedef struct
+{
+	volatile long inUse;
+
+	long long phaseCalls[NUM_STAT_PHASES];
+	long long phaseTime[NUM_STAT_PHASES];
+	long long counters[NUM_STAT_COUNTERS];
+
+	//Nested calls of the same phase (composite glyphs) are only timed once
+	int depth[NUM_STAT_PHASES];
+	long long start[NUM_STAT_PHASES];
+
+	traceevent_t* events;
+	size_t numEvents;
+	size_t droppedEvents;
+} threadstats_t;
+
+threadstats_t statsBlocks[MAX_STATS_THREADS];
+THREAD_LOCAL threadstats_t* threadStats = NULL;
+volatile int statsTracing = 0;
+long long statsEpoch = 0;
+
+//Monotonic time in nanoseconds
+long long StatsNow()
+{
+#ifdef _WIN32
+	LARGE_INTEGER counter, frequency;
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+	return (long long)((double)counter.QuadPart * 1e9 / frequency.QuadPart);
+#else
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (long long)now.tv_sec * 1000000000 + now.tv_nsec;
+#endif
+}
+
+//Blocks of exited threads are handed to new ones, ParallelFor starts fresh threads for every job
+#ifdef _WIN32
+DWORD statsKey = FLS_OUT_OF_INDEXES;
+INIT_ONCE statsOnce = INIT_ONCE_STATIC_INIT;
+
+void WINAPI ReleaseThreadStats(void* block)
+{
+	if (block != NULL)
+		((threadstats_t*)block)->inUse = 0;
+}
+
+BOOL CALLBACK InitStatsKey(PINIT_ONCE once, void* parameter, void** context)
+{
+	statsKey = FlsAlloc(ReleaseThreadStats);
+	statsEpoch = StatsNow();
+	return TRUE;
+}
+#else
+pthread_key_t statsKey;
+pthread_once_t statsOnce = PTHREAD_ONCE_INIT;
+
+void ReleaseThreadStats(void* block)
+{
+	__sync_lock_release(&((threadstats_t*)block)->inUse);
+}
+
+void InitStatsKey()
+{
+	pthread_key_create(&statsKey, ReleaseThreadStats);
+	statsEpoch = StatsNow();
+}
+#endif
+
+threadstats_t* AcquireThreadStats()
+{
+#ifdef _WIN32
+	InitOnceExecuteOnce(&statsOnce, InitStatsKey, NULL, NULL);
+#else
+	pthread_once(&statsOnce, InitStatsKey);
+#endif
+
+	threadstats_t* block = &statsBlocks[MAX_STATS_THREADS - 1];
+	for (int i = 0; i < MAX_STATS_THREADS - 1; i++)
+	{
+#ifdef _WIN32
+		if (InterlockedCompareExchange(&statsBlocks[i].inUse, 1, 0) == 0)
+#else
+		if (__sync_bool_compare_and_swap(&statsBlocks[i].inUse, 0, 1))
+#endif
+		{
+			block = &statsBlocks[i];
+#ifdef _WIN32
+			FlsSetValue(statsKey, block);
+#else
+			pthread_setspecific(statsKey, block);
+#endif
+			break;
+		}
+	}
+
+	return threadStats = block;
+}
+
+threadstats_t* GetThreadStats()
+{
+	return threadStats != NULL ? threadStats : AcquireThreadStats();
+}
+
+void StatsBegin(int phase)
+{
+	threadstats_t* stats = GetThreadStats();
+	if (stats->depth[phase]++ == 0)
+		stats->start[phase] = StatsNow();
+}
+
+void StatsEnd(int phase)
+{
+	threadstats_t* stats = GetThreadStats();
+	if (--stats->depth[phase] != 0)
+		return;
+
+	long long start = stats->start[phase];
+	long long duration = StatsNow() - start;
+	stats->phaseCalls[phase]++;
+	stats->phaseTime[phase] += duration;
+
+	//Lookups are too short and too many to trace one by one
+	if (statsTracing && phase != STAT_CMAP && phase != STAT_KERN)
+	{
+		if (stats->events == NULL)
+			stats->events = malloc(sizeof(traceevent_t) * MAX_TRACE_EVENTS);
+		if (stats->numEvents < MAX_TRACE_EVENTS)
+		{
+			traceevent_t* event = &stats->events[stats->numEvents++];
+			event->phase = phase;
+			event->start = start;
+			event->duration = duration;
+		}
+		else
+		{
+			stats->droppedEvents++;
+		}
+	}
+}
+
+void StatsCount(int counter, long long amount)
+{
+	GetThreadStats()->counters[counter] += amount;
+}
+
+void* StatsMalloc(size_t size)
+{
+	StatsCount(STAT_ALLOCATIONS, 1);
+	StatsCount(STAT_BYTES_ALLOCATED, (long long)size);
+	return malloc(size);
+}
+
+void* StatsCalloc(size_t count, size_t size)
+{
+	StatsCount(STAT_ALLOCATIONS, 1);
+	StatsCount(STAT_BYTES_ALLOCATED, (long long)(count * size));
+	return calloc(count, size);
+}
+
+void* StatsRealloc(void* block, size_t size)
+{
+	StatsCount(STAT_ALLOCATIONS, 1);
+	StatsCount(STAT_BYTES_ALLOCATED, (long long)size);
+	return realloc(block, size);
+}
+
+//Sums the blocks of all threads, threads that are still working may be counted partially
+int CollectStats(long long* values, int count)
+{
+	long long sums[NUM_STAT_VALUES] = { 0 };
+	for (int i = 0; i < MAX_STATS_THREADS; i++)
+	{
+		for (int p = 0; p < NUM_STAT_PHASES; p++)
+		{
+			sums[p * 2] += statsBlocks[i].phaseCalls[p];
+			sums[p * 2 + 1] += statsBlocks[i].phaseTime[p];
+		}
+		for (int c = 0; c < NUM_STAT_COUNTERS; c++)
+			sums[NUM_STAT_PHASES * 2 + c] += statsBlocks[i].counters[c];
+	}
+
+	for (int i = 0; i < min(count, NUM_STAT_VALUES); i++)
+		values[i] = sums[i];
+	return NUM_STAT_VALUES;
+}
+
+void ClearStats()
+{
+	for (int i = 0; i < MAX_STATS_THREADS; i++)
+	{
+		memset(statsBlocks[i].phaseCalls, 0, sizeof(statsBlocks[i].phaseCalls));
+		memset(statsBlocks[i].phaseTime, 0, sizeof(statsBlocks[i].phaseTime));
+		memset(statsBlocks[i].counters, 0, sizeof(statsBlocks[i].counters));
+		statsBlocks[i].numEvents = 0;
+		statsBlocks[i].droppedEvents = 0;
+	}
+}
+
+//Chrome trace event format, open in chrome://tracing or ui.perfetto.dev. Returns the number of events
+int WriteTrace(FILE* file)
+{
+	static const char* phaseNames[NUM_STAT_PHASES] = { "LoadFont", "Layout", "Render", "Cmap", "Kern", "Outline", "Rasterize", "Shape" };
+
+	int written = 0;
+	fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+	for (int i = 0; i < MAX_STATS_THREADS; i++)
+	{
+		threadstats_t* stats = &statsBlocks[i];
+		for (size_t e = 0; e < stats->numEvents; e++)
+		{
+			traceevent_t* event = &stats->events[e];
+			fprintf(file, "%s\n{\"name\":\"%s\",\"cat\":\"simple-font-lib\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+				written == 0 ? "" : ",", phaseNames[event->phase], i, (event->start - statsEpoch) / 1000.0, event->duration / 1000.0);
+			written++;
+		}
+		if (stats->droppedEvents > 0)
+		{
+			fprintf(file, "%s\n{\"name\":\"Dropped %zu events\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%d,\"ts\":0}",
+				written == 0 ? "" : ",", stats->droppedEvents, i);
+			written++;
+		}
+	}
+	fprintf(file, "\n]}\n");
+	return written;
+}
+
+#define STATS_BEGIN(phase) StatsBegin(phase)
+#define STATS_END(phase) StatsEnd(phase)
+#define STATS_COUNT(counter, amount) StatsCount(counter, amount)
+
+//Hooks in stb_truetype.h, this header has to be included before it
+#define STBTT_malloc(x, u) ((void)(u), StatsMalloc(x))
+#define STBTT_free(x, u) ((void)(u), free(x))
+#define STBTT_PROFILE_BEGIN(phase) StatsBegin(STAT_##phase)
+#define STBTT_PROFILE_END(phase) StatsEnd(STAT_##phase)
+#define STBTT_COUNT(counter, amount) StatsCount(STAT_##counter, amount)
+
+#else
+
+#define STATS_BEGIN(phase)
+#define STATS_END(phase)
+#define STATS_COUNT(counter, amount)
+
+#endif
+
+#endif
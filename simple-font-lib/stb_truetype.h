@@ -461,6 +461,32 @@ typedef char stbtt__check_size16[sizeof(stbtt_int16) == 2 ? 1 : -1];
 #define STBTT_free(x,u)    ((void)(u),free(x))
 #endif
 
+// limits on the work a single glyph may cause, fonts that exceed them are rejected by
+// stbtt_InitFontChecked (TrueType) or have the glyph treated as empty (CFF)
+#ifndef STBTT_MAX_GLYPH_VERTICES
+#define STBTT_MAX_GLYPH_VERTICES   (1 << 16)  // vertices of a glyph including all components
+#endif
+#ifndef STBTT_MAX_GLYPH_WORK
+#define STBTT_MAX_GLYPH_WORK       (1 << 22)  // vertices copied while composites are assembled
+#endif
+#ifndef STBTT_MAX_COMPOSITE_DEPTH
+#define STBTT_MAX_COMPOSITE_DEPTH  8
+#endif
+#ifndef STBTT_MAX_SUBR_DEPTH
+#define STBTT_MAX_SUBR_DEPTH       10         // nesting of CFF subroutine calls
+#endif
+#ifndef STBTT_MAX_CHARSTRING_OPS
+#define STBTT_MAX_CHARSTRING_OPS   (1 << 16)  // CFF operators run per glyph, subroutines included
+#endif
+
+// #define your own "STBTT_PROFILE_BEGIN" / "STBTT_PROFILE_END" / "STBTT_COUNT" to instrument the hot paths,
+// phases are CMAP, KERN, OUTLINE and RASTERIZE, counters GLYPHS_RASTERIZED and EDGES
+#ifndef STBTT_PROFILE_BEGIN
+#define STBTT_PROFILE_BEGIN(phase)
+#define STBTT_PROFILE_END(phase)
+#define STBTT_COUNT(counter, amount)
+#endif
+
 #ifndef STBTT_assert
 #include <assert.h>
 #define STBTT_assert(x)    assert(x)
@@ -717,6 +743,8 @@ extern "C" {
 		stbtt__buf subrs;                  // private charstring subroutines index
 		stbtt__buf fontdicts;              // array of font dicts
 		stbtt__buf fdselect;               // map from glyph to fontdict
+
+		int validated;                     // set by stbtt_InitFontChecked, lookups skip the checks it has done
 	};
 
 	STBTT_DEF int stbtt_InitFont(stbtt_fontinfo *info, const unsigned char *data, int offset);
@@ -726,6 +754,14 @@ extern "C" {
 	// need to do anything special to free it, because the contents are pure
 	// value data with no additional data structures. Returns 0 on failure.
 
+	STBTT_DEF int stbtt_InitFontChecked(stbtt_fontinfo *info, const unsigned char *data, int size, int index);
+	// Same as stbtt_InitFont for font 'index' of a file of 'size' bytes, but the
+	// file is validated first: the table directory, cmap, metrics, loca/glyf or
+	// CFF structures, kerning and name tables are bounds-checked once so later
+	// lookups can't read outside the file, and glyphs that would exceed the
+	// STBTT_MAX_GLYPH_* limits are rejected. Malformed kern and GPOS tables are
+	// ignored. Returns 0 if the font is invalid or unsafe to use.
+
 
 	//////////////////////////////////////////////////////////////////////////////
 	//
@@ -869,6 +905,12 @@ extern "C" {
 	// same as stbtt_MakeCodepointBitmapSubpixel, but prefiltering
 	// is performed (see stbtt_PackSetOversampling)
 
+	STBTT_DEF void stbtt_MakeCodepointBitmapClipped(const stbtt_fontinfo *info, unsigned char *output, int out_w, int out_h, int out_stride, float scale_x, float scale_y, int clip_x0, int clip_y0, int clip_x1, int clip_y1, int codepoint);
+	// same as stbtt_MakeCodepointBitmap, but only the pixels in columns clip_x0..clip_x1-1
+	// and rows clip_y0..clip_y1-1 of the out_w*out_h bitmap are rasterized and written.
+	// 'output' points at pixel (clip_x0, clip_y0). Scanlines above and below the clip
+	// rectangle are skipped entirely, the written pixels are the same as the unclipped bitmap's.
+
 	STBTT_DEF void stbtt_GetCodepointBitmapBox(const stbtt_fontinfo *font, int codepoint, float scale_x, float scale_y, int *ix0, int *iy0, int *ix1, int *iy1);
 	// get the bbox of the bitmap centered around the glyph origin; so the
 	// bitmap width is ix1-ix0, height is iy1-iy0, and location to place
@@ -887,6 +929,7 @@ extern "C" {
 	STBTT_DEF void stbtt_MakeGlyphBitmap(const stbtt_fontinfo *info, unsigned char *output, int out_w, int out_h, int out_stride, float scale_x, float scale_y, int glyph);
 	STBTT_DEF void stbtt_MakeGlyphBitmapSubpixel(const stbtt_fontinfo *info, unsigned char *output, int out_w, int out_h, int out_stride, float scale_x, float scale_y, float shift_x, float shift_y, int glyph);
 	STBTT_DEF void stbtt_MakeGlyphBitmapSubpixelPrefilter(const stbtt_fontinfo *info, unsigned char *output, int out_w, int out_h, int out_stride, float scale_x, float scale_y, float shift_x, float shift_y, int oversample_x, int oversample_y, float *sub_x, float *sub_y, int glyph);
+	STBTT_DEF void stbtt_MakeGlyphBitmapClipped(const stbtt_fontinfo *info, unsigned char *output, int out_w, int out_h, int out_stride, float scale_x, float scale_y, int clip_x0, int clip_y0, int clip_x1, int clip_y1, int glyph);
 	STBTT_DEF void stbtt_GetGlyphBitmapBox(const stbtt_fontinfo *font, int glyph, float scale_x, float scale_y, int *ix0, int *iy0, int *ix1, int *iy1);
 	STBTT_DEF void stbtt_GetGlyphBitmapBoxSubpixel(const stbtt_fontinfo *font, int glyph, float scale_x, float scale_y, float shift_x, float shift_y, int *ix0, int *iy0, int *ix1, int *iy1);
 
@@ -896,6 +939,9 @@ extern "C" {
 	{
 		int w, h, stride;
 		unsigned char *pixels;
+		// only rows clip_y0..clip_y1-1 and columns clip_x0..clip_x1-1 are rasterized,
+		// pixels points at (clip_x0, clip_y0). Use 0, 0, w, h for the whole bitmap
+		int clip_x0, clip_y0, clip_x1, clip_y1;
 	} stbtt__bitmap;
 
 	// rasterize a shape with quadratic beziers into a bitmap
@@ -909,6 +955,51 @@ extern "C" {
 		int invert,                   // if non-zero, vertically flip shape
 		void *userdata);              // context for to STBTT_MALLOC
 
+	// how the rasterizer keeps the edges that cross the current scanline
+	enum
+	{
+		STBTT_RASTERIZER_LIST,       // a linked list allocated from a small heap, as upstream
+		STBTT_RASTERIZER_EDGE_TABLE  // contiguous arrays per field, edges are inserted and removed in batches per scanline
+	};
+
+	// selects the active edge structure for every font, both produce identical bitmaps. Only the
+	// version 2 rasterizer has the edge table, version 1 always uses the list
+	STBTT_DEF void stbtt_SetRasterizer(int rasterizer);
+
+	// how the edges of a shape are put in the order the rasterizer activates them in
+	enum
+	{
+		STBTT_SORT_QUICKSORT, // compared by their highest point, as upstream
+		STBTT_SORT_BUCKETS    // counted into one bucket per scanline, linear in the edges and rows
+	};
+
+	// selects the edge sort for every font, buckets are the default. Both activate every edge on the same
+	// scanline and produce the same bitmaps up to float rounding. Version 1 always uses quicksort
+	STBTT_DEF void stbtt_SetEdgeSort(int sort);
+
+	// how curves are flattened into the line segments the rasterizers draw
+	enum
+	{
+		STBTT_FLATTEN_HALVING, // curves are halved until each half is flat enough, as upstream
+		STBTT_FLATTEN_ANALYTIC // the segments a curve needs are computed from its control points, in one pass
+	};
+
+	// selects how every font flattens curves, halving is the default. Both stay within the same error of
+	// the curve but place their points differently, so the bitmaps differ slightly along curves
+	STBTT_DEF void stbtt_SetFlattening(int flattening);
+
+	// the rasterizer, edge sort and flattening of a single call
+	typedef struct
+	{
+		int rasterizer; // STBTT_RASTERIZER_*
+		int edge_sort;  // STBTT_SORT_*
+		int flattening; // STBTT_FLATTEN_*
+	} stbtt_raster_options;
+
+	// same as stbtt_MakeGlyphBitmapClipped, but with the given options instead of the ones selected for every font
+	// above, so threads can rasterize with different options without racing on them
+	STBTT_DEF void stbtt_MakeGlyphBitmapClippedOptions(const stbtt_fontinfo *info, unsigned char *output, int out_w, int out_h, int out_stride, float scale_x, float scale_y, int clip_x0, int clip_y0, int clip_x1, int clip_y1, int glyph, const stbtt_raster_options *options);
+
 //////////////////////////////////////////////////////////////////////////////
 //
 // Signed Distance Function (or Field) rendering
@@ -1263,8 +1354,8 @@ static stbtt__buf stbtt__cff_index_get(stbtt__buf b, int i)
 
 static stbtt_uint16 ttUSHORT(stbtt_uint8 *p) { return p[0] * 256 + p[1]; }
 static stbtt_int16 ttSHORT(stbtt_uint8 *p) { return p[0] * 256 + p[1]; }
-static stbtt_uint32 ttULONG(stbtt_uint8 *p) { return (p[0] << 24) + (p[1] << 16) + (p[2] << 8) + p[3]; }
-static stbtt_int32 ttLONG(stbtt_uint8 *p) { return (p[0] << 24) + (p[1] << 16) + (p[2] << 8) + p[3]; }
+static stbtt_uint32 ttULONG(stbtt_uint8 *p) { return ((stbtt_uint32)p[0] << 24) + (p[1] << 16) + (p[2] << 8) + p[3]; }
+static stbtt_int32 ttLONG(stbtt_uint8 *p) { return (stbtt_int32)(((stbtt_uint32)p[0] << 24) + (p[1] << 16) + (p[2] << 8) + p[3]); }
 
 #define stbtt_tag4(p,c0,c1,c2,c3) ((p)[0] == (c0) && (p)[1] == (c1) && (p)[2] == (c2) && (p)[3] == (c3))
 #define stbtt_tag(p,str)           stbtt_tag4(p,str[0],str[1],str[2],str[3])
@@ -1295,6 +1386,24 @@ static stbtt_uint32 stbtt__find_table(stbtt_uint8 *data, stbtt_uint32 fontstart,
 	return 0;
 }
 
+static stbtt_uint32 stbtt__find_table_length(stbtt_uint8 *data, stbtt_uint32 fontstart, const char *tag, stbtt_uint32 *length)
+{
+	stbtt_int32 num_tables = ttUSHORT(data + fontstart + 4);
+	stbtt_uint32 tabledir = fontstart + 12;
+	stbtt_int32 i;
+	for (i = 0; i < num_tables; ++i)
+	{
+		stbtt_uint32 loc = tabledir + 16 * i;
+		if (stbtt_tag(data + loc + 0, tag))
+		{
+			*length = ttULONG(data + loc + 12);
+			return ttULONG(data + loc + 8);
+		}
+	}
+	*length = 0;
+	return 0;
+}
+
 static int stbtt_GetFontOffsetForIndex_internal(unsigned char *font_collection, int index)
 {
 	// if it's just a font, there's only one valid index
@@ -1355,6 +1464,7 @@ static int stbtt_InitFont_internal(stbtt_fontinfo *info, unsigned char *data, in
 	info->data = data;
 	info->fontstart = fontstart;
 	info->cff = stbtt__new_buf(NULL, 0);
+	info->validated = 0;
 
 	cmap = stbtt__find_table(data, fontstart, "cmap");       // required
 	info->loca = stbtt__find_table(data, fontstart, "loca"); // required
@@ -1377,16 +1487,15 @@ static int stbtt_InitFont_internal(stbtt_fontinfo *info, unsigned char *data, in
 		// initialization for CFF / Type2 fonts (OTF)
 		stbtt__buf b, topdict, topdictidx;
 		stbtt_uint32 cstype = 2, charstrings = 0, fdarrayoff = 0, fdselectoff = 0;
-		stbtt_uint32 cff;
+		stbtt_uint32 cff, cfflength;
 
-		cff = stbtt__find_table(data, fontstart, "CFF ");
+		cff = stbtt__find_table_length(data, fontstart, "CFF ", &cfflength);
 		if (!cff) return 0;
 
 		info->fontdicts = stbtt__new_buf(NULL, 0);
 		info->fdselect = stbtt__new_buf(NULL, 0);
 
-		// @TODO this should use size from table (not 512MB)
-		info->cff = stbtt__new_buf(data + cff, 512 * 1024 * 1024);
+		info->cff = stbtt__new_buf(data + cff, cfflength < 512 * 1024 * 1024 ? cfflength : 512 * 1024 * 1024);
 		b = info->cff;
 
 		// read the header
@@ -1465,173 +1574,976 @@ static int stbtt_InitFont_internal(stbtt_fontinfo *info, unsigned char *data, in
 	return 1;
 }
 
-STBTT_DEF int stbtt_FindGlyphIndex(const stbtt_fontinfo *info, int unicode_codepoint)
+//////////////////////////////////////////////////////////////////////////
+//
+// load-time validation
+//
+// everything the lookups read is checked once here, stbtt_InitFontChecked
+// only initializes fonts that pass
+
+typedef struct
 {
-	stbtt_uint8 *data = info->data;
-	stbtt_uint32 index_map = info->index_map;
+	stbtt_uint32 vertices;
+	stbtt_uint32 work;
+	stbtt_uint8 state; // 0 unchecked, 1 being checked, 2 checked
+} stbtt__glyphcheck;
 
-	stbtt_uint16 format = ttUSHORT(data + index_map + 0);
-	if (format == 0)
-	{ // apple byte encoding
-		stbtt_int32 bytes = ttUSHORT(data + index_map + 2);
-		if (unicode_codepoint < bytes - 6)
-			return ttBYTE(data + index_map + 6 + unicode_codepoint);
+typedef struct
+{
+	stbtt_uint8 *data;
+	stbtt_uint32 loca, glyf;
+	int indexToLocFormat;
+	int numGlyphs;
+	stbtt__glyphcheck *glyphs;
+} stbtt__validator;
+
+// true if 'length' bytes at 'offset' lie within 'size' bytes, without overflowing
+static int stbtt__in_range(stbtt_uint32 size, stbtt_uint32 offset, stbtt_uint32 length)
+{
+	return offset <= size && length <= size - offset;
+}
+
+static stbtt_uint32 stbtt__read_offset(stbtt_uint8 *p, int offsize)
+{
+	stbtt_uint32 v = 0;
+	int i;
+	for (i = 0; i < offsize; i++)
+		v = (v << 8) | p[i];
+	return v;
+}
+
+static int stbtt__validate_font_offset(stbtt_uint8 *data, stbtt_uint32 size, int index)
+{
+	stbtt_uint32 n, offset;
+	if (index < 0 || size < 12)
+		return -1;
+	if (stbtt__isfont(data))
+		return index == 0 ? 0 : -1;
+	if (!stbtt_tag(data, "ttcf") || (ttULONG(data + 4) != 0x00010000 && ttULONG(data + 4) != 0x00020000))
+		return -1;
+	n = ttULONG(data + 8);
+	if ((stbtt_uint32)index >= n || !stbtt__in_range(size, 12, 4 * ((stbtt_uint32)index + 1)))
+		return -1;
+	offset = ttULONG(data + 12 + 4 * index);
+	return offset < size ? (int)offset : -1;
+}
+
+static int stbtt__validate_directory(stbtt_uint8 *data, stbtt_uint32 size, stbtt_uint32 fontstart)
+{
+	stbtt_uint32 numTables, i;
+	if (!stbtt__in_range(size, fontstart, 12) || !stbtt__isfont(data + fontstart))
 		return 0;
-	}
-	else if (format == 6)
-	{
-		stbtt_uint32 first = ttUSHORT(data + index_map + 6);
-		stbtt_uint32 count = ttUSHORT(data + index_map + 8);
-		if ((stbtt_uint32)unicode_codepoint >= first && (stbtt_uint32)unicode_codepoint < first + count)
-			return ttUSHORT(data + index_map + 10 + (unicode_codepoint - first) * 2);
+	numTables = ttUSHORT(data + fontstart + 4);
+	if (!stbtt__in_range(size, fontstart + 12, 16 * numTables))
 		return 0;
-	}
-	else if (format == 2)
+	for (i = 0; i < numTables; ++i)
 	{
-		STBTT_assert(0); // @TODO: high-byte mapping for japanese/chinese/korean
-		return 0;
+		stbtt_uint8 *record = data + fontstart + 12 + 16 * i;
+		if (!stbtt__in_range(size, ttULONG(record + 8), ttULONG(record + 12)))
+			return 0;
 	}
-	else if (format == 4)
-	{ // standard mapping for windows fonts: binary search collection of ranges
-		stbtt_uint16 segcount = ttUSHORT(data + index_map + 6) >> 1;
-		stbtt_uint16 searchRange = ttUSHORT(data + index_map + 8) >> 1;
-		stbtt_uint16 entrySelector = ttUSHORT(data + index_map + 10);
-		stbtt_uint16 rangeShift = ttUSHORT(data + index_map + 12) >> 1;
-
-		// do a binary search of the segments
-		stbtt_uint32 endCount = index_map + 14;
-		stbtt_uint32 search = endCount;
+	return 1;
+}
 
-		if (unicode_codepoint > 0xffff)
+// checks a CFF INDEX, returns the offset just past it or 0
+static stbtt_uint32 stbtt__validate_cff_index(stbtt_uint8 *cff, stbtt_uint32 size, stbtt_uint32 offset, stbtt_uint32 *count)
+{
+	stbtt_uint32 n, offsize, i, prev = 1, v;
+	if (!stbtt__in_range(size, offset, 2))
+		return 0;
+	n = ttUSHORT(cff + offset);
+	if (count) *count = n;
+	if (n == 0)
+		return offset + 2;
+	if (!stbtt__in_range(size, offset + 2, 1))
+		return 0;
+	offsize = cff[offset + 2];
+	if (offsize < 1 || offsize > 4 || !stbtt__in_range(size, offset + 3, (n + 1) * offsize))
+		return 0;
+	// offsets start at 1 and never decrease
+	for (i = 0; i <= n; i++)
+	{
+		v = stbtt__read_offset(cff + offset + 3 + i * offsize, offsize);
+		if ((i == 0 && v != 1) || v < prev)
 			return 0;
-
-		// they lie from endCount .. endCount + segCount
-		// but searchRange is the nearest power of two, so...
-		if (unicode_codepoint >= ttUSHORT(data + search + rangeShift * 2))
-			search += rangeShift * 2;
-
-		// now decrement to bias correctly to find smallest
-		search -= 2;
-		while (entrySelector)
-		{
-			stbtt_uint16 end;
-			searchRange >>= 1;
-			end = ttUSHORT(data + search + searchRange * 2);
-			if (unicode_codepoint > end)
-				search += searchRange * 2;
-			--entrySelector;
-		}
-		search += 2;
-
-		{
-			stbtt_uint16 offset, start;
-			stbtt_uint16 item = (stbtt_uint16)((search - endCount) >> 1);
-
-			STBTT_assert(unicode_codepoint <= ttUSHORT(data + endCount + 2 * item));
-			start = ttUSHORT(data + index_map + 14 + segcount * 2 + 2 + 2 * item);
-			if (unicode_codepoint < start)
-				return 0;
-
-			offset = ttUSHORT(data + index_map + 14 + segcount * 6 + 2 + 2 * item);
-			if (offset == 0)
-				return (stbtt_uint16)(unicode_codepoint + ttSHORT(data + index_map + 14 + segcount * 4 + 2 + 2 * item));
-
-			return ttUSHORT(data + offset + (unicode_codepoint - start) * 2 + index_map + 14 + segcount * 6 + 2 + 2 * item);
-		}
+		prev = v;
 	}
-	else if (format == 12 || format == 13)
+	if (!stbtt__in_range(size, offset + 2 + (n + 1) * offsize, prev))
+		return 0;
+	return offset + 2 + (n + 1) * offsize + prev;
+}
+
+// walks a CFF DICT. the operands of 'key' have to be integers, up to 'outcount' of them are stored in 'out'
+static int stbtt__validate_cff_dict(stbtt__buf dict, int key, stbtt_uint32 *out, int outcount)
+{
+	stbtt_uint8 *p = dict.data;
+	stbtt_uint32 size = (stbtt_uint32)dict.size, pos = 0, start = 0;
+	int integers = 1, found = 0;
+	while (pos < size)
 	{
-		stbtt_uint32 ngroups = ttULONG(data + index_map + 12);
-		stbtt_int32 low, high;
-		low = 0; high = (stbtt_int32)ngroups;
-		// Binary search the right group.
-		while (low < high)
+		int b0 = p[pos];
+		if (b0 <= 21)
 		{
-			stbtt_int32 mid = low + ((high - low) >> 1); // rounds down, so low <= mid < high
-			stbtt_uint32 start_char = ttULONG(data + index_map + 16 + mid * 12);
-			stbtt_uint32 end_char = ttULONG(data + index_map + 16 + mid * 12 + 4);
-			if ((stbtt_uint32)unicode_codepoint < start_char)
-				high = mid;
-			else if ((stbtt_uint32)unicode_codepoint > end_char)
-				low = mid + 1;
-			else
+			stbtt_uint32 end = pos;
+			int op = b0, i;
+			if (b0 == 12)
 			{
-				stbtt_uint32 start_glyph = ttULONG(data + index_map + 16 + mid * 12 + 8);
-				if (format == 12)
-					return start_glyph + unicode_codepoint - start_char;
-				else // format == 13
-					return start_glyph;
+				if (pos + 1 >= size) return 0;
+				op = 0x100 | p[++pos];
+			}
+			pos++;
+			if (op == key && !found)
+			{
+				stbtt__buf operands = stbtt__new_buf(p + start, end - start);
+				if (!integers) return 0;
+				for (i = 0; i < outcount && operands.cursor < operands.size; i++)
+					out[i] = stbtt__cff_int(&operands);
+				found = 1;
 			}
+			start = pos;
+			integers = 1;
+			continue;
 		}
-		return 0; // not found
-	}
-	// @TODO
-	STBTT_assert(0);
-	return 0;
-}
 
-STBTT_DEF int stbtt_GetCodepointShape(const stbtt_fontinfo *info, int unicode_codepoint, stbtt_vertex **vertices)
-{
-	return stbtt_GetGlyphShape(info, stbtt_FindGlyphIndex(info, unicode_codepoint), vertices);
+		if (b0 == 30)
+		{
+			// real number, nibbles up to one of 0xf
+			integers = 0;
+			for (pos++; pos < size && (p[pos] & 0xf) != 0xf && (p[pos] >> 4) != 0xf; pos++)
+				;
+			if (pos >= size) return 0;
+			pos++;
+		}
+		else if (b0 == 28) pos += 3;
+		else if (b0 == 29) pos += 5;
+		else if (b0 >= 32 && b0 <= 246) pos += 1;
+		else if (b0 >= 247 && b0 <= 254) pos += 2;
+		else return 0;
+		if (pos > size) return 0;
+	}
+	return 1;
 }
 
-static void stbtt_setvertex(stbtt_vertex *v, stbtt_uint8 type, stbtt_int32 x, stbtt_int32 y, stbtt_int32 cx, stbtt_int32 cy)
+// private DICT of a font dict and the local subroutines it points to
+static int stbtt__validate_cff_private(stbtt_uint8 *cff, stbtt_uint32 size, stbtt__buf fontdict)
 {
-	v->type = type;
-	v->x = (stbtt_int16)x;
-	v->y = (stbtt_int16)y;
-	v->cx = (stbtt_int16)cx;
-	v->cy = (stbtt_int16)cy;
+	stbtt_uint32 private_loc[2] = { 0, 0 }, subrsoff = 0;
+	if (!stbtt__validate_cff_dict(fontdict, 18, private_loc, 2))
+		return 0;
+	if (!private_loc[1] || !private_loc[0])
+		return 1;
+	if (!stbtt__in_range(size, private_loc[1], private_loc[0]))
+		return 0;
+	if (!stbtt__validate_cff_dict(stbtt__new_buf(cff + private_loc[1], private_loc[0]), 19, &subrsoff, 1))
+		return 0;
+	if (!subrsoff)
+		return 1;
+	return subrsoff <= size - private_loc[1] && stbtt__validate_cff_index(cff, size, private_loc[1] + subrsoff, NULL);
 }
 
-static int stbtt__GetGlyfOffset(const stbtt_fontinfo *info, int glyph_index)
+static int stbtt__validate_cff(stbtt_uint8 *cff, stbtt_uint32 size, int numGlyphs)
 {
-	int g1, g2;
-
-	STBTT_assert(!info->cff.size);
+	stbtt_uint32 pos, start, count, fds = 0, fdend, i;
+	stbtt_uint32 cstype = 2, charstrings = 0, fdarrayoff = 0, fdselectoff = 0;
+	stbtt__buf topdict, fontdicts;
 
-	if (glyph_index >= info->numGlyphs) return -1; // glyph index out of range
-	if (info->indexToLocFormat >= 2)    return -1; // unknown index->glyph map format
+	if (size < 4)
+		return 0;
 
-	if (info->indexToLocFormat == 0)
-	{
-		g1 = info->glyf + ttUSHORT(info->data + info->loca + glyph_index * 2) * 2;
-		g2 = info->glyf + ttUSHORT(info->data + info->loca + glyph_index * 2 + 2) * 2;
-	}
-	else
-	{
-		g1 = info->glyf + ttULONG(info->data + info->loca + glyph_index * 4);
-		g2 = info->glyf + ttULONG(info->data + info->loca + glyph_index * 4 + 4);
-	}
+	// name INDEX, top DICT INDEX, string INDEX and global subroutines follow the header
+	pos = stbtt__validate_cff_index(cff, size, cff[2], NULL);
+	start = pos;
+	if (pos) pos = stbtt__validate_cff_index(cff, size, pos, &count);
+	if (!pos || count == 0)
+		return 0;
+	topdict = stbtt__cff_index_get(stbtt__new_buf(cff + start, pos - start), 0);
+	pos = stbtt__validate_cff_index(cff, size, pos, NULL);
+	if (pos) pos = stbtt__validate_cff_index(cff, size, pos, NULL);
+	if (!pos)
+		return 0;
 
-	return g1 == g2 ? -1 : g1; // if length is 0, return -1
-}
+	if (!stbtt__validate_cff_dict(topdict, 17, &charstrings, 1) ||
+		!stbtt__validate_cff_dict(topdict, 0x100 | 6, &cstype, 1) ||
+		!stbtt__validate_cff_dict(topdict, 0x100 | 36, &fdarrayoff, 1) ||
+		!stbtt__validate_cff_dict(topdict, 0x100 | 37, &fdselectoff, 1) ||
+		!stbtt__validate_cff_private(cff, size, topdict))
+		return 0;
+	if (cstype != 2 || charstrings == 0)
+		return 0;
 
-static int stbtt__GetGlyphInfoT2(const stbtt_fontinfo *info, int glyph_index, int *x0, int *y0, int *x1, int *y1);
+	// every glyph needs a charstring
+	if (!stbtt__validate_cff_index(cff, size, charstrings, &count) || count < (stbtt_uint32)numGlyphs)
+		return 0;
 
-STBTT_DEF int stbtt_GetGlyphBox(const stbtt_fontinfo *info, int glyph_index, int *x0, int *y0, int *x1, int *y1)
-{
-	if (info->cff.size)
-	{
-		stbtt__GetGlyphInfoT2(info, glyph_index, x0, y0, x1, y1);
-	}
-	else
+	if (fdarrayoff)
 	{
-		int g = stbtt__GetGlyfOffset(info, glyph_index);
-		if (g < 0) return 0;
+		// CID font, every glyph has to select an existing font dict
+		fdend = stbtt__validate_cff_index(cff, size, fdarrayoff, &fds);
+		if (!fdselectoff || !fdend || fds == 0)
+			return 0;
+		fontdicts = stbtt__new_buf(cff + fdarrayoff, fdend - fdarrayoff);
+		for (i = 0; i < fds; i++)
+		{
+			if (!stbtt__validate_cff_private(cff, size, stbtt__cff_index_get(fontdicts, i)))
+				return 0;
+		}
 
-		if (x0) *x0 = ttSHORT(info->data + g + 2);
-		if (y0) *y0 = ttSHORT(info->data + g + 4);
-		if (x1) *x1 = ttSHORT(info->data + g + 6);
-		if (y1) *y1 = ttSHORT(info->data + g + 8);
+		if (!stbtt__in_range(size, fdselectoff, 1))
+			return 0;
+		if (cff[fdselectoff] == 0)
+		{
+			if (!stbtt__in_range(size, fdselectoff + 1, numGlyphs))
+				return 0;
+			for (i = 0; i < (stbtt_uint32)numGlyphs; i++)
+			{
+				if (cff[fdselectoff + 1 + i] >= fds)
+					return 0;
+			}
+		}
+		else if (cff[fdselectoff] == 3)
+		{
+			stbtt_uint32 nranges, first, next = 0;
+			stbtt_uint8 *range;
+			if (!stbtt__in_range(size, fdselectoff + 1, 2))
+				return 0;
+			nranges = ttUSHORT(cff + fdselectoff + 1);
+			if (nranges == 0 || !stbtt__in_range(size, fdselectoff + 3, 3 * nranges + 2))
+				return 0;
+			range = cff + fdselectoff + 3;
+			if (ttUSHORT(range) != 0)
+				return 0;
+			for (i = 0; i < nranges; i++, range += 3)
+			{
+				first = ttUSHORT(range);
+				next = ttUSHORT(range + 3);
+				if (range[2] >= fds || next <= first)
+					return 0;
+			}
+			if (next < (stbtt_uint32)numGlyphs)
+				return 0;
+		}
+		else
+		{
+			return 0;
+		}
 	}
 	return 1;
 }
 
-STBTT_DEF int stbtt_GetCodepointBox(const stbtt_fontinfo *info, int codepoint, int *x0, int *y0, int *x1, int *y1)
+static int stbtt__validate_cmap(stbtt_fontinfo *info, stbtt_uint32 cmap, stbtt_uint32 cmaplength)
 {
-	return stbtt_GetGlyphBox(info, stbtt_FindGlyphIndex(info, codepoint), x0, y0, x1, y1);
-}
+	stbtt_uint8 *data = info->data;
+	stbtt_uint32 map = info->index_map, end = cmap + cmaplength, numGlyphs = info->numGlyphs, i, c;
+	stbtt_uint8 *table;
+
+	if (map < cmap || !stbtt__in_range(end, map, 4))
+		return 0;
+	table = data + map;
+
+	switch (ttUSHORT(table))
+	{
+		case 0:
+		{
+			stbtt_uint32 bytes = ttUSHORT(table + 2);
+			if (bytes < 6 || !stbtt__in_range(end, map, bytes))
+				return 0;
+			for (i = 6; i < bytes; i++)
+			{
+				if (table[i] >= numGlyphs)
+					return 0;
+			}
+			return 1;
+		}
+
+		case 6:
+		{
+			stbtt_uint32 count;
+			if (!stbtt__in_range(end, map, 10))
+				return 0;
+			count = ttUSHORT(table + 8);
+			if (!stbtt__in_range(end, map + 10, 2 * count))
+				return 0;
+			for (i = 0; i < count; i++)
+			{
+				if (ttUSHORT(table + 10 + 2 * i) >= numGlyphs)
+					return 0;
+			}
+			return 1;
+		}
+
+		case 4:
+		{
+			stbtt_uint32 segcount, searchRange = 1, entrySelector = 0, previous = 0;
+			stbtt_uint8 *endCount, *startCount, *idDelta, *idRangeOffset;
+			if (!stbtt__in_range(end, map, 14))
+				return 0;
+			segcount = ttUSHORT(table + 6) / 2;
+			if (segcount == 0 || (ttUSHORT(table + 6) & 1) || !stbtt__in_range(end, map, 16 + 8 * segcount))
+				return 0;
+
+			// the binary search trusts the search parameters
+			while (searchRange * 2 <= segcount)
+			{
+				searchRange *= 2;
+				entrySelector++;
+			}
+			if (ttUSHORT(table + 8) != 2 * searchRange || ttUSHORT(table + 10) != entrySelector || ttUSHORT(table + 12) != 2 * (segcount - searchRange))
+				return 0;
+
+			endCount = table + 14;
+			startCount = endCount + 2 * segcount + 2;
+			idDelta = startCount + 2 * segcount;
+			idRangeOffset = idDelta + 2 * segcount;
+			if (ttUSHORT(endCount + 2 * (segcount - 1)) != 0xffff)
+				return 0;
+
+			for (i = 0; i < segcount; i++)
+			{
+				stbtt_uint32 first = ttUSHORT(startCount + 2 * i), last = ttUSHORT(endCount + 2 * i);
+				stbtt_uint32 offset = ttUSHORT(idRangeOffset + 2 * i);
+				stbtt_uint32 glyphs = map + 16 + 6 * segcount + 2 * i + offset;
+
+				// segments are sorted and don't overlap, so this visits each code point once
+				if (first > last || (i > 0 && first <= previous))
+					return 0;
+				previous = last;
+
+				if (offset == 0)
+				{
+					for (c = first; c <= last; c++)
+					{
+						if (((c + ttSHORT(idDelta + 2 * i)) & 0xffff) >= numGlyphs)
+							return 0;
+					}
+				}
+				else
+				{
+					// glyph arrays of large subtables can run past their 16-bit length, allow them up to the end of cmap
+					if (!stbtt__in_range(end, glyphs, 2 * (last - first + 1)))
+						return 0;
+					for (c = first; c <= last; c++)
+					{
+						if (ttUSHORT(data + glyphs + 2 * (c - first)) >= numGlyphs)
+							return 0;
+					}
+				}
+			}
+			return 1;
+		}
+
+		case 12:
+		case 13:
+		{
+			stbtt_uint32 ngroups;
+			stbtt_int32 previous = -1;
+			if (!stbtt__in_range(end, map, 16))
+				return 0;
+			ngroups = ttULONG(table + 12);
+			if (ngroups > (end - map - 16) / 12)
+				return 0;
+			for (i = 0; i < ngroups; i++)
+			{
+				stbtt_uint8 *group = table + 16 + 12 * i;
+				stbtt_uint32 first = ttULONG(group), last = ttULONG(group + 4), glyph = ttULONG(group + 8);
+				if (first > last || last > 0x10ffff || (stbtt_int32)first <= previous || glyph >= numGlyphs)
+					return 0;
+				if (ttUSHORT(table) == 12 && last - first >= numGlyphs - glyph)
+					return 0;
+				previous = (stbtt_int32)last;
+			}
+			return 1;
+		}
+	}
+
+	// format 2 and the variation sequences of format 14 can't be used for lookups
+	return 0;
+}
+
+// offset of a glyph in glyf, loca has been checked
+static stbtt_uint32 stbtt__validator_loca(stbtt__validator *v, int glyph)
+{
+	if (v->indexToLocFormat == 0)
+		return ttUSHORT(v->data + v->loca + glyph * 2) * 2;
+	return ttULONG(v->data + v->loca + glyph * 4);
+}
+
+// checks one glyph and the components it uses, counting the vertices stbtt_GetGlyphShape will allocate for it
+static int stbtt__validate_glyph(stbtt__validator *v, int glyph, int depth)
+{
+	stbtt__glyphcheck *check = &v->glyphs[glyph];
+	stbtt_uint8 *data = v->data;
+	stbtt_uint32 g1, g2, length;
+	stbtt_int16 numberOfContours;
+	stbtt_uint8 *g;
+
+	if (check->state == 2)
+		return 1;
+	if (check->state == 1 || depth > STBTT_MAX_COMPOSITE_DEPTH)
+		return 0; // component cycle or too deeply nested
+	check->state = 1;
+
+	g1 = stbtt__validator_loca(v, glyph);
+	g2 = stbtt__validator_loca(v, glyph + 1);
+	length = g2 - g1;
+	if (length == 0)
+	{
+		check->state = 2;
+		return 1;
+	}
+	if (length < 10)
+		return 0;
+
+	g = data + v->glyf + g1;
+	numberOfContours = ttSHORT(g);
+
+	// bitmap boxes come from the header, an inverted one would give glyphs a negative size
+	if (ttSHORT(g + 2) > ttSHORT(g + 6) || ttSHORT(g + 4) > ttSHORT(g + 8))
+		return 0;
+	if (numberOfContours > 0)
+	{
+		stbtt_uint32 n, pos, i, xbytes = 0, ybytes = 0, flagcount = 0, previous = 0;
+		stbtt_uint8 flags = 0;
+
+		if (!stbtt__in_range(length, 10, 2 * numberOfContours + 2))
+			return 0;
+		for (i = 0; i < (stbtt_uint32)numberOfContours; i++)
+		{
+			stbtt_uint32 endPt = ttUSHORT(g + 10 + 2 * i);
+			if (i > 0 && endPt <= previous)
+				return 0;
+			previous = endPt;
+		}
+		n = previous + 1;
+		pos = 10 + 2 * numberOfContours;
+		pos += 2 + ttUSHORT(g + pos); // instructions
+
+		// flags decide how many bytes each coordinate takes
+		for (i = 0; i < n; i++)
+		{
+			if (flagcount == 0)
+			{
+				if (pos >= length) return 0;
+				flags = g[pos++];
+				if (flags & 8)
+				{
+					if (pos >= length) return 0;
+					flagcount = g[pos++];
+				}
+			}
+			else
+				--flagcount;
+			xbytes += (flags & 2) ? 1 : (flags & 16) ? 0 : 2;
+			ybytes += (flags & 4) ? 1 : (flags & 32) ? 0 : 2;
+		}
+		if (!stbtt__in_range(length, pos, xbytes + ybytes))
+			return 0;
+
+		check->vertices = check->work = n + 2 * numberOfContours;
+	}
+	else if (numberOfContours == -1)
+	{
+		stbtt_uint32 pos = 10, more = 1;
+		while (more)
+		{
+			stbtt_uint16 flags, gidx;
+			stbtt__glyphcheck *component;
+			if (!stbtt__in_range(length, pos, 4))
+				return 0;
+			flags = ttUSHORT(g + pos);
+			gidx = ttUSHORT(g + pos + 2);
+			pos += 4;
+			pos += (flags & 1) ? 4 : 2;
+			if (flags & (1 << 3))
+				pos += 2;
+			else if (flags & (1 << 6))
+				pos += 4;
+			else if (flags & (1 << 7))
+				pos += 8;
+			if (pos > length || gidx >= v->numGlyphs)
+				return 0;
+
+			// each component is appended to a new copy of the vertices so far
+			if (!stbtt__validate_glyph(v, gidx, depth + 1))
+				return 0;
+			component = &v->glyphs[gidx];
+			check->vertices += component->vertices;
+			check->work += component->work + (component->vertices ? check->vertices : 0);
+			if (check->vertices > STBTT_MAX_GLYPH_VERTICES || check->work > STBTT_MAX_GLYPH_WORK)
+				return 0;
+			more = flags & (1 << 5);
+		}
+	}
+	else if (numberOfContours < 0)
+	{
+		return 0;
+	}
+
+	if (check->vertices > STBTT_MAX_GLYPH_VERTICES)
+		return 0;
+	check->state = 2;
+	return 1;
+}
+
+static int stbtt__validate_glyphs(stbtt_fontinfo *info)
+{
+	stbtt__validator v;
+	stbtt_uint32 localength, glyflength, i, previous = 0, entry;
+	int ok = 1;
+
+	v.data = info->data;
+	v.loca = stbtt__find_table_length(info->data, info->fontstart, "loca", &localength);
+	v.glyf = stbtt__find_table_length(info->data, info->fontstart, "glyf", &glyflength);
+	v.indexToLocFormat = info->indexToLocFormat;
+	v.numGlyphs = info->numGlyphs;
+	if (info->indexToLocFormat > 1 || localength < ((stbtt_uint32)info->numGlyphs + 1) * (info->indexToLocFormat ? 4 : 2))
+		return 0;
+
+	// glyph data is in order and inside glyf
+	for (i = 0; i <= (stbtt_uint32)info->numGlyphs; i++)
+	{
+		entry = stbtt__validator_loca(&v, i);
+		if (entry < previous || entry > glyflength)
+			return 0;
+		previous = entry;
+	}
+
+	v.glyphs = (stbtt__glyphcheck *)STBTT_malloc(sizeof(stbtt__glyphcheck) * (info->numGlyphs + 1), info->userdata);
+	if (!v.glyphs)
+		return 0;
+	STBTT_memset(v.glyphs, 0, sizeof(stbtt__glyphcheck) * (info->numGlyphs + 1));
+	for (i = 0; ok && i < (stbtt_uint32)info->numGlyphs; i++)
+		ok = stbtt__validate_glyph(&v, i, 0);
+	STBTT_free(v.glyphs, info->userdata);
+	return ok;
+}
+
+static int stbtt__validate_coverage(stbtt_uint8 *gpos, stbtt_uint32 length, stbtt_uint32 coverage, stbtt_uint32 *indices)
+{
+	stbtt_uint32 count, i;
+	if (!stbtt__in_range(length, coverage, 4))
+		return 0;
+	count = ttUSHORT(gpos + coverage + 2);
+	*indices = 0;
+	switch (ttUSHORT(gpos + coverage))
+	{
+		case 1:
+			*indices = count;
+			return stbtt__in_range(length, coverage + 4, 2 * count);
+
+		case 2:
+			if (!stbtt__in_range(length, coverage + 4, 6 * count))
+				return 0;
+			for (i = 0; i < count; i++)
+			{
+				stbtt_uint8 *range = gpos + coverage + 4 + 6 * i;
+				stbtt_uint32 first = ttUSHORT(range), last = ttUSHORT(range + 2);
+				if (last >= first && ttUSHORT(range + 4) + last - first + 1 > *indices)
+					*indices = ttUSHORT(range + 4) + last - first + 1;
+			}
+			return 1;
+	}
+	return 0;
+}
+
+static int stbtt__validate_class_def(stbtt_uint8 *gpos, stbtt_uint32 length, stbtt_uint32 classDef, stbtt_uint32 classes)
+{
+	stbtt_uint32 count, i;
+	if (!stbtt__in_range(length, classDef, 4))
+		return 0;
+	switch (ttUSHORT(gpos + classDef))
+	{
+		case 1:
+			if (!stbtt__in_range(length, classDef, 6))
+				return 0;
+			count = ttUSHORT(gpos + classDef + 4);
+			if (!stbtt__in_range(length, classDef + 6, 2 * count))
+				return 0;
+			for (i = 0; i < count; i++)
+			{
+				if (ttUSHORT(gpos + classDef + 6 + 2 * i) >= classes)
+					return 0;
+			}
+			return 1;
+
+		case 2:
+			count = ttUSHORT(gpos + classDef + 2);
+			if (!stbtt__in_range(length, classDef + 4, 6 * count))
+				return 0;
+			for (i = 0; i < count; i++)
+			{
+				if (ttUSHORT(gpos + classDef + 4 + 6 * i + 4) >= classes)
+					return 0;
+			}
+			return 1;
+	}
+	return 0;
+}
+
+// pair adjustment subtable as read by stbtt__GetGlyphGPOSInfoAdvance
+static int stbtt__validate_pair_pos(stbtt_uint8 *gpos, stbtt_uint32 length, stbtt_uint32 table)
+{
+	stbtt_uint32 indices, i;
+	stbtt_uint8 *t = gpos + table;
+	int kerningOnly;
+
+	if (!stbtt__in_range(length, table, 8))
+		return 0;
+	if (!stbtt__validate_coverage(gpos, length, table + ttUSHORT(t + 2), &indices))
+		return 0;
+	kerningOnly = ttUSHORT(t + 4) == 4 && ttUSHORT(t + 6) == 0;
+
+	switch (ttUSHORT(t))
+	{
+		case 1:
+		{
+			stbtt_uint32 pairSetCount;
+			if (!stbtt__in_range(length, table, 10))
+				return 0;
+			pairSetCount = ttUSHORT(t + 8);
+			if (indices > pairSetCount || !stbtt__in_range(length, table + 10, 2 * pairSetCount))
+				return 0;
+			for (i = 0; i < pairSetCount; i++)
+			{
+				stbtt_uint32 pairSet = table + ttUSHORT(t + 10 + 2 * i);
+				if (!stbtt__in_range(length, pairSet, 2))
+					return 0;
+				if (kerningOnly && !stbtt__in_range(length, pairSet + 2, 4 * ttUSHORT(gpos + pairSet)))
+					return 0;
+			}
+			return 1;
+		}
+
+		case 2:
+		{
+			stbtt_uint32 class1Count, class2Count;
+			if (!stbtt__in_range(length, table, 16))
+				return 0;
+			class1Count = ttUSHORT(t + 12);
+			class2Count = ttUSHORT(t + 14);
+			if (!stbtt__validate_class_def(gpos, length, table + ttUSHORT(t + 8), class1Count) ||
+				!stbtt__validate_class_def(gpos, length, table + ttUSHORT(t + 10), class2Count))
+				return 0;
+			if (!kerningOnly || class2Count == 0)
+				return 1;
+			return stbtt__in_range(length, table, 16) && class1Count <= (length - table - 16) / (2 * class2Count);
+		}
+	}
+	return 0;
+}
+
+static int stbtt__validate_gpos(stbtt_uint8 *gpos, stbtt_uint32 length)
+{
+	stbtt_uint32 lookupList, lookupCount, i, j;
+	if (length < 10 || ttUSHORT(gpos) != 1 || ttUSHORT(gpos + 2) != 0)
+		return 0;
+	lookupList = ttUSHORT(gpos + 8);
+	if (!stbtt__in_range(length, lookupList, 2))
+		return 0;
+	lookupCount = ttUSHORT(gpos + lookupList);
+	if (!stbtt__in_range(length, lookupList + 2, 2 * lookupCount))
+		return 0;
+
+	for (i = 0; i < lookupCount; i++)
+	{
+		stbtt_uint32 lookup = lookupList + ttUSHORT(gpos + lookupList + 2 + 2 * i), subTableCount;
+		if (!stbtt__in_range(length, lookup, 6))
+			return 0;
+		subTableCount = ttUSHORT(gpos + lookup + 4);
+		if (!stbtt__in_range(length, lookup + 6, 2 * subTableCount))
+			return 0;
+		if (ttUSHORT(gpos + lookup) != 2)
+			continue;
+		for (j = 0; j < subTableCount; j++)
+		{
+			if (!stbtt__validate_pair_pos(gpos, length, lookup + ttUSHORT(gpos + lookup + 6 + 2 * j)))
+				return 0;
+		}
+	}
+	return 1;
+}
+
+static int stbtt__validate_kern(stbtt_uint8 *kern, stbtt_uint32 length)
+{
+	// only the first subtable is used
+	if (length < 18 || ttUSHORT(kern + 2) < 1 || ttUSHORT(kern + 8) != 1)
+		return 0;
+	return stbtt__in_range(length, 18, 6 * ttUSHORT(kern + 10));
+}
+
+static int stbtt__validate_name(stbtt_uint8 *name, stbtt_uint32 length)
+{
+	stbtt_uint32 count, strings, i;
+	if (length < 6)
+		return 0;
+	count = ttUSHORT(name + 2);
+	strings = ttUSHORT(name + 4);
+	if (!stbtt__in_range(length, 6, 12 * count))
+		return 0;
+	for (i = 0; i < count; i++)
+	{
+		stbtt_uint8 *record = name + 6 + 12 * i;
+		if (!stbtt__in_range(length, strings + ttUSHORT(record + 10), ttUSHORT(record + 8)))
+			return 0;
+	}
+	return 1;
+}
+
+// tables stbtt_InitFont reads before it can be called
+static int stbtt__validate_tables(stbtt_uint8 *data, stbtt_uint32 size, stbtt_uint32 fontstart)
+{
+	stbtt_uint32 cmap, head, hhea, maxp, hmtx, glyf, cff, name, length[8];
+	stbtt_uint32 numGlyphs, numOfLongHorMetrics;
+
+	if (!stbtt__validate_directory(data, size, fontstart))
+		return 0;
+
+	cmap = stbtt__find_table_length(data, fontstart, "cmap", &length[0]);
+	head = stbtt__find_table_length(data, fontstart, "head", &length[1]);
+	hhea = stbtt__find_table_length(data, fontstart, "hhea", &length[2]);
+	maxp = stbtt__find_table_length(data, fontstart, "maxp", &length[3]);
+	hmtx = stbtt__find_table_length(data, fontstart, "hmtx", &length[4]);
+	glyf = stbtt__find_table_length(data, fontstart, "glyf", &length[5]);
+	cff = stbtt__find_table_length(data, fontstart, "CFF ", &length[6]);
+	name = stbtt__find_table_length(data, fontstart, "name", &length[7]);
+	if (!cmap || !head || !hhea || !maxp || !hmtx || (!glyf && !cff))
+		return 0;
+
+	// cmap encoding records, head up to indexToLocFormat, hhea up to numOfLongHorMetrics, maxp up to numGlyphs
+	if (length[0] < 4 || !stbtt__in_range(length[0], 4, 8 * ttUSHORT(data + cmap + 2)))
+		return 0;
+	if (length[1] < 54 || length[2] < 36 || length[3] < 6)
+		return 0;
+	numGlyphs = ttUSHORT(data + maxp + 4);
+	if (numGlyphs == 0)
+		return 0;
+
+	// a zero line height would make ScaleForPixelHeight divide by zero
+	if (ttSHORT(data + hhea + 4) <= ttSHORT(data + hhea + 6))
+		return 0;
+
+	numOfLongHorMetrics = ttUSHORT(data + hhea + 34);
+	if (numOfLongHorMetrics == 0)
+		return 0;
+	if (numOfLongHorMetrics > numGlyphs)
+		numOfLongHorMetrics = numGlyphs;
+	if (length[4] < 4 * numOfLongHorMetrics + 2 * (numGlyphs - numOfLongHorMetrics))
+		return 0;
+
+	if (!glyf && !stbtt__validate_cff(data + cff, length[6], numGlyphs))
+		return 0;
+	if (name && !stbtt__validate_name(data + name, length[7]))
+		return 0;
+	return 1;
+}
+
+STBTT_DEF int stbtt_InitFontChecked(stbtt_fontinfo *info, const unsigned char *data, int size, int index)
+{
+	stbtt_uint8 *fontdata = (stbtt_uint8 *)data;
+	stbtt_uint32 cmap, cmaplength, length;
+	int fontstart;
+
+	if (size < 0)
+		return 0;
+	fontstart = stbtt__validate_font_offset(fontdata, (stbtt_uint32)size, index);
+	if (fontstart < 0 || !stbtt__validate_tables(fontdata, (stbtt_uint32)size, (stbtt_uint32)fontstart))
+		return 0;
+	if (!stbtt_InitFont_internal(info, fontdata, fontstart))
+		return 0;
+
+	cmap = stbtt__find_table_length(fontdata, fontstart, "cmap", &cmaplength);
+	if (!stbtt__validate_cmap(info, cmap, cmaplength))
+		return 0;
+	if (info->glyf && !stbtt__validate_glyphs(info))
+		return 0;
+
+	// optional tables that can't be used safely are ignored instead of failing the font
+	stbtt__find_table_length(fontdata, fontstart, "kern", &length);
+	if (info->kern && !stbtt__validate_kern(fontdata + info->kern, length))
+		info->kern = 0;
+	stbtt__find_table_length(fontdata, fontstart, "GPOS", &length);
+	if (info->gpos && !stbtt__validate_gpos(fontdata + info->gpos, length))
+		info->gpos = 0;
+
+	info->validated = 1;
+	return 1;
+}
+
+static int stbtt__FindGlyphIndex(const stbtt_fontinfo *info, int unicode_codepoint)
+{
+	stbtt_uint8 *data = info->data;
+	stbtt_uint32 index_map = info->index_map;
+
+	stbtt_uint16 format = ttUSHORT(data + index_map + 0);
+	if (format == 0)
+	{ // apple byte encoding
+		stbtt_int32 bytes = ttUSHORT(data + index_map + 2);
+		if (unicode_codepoint < bytes - 6)
+			return ttBYTE(data + index_map + 6 + unicode_codepoint);
+		return 0;
+	}
+	else if (format == 6)
+	{
+		stbtt_uint32 first = ttUSHORT(data + index_map + 6);
+		stbtt_uint32 count = ttUSHORT(data + index_map + 8);
+		if ((stbtt_uint32)unicode_codepoint >= first && (stbtt_uint32)unicode_codepoint < first + count)
+			return ttUSHORT(data + index_map + 10 + (unicode_codepoint - first) * 2);
+		return 0;
+	}
+	else if (format == 2)
+	{
+		STBTT_assert(0); // @TODO: high-byte mapping for japanese/chinese/korean
+		return 0;
+	}
+	else if (format == 4)
+	{ // standard mapping for windows fonts: binary search collection of ranges
+		stbtt_uint16 segcount = ttUSHORT(data + index_map + 6) >> 1;
+		stbtt_uint16 searchRange = ttUSHORT(data + index_map + 8) >> 1;
+		stbtt_uint16 entrySelector = ttUSHORT(data + index_map + 10);
+		stbtt_uint16 rangeShift = ttUSHORT(data + index_map + 12) >> 1;
+
+		// do a binary search of the segments
+		stbtt_uint32 endCount = index_map + 14;
+		stbtt_uint32 search = endCount;
+
+		if (unicode_codepoint > 0xffff)
+			return 0;
+
+		// they lie from endCount .. endCount + segCount
+		// but searchRange is the nearest power of two, so...
+		if (unicode_codepoint >= ttUSHORT(data + search + rangeShift * 2))
+			search += rangeShift * 2;
+
+		// now decrement to bias correctly to find smallest
+		search -= 2;
+		while (entrySelector)
+		{
+			stbtt_uint16 end;
+			searchRange >>= 1;
+			end = ttUSHORT(data + search + searchRange * 2);
+			if (unicode_codepoint > end)
+				search += searchRange * 2;
+			--entrySelector;
+		}
+		search += 2;
+
+		{
+			stbtt_uint16 offset, start;
+			stbtt_uint16 item = (stbtt_uint16)((search - endCount) >> 1);
+
+			STBTT_assert(unicode_codepoint <= ttUSHORT(data + endCount + 2 * item));
+			start = ttUSHORT(data + index_map + 14 + segcount * 2 + 2 + 2 * item);
+			if (unicode_codepoint < start)
+				return 0;
+
+			offset = ttUSHORT(data + index_map + 14 + segcount * 6 + 2 + 2 * item);
+			if (offset == 0)
+				return (stbtt_uint16)(unicode_codepoint + ttSHORT(data + index_map + 14 + segcount * 4 + 2 + 2 * item));
+
+			return ttUSHORT(data + offset + (unicode_codepoint - start) * 2 + index_map + 14 + segcount * 6 + 2 + 2 * item);
+		}
+	}
+	else if (format == 12 || format == 13)
+	{
+		stbtt_uint32 ngroups = ttULONG(data + index_map + 12);
+		stbtt_int32 low, high;
+		low = 0; high = (stbtt_int32)ngroups;
+		// Binary search the right group.
+		while (low < high)
+		{
+			stbtt_int32 mid = low + ((high - low) >> 1); // rounds down, so low <= mid < high
+			stbtt_uint32 start_char = ttULONG(data + index_map + 16 + mid * 12);
+			stbtt_uint32 end_char = ttULONG(data + index_map + 16 + mid * 12 + 4);
+			if ((stbtt_uint32)unicode_codepoint < start_char)
+				high = mid;
+			else if ((stbtt_uint32)unicode_codepoint > end_char)
+				low = mid + 1;
+			else
+			{
+				stbtt_uint32 start_glyph = ttULONG(data + index_map + 16 + mid * 12 + 8);
+				if (format == 12)
+					return start_glyph + unicode_codepoint - start_char;
+				else // format == 13
+					return start_glyph;
+			}
+		}
+		return 0; // not found
+	}
+	// @TODO
+	STBTT_assert(0);
+	return 0;
+}
+
+STBTT_DEF int stbtt_FindGlyphIndex(const stbtt_fontinfo *info, int unicode_codepoint)
+{
+	int glyph;
+	STBTT_PROFILE_BEGIN(CMAP);
+	glyph = stbtt__FindGlyphIndex(info, unicode_codepoint);
+	STBTT_PROFILE_END(CMAP);
+	return glyph;
+}
+
+STBTT_DEF int stbtt_GetCodepointShape(const stbtt_fontinfo *info, int unicode_codepoint, stbtt_vertex **vertices)
+{
+	return stbtt_GetGlyphShape(info, stbtt_FindGlyphIndex(info, unicode_codepoint), vertices);
+}
+
+static void stbtt_setvertex(stbtt_vertex *v, stbtt_uint8 type, stbtt_int32 x, stbtt_int32 y, stbtt_int32 cx, stbtt_int32 cy)
+{
+	v->type = type;
+	v->x = (stbtt_int16)x;
+	v->y = (stbtt_int16)y;
+	v->cx = (stbtt_int16)cx;
+	v->cy = (stbtt_int16)cy;
+}
+
+static int stbtt__GetGlyfOffset(const stbtt_fontinfo *info, int glyph_index)
+{
+	int g1, g2;
+
+	STBTT_assert(!info->cff.size);
+
+	if (glyph_index >= info->numGlyphs) return -1; // glyph index out of range
+	if (!info->validated && info->indexToLocFormat >= 2) return -1; // unknown index->glyph map format
+
+	if (info->indexToLocFormat == 0)
+	{
+		g1 = info->glyf + ttUSHORT(info->data + info->loca + glyph_index * 2) * 2;
+		g2 = info->glyf + ttUSHORT(info->data + info->loca + glyph_index * 2 + 2) * 2;
+	}
+	else
+	{
+		g1 = info->glyf + ttULONG(info->data + info->loca + glyph_index * 4);
+		g2 = info->glyf + ttULONG(info->data + info->loca + glyph_index * 4 + 4);
+	}
+
+	return g1 == g2 ? -1 : g1; // if length is 0, return -1
+}
+
+static int stbtt__GetGlyphInfoT2(const stbtt_fontinfo *info, int glyph_index, int *x0, int *y0, int *x1, int *y1);
+
+STBTT_DEF int stbtt_GetGlyphBox(const stbtt_fontinfo *info, int glyph_index, int *x0, int *y0, int *x1, int *y1)
+{
+	if (info->cff.size)
+	{
+		stbtt__GetGlyphInfoT2(info, glyph_index, x0, y0, x1, y1);
+	}
+	else
+	{
+		int g = stbtt__GetGlyfOffset(info, glyph_index);
+		if (g < 0) return 0;
+
+		if (x0) *x0 = ttSHORT(info->data + g + 2);
+		if (y0) *y0 = ttSHORT(info->data + g + 4);
+		if (x1) *x1 = ttSHORT(info->data + g + 6);
+		if (y1) *y1 = ttSHORT(info->data + g + 8);
+	}
+	return 1;
+}
+
+STBTT_DEF int stbtt_GetCodepointBox(const stbtt_fontinfo *info, int codepoint, int *x0, int *y0, int *x1, int *y1)
+{
+	return stbtt_GetGlyphBox(info, stbtt_FindGlyphIndex(info, codepoint), x0, y0, x1, y1);
+}
 
 STBTT_DEF int stbtt_IsGlyphEmpty(const stbtt_fontinfo *info, int glyph_index)
 {
@@ -1862,8 +2774,8 @@ static int stbtt__GetGlyphShapeTT(const stbtt_fontinfo *info, int glyph_index, s
 			}
 			else
 			{
-				// @TODO handle matching point
-				STBTT_assert(0);
+				// @TODO handle matching point, the component is placed at the origin
+				comp += (flags & 1) ? 4 : 2;
 			}
 			if (flags & (1 << 3))
 			{ // WE_HAVE_A_SCALE
@@ -2062,9 +2974,9 @@ static stbtt__buf stbtt__cid_get_glyph_subrs(const stbtt_fontinfo *info, int gly
 static int stbtt__run_charstring(const stbtt_fontinfo *info, int glyph_index, stbtt__csctx *c)
 {
 	int in_header = 1, maskbits = 0, subr_stack_height = 0, sp = 0, v, i, b0;
-	int has_subrs = 0, clear_stack;
+	int has_subrs = 0, clear_stack, operations = 0;
 	float s[48];
-	stbtt__buf subr_stack[10], subrs = info->subrs, b;
+	stbtt__buf subr_stack[STBTT_MAX_SUBR_DEPTH], subrs = info->subrs, b;
 	float f;
 
 #define STBTT__CSERR(s) (0)
@@ -2073,6 +2985,8 @@ static int stbtt__run_charstring(const stbtt_fontinfo *info, int glyph_index, st
 	b = stbtt__cff_index_get(info->charstrings, glyph_index);
 	while (b.cursor < b.size)
 	{
+		// subroutines can call each other many times over, this bounds the work of a glyph
+		if (++operations > STBTT_MAX_CHARSTRING_OPS) return STBTT__CSERR("operation limit");
 		i = 0;
 		clear_stack = 1;
 		b0 = stbtt__buf_get8(&b);
@@ -2084,6 +2998,7 @@ static int stbtt__run_charstring(const stbtt_fontinfo *info, int glyph_index, st
 				if (in_header)
 					maskbits += (sp / 2); // implicit "vstem"
 				in_header = 0;
+				if ((maskbits + 7) / 8 > b.size - b.cursor) return STBTT__CSERR("hintmask");
 				stbtt__buf_skip(&b, (maskbits + 7) / 8);
 				break;
 
@@ -2201,7 +3116,7 @@ static int stbtt__run_charstring(const stbtt_fontinfo *info, int glyph_index, st
 			case 0x1D: // callgsubr
 				if (sp < 1) return STBTT__CSERR("call(g|)subr stack");
 				v = (int)s[--sp];
-				if (subr_stack_height >= 10) return STBTT__CSERR("recursion limit");
+				if (subr_stack_height >= STBTT_MAX_SUBR_DEPTH) return STBTT__CSERR("recursion limit");
 				subr_stack[subr_stack_height++] = b;
 				b = stbtt__get_subr(b0 == 0x0A ? subrs : info->gsubrs, v);
 				if (b.size == 0) return STBTT__CSERR("subr not found");
@@ -2361,10 +3276,14 @@ static int stbtt__GetGlyphInfoT2(const stbtt_fontinfo *info, int glyph_index, in
 
 STBTT_DEF int stbtt_GetGlyphShape(const stbtt_fontinfo *info, int glyph_index, stbtt_vertex **pvertices)
 {
+	int num_vertices;
+	STBTT_PROFILE_BEGIN(OUTLINE);
 	if (!info->cff.size)
-		return stbtt__GetGlyphShapeTT(info, glyph_index, pvertices);
+		num_vertices = stbtt__GetGlyphShapeTT(info, glyph_index, pvertices);
 	else
-		return stbtt__GetGlyphShapeT2(info, glyph_index, pvertices);
+		num_vertices = stbtt__GetGlyphShapeT2(info, glyph_index, pvertices);
+	STBTT_PROFILE_END(OUTLINE);
+	return num_vertices;
 }
 
 STBTT_DEF void stbtt_GetGlyphHMetrics(const stbtt_fontinfo *info, int glyph_index, int *advanceWidth, int *leftSideBearing)
@@ -2389,12 +3308,16 @@ static int  stbtt__GetGlyphKernInfoAdvance(const stbtt_fontinfo *info, int glyph
 	int l, r, m;
 
 	// we only look at the first table. it must be 'horizontal' and format 0.
+	// validated fonts only keep kern tables that pass these checks
 	if (!info->kern)
 		return 0;
-	if (ttUSHORT(data + 2) < 1) // number of tables, need at least 1
-		return 0;
-	if (ttUSHORT(data + 8) != 1) // horizontal flag must be set in format
-		return 0;
+	if (!info->validated)
+	{
+		if (ttUSHORT(data + 2) < 1) // number of tables, need at least 1
+			return 0;
+		if (ttUSHORT(data + 8) != 1) // horizontal flag must be set in format
+			return 0;
+	}
 
 	l = 0;
 	r = ttUSHORT(data + 10) - 1;
@@ -2548,8 +3471,12 @@ static stbtt_int32  stbtt__GetGlyphGPOSInfoAdvance(const stbtt_fontinfo *info, i
 
 	data = info->data + info->gpos;
 
-	if (ttUSHORT(data + 0) != 1) return 0; // Major version 1
-	if (ttUSHORT(data + 2) != 0) return 0; // Minor version 0
+	// validated fonts only keep GPOS tables of this version
+	if (!info->validated)
+	{
+		if (ttUSHORT(data + 0) != 1) return 0; // Major version 1
+		if (ttUSHORT(data + 2) != 0) return 0; // Minor version 0
+	}
 
 	lookupListOffset = ttUSHORT(data + 8);
 	lookupList = data + lookupListOffset;
@@ -2678,6 +3605,7 @@ static stbtt_int32  stbtt__GetGlyphGPOSInfoAdvance(const stbtt_fontinfo *info, i
 STBTT_DEF int  stbtt_GetGlyphKernAdvance(const stbtt_fontinfo *info, int g1, int g2)
 {
 	int xAdvance = 0;
+	STBTT_PROFILE_BEGIN(KERN);
 
 	if (info->gpos)
 		xAdvance += stbtt__GetGlyphGPOSInfoAdvance(info, g1, g2);
@@ -2685,6 +3613,7 @@ STBTT_DEF int  stbtt_GetGlyphKernAdvance(const stbtt_fontinfo *info, int g1, int
 	if (info->kern)
 		xAdvance += stbtt__GetGlyphKernInfoAdvance(info, g1, g2);
 
+	STBTT_PROFILE_END(KERN);
 	return xAdvance;
 }
 
@@ -2985,7 +3914,7 @@ static void stbtt__rasterize_sorted_edges(stbtt__bitmap *result, stbtt__edge *e,
 	y = off_y * vsubsample;
 	e[n].y0 = (off_y + result->h) * (float)vsubsample + 1;
 
-	while (j < result->h)
+	while (j < result->clip_y1)
 	{
 		STBTT_memset(scanline, 0, result->w);
 		for (s = 0; s < vsubsample; ++s)
@@ -3073,7 +4002,8 @@ static void stbtt__rasterize_sorted_edges(stbtt__bitmap *result, stbtt__edge *e,
 
 			++y;
 		}
-		STBTT_memcpy(result->pixels + j * result->stride, scanline, result->w);
+		if (j >= result->clip_y0)
+			STBTT_memcpy(result->pixels + (j - result->clip_y0) * result->stride, scanline + result->clip_x0, result->clip_x1 - result->clip_x0);
 		++j;
 	}
 
@@ -3127,232 +4057,258 @@ static void stbtt__handle_clipped_edge(float *scanline, int x, stbtt__active_edg
 	}
 }
 
-static void stbtt__fill_active_edges_new(float *scanline, float *scanline_fill, int len, stbtt__active_edge *e, float y_top)
+// accumulates the coverage of one active edge over the scanline
+static void stbtt__fill_active_edge(float *scanline, float *scanline_fill, int len, stbtt__active_edge *e, float y_top)
 {
 	float y_bottom = y_top + 1;
 
-	while (e)
-	{
-		// brute force every pixel
+	// brute force every pixel
 
-		// compute intersection points with top & bottom
-		STBTT_assert(e->ey >= y_top);
+	// compute intersection points with top & bottom
+	STBTT_assert(e->ey >= y_top);
 
-		if (e->fdx == 0)
+	if (e->fdx == 0)
+	{
+		float x0 = e->fx;
+		if (x0 < len)
+		{
+			if (x0 >= 0)
+			{
+				stbtt__handle_clipped_edge(scanline, (int)x0, e, x0, y_top, x0, y_bottom);
+				stbtt__handle_clipped_edge(scanline_fill - 1, (int)x0 + 1, e, x0, y_top, x0, y_bottom);
+			}
+			else
+			{
+				stbtt__handle_clipped_edge(scanline_fill - 1, 0, e, x0, y_top, x0, y_bottom);
+			}
+		}
+	}
+	else
+	{
+		float x0 = e->fx;
+		float dx = e->fdx;
+		float xb = x0 + dx;
+		float x_top, x_bottom;
+		float sy0, sy1;
+		float dy = e->fdy;
+		STBTT_assert(e->sy <= y_bottom && e->ey >= y_top);
+
+		// compute endpoints of line segment clipped to this scanline (if the
+		// line segment starts on this scanline. x0 is the intersection of the
+		// line with y_top, but that may be off the line segment.
+		if (e->sy > y_top)
+		{
+			x_top = x0 + dx * (e->sy - y_top);
+			sy0 = e->sy;
+		}
+		else
+		{
+			x_top = x0;
+			sy0 = y_top;
+		}
+		if (e->ey < y_bottom)
 		{
-			float x0 = e->fx;
-			if (x0 < len)
-			{
-				if (x0 >= 0)
-				{
-					stbtt__handle_clipped_edge(scanline, (int)x0, e, x0, y_top, x0, y_bottom);
-					stbtt__handle_clipped_edge(scanline_fill - 1, (int)x0 + 1, e, x0, y_top, x0, y_bottom);
-				}
-				else
-				{
-					stbtt__handle_clipped_edge(scanline_fill - 1, 0, e, x0, y_top, x0, y_bottom);
-				}
-			}
+			x_bottom = x0 + dx * (e->ey - y_top);
+			sy1 = e->ey;
 		}
 		else
 		{
-			float x0 = e->fx;
-			float dx = e->fdx;
-			float xb = x0 + dx;
-			float x_top, x_bottom;
-			float sy0, sy1;
-			float dy = e->fdy;
-			STBTT_assert(e->sy <= y_bottom && e->ey >= y_top);
-
-			// compute endpoints of line segment clipped to this scanline (if the
-			// line segment starts on this scanline. x0 is the intersection of the
-			// line with y_top, but that may be off the line segment.
-			if (e->sy > y_top)
-			{
-				x_top = x0 + dx * (e->sy - y_top);
-				sy0 = e->sy;
-			}
-			else
-			{
-				x_top = x0;
-				sy0 = y_top;
-			}
-			if (e->ey < y_bottom)
+			x_bottom = xb;
+			sy1 = y_bottom;
+		}
+
+		if (x_top >= 0 && x_bottom >= 0 && x_top < len && x_bottom < len)
+		{
+			// from here on, we don't have to range check x values
+
+			if ((int)x_top == (int)x_bottom)
 			{
-				x_bottom = x0 + dx * (e->ey - y_top);
-				sy1 = e->ey;
+				float height;
+				// simple case, only spans one pixel
+				int x = (int)x_top;
+				height = sy1 - sy0;
+				STBTT_assert(x >= 0 && x < len);
+				scanline[x] += e->direction * (1 - ((x_top - x) + (x_bottom - x)) / 2)  * height;
+				scanline_fill[x] += e->direction * height; // everything right of this pixel is filled
 			}
 			else
 			{
-				x_bottom = xb;
-				sy1 = y_bottom;
-			}
-
-			if (x_top >= 0 && x_bottom >= 0 && x_top < len && x_bottom < len)
-			{
-				// from here on, we don't have to range check x values
-
-				if ((int)x_top == (int)x_bottom)
+				int x, x1, x2;
+				float y_crossing, step, sign, area;
+				// covers 2+ pixels
+				if (x_top > x_bottom)
 				{
-					float height;
-					// simple case, only spans one pixel
-					int x = (int)x_top;
-					height = sy1 - sy0;
-					STBTT_assert(x >= 0 && x < len);
-					scanline[x] += e->direction * (1 - ((x_top - x) + (x_bottom - x)) / 2)  * height;
-					scanline_fill[x] += e->direction * height; // everything right of this pixel is filled
+					// flip scanline vertically; signed area is the same
+					float t;
+					sy0 = y_bottom - (sy0 - y_top);
+					sy1 = y_bottom - (sy1 - y_top);
+					t = sy0, sy0 = sy1, sy1 = t;
+					t = x_bottom, x_bottom = x_top, x_top = t;
+					dx = -dx;
+					dy = -dy;
+					t = x0, x0 = xb, xb = t;
 				}
-				else
-				{
-					int x, x1, x2;
-					float y_crossing, step, sign, area;
-					// covers 2+ pixels
-					if (x_top > x_bottom)
-					{
-						// flip scanline vertically; signed area is the same
-						float t;
-						sy0 = y_bottom - (sy0 - y_top);
-						sy1 = y_bottom - (sy1 - y_top);
-						t = sy0, sy0 = sy1, sy1 = t;
-						t = x_bottom, x_bottom = x_top, x_top = t;
-						dx = -dx;
-						dy = -dy;
-						t = x0, x0 = xb, xb = t;
-					}
 
-					x1 = (int)x_top;
-					x2 = (int)x_bottom;
-					// compute intersection with y axis at x1+1
-					y_crossing = (x1 + 1 - x0) * dy + y_top;
+				x1 = (int)x_top;
+				x2 = (int)x_bottom;
+				// compute intersection with y axis at x1+1
+				y_crossing = (x1 + 1 - x0) * dy + y_top;
 
-					sign = e->direction;
-					// area of the rectangle covered from y0..y_crossing
-					area = sign * (y_crossing - sy0);
-					// area of the triangle (x_top,y0), (x+1,y0), (x+1,y_crossing)
-					scanline[x1] += area * (1 - ((x_top - x1) + (x1 + 1 - x1)) / 2);
+				sign = e->direction;
+				// area of the rectangle covered from y0..y_crossing
+				area = sign * (y_crossing - sy0);
+				// area of the triangle (x_top,y0), (x+1,y0), (x+1,y_crossing)
+				scanline[x1] += area * (1 - ((x_top - x1) + (x1 + 1 - x1)) / 2);
 
-					step = sign * dy;
-					for (x = x1 + 1; x < x2; ++x)
-					{
-						scanline[x] += area + step / 2;
-						area += step;
-					}
-					y_crossing += dy * (x2 - (x1 + 1));
+				step = sign * dy;
+				for (x = x1 + 1; x < x2; ++x)
+				{
+					scanline[x] += area + step / 2;
+					area += step;
+				}
+				y_crossing += dy * (x2 - (x1 + 1));
 
-					STBTT_assert(STBTT_fabs(area) <= 1.01f);
+				STBTT_assert(STBTT_fabs(area) <= 1.01f);
 
-					scanline[x2] += area + sign * (1 - ((x2 - x2) + (x_bottom - x2)) / 2) * (sy1 - y_crossing);
+				scanline[x2] += area + sign * (1 - ((x2 - x2) + (x_bottom - x2)) / 2) * (sy1 - y_crossing);
 
-					scanline_fill[x2] += sign * (sy1 - sy0);
-				}
+				scanline_fill[x2] += sign * (sy1 - sy0);
 			}
-			else
+		}
+		else
+		{
+			// if edge goes outside of box we're drawing, we require
+			// clipping logic. since this does not match the intended use
+			// of this library, we use a different, very slow brute
+			// force implementation
+			int x;
+			for (x = 0; x < len; ++x)
 			{
-				// if edge goes outside of box we're drawing, we require
-				// clipping logic. since this does not match the intended use
-				// of this library, we use a different, very slow brute
-				// force implementation
-				int x;
-				for (x = 0; x < len; ++x)
-				{
-					// cases:
-					//
-					// there can be up to two intersections with the pixel. any intersection
-					// with left or right edges can be handled by splitting into two (or three)
-					// regions. intersections with top & bottom do not necessitate case-wise logic.
-					//
-					// the old way of doing this found the intersections with the left & right edges,
-					// then used some simple logic to produce up to three segments in sorted order
-					// from top-to-bottom. however, this had a problem: if an x edge was epsilon
-					// across the x border, then the corresponding y position might not be distinct
-					// from the other y segment, and it might ignored as an empty segment. to avoid
-					// that, we need to explicitly produce segments based on x positions.
-
-					// rename variables to clearly-defined pairs
-					float y0 = y_top;
-					float x1 = (float)(x);
-					float x2 = (float)(x + 1);
-					float x3 = xb;
-					float y3 = y_bottom;
-
-					// x = e->x + e->dx * (y-y_top)
-					// (y-y_top) = (x - e->x) / e->dx
-					// y = (x - e->x) / e->dx + y_top
-					float y1 = (x - x0) / dx + y_top;
-					float y2 = (x + 1 - x0) / dx + y_top;
-
-					if (x0 < x1 && x3 > x2)
-					{         // three segments descending down-right
-						stbtt__handle_clipped_edge(scanline, x, e, x0, y0, x1, y1);
-						stbtt__handle_clipped_edge(scanline, x, e, x1, y1, x2, y2);
-						stbtt__handle_clipped_edge(scanline, x, e, x2, y2, x3, y3);
-					}
-					else if (x3 < x1 && x0 > x2)
-					{  // three segments descending down-left
-						stbtt__handle_clipped_edge(scanline, x, e, x0, y0, x2, y2);
-						stbtt__handle_clipped_edge(scanline, x, e, x2, y2, x1, y1);
-						stbtt__handle_clipped_edge(scanline, x, e, x1, y1, x3, y3);
-					}
-					else if (x0 < x1 && x3 > x1)
-					{  // two segments across x, down-right
-						stbtt__handle_clipped_edge(scanline, x, e, x0, y0, x1, y1);
-						stbtt__handle_clipped_edge(scanline, x, e, x1, y1, x3, y3);
-					}
-					else if (x3 < x1 && x0 > x1)
-					{  // two segments across x, down-left
-						stbtt__handle_clipped_edge(scanline, x, e, x0, y0, x1, y1);
-						stbtt__handle_clipped_edge(scanline, x, e, x1, y1, x3, y3);
-					}
-					else if (x0 < x2 && x3 > x2)
-					{  // two segments across x+1, down-right
-						stbtt__handle_clipped_edge(scanline, x, e, x0, y0, x2, y2);
-						stbtt__handle_clipped_edge(scanline, x, e, x2, y2, x3, y3);
-					}
-					else if (x3 < x2 && x0 > x2)
-					{  // two segments across x+1, down-left
-						stbtt__handle_clipped_edge(scanline, x, e, x0, y0, x2, y2);
-						stbtt__handle_clipped_edge(scanline, x, e, x2, y2, x3, y3);
-					}
-					else
-					{  // one segment
-						stbtt__handle_clipped_edge(scanline, x, e, x0, y0, x3, y3);
-					}
+				// cases:
+				//
+				// there can be up to two intersections with the pixel. any intersection
+				// with left or right edges can be handled by splitting into two (or three)
+				// regions. intersections with top & bottom do not necessitate case-wise logic.
+				//
+				// the old way of doing this found the intersections with the left & right edges,
+				// then used some simple logic to produce up to three segments in sorted order
+				// from top-to-bottom. however, this had a problem: if an x edge was epsilon
+				// across the x border, then the corresponding y position might not be distinct
+				// from the other y segment, and it might ignored as an empty segment. to avoid
+				// that, we need to explicitly produce segments based on x positions.
+
+				// rename variables to clearly-defined pairs
+				float y0 = y_top;
+				float x1 = (float)(x);
+				float x2 = (float)(x + 1);
+				float x3 = xb;
+				float y3 = y_bottom;
+
+				// x = e->x + e->dx * (y-y_top)
+				// (y-y_top) = (x - e->x) / e->dx
+				// y = (x - e->x) / e->dx + y_top
+				float y1 = (x - x0) / dx + y_top;
+				float y2 = (x + 1 - x0) / dx + y_top;
+
+				if (x0 < x1 && x3 > x2)
+				{         // three segments descending down-right
+					stbtt__handle_clipped_edge(scanline, x, e, x0, y0, x1, y1);
+					stbtt__handle_clipped_edge(scanline, x, e, x1, y1, x2, y2);
+					stbtt__handle_clipped_edge(scanline, x, e, x2, y2, x3, y3);
+				}
+				else if (x3 < x1 && x0 > x2)
+				{  // three segments descending down-left
+					stbtt__handle_clipped_edge(scanline, x, e, x0, y0, x2, y2);
+					stbtt__handle_clipped_edge(scanline, x, e, x2, y2, x1, y1);
+					stbtt__handle_clipped_edge(scanline, x, e, x1, y1, x3, y3);
+				}
+				else if (x0 < x1 && x3 > x1)
+				{  // two segments across x, down-right
+					stbtt__handle_clipped_edge(scanline, x, e, x0, y0, x1, y1);
+					stbtt__handle_clipped_edge(scanline, x, e, x1, y1, x3, y3);
+				}
+				else if (x3 < x1 && x0 > x1)
+				{  // two segments across x, down-left
+					stbtt__handle_clipped_edge(scanline, x, e, x0, y0, x1, y1);
+					stbtt__handle_clipped_edge(scanline, x, e, x1, y1, x3, y3);
+				}
+				else if (x0 < x2 && x3 > x2)
+				{  // two segments across x+1, down-right
+					stbtt__handle_clipped_edge(scanline, x, e, x0, y0, x2, y2);
+					stbtt__handle_clipped_edge(scanline, x, e, x2, y2, x3, y3);
+				}
+				else if (x3 < x2 && x0 > x2)
+				{  // two segments across x+1, down-left
+					stbtt__handle_clipped_edge(scanline, x, e, x0, y0, x2, y2);
+					stbtt__handle_clipped_edge(scanline, x, e, x2, y2, x3, y3);
+				}
+				else
+				{  // one segment
+					stbtt__handle_clipped_edge(scanline, x, e, x0, y0, x3, y3);
 				}
 			}
 		}
+	}
+}
+
+static void stbtt__fill_active_edges_new(float *scanline, float *scanline_fill, int len, stbtt__active_edge *e, float y_top)
+{
+	while (e)
+	{
+		stbtt__fill_active_edge(scanline, scanline_fill, len, e, y_top);
 		e = e->next;
 	}
 }
 
+// the row a sorted edges rasterizer activates an edge on: the first row from row0 whose bottom is at or
+// below y0, row1 if there is none before it
+static int stbtt__edge_row(float y0, int off_y, int row0, int row1)
+{
+	float t = y0 - off_y - 1;
+	int r;
+	if (!(t > row0)) return row0;
+	if (t >= row1) return row1;
+	// rounding t up can be one off from the comparison the rasterizer makes
+	r = (int)t;
+	r += r < t;
+	while (r > row0 && y0 <= (float)(off_y + r - 1) + 1.0f) --r;
+	while (r < row1 && !(y0 <= (float)(off_y + r) + 1.0f)) ++r;
+	return r;
+}
+
 // directly AA rasterize edges w/o supersampling
 static void stbtt__rasterize_sorted_edges(stbtt__bitmap *result, stbtt__edge *e, int n, int vsubsample, int off_x, int off_y, void *userdata)
 {
 	stbtt__hheap hh = { 0, 0, 0 };
 	stbtt__active_edge *active = NULL;
-	int y, j = 0, i;
+	int y, j, i;
 	float scanline_data[129], *scanline, *scanline2;
+	// the whole width is accumulated even when clipped, the fill of an edge depends on it
+	int w = result->w;
 
 	STBTT__NOTUSED(vsubsample);
 
-	if (result->w > 64)
-		scanline = (float *)STBTT_malloc((result->w * 2 + 1) * sizeof(float), userdata);
+	if (w > 64)
+		scanline = (float *)STBTT_malloc((w * 2 + 1) * sizeof(float), userdata);
 	else
 		scanline = scanline_data;
 
-	scanline2 = scanline + result->w;
+	scanline2 = scanline + w;
 
-	y = off_y;
+	// start at the first clipped row, edges that end above it are skipped when inserted
+	j = result->clip_y0;
+	y = off_y + j;
 	e[n].y0 = (float)(off_y + result->h) + 1;
 
-	while (j < result->h)
+	while (j < result->clip_y1)
 	{
 		// find center of pixel for this scanline
 		float scan_y_top = y + 0.0f;
 		float scan_y_bottom = y + 1.0f;
 		stbtt__active_edge **step = &active;
 
-		STBTT_memset(scanline, 0, result->w * sizeof(scanline[0]));
-		STBTT_memset(scanline2, 0, (result->w + 1) * sizeof(scanline[0]));
+		STBTT_memset(scanline, 0, w * sizeof(scanline[0]));
+		STBTT_memset(scanline2, 0, (w + 1) * sizeof(scanline[0]));
 
 		// update all active edges;
 		// remove all active edges that terminate before the top of this scanline
@@ -3375,12 +4331,16 @@ static void stbtt__rasterize_sorted_edges(stbtt__bitmap *result, stbtt__edge *e,
 		// insert all edges that start before the bottom of this scanline
 		while (e->y0 <= scan_y_bottom)
 		{
-			if (e->y0 != e->y1)
+			if (e->y0 != e->y1 && e->y1 > scan_y_top)
 			{
-				stbtt__active_edge *z = stbtt__new_active(&hh, e, off_x, scan_y_top, userdata);
+				// an edge that starts above the clip is stepped down from its first row to round like it does unclipped
+				int row = j == result->clip_y0 ? stbtt__edge_row(e->y0, off_y, 0, j) : j;
+				stbtt__active_edge *z = stbtt__new_active(&hh, e, off_x, (float)(off_y + row), userdata);
 				if (z != NULL)
 				{
-					if (j == 0 && off_y != 0)
+					for (; row < j; ++row)
+						z->fx += z->fdx;
+					if (j == result->clip_y0 && off_y != 0)
 					{
 						if (z->ey < scan_y_top)
 						{
@@ -3399,11 +4359,14 @@ static void stbtt__rasterize_sorted_edges(stbtt__bitmap *result, stbtt__edge *e,
 
 		// now process all active edges
 		if (active)
-			stbtt__fill_active_edges_new(scanline, scanline2 + 1, result->w, active, scan_y_top);
+			stbtt__fill_active_edges_new(scanline, scanline2 + 1, w, active, scan_y_top);
 
 		{
 			float sum = 0;
-			for (i = 0; i < result->w; ++i)
+			unsigned char *row = result->pixels + (j - result->clip_y0) * result->stride;
+			for (i = 0; i < result->clip_x0; ++i)
+				sum += scanline2[i];
+			for (; i < result->clip_x1; ++i)
 			{
 				float k;
 				int m;
@@ -3412,7 +4375,7 @@ static void stbtt__rasterize_sorted_edges(stbtt__bitmap *result, stbtt__edge *e,
 				k = (float)STBTT_fabs(k) * 255 + 0.5f;
 				m = (int)k;
 				if (m > 255) m = 255;
-				result->pixels[j*result->stride + i] = (unsigned char)m;
+				row[i - result->clip_x0] = (unsigned char)m;
 			}
 		}
 		// advance all the edges
@@ -3433,10 +4396,168 @@ static void stbtt__rasterize_sorted_edges(stbtt__bitmap *result, stbtt__edge *e,
 	if (scanline != scanline_data)
 		STBTT_free(scanline, userdata);
 }
+
+// the active edges of stbtt__rasterize_sorted_edges_table, one array per field. Edges are appended when
+// they start and compacted away when they end, so the table never holds more than the n edges of the shape
+typedef struct
+{
+	float *fx, *fdx, *fdy, *direction, *sy, *ey;
+	int count;
+} stbtt__edge_table;
+
+// same as stbtt__rasterize_sorted_edges with the active edges in a stbtt__edge_table instead of a linked
+// list. The list inserts new edges at its front, so the table is filled back to front to accumulate the
+// edges in the same order and produce the same bitmap
+static void stbtt__rasterize_sorted_edges_table(stbtt__bitmap *result, stbtt__edge *e, int n, int vsubsample, int off_x, int off_y, void *userdata)
+{
+	stbtt__edge_table table;
+	int y, j, i, k;
+	float scanline_data[129], *scanline, *scanline2;
+	float table_data[6 * 32], *fields;
+	int w = result->w;
+
+	STBTT__NOTUSED(vsubsample);
+
+	if (w > 64)
+		scanline = (float *)STBTT_malloc((w * 2 + 1) * sizeof(float), userdata);
+	else
+		scanline = scanline_data;
+
+	if (n > 32)
+		fields = (float *)STBTT_malloc(6 * n * sizeof(float), userdata);
+	else
+		fields = table_data;
+
+	scanline2 = scanline + w;
+	table.fx = fields;
+	table.fdx = table.fx + n;
+	table.fdy = table.fdx + n;
+	table.direction = table.fdy + n;
+	table.sy = table.direction + n;
+	table.ey = table.sy + n;
+	table.count = 0;
+
+	j = result->clip_y0;
+	y = off_y + j;
+	e[n].y0 = (float)(off_y + result->h) + 1;
+
+	while (j < result->clip_y1)
+	{
+		float scan_y_top = y + 0.0f;
+		float scan_y_bottom = y + 1.0f;
+
+		STBTT_memset(scanline, 0, w * sizeof(scanline[0]));
+		STBTT_memset(scanline2, 0, (w + 1) * sizeof(scanline[0]));
+
+		// remove all active edges that terminate before the top of this scanline in one compacting pass
+		for (i = 0, k = 0; i < table.count; ++i)
+		{
+			if (table.ey[i] <= scan_y_top)
+				continue;
+			if (k != i)
+			{
+				table.fx[k] = table.fx[i];
+				table.fdx[k] = table.fdx[i];
+				table.fdy[k] = table.fdy[i];
+				table.direction[k] = table.direction[i];
+				table.sy[k] = table.sy[i];
+				table.ey[k] = table.ey[i];
+			}
+			++k;
+		}
+		table.count = k;
+
+		// append all edges that start before the bottom of this scanline
+		while (e->y0 <= scan_y_bottom)
+		{
+			if (e->y0 != e->y1 && e->y1 > scan_y_top)
+			{
+				float dxdy = (e->x1 - e->x0) / (e->y1 - e->y0);
+				int row = j == result->clip_y0 ? stbtt__edge_row(e->y0, off_y, 0, j) : j;
+				k = table.count++;
+				table.fdx[k] = dxdy;
+				table.fdy[k] = dxdy != 0.0f ? (1.0f / dxdy) : 0.0f;
+				table.fx[k] = e->x0 + dxdy * ((float)(off_y + row) - e->y0);
+				table.fx[k] -= off_x;
+				for (; row < j; ++row)
+					table.fx[k] += dxdy;
+				table.direction[k] = e->invert ? 1.0f : -1.0f;
+				table.sy[k] = e->y0;
+				table.ey[k] = e->y1;
+				if (j == result->clip_y0 && off_y != 0 && table.ey[k] < scan_y_top)
+					table.ey[k] = scan_y_top;
+				STBTT_assert(table.ey[k] >= scan_y_top);
+			}
+			++e;
+		}
+
+		// now process all active edges, newest first like the list
+		for (i = table.count - 1; i >= 0; --i)
+		{
+			stbtt__active_edge z;
+			z.next = NULL;
+			z.fx = table.fx[i];
+			z.fdx = table.fdx[i];
+			z.fdy = table.fdy[i];
+			z.direction = table.direction[i];
+			z.sy = table.sy[i];
+			z.ey = table.ey[i];
+			stbtt__fill_active_edge(scanline, scanline2 + 1, w, &z, scan_y_top);
+		}
+
+		{
+			float sum = 0;
+			unsigned char *row = result->pixels + (j - result->clip_y0) * result->stride;
+			for (i = 0; i < result->clip_x0; ++i)
+				sum += scanline2[i];
+			for (; i < result->clip_x1; ++i)
+			{
+				float c;
+				int m;
+				sum += scanline2[i];
+				c = scanline[i] + sum;
+				c = (float)STBTT_fabs(c) * 255 + 0.5f;
+				m = (int)c;
+				if (m > 255) m = 255;
+				row[i - result->clip_x0] = (unsigned char)m;
+			}
+		}
+
+		// advance all the edges, a loop over one array that vectorizes
+		for (i = 0; i < table.count; ++i)
+			table.fx[i] += table.fdx[i];
+
+		++y;
+		++j;
+	}
+
+	if (fields != table_data)
+		STBTT_free(fields, userdata);
+	if (scanline != scanline_data)
+		STBTT_free(scanline, userdata);
+}
 #else
 #error "Unrecognized value of STBTT_RASTERIZER_VERSION"
 #endif
 
+// the options every function but stbtt_MakeGlyphBitmapClippedOptions uses
+static stbtt_raster_options stbtt__raster_options = { STBTT_RASTERIZER_LIST, STBTT_SORT_BUCKETS, STBTT_FLATTEN_HALVING };
+
+STBTT_DEF void stbtt_SetRasterizer(int rasterizer)
+{
+	stbtt__raster_options.rasterizer = rasterizer;
+}
+
+STBTT_DEF void stbtt_SetEdgeSort(int sort)
+{
+	stbtt__raster_options.edge_sort = sort;
+}
+
+STBTT_DEF void stbtt_SetFlattening(int flattening)
+{
+	stbtt__raster_options.flattening = flattening;
+}
+
 #define STBTT__COMPARE(a,b)  ((a)->y0 < (b)->y0)
 
 static void stbtt__sort_edges_ins_sort(stbtt__edge *p, int n)
@@ -3535,12 +4656,55 @@ static void stbtt__sort_edges(stbtt__edge *p, int n)
 	stbtt__sort_edges_ins_sort(p, n);
 }
 
+#if STBTT_RASTERIZER_VERSION == 2
+// counting sort of the edges into one bucket per scanline they are activated on, rows row0..row1-1 and a
+// last one for edges below them, in time linear in the edges and rows. The rasterizers only need edges in
+// the order of the rows they start on, within a row they stay in outline order. Quicksort leaves edges with
+// the same y0 in arbitrary order too, so the bitmaps only differ if the order edges of one row are summed
+// in rounds a pixel differently, which the test fonts never do. Returns the n + 1 sorted edges and frees e
+static stbtt__edge *stbtt__sort_edges_buckets(stbtt__edge *e, int n, int off_y, int row0, int row1, void *userdata)
+{
+	int start_data[130], *start;
+	int rows = row1 - row0 + 1, i;
+	stbtt__edge *sorted = (stbtt__edge *)STBTT_malloc(sizeof(*sorted) * (n + 1), userdata);
+	if (sorted == NULL)
+	{
+		stbtt__sort_edges(e, n);
+		return e;
+	}
+
+	if (rows + 1 > 130)
+		start = (int *)STBTT_malloc((rows + 1) * sizeof(int), userdata);
+	else
+		start = start_data;
+	if (start == NULL)
+	{
+		STBTT_free(sorted, userdata);
+		stbtt__sort_edges(e, n);
+		return e;
+	}
+
+	STBTT_memset(start, 0, (rows + 1) * sizeof(int));
+	for (i = 0; i < n; ++i)
+		++start[stbtt__edge_row(e[i].y0, off_y, row0, row1) - row0 + 1];
+	for (i = 1; i <= rows; ++i)
+		start[i] += start[i - 1];
+	for (i = 0; i < n; ++i)
+		sorted[start[stbtt__edge_row(e[i].y0, off_y, row0, row1) - row0]++] = e[i];
+
+	if (start != start_data)
+		STBTT_free(start, userdata);
+	STBTT_free(e, userdata);
+	return sorted;
+}
+#endif
+
 typedef struct
 {
 	float x, y;
 } stbtt__point;
 
-static void stbtt__rasterize(stbtt__bitmap *result, stbtt__point *pts, int *wcount, int windings, float scale_x, float scale_y, float shift_x, float shift_y, int off_x, int off_y, int invert, void *userdata)
+static void stbtt__rasterize(stbtt__bitmap *result, stbtt__point *pts, int *wcount, int windings, float scale_x, float scale_y, float shift_x, float shift_y, int off_x, int off_y, int invert, void *userdata, const stbtt_raster_options *options)
 {
 	float y_scale_inv = invert ? -scale_y : scale_y;
 	stbtt__edge *e;
@@ -3558,6 +4722,7 @@ static void stbtt__rasterize(stbtt__bitmap *result, stbtt__point *pts, int *wcou
 	n = 0;
 	for (i = 0; i < windings; ++i)
 		n += wcount[i];
+	STBTT_COUNT(EDGES, n);
 
 	e = (stbtt__edge *)STBTT_malloc(sizeof(*e) * (n + 1), userdata); // add an extra one as a sentinel
 	if (e == 0) return;
@@ -3592,9 +4757,20 @@ static void stbtt__rasterize(stbtt__bitmap *result, stbtt__point *pts, int *wcou
 
 	// now sort the edges by their highest point (should snap to integer, and then by x)
 	//STBTT_sort(e, n, sizeof(e[0]), stbtt__edge_compare);
+#if STBTT_RASTERIZER_VERSION == 2
+	// rows above the clip get their own buckets too, so their edges are summed in the same order as unclipped
+	if (options->edge_sort == STBTT_SORT_BUCKETS && result->clip_y0 < result->clip_y1)
+		e = stbtt__sort_edges_buckets(e, n, off_y, 0, result->clip_y1, userdata);
+	else
+#endif
 	stbtt__sort_edges(e, n);
 
 	// now, traverse the scanlines and find the intersections on each scanline, use xor winding rule
+#if STBTT_RASTERIZER_VERSION == 2
+	if (options->rasterizer == STBTT_RASTERIZER_EDGE_TABLE)
+		stbtt__rasterize_sorted_edges_table(result, e, n, vsubsample, off_x, off_y, userdata);
+	else
+#endif
 	stbtt__rasterize_sorted_edges(result, e, n, vsubsample, off_x, off_y, userdata);
 
 	STBTT_free(e, userdata);
@@ -3677,7 +4853,7 @@ static void stbtt__tesselate_cubic(stbtt__point *points, int *num_points, float
 }
 
 // returns number of contours
-static stbtt__point *stbtt_FlattenCurves(stbtt_vertex *vertices, int num_verts, float objspace_flatness, int **contour_lengths, int *num_contours, void *userdata)
+static stbtt__point *stbtt__flatten_curves_halving(stbtt_vertex *vertices, int num_verts, float objspace_flatness, int **contour_lengths, int *num_contours, void *userdata)
 {
 	stbtt__point *points = 0;
 	int num_points = 0;
@@ -3759,18 +4935,268 @@ error:
 	return NULL;
 }
 
-STBTT_DEF void stbtt_Rasterize(stbtt__bitmap *result, float flatness_in_pixels, stbtt_vertex *vertices, int num_verts, float scale_x, float scale_y, float shift_x, float shift_y, int x_off, int y_off, int invert, void *userdata)
+// Analytic flattening works without recursion: the number of segments a curve needs for the given error is
+// computed from its control points, so the buffer is sized up front and the points emitted in one pass.
+
+#define STBTT__MAX_CURVE_SEGMENTS 65536 // as many as 16 levels of halving gave
+
+// Quadratics are flattened as in Raph Levien's "Flattening quadratic Beziers". The curve is mapped onto a
+// segment of the parabola y = x^2, where the segments needed for a given error grow with the integral of
+// the square root of the curvature. Closed form approximations of that integral and of its inverse place
+// the points so every segment has about the same error, which takes fewer segments than halving.
+static float stbtt__approx_parabola_integral(float x)
+{
+	const float d = 0.67f;
+	return x / (1 - d + (float)STBTT_sqrt(STBTT_sqrt(d * d * d * d + 0.25f * x * x)));
+}
+
+static float stbtt__approx_parabola_inv_integral(float x)
+{
+	const float b = 0.39f;
+	return x * (1 - b + (float)STBTT_sqrt(b * b + 0.25f * x * x));
+}
+
+static int stbtt__segment_count(float segments)
+{
+	if (!(segments < STBTT__MAX_CURVE_SEGMENTS)) return STBTT__MAX_CURVE_SEGMENTS; // also catches NaN
+	return segments > 1 ? (int)segments + (segments > (int)segments) : 1;
+}
+
+// Uniform steps of 1/n in t stay within |p0 - 2 * p1 + p2| / (4 * n^2) of the curve. Levien's spacing never
+// takes more segments than this, so it bounds the points a quadratic flattens to.
+static int stbtt__flatten_quad_count(float x0, float y0, float x1, float y1, float x2, float y2, float objspace_flatness)
+{
+	float ddx = x0 - 2 * x1 + x2, ddy = y0 - 2 * y1 + y2;
+	return stbtt__segment_count((float)STBTT_sqrt(STBTT_sqrt(ddx * ddx + ddy * ddy) / (4 * objspace_flatness)));
+}
+
+typedef struct
+{
+	int n;
+	float a0, da, u0, uscale; // uscale is 0 when the points are spaced uniformly in t
+} stbtt__flatten_quad;
+
+static void stbtt__flatten_quad_params(stbtt__flatten_quad *q, float x0, float y0, float x1, float y1, float x2, float y2, float objspace_flatness)
+{
+	float d01x = x1 - x0, d01y = y1 - y0;
+	float d12x = x2 - x1, d12y = y2 - y1;
+	float ddx = d01x - d12x, ddy = d01y - d12y;
+	float dd2 = ddx * ddx + ddy * ddy;
+	float cross = (x2 - x0) * ddy - (y2 - y0) * ddx;
+
+	q->n = stbtt__flatten_quad_count(x0, y0, x1, y1, x2, y2, objspace_flatness);
+	q->uscale = 0;
+
+	// nearly straight curves, and curves that fold back onto a line, keep the uniform steps
+	if (q->n > 1 && cross * cross * (1 << 20) > dd2 * (d01x * d01x + d01y * d01y + d12x * d12x + d12y * d12y))
+	{
+		float px0 = (d01x * ddx + d01y * ddy) / cross;
+		float px2 = (d12x * ddx + d12y * ddy) / cross;
+		float dd = (float)STBTT_sqrt(dd2);
+		float sqrt_scale = (float)STBTT_fabs(cross) / (dd * (float)STBTT_sqrt(dd)); // sqrt(cross^2 / |dd|^3)
+		float sqrt_tol = (float)STBTT_sqrt(objspace_flatness);
+		float a0 = stbtt__approx_parabola_integral(px0);
+		float a2 = stbtt__approx_parabola_integral(px2);
+		float val, u0, u2;
+		int n;
+
+		if ((px0 < 0) == (px2 < 0))
+			val = (float)STBTT_fabs(a2 - a0) * sqrt_scale;
+		else // the vertex of the parabola is on the curve, where the integral is approximated worst
+			val = sqrt_tol * (float)STBTT_fabs(a2 - a0) / stbtt__approx_parabola_integral(sqrt_tol / sqrt_scale);
+		n = stbtt__segment_count(0.5f * val / sqrt_tol);
+
+		u0 = stbtt__approx_parabola_inv_integral(a0);
+		u2 = stbtt__approx_parabola_inv_integral(a2);
+		if (n < q->n && u2 != u0)
+		{
+			q->n = n;
+			q->a0 = a0;
+			q->da = a2 - a0;
+			q->u0 = u0;
+			q->uscale = 1 / (u2 - u0);
+		}
+	}
+}
+
+static int stbtt__flatten_quad_emit(stbtt__point *points, int num_points, const stbtt__flatten_quad *q, float x0, float y0, float x1, float y1, float x2, float y2)
+{
+	// B(t) = p0 + t * (2 * (p1 - p0) + t * (p0 - 2 * p1 + p2))
+	float bx = 2 * (x1 - x0), by = 2 * (y1 - y0);
+	float ax = x0 - 2 * x1 + x2, ay = y0 - 2 * y1 + y2;
+	float step = 1.0f / q->n;
+	int i;
+	for (i = 1; i < q->n; ++i)
+	{
+		float t = i * step;
+		if (q->uscale != 0)
+		{
+			t = (stbtt__approx_parabola_inv_integral(q->a0 + q->da * t) - q->u0) * q->uscale;
+			t = t < 0 ? 0 : t > 1 ? 1 : t;
+		}
+		points[num_points].x = x0 + t * (bx + t * ax);
+		points[num_points].y = y0 + t * (by + t * ay);
+		++num_points;
+	}
+	points[num_points].x = x2;
+	points[num_points].y = y2;
+	return num_points + 1;
+}
+
+// Cubics take uniform steps, as many as Wang's formula bounds the error with
+static int stbtt__flatten_cubic_count(float x0, float y0, float x1, float y1, float x2, float y2, float x3, float y3, float objspace_flatness)
+{
+	float d0x = x0 - 2 * x1 + x2, d0y = y0 - 2 * y1 + y2;
+	float d1x = x1 - 2 * x2 + x3, d1y = y1 - 2 * y2 + y3;
+	float m0 = d0x * d0x + d0y * d0y, m1 = d1x * d1x + d1y * d1y;
+	return stbtt__segment_count((float)STBTT_sqrt(0.75f * (float)STBTT_sqrt(m0 > m1 ? m0 : m1) / objspace_flatness));
+}
+
+static int stbtt__flatten_cubic_emit(stbtt__point *points, int num_points, int n, float x0, float y0, float x1, float y1, float x2, float y2, float x3, float y3)
+{
+	// B(t) = p0 + t * (c + t * (b + t * a))
+	float cx = 3 * (x1 - x0), cy = 3 * (y1 - y0);
+	float bx = 3 * (x0 - 2 * x1 + x2), by = 3 * (y0 - 2 * y1 + y2);
+	float ax = x3 - x0 + 3 * (x1 - x2), ay = y3 - y0 + 3 * (y1 - y2);
+	float step = 1.0f / n;
+	int i;
+	for (i = 1; i < n; ++i)
+	{
+		float t = i * step;
+		points[num_points].x = x0 + t * (cx + t * (bx + t * ax));
+		points[num_points].y = y0 + t * (cy + t * (by + t * ay));
+		++num_points;
+	}
+	points[num_points].x = x3;
+	points[num_points].y = y3;
+	return num_points + 1;
+}
+
+static stbtt__point *stbtt__flatten_curves_analytic(stbtt_vertex *vertices, int num_verts, float objspace_flatness, int **contour_lengths, int *num_contours, void *userdata)
+{
+	stbtt__point *points = 0;
+	int num_points = 0;
+	stbtt__flatten_quad q;
+	float x = 0, y = 0;
+	int i, n = 0, start = 0, *segments;
+
+	// every vertex starts a contour or is a line or a curve, so num_verts entries hold both the contour
+	// lengths and, until they are overwritten, the number of segments of the curve at each vertex index
+	*num_contours = 0;
+	if (num_verts <= 0) return 0;
+	*contour_lengths = segments = (int *)STBTT_malloc(sizeof(**contour_lengths) * num_verts, userdata);
+	if (*contour_lengths == 0) return 0;
+
+	// count how many "moves" there are to get the contour count, and at most how many points there will be
+	for (i = 0; i < num_verts; ++i)
+	{
+		switch (vertices[i].type)
+		{
+			case STBTT_vmove:
+				++n;
+				++num_points;
+				break;
+			case STBTT_vline:
+				++num_points;
+				break;
+			case STBTT_vcurve:
+				segments[i] = stbtt__flatten_quad_count(x, y, vertices[i].cx, vertices[i].cy, vertices[i].x, vertices[i].y, objspace_flatness);
+				num_points += segments[i];
+				break;
+			case STBTT_vcubic:
+				segments[i] = stbtt__flatten_cubic_count(x, y,
+					vertices[i].cx, vertices[i].cy,
+					vertices[i].cx1, vertices[i].cy1,
+					vertices[i].x, vertices[i].y,
+					objspace_flatness);
+				num_points += segments[i];
+				break;
+		}
+		x = vertices[i].x, y = vertices[i].y;
+	}
+
+	*num_contours = n;
+	if (n == 0) goto error;
+
+	points = (stbtt__point *)STBTT_malloc(num_points * sizeof(points[0]), userdata);
+	if (points == NULL) goto error;
+
+	// place the points of curves and emit them in one pass, a contour length is only written at a later
+	// vertex than its index
+	num_points = 0;
+	n = -1;
+	x = 0, y = 0;
+	for (i = 0; i < num_verts; ++i)
+	{
+		switch (vertices[i].type)
+		{
+			case STBTT_vmove:
+				// start the next contour
+				if (n >= 0)
+					(*contour_lengths)[n] = num_points - start;
+				++n;
+				start = num_points;
+				stbtt__add_point(points, num_points++, vertices[i].x, vertices[i].y);
+				break;
+			case STBTT_vline:
+				stbtt__add_point(points, num_points++, vertices[i].x, vertices[i].y);
+				break;
+			case STBTT_vcurve:
+				stbtt__flatten_quad_params(&q, x, y, vertices[i].cx, vertices[i].cy, vertices[i].x, vertices[i].y, objspace_flatness);
+				if (q.n > segments[i]) q.n = segments[i]; // only if the bound rounded differently
+				num_points = stbtt__flatten_quad_emit(points, num_points, &q, x, y,
+					vertices[i].cx, vertices[i].cy,
+					vertices[i].x, vertices[i].y);
+				break;
+			case STBTT_vcubic:
+				num_points = stbtt__flatten_cubic_emit(points, num_points, segments[i], x, y,
+					vertices[i].cx, vertices[i].cy,
+					vertices[i].cx1, vertices[i].cy1,
+					vertices[i].x, vertices[i].y);
+				break;
+		}
+		x = vertices[i].x, y = vertices[i].y;
+	}
+	(*contour_lengths)[n] = num_points - start;
+
+	return points;
+error:
+	STBTT_free(points, userdata);
+	STBTT_free(*contour_lengths, userdata);
+	*contour_lengths = 0;
+	*num_contours = 0;
+	return NULL;
+}
+
+// returns number of contours
+static stbtt__point *stbtt_FlattenCurves(stbtt_vertex *vertices, int num_verts, float objspace_flatness, int **contour_lengths, int *num_contours, void *userdata, int flattening)
+{
+	if (flattening == STBTT_FLATTEN_ANALYTIC)
+		return stbtt__flatten_curves_analytic(vertices, num_verts, objspace_flatness, contour_lengths, num_contours, userdata);
+	return stbtt__flatten_curves_halving(vertices, num_verts, objspace_flatness, contour_lengths, num_contours, userdata);
+}
+
+static void stbtt__rasterize_options(stbtt__bitmap *result, float flatness_in_pixels, stbtt_vertex *vertices, int num_verts, float scale_x, float scale_y, float shift_x, float shift_y, int x_off, int y_off, int invert, void *userdata, const stbtt_raster_options *options)
 {
 	float scale = scale_x > scale_y ? scale_y : scale_x;
 	int winding_count = 0;
 	int *winding_lengths = NULL;
-	stbtt__point *windings = stbtt_FlattenCurves(vertices, num_verts, flatness_in_pixels / scale, &winding_lengths, &winding_count, userdata);
+	stbtt__point *windings;
+	STBTT_PROFILE_BEGIN(RASTERIZE);
+	STBTT_COUNT(GLYPHS_RASTERIZED, 1);
+	windings = stbtt_FlattenCurves(vertices, num_verts, flatness_in_pixels / scale, &winding_lengths, &winding_count, userdata, options->flattening);
 	if (windings)
 	{
-		stbtt__rasterize(result, windings, winding_lengths, winding_count, scale_x, scale_y, shift_x, shift_y, x_off, y_off, invert, userdata);
+		stbtt__rasterize(result, windings, winding_lengths, winding_count, scale_x, scale_y, shift_x, shift_y, x_off, y_off, invert, userdata, options);
 		STBTT_free(winding_lengths, userdata);
 		STBTT_free(windings, userdata);
 	}
+	STBTT_PROFILE_END(RASTERIZE);
+}
+
+STBTT_DEF void stbtt_Rasterize(stbtt__bitmap *result, float flatness_in_pixels, stbtt_vertex *vertices, int num_verts, float scale_x, float scale_y, float shift_x, float shift_y, int x_off, int y_off, int invert, void *userdata)
+{
+	stbtt__rasterize_options(result, flatness_in_pixels, vertices, num_verts, scale_x, scale_y, shift_x, shift_y, x_off, y_off, invert, userdata, &stbtt__raster_options);
 }
 
 STBTT_DEF void stbtt_FreeBitmap(unsigned char *bitmap, void *userdata)
@@ -3814,6 +5240,9 @@ STBTT_DEF unsigned char *stbtt_GetGlyphBitmapSubpixel(const stbtt_fontinfo *info
 		if (gbm.pixels)
 		{
 			gbm.stride = gbm.w;
+			gbm.clip_x0 = gbm.clip_y0 = 0;
+			gbm.clip_x1 = gbm.w;
+			gbm.clip_y1 = gbm.h;
 
 			stbtt_Rasterize(&gbm, 0.35f, vertices, num_verts, scale_x, scale_y, shift_x, shift_y, ix0, iy0, 1, info->userdata);
 		}
@@ -3839,6 +5268,9 @@ STBTT_DEF void stbtt_MakeGlyphBitmapSubpixel(const stbtt_fontinfo *info, unsigne
 	gbm.w = out_w;
 	gbm.h = out_h;
 	gbm.stride = out_stride;
+	gbm.clip_x0 = gbm.clip_y0 = 0;
+	gbm.clip_x1 = out_w;
+	gbm.clip_y1 = out_h;
 
 	if (gbm.w && gbm.h)
 		stbtt_Rasterize(&gbm, 0.35f, vertices, num_verts, scale_x, scale_y, shift_x, shift_y, ix0, iy0, 1, info->userdata);
@@ -3846,6 +5278,46 @@ STBTT_DEF void stbtt_MakeGlyphBitmapSubpixel(const stbtt_fontinfo *info, unsigne
 	STBTT_free(vertices, info->userdata);
 }
 
+STBTT_DEF void stbtt_MakeGlyphBitmapClippedOptions(const stbtt_fontinfo *info, unsigned char *output, int out_w, int out_h, int out_stride, float scale_x, float scale_y, int clip_x0, int clip_y0, int clip_x1, int clip_y1, int glyph, const stbtt_raster_options *options)
+{
+	int ix0, iy0;
+	stbtt_vertex *vertices;
+	int num_verts;
+	stbtt__bitmap gbm;
+
+	if (clip_x0 < 0) clip_x0 = 0;
+	if (clip_y0 < 0) clip_y0 = 0;
+	if (clip_x1 > out_w) clip_x1 = out_w;
+	if (clip_y1 > out_h) clip_y1 = out_h;
+	if (clip_x0 >= clip_x1 || clip_y0 >= clip_y1)
+		return;
+
+	num_verts = stbtt_GetGlyphShape(info, glyph, &vertices);
+	stbtt_GetGlyphBitmapBoxSubpixel(info, glyph, scale_x, scale_y, 0.0f, 0.0f, &ix0, &iy0, 0, 0);
+	gbm.pixels = output;
+	gbm.w = out_w;
+	gbm.h = out_h;
+	gbm.stride = out_stride;
+	gbm.clip_x0 = clip_x0;
+	gbm.clip_y0 = clip_y0;
+	gbm.clip_x1 = clip_x1;
+	gbm.clip_y1 = clip_y1;
+
+	stbtt__rasterize_options(&gbm, 0.35f, vertices, num_verts, scale_x, scale_y, 0.0f, 0.0f, ix0, iy0, 1, info->userdata, options);
+
+	STBTT_free(vertices, info->userdata);
+}
+
+STBTT_DEF void stbtt_MakeGlyphBitmapClipped(const stbtt_fontinfo *info, unsigned char *output, int out_w, int out_h, int out_stride, float scale_x, float scale_y, int clip_x0, int clip_y0, int clip_x1, int clip_y1, int glyph)
+{
+	stbtt_MakeGlyphBitmapClippedOptions(info, output, out_w, out_h, out_stride, scale_x, scale_y, clip_x0, clip_y0, clip_x1, clip_y1, glyph, &stbtt__raster_options);
+}
+
+STBTT_DEF void stbtt_MakeCodepointBitmapClipped(const stbtt_fontinfo *info, unsigned char *output, int out_w, int out_h, int out_stride, float scale_x, float scale_y, int clip_x0, int clip_y0, int clip_x1, int clip_y1, int codepoint)
+{
+	stbtt_MakeGlyphBitmapClipped(info, output, out_w, out_h, out_stride, scale_x, scale_y, clip_x0, clip_y0, clip_x1, clip_y1, stbtt_FindGlyphIndex(info, codepoint));
+}
+
 STBTT_DEF void stbtt_MakeGlyphBitmap(const stbtt_fontinfo *info, unsigned char *output, int out_w, int out_h, int out_stride, float scale_x, float scale_y, int glyph)
 {
 	stbtt_MakeGlyphBitmapSubpixel(info, output, out_w, out_h, out_stride, scale_x, scale_y, 0.0f, 0.0f, glyph);
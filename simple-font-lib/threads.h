@@ -0,0 +1,243 @@
+#ifndef THREADS_H
+#define THREADS_H
+
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <Windows.h>
+typedef HANDLE thread_t;
+typedef LPTHREAD_START_ROUTINE threadfunc_t;
+typedef CRITICAL_SECTION mutex_t;
+typedef CONDITION_VARIABLE condition_t;
+typedef INIT_ONCE once_t;
+#define ONCE_INIT INIT_ONCE_STATIC_INIT
+#else
+#include <pthread.h>
+#include <unistd.h>
+#include <time.h>
+typedef pthread_t thread_t;
+typedef void*(*threadfunc_t)(void* argument);
+typedef pthread_mutex_t mutex_t;
+typedef pthread_cond_t condition_t;
+typedef pthread_once_t once_t;
+#define ONCE_INIT PTHREAD_ONCE_INIT
+#endif
+
+#define MAX_THREADS 16
+
+typedef void(*parallelfunc_t)(void* context, int index);
+
+typedef struct
+{
+	parallelfunc_t func;
+	void* context;
+	int count;
+	volatile long next;
+} parallelfor_t;
+
+int GetNumCores()
+{
+#ifdef _WIN32
+	SYSTEM_INFO sysInfo;
+	GetSystemInfo(&sysInfo);
+	int cores = (int)sysInfo.dwNumberOfProcessors;
+#else
+	int cores = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	if (cores < 1)
+		return 1;
+	return cores < MAX_THREADS ? cores : MAX_THREADS;
+}
+
+//Returns the value before incrementing
+long AtomicIncrement(volatile long* value)
+{
+#ifdef _WIN32
+	return InterlockedIncrement(value) - 1;
+#else
+	return __sync_fetch_and_add(value, 1);
+#endif
+}
+
+//Monotonic time for timeouts
+long long GetNanoseconds()
+{
+#ifdef _WIN32
+	LARGE_INTEGER counter, frequency;
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+	return (long long)((double)counter.QuadPart * 1e9 / frequency.QuadPart);
+#else
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (long long)now.tv_sec * 1000000000 + now.tv_nsec;
+#endif
+}
+
+//Returns 0 if the thread couldn't be started
+int StartThread(thread_t* thread, threadfunc_t func, void* argument)
+{
+#ifdef _WIN32
+	*thread = CreateThread(NULL, 0, func, argument, 0, NULL);
+	return *thread != NULL;
+#else
+	return pthread_create(thread, NULL, func, argument) == 0;
+#endif
+}
+
+//Waits for the thread to return and releases it
+void JoinThread(thread_t thread)
+{
+#ifdef _WIN32
+	WaitForSingleObject(thread, INFINITE);
+	CloseHandle(thread);
+#else
+	pthread_join(thread, NULL);
+#endif
+}
+
+//Mutexes are recursive, a thread holding one can lock it again and unlocks it as many times
+void InitMutex(mutex_t* mutex)
+{
+#ifdef _WIN32
+	InitializeCriticalSection(mutex);
+#else
+	pthread_mutexattr_t attributes;
+	pthread_mutexattr_init(&attributes);
+	pthread_mutexattr_settype(&attributes, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(mutex, &attributes);
+	pthread_mutexattr_destroy(&attributes);
+#endif
+}
+
+void LockMutex(mutex_t* mutex)
+{
+#ifdef _WIN32
+	EnterCriticalSection(mutex);
+#else
+	pthread_mutex_lock(mutex);
+#endif
+}
+
+void UnlockMutex(mutex_t* mutex)
+{
+#ifdef _WIN32
+	LeaveCriticalSection(mutex);
+#else
+	pthread_mutex_unlock(mutex);
+#endif
+}
+
+void InitCondition(condition_t* condition)
+{
+#ifdef _WIN32
+	InitializeConditionVariable(condition);
+#else
+	pthread_cond_init(condition, NULL);
+#endif
+}
+
+//Unlocks the mutex until the condition is woken, it must be locked exactly once. Wakeups can be spurious so the caller
+//checks what it waits for in a loop
+void WaitCondition(condition_t* condition, mutex_t* mutex)
+{
+#ifdef _WIN32
+	SleepConditionVariableCS(condition, mutex, INFINITE);
+#else
+	pthread_cond_wait(condition, mutex);
+#endif
+}
+
+//Same as WaitCondition, returning after at most milliseconds
+void WaitConditionFor(condition_t* condition, mutex_t* mutex, int milliseconds)
+{
+#ifdef _WIN32
+	SleepConditionVariableCS(condition, mutex, (DWORD)milliseconds);
+#else
+	struct timespec until;
+	clock_gettime(CLOCK_REALTIME, &until);
+	until.tv_sec += milliseconds / 1000;
+	until.tv_nsec += (long)(milliseconds % 1000) * 1000000;
+	if (until.tv_nsec >= 1000000000)
+	{
+		until.tv_sec++;
+		until.tv_nsec -= 1000000000;
+	}
+	pthread_cond_timedwait(condition, mutex, &until);
+#endif
+}
+
+void WakeAllWaiting(condition_t* condition)
+{
+#ifdef _WIN32
+	WakeAllConditionVariable(condition);
+#else
+	pthread_cond_broadcast(condition);
+#endif
+}
+
+#ifdef _WIN32
+BOOL CALLBACK RunOnceCallback(PINIT_ONCE once, void* func, void** context)
+{
+	((void(*)())func)();
+	return TRUE;
+}
+#endif
+
+//Calls func the first time any thread gets here with once, the others wait for it to return
+void RunOnce(once_t* once, void(*func)())
+{
+#ifdef _WIN32
+	InitOnceExecuteOnce(once, RunOnceCallback, (void*)func, NULL);
+#else
+	pthread_once(once, func);
+#endif
+}
+
+//Keep taking indices until all of them have been processed
+void ParallelForWorker(parallelfor_t* job)
+{
+	long index;
+	while ((index = AtomicIncrement(&job->next)) < job->count)
+		job->func(job->context, (int)index);
+}
+
+#ifdef _WIN32
+DWORD WINAPI ParallelForThread(LPVOID job)
+{
+	ParallelForWorker(job);
+	return 0;
+}
+#else
+void* ParallelForThread(void* job)
+{
+	ParallelForWorker(job);
+	return NULL;
+}
+#endif
+
+//Calls func(context, i) for every i in [0, count) using all cores, returns when every call has finished
+//Small jobs (count < minPerThread * 2) are run on the calling thread
+void ParallelFor(int count, parallelfunc_t func, void* context, int minPerThread)
+{
+	parallelfor_t job = { func, context, count, 0 };
+	thread_t threads[MAX_THREADS];
+
+	int numThreads = GetNumCores();
+	if (minPerThread < 1)
+		minPerThread = 1;
+	if (numThreads > count / minPerThread)
+		numThreads = count / minPerThread;
+
+	//The calling thread works too
+	int started = 0;
+	for (int i = 1; i < numThreads; i++)
+		started += StartThread(&threads[started], ParallelForThread, &job);
+
+	ParallelForWorker(&job);
+
+	for (int i = 0; i < started; i++)
+		JoinThread(threads[i]);
+}
+
+#endif
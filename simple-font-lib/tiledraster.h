@@ -0,0 +1,309 @@
+#ifndef TILEDRASTER_H
+#define TILEDRASTER_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TILEDRASTER_SSE2
+#include <emmintrin.h>
+#endif
+
+//Coverage rasterizer for large glyphs in the style of font-rs. Every line segment of the flattened outline adds the
+//exact area it covers to an accumulation buffer, and a prefix sum along each row turns the buffer into coverage, so the
+//cost grows with the length of the outline instead of scanlines times active edges. The glyph is rasterized in bands of
+//TILE_SIZE rows whose buffer stays in cache. Tiles of TILE_SIZE by TILE_SIZE pixels that no segment touches are solid or
+//empty and are filled with the winding to their left without summing them, which covers most of a large glyph.
+
+#define TILE_SIZE 16
+
+typedef struct
+{
+	float x0, y0, x1, y1;
+} tilesegment_t;
+
+typedef struct
+{
+	//Segments in pixels relative to the glyph box, ordered by the band they start in
+	tilesegment_t* segments;
+	tilesegment_t* sorted;
+	size_t allocSegments;
+	int* bandStart;
+	size_t allocBands;
+	int* active;
+
+	//TILE_SIZE rows of tilesX * TILE_SIZE floats, tiles are cleared again as they are summed
+	float* accumulation;
+	unsigned char* touched;
+	unsigned char* row;
+	size_t allocTiles;
+} tiledrasterizer_t;
+
+//Buffers reused by every glyph
+tiledrasterizer_t tiledRasterizer;
+
+//Adds the area of a segment within the rows of the band, as in font-rs. Coverage flows to the right, so a segment
+//crossing a pixel adds the part of it that is right of the segment there and the rest to the next pixel
+void AccumulateSegment(tiledrasterizer_t* r, const tilesegment_t* s, int bandTop, int bandRows, int lineLength, int width)
+{
+	float x0 = s->x0, y0 = s->y0, x1 = s->x1, y1 = s->y1, direction = 1.0f;
+	if (y0 > y1)
+	{
+		float t = x0; x0 = x1; x1 = t;
+		t = y0; y0 = y1; y1 = t;
+		direction = -1.0f;
+	}
+
+	float top = max(y0, (float)bandTop), bottom = min(y1, (float)(bandTop + bandRows));
+	if (top >= bottom)
+		return;
+
+	float dxdy = (x1 - x0) / (y1 - y0);
+	float x = x0 + (top - y0) * dxdy;
+	for (int y = (int)top; y < bottom; y++)
+	{
+		float dy = min((float)(y + 1), bottom) - max((float)y, top);
+		float xNext = x + dxdy * dy;
+		float d = dy * direction;
+		float left = min(max(min(x, xNext), 0.0f), (float)width);
+		float right = min(max(max(x, xNext), 0.0f), (float)width);
+		float* line = r->accumulation + (size_t)(y - bandTop) * lineLength;
+
+		float leftFloor = floorf(left);
+		int leftIndex = (int)leftFloor, rightIndex = (int)ceilf(right);
+		if (rightIndex <= leftIndex + 1)
+		{
+			//Within one pixel, the area right of the segment is one minus its mean position
+			float mean = 0.5f * (left + right) - leftFloor;
+			line[leftIndex] += d - d * mean;
+			line[leftIndex + 1] += d * mean;
+			rightIndex = leftIndex + 1;
+		}
+		else
+		{
+			//Triangles in the first and last pixel, equal steps in between
+			float inverse = 1.0f / (right - left);
+			float leftFraction = left - leftFloor;
+			float firstArea = 0.5f * inverse * (1.0f - leftFraction) * (1.0f - leftFraction);
+			float rightFraction = right - (float)rightIndex + 1.0f;
+			float lastArea = 0.5f * inverse * rightFraction * rightFraction;
+			line[leftIndex] += d * firstArea;
+			if (rightIndex == leftIndex + 2)
+			{
+				line[leftIndex + 1] += d * (1.0f - firstArea - lastArea);
+			}
+			else
+			{
+				float secondArea = inverse * (1.5f - leftFraction);
+				line[leftIndex + 1] += d * (secondArea - firstArea);
+				for (int i = leftIndex + 2; i < rightIndex - 1; i++)
+					line[i] += d * inverse;
+				float beforeLast = secondArea + (rightIndex - leftIndex - 3) * inverse;
+				line[rightIndex - 1] += d * (1.0f - beforeLast - lastArea);
+			}
+			line[rightIndex] += d * lastArea;
+		}
+
+		for (int tile = leftIndex / TILE_SIZE; tile <= rightIndex / TILE_SIZE; tile++)
+			r->touched[tile] = 1;
+		x = xNext;
+	}
+}
+
+unsigned char CoverageToAlpha(float sum)
+{
+	return (unsigned char)(int)(min(fabsf(sum), 1.0f) * 255.0f + 0.5f);
+}
+
+//Prefix sums one row of the band into alphas, clearing the accumulation behind it. Untouched tiles hold zeros and keep
+//the running sum, so they are filled without summing
+void ResolveTiledRow(tiledrasterizer_t* r, float* line, int tilesX, unsigned char* alphas)
+{
+#ifdef TILEDRASTER_SSE2
+	const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF)), one = _mm_set1_ps(1.0f);
+	const __m128 scale = _mm_set1_ps(255.0f), half = _mm_set1_ps(0.5f), zero = _mm_setzero_ps();
+	__m128 carry = zero;
+	for (int tile = 0; tile < tilesX; tile++)
+	{
+		float* values = line + tile * TILE_SIZE;
+		unsigned char* output = alphas + tile * TILE_SIZE;
+		if (!r->touched[tile])
+		{
+			memset(output, CoverageToAlpha(_mm_cvtss_f32(carry)), TILE_SIZE);
+			continue;
+		}
+
+		__m128i quarters[4];
+		for (int k = 0; k < 4; k++)
+		{
+			//Prefix sum of four lanes in two shifted adds, then the sum of everything to the left
+			__m128 v = _mm_loadu_ps(values + 4 * k);
+			v = _mm_add_ps(v, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v), 4)));
+			v = _mm_add_ps(v, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v), 8)));
+			v = _mm_add_ps(v, carry);
+			carry = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3));
+			v = _mm_min_ps(_mm_and_ps(v, absMask), one);
+			quarters[k] = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, scale), half));
+			_mm_storeu_ps(values + 4 * k, zero);
+		}
+		__m128i packed = _mm_packus_epi16(_mm_packs_epi32(quarters[0], quarters[1]), _mm_packs_epi32(quarters[2], quarters[3]));
+		_mm_storeu_si128((__m128i*)output, packed);
+	}
+#else
+	float sum = 0.0f;
+	for (int tile = 0; tile < tilesX; tile++)
+	{
+		float* values = line + tile * TILE_SIZE;
+		unsigned char* output = alphas + tile * TILE_SIZE;
+		if (!r->touched[tile])
+		{
+			memset(output, CoverageToAlpha(sum), TILE_SIZE);
+			continue;
+		}
+
+		for (int i = 0; i < TILE_SIZE; i++)
+		{
+			sum += values[i];
+			values[i] = 0.0f;
+			output[i] = CoverageToAlpha(sum);
+		}
+	}
+#endif
+}
+
+//Same as stbtt_MakeGlyphBitmapClipped: output points at pixel (clipX0, clipY0) of a width by height glyph box and only
+//the clipped pixels are written. flattening is the STBTT_FLATTEN_* value curves are flattened with
+void RasterizeTiled(tiledrasterizer_t* r, const stbtt_fontinfo* info, unsigned char* output, int width, int height, int stride, float scale,
+	int clipX0, int clipY0, int clipX1, int clipY1, int glyph, int flattening)
+{
+	clipX0 = max(clipX0, 0), clipY0 = max(clipY0, 0);
+	clipX1 = min(clipX1, width), clipY1 = min(clipY1, height);
+	if (clipX0 >= clipX1 || clipY0 >= clipY1)
+		return;
+
+	STATS_BEGIN(STAT_RASTERIZE);
+	STATS_COUNT(STAT_GLYPHS_RASTERIZED, 1);
+	stbtt_vertex* vertices;
+	int numVertices = stbtt_GetGlyphShape(info, glyph, &vertices);
+	int numContours = 0;
+	int* contourLengths = NULL;
+	stbtt__point* points = numVertices > 0 ? stbtt_FlattenCurves(vertices, numVertices, 0.35f / scale, &contourLengths, &numContours, info->userdata, flattening) : NULL;
+	STBTT_free(vertices, info->userdata);
+	if (points == NULL)
+	{
+		STATS_END(STAT_RASTERIZE);
+		return;
+	}
+
+	int numPoints = 0;
+	for (int i = 0; i < numContours; i++)
+		numPoints += contourLengths[i];
+
+	//Segments on the right edge of the box write up to two columns past it
+	int bands = (height + TILE_SIZE - 1) / TILE_SIZE, tilesX = (width + 1 + TILE_SIZE) / TILE_SIZE;
+	int lineLength = tilesX * TILE_SIZE;
+	if ((size_t)numPoints > r->allocSegments)
+	{
+		r->allocSegments = max((size_t)numPoints, r->allocSegments * 2);
+		r->segments = realloc(r->segments, sizeof(tilesegment_t) * r->allocSegments);
+		r->sorted = realloc(r->sorted, sizeof(tilesegment_t) * r->allocSegments);
+		r->active = realloc(r->active, sizeof(int) * r->allocSegments);
+	}
+	if ((size_t)bands + 1 > r->allocBands)
+	{
+		r->allocBands = max((size_t)bands + 1, r->allocBands * 2);
+		r->bandStart = realloc(r->bandStart, sizeof(int) * r->allocBands);
+	}
+	if ((size_t)tilesX > r->allocTiles)
+	{
+		r->allocTiles = max((size_t)tilesX, r->allocTiles * 2);
+		free(r->accumulation);
+		r->accumulation = calloc(r->allocTiles * TILE_SIZE * TILE_SIZE, sizeof(float));
+		r->touched = realloc(r->touched, r->allocTiles);
+		r->row = realloc(r->row, r->allocTiles * TILE_SIZE);
+	}
+
+	//Segments in the glyph box like stbtt_Rasterize, horizontal ones and those outside the box add nothing
+	int ix0, iy0, numSegments = 0;
+	stbtt_GetGlyphBitmapBoxSubpixel(info, glyph, scale, scale, 0.0f, 0.0f, &ix0, &iy0, NULL, NULL);
+	memset(r->bandStart, 0, sizeof(int) * (bands + 1));
+	stbtt__point* contour = points;
+	for (int i = 0; i < numContours; i++)
+	{
+		for (int j = 0, k = contourLengths[i] - 1; j < contourLengths[i]; k = j++)
+		{
+			tilesegment_t* s = r->segments + numSegments;
+			s->x0 = contour[k].x * scale - ix0, s->y0 = -contour[k].y * scale - iy0;
+			s->x1 = contour[j].x * scale - ix0, s->y1 = -contour[j].y * scale - iy0;
+			if (s->y0 == s->y1 || max(s->y0, s->y1) <= 0.0f || min(s->y0, s->y1) >= (float)height)
+				continue;
+			r->bandStart[min(max((int)min(s->y0, s->y1), 0) / TILE_SIZE, bands - 1) + 1]++;
+			numSegments++;
+		}
+		contour += contourLengths[i];
+	}
+	STBTT_free(contourLengths, info->userdata);
+	STBTT_free(points, info->userdata);
+	STATS_COUNT(STAT_EDGES, numSegments);
+
+	//Counting sort by starting band
+	for (int band = 0; band < bands; band++)
+		r->bandStart[band + 1] += r->bandStart[band];
+	for (int i = 0; i < numSegments; i++)
+	{
+		tilesegment_t* s = r->segments + i;
+		r->sorted[r->bandStart[min(max((int)min(s->y0, s->y1), 0) / TILE_SIZE, bands - 1)]++] = *s;
+	}
+	for (int band = bands; band > 0; band--)
+		r->bandStart[band] = r->bandStart[band - 1];
+	r->bandStart[0] = 0;
+
+	//Bands above the clip still carry their segments into the active list
+	int numActive = 0;
+	for (int band = 0; band <= (clipY1 - 1) / TILE_SIZE; band++)
+	{
+		int bandTop = band * TILE_SIZE, bandRows = min(TILE_SIZE, height - bandTop);
+		for (int i = r->bandStart[band]; i < r->bandStart[band + 1]; i++)
+			r->active[numActive++] = i;
+		if (bandTop + bandRows > clipY0)
+		{
+			memset(r->touched, 0, tilesX);
+			for (int i = 0; i < numActive; i++)
+				AccumulateSegment(r, r->sorted + r->active[i], bandTop, bandRows, lineLength, width);
+
+			//Rows outside the clip are summed too, that clears them for the next band
+			for (int y = bandTop; y < bandTop + bandRows; y++)
+			{
+				ResolveTiledRow(r, r->accumulation + (size_t)(y - bandTop) * lineLength, tilesX, r->row);
+				if (y >= clipY0 && y < clipY1)
+					memcpy(output + (size_t)(y - clipY0) * stride, r->row + clipX0, clipX1 - clipX0);
+			}
+		}
+
+		//Segments that end within the band are done
+		int kept = 0;
+		for (int i = 0; i < numActive; i++)
+		{
+			const tilesegment_t* s = r->sorted + r->active[i];
+			if (max(s->y0, s->y1) > (float)(bandTop + bandRows))
+				r->active[kept++] = r->active[i];
+		}
+		numActive = kept;
+	}
+	STATS_END(STAT_RASTERIZE);
+}
+
+void FreeTiledRasterizer(tiledrasterizer_t* r)
+{
+	free(r->segments);
+	free(r->sorted);
+	free(r->bandStart);
+	free(r->active);
+	free(r->accumulation);
+	free(r->touched);
+	free(r->row);
+	memset(r, 0, sizeof(tiledrasterizer_t));
+}
+
+#endif
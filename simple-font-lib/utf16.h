@@ -0,0 +1,154 @@
+#ifndef UTF16_H
+#define UTF16_H
+
+#include <string.h>
+#include <stdint.h>
+#include "platform.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define UTF16_SSE2
+#include <emmintrin.h>
+#endif
+
+#define REPLACEMENT_CHARACTER 0xFFFD
+
+//Decode the codepoint at text[*i] and move *i past it, unpaired surrogates become the replacement character
+int NextCodepoint(const utf16_t* text, size_t length, size_t* i)
+{
+	unsigned int c = text[(*i)++];
+	if ((c & 0xF800) != 0xD800)
+		return (int)c;
+	if (c < 0xDC00 && *i < length && (text[*i] & 0xFC00) == 0xDC00)
+		return 0x10000 + (int)((c - 0xD800) << 10) + (text[(*i)++] - 0xDC00);
+	return REPLACEMENT_CHARACTER;
+}
+
+//The codepoint at text[i] without moving past it, 0 at the end of the text
+int PeekCodepoint(const utf16_t* text, size_t length, size_t i)
+{
+	return i < length ? NextCodepoint(text, length, &i) : 0;
+}
+
+//Code units that are a codepoint of their own and not a control character
+int IsSimpleUnit(unsigned int c)
+{
+	return c >= 0x20 && (c & 0xF800) != 0xD800;
+}
+
+//Any 16-bit lane of x is zero
+int HasZeroLane(uint64_t x)
+{
+	return ((x - 0x0001000100010001ULL) & ~x & 0x8000800080008000ULL) != 0;
+}
+
+//End of the run of simple code units that starts at start. Most text is one long run, so it is checked 8 units at a
+//time (4 without SSE2) and the block that ends the run is finished one unit at a time
+size_t FindSimpleRun(const utf16_t* text, size_t start, size_t length)
+{
+	size_t i = start;
+#ifdef UTF16_SSE2
+	const __m128i surrogateBits = _mm_set1_epi16((short)0xF800), surrogate = _mm_set1_epi16((short)0xD800);
+	const __m128i controlBits = _mm_set1_epi16((short)0xFFE0), zero = _mm_setzero_si128();
+	for (; i + 8 <= length; i += 8)
+	{
+		__m128i units = _mm_loadu_si128((const __m128i*)(text + i));
+		__m128i surrogates = _mm_cmpeq_epi16(_mm_and_si128(units, surrogateBits), surrogate);
+		__m128i controls = _mm_cmpeq_epi16(_mm_and_si128(units, controlBits), zero);
+		if (_mm_movemask_epi8(_mm_or_si128(surrogates, controls)) != 0)
+			break;
+	}
+#else
+	for (; i + 4 <= length; i += 4)
+	{
+		uint64_t units;
+		memcpy(&units, text + i, sizeof(uint64_t));
+		if (HasZeroLane(units & 0xFFE0FFE0FFE0FFE0ULL) || HasZeroLane((units & 0xF800F800F800F800ULL) ^ 0xD800D800D800D800ULL))
+			break;
+	}
+#endif
+
+	while (i < length && IsSimpleUnit(text[i]))
+		i++;
+	return i;
+}
+
+//Decode length bytes of UTF-8 into output, which needs room for length code units. Invalid and truncated sequences
+//become the replacement character. ASCII is widened 16 bytes at a time with SSE2 (8 without), returns the units written
+size_t DecodeUtf8(const unsigned char* text, size_t length, utf16_t* output)
+{
+	size_t i = 0, count = 0;
+	while (i < length)
+	{
+#ifdef UTF16_SSE2
+		const __m128i zero = _mm_setzero_si128();
+		for (; i + 16 <= length; i += 16, count += 16)
+		{
+			__m128i bytes = _mm_loadu_si128((const __m128i*)(text + i));
+			if (_mm_movemask_epi8(bytes) != 0)
+				break;
+			_mm_storeu_si128((__m128i*)(output + count), _mm_unpacklo_epi8(bytes, zero));
+			_mm_storeu_si128((__m128i*)(output + count + 8), _mm_unpackhi_epi8(bytes, zero));
+		}
+#else
+		for (; i + 8 <= length; i += 8, count += 8)
+		{
+			uint64_t bytes;
+			memcpy(&bytes, text + i, sizeof(uint64_t));
+			if (bytes & 0x8080808080808080ULL)
+				break;
+			for (int k = 0; k < 8; k++)
+				output[count + k] = text[i + k];
+		}
+#endif
+
+		while (i < length && text[i] < 0x80)
+			output[count++] = text[i++];
+		if (i == length)
+			break;
+
+		//Lead bytes limit the first continuation byte so overlong forms, surrogates and values past U+10FFFF are rejected
+		unsigned int c = text[i++];
+		if (c < 0xC2 || c > 0xF4)
+		{
+			output[count++] = REPLACEMENT_CHARACTER;
+			continue;
+		}
+
+		int extra = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : 1, k = 0;
+		unsigned int lower = c == 0xE0 ? 0xA0 : c == 0xF0 ? 0x90 : 0x80;
+		unsigned int upper = c == 0xED ? 0x9F : c == 0xF4 ? 0x8F : 0xBF;
+		c &= 0x3F >> extra;
+		for (; k < extra && i < length && text[i] >= lower && text[i] <= upper; k++)
+		{
+			c = c << 6 | (text[i++] & 0x3F);
+			lower = 0x80;
+			upper = 0xBF;
+		}
+
+		if (k < extra)
+		{
+			output[count++] = REPLACEMENT_CHARACTER;
+		}
+		else if (c >= 0x10000)
+		{
+			output[count++] = (utf16_t)(0xD800 + ((c - 0x10000) >> 10));
+			output[count++] = (utf16_t)(0xDC00 + ((c - 0x10000) & 0x3FF));
+		}
+		else
+		{
+			output[count++] = (utf16_t)c;
+		}
+	}
+	return count;
+}
+
+//Returns a null terminated UTF-16 copy of a null terminated UTF-8 string that has to be freed, decoded like DecodeUtf8
+utf16_t* Utf8ToUtf16(const char* string)
+{
+	size_t length = strlen(string);
+	utf16_t* result = malloc(sizeof(utf16_t) * (length + 1));
+	result[DecodeUtf8((const unsigned char*)string, length, result)] = 0;
+	return result;
+}
+
+#endif
@@ -2,6 +2,7 @@
 #define WCSUTIL_H
 
 #include <string.h>
+#include <wchar.h>
 
 // Implementation of wcstok that matches the delimiter string as a whole
 // instead of any character within the delimiter string
@@ -0,0 +1,499 @@
+//Golden image regression test of simple-font-lib
+//
+//Renders a fixed matrix of cases through MeasureBitmap and GenerateBitmap and compares them with the bitmaps stored in
+//tests/golden. Every case is also timed so optimizations can show both that the output is unchanged and what they gained
+//
+//Usage: sfl-golden --fonts dir --golden dir [--update] [--tolerance n] [--max-pixels n] [--repeat n] [--filter text]
+//                  [--output dir] [--timings file] [--rasterizer list|table|tiled] [--edge-sort quicksort|buckets]
+//                  [--flattening halving|analytic] [--queued]
+//--tolerance is the largest difference of a pixel that is ignored, --max-pixels the number of pixels allowed to differ more
+//--rasterizer picks the rasterizer, list and table match the goldens exactly and tiled differs by rounding
+//--edge-sort picks how edges are sorted for list and table, both match the goldens exactly
+//--flattening picks how curves are flattened, the goldens are drawn halving them and analytic differs along curves
+//--queued renders every case on a render worker through QueueRender, WaitRender and TakeRender instead
+//--update rewrites the goldens from the current output, review the changed images before committing them
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "../simple-font-lib/platform.h"
+#include "../simple-font-lib/utf16.h"
+
+//Exports of the shared library
+int LoadFontUtf8(const char* filename, int index, char** actualName);
+void FreeAllResources();
+void SetRenderMode(int mode, int spread);
+void SetWrapMode(int mode);
+void SetRasterizer(int rasterizer);
+void SetEdgeSort(int sort);
+void SetFlattening(int flattening);
+int SetFallbackFonts(int handle, const int* handles, int count);
+void MeasureBitmap(int handle, utf16_t* text, int fontSize, int* width, int* height, int* yOffset, int maxWidth, float lineSpacing);
+void MeasureBitmapUtf8(int handle, const char* text, int length, int fontSize, int* width, int* height, int* yOffset, int maxWidth, float lineSpacing);
+void GenerateBitmap(int handle, unsigned char* emptyBitmap, int width);
+int QueueRender(int handle, const utf16_t* text, int length, int fontSize, int maxWidth, float lineSpacing, int spread);
+int GetRenderStatus(int job, int* width, int* height, int* yOffset);
+int WaitRender(int job);
+int TakeRender(int job, unsigned char* destination);
+
+//------------------------------------- CASES -------------------------------------
+//Changing anything here needs the goldens to be regenerated with --update
+typedef struct
+{
+	const char* name;
+	const char* text;
+	int fallback; //Characters the font doesn't have come from the other test font
+} testtext_t;
+
+typedef struct
+{
+	int maxWidth;
+	float lineSpacing;
+	int optimal;
+} testwrap_t;
+
+static const char* const testFonts[] = { "Lato-Regular.ttf", "SourceCodePro-Regular.ttf" };
+static const int testSizes[] = { 12, 20, 32 };
+
+static const testtext_t testTexts[] =
+{
+	{ "label", "Settings (3/4)", 0 },
+	{ "kerning", "AVATAR Tolls, WAVY Ty. LT fi", 0 },
+	{ "latin", "Voix ambigu\xC3\xAB d'un c\xC5\x93ur \xE2\x80\x94 \xC3\x86r\xC3\xB8sk\xC3\xB8" "bing \xC2\xBD \xC2\xA9", 0 },
+	{ "lines", "First line\nSecond, longer line\n\nAfter an empty line\r\nCRLF", 0 },
+	{ "paragraph", "The quick brown fox jumps over the lazy dog. Sphinx of black quartz, judge my vow!", 0 },
+	{ "surrogates", "Smile \xF0\x9F\x99\x82 V\xF0\x9D\x90\x80" "A \xF0\x9F\x91\x8D\xF0\x9F\x91\x8D", 0 },
+	{ "breaks", "A well-known e-mail: https://example.com/a?b=1 costs $3.14\xC2\xA0(40%)\vNon\xE2\x80\x8B" "breaking", 0 },
+	{ "fallback", "\xC4\xA6\xC4\x95\xC5\x80\xC5\x80\xC5\x91 \xE1\xBA\x80orld a\xCC\x88 \xE2\x88\x9E \xE2\x89\xA0 \xCF\x80 \xE2\x80\xA6 \xE2\x80\xB0", 1 },
+};
+
+static const testwrap_t testWraps[] =
+{
+	{ 0, 1.0f, 0 },
+	{ 160, 1.5f, 0 },
+	{ 160, 1.5f, 1 },
+};
+
+//Distance fields are checked with a subset
+static const int sdfSizes[] = { 24 };
+static const int sdfSpread = 4;
+
+typedef struct
+{
+	const char* font;
+	int size;
+	const testtext_t* text;
+	testwrap_t wrap;
+	int sdf;
+	int utf8;
+	char name[128];
+} testcase_t;
+
+#define COUNT(array) (int)(sizeof(array) / sizeof(array[0]))
+
+static int BuildCases(testcase_t* cases)
+{
+	int count = 0;
+	for (int sdf = 0; sdf < 2; sdf++)
+	{
+		for (int f = 0; f < COUNT(testFonts); f++)
+		{
+			for (int s = 0; s < (sdf ? COUNT(sdfSizes) : COUNT(testSizes)); s++)
+			{
+				for (int t = 0; t < COUNT(testTexts); t++)
+				{
+					for (int w = 0; w < COUNT(testWraps); w++)
+					{
+						testcase_t* c = &cases[count++];
+						c->font = testFonts[f];
+						c->size = sdf ? sdfSizes[s] : testSizes[s];
+						c->text = &testTexts[t];
+						c->wrap = testWraps[w];
+						c->sdf = sdf;
+
+						//Wrapped cases are measured from UTF-8, the output must be the same so they share the goldens
+						c->utf8 = c->wrap.maxWidth != 0;
+
+						char fontName[64];
+						strncpy(fontName, c->font, sizeof(fontName) - 1);
+						fontName[sizeof(fontName) - 1] = 0;
+						*strchr(fontName, '.') = 0;
+						snprintf(c->name, sizeof(c->name), "%s-%d-%s-w%d-s%d%s%s", fontName, c->size, c->text->name,
+							c->wrap.maxWidth, (int)(c->wrap.lineSpacing * 10), c->wrap.optimal ? "-optimal" : "", sdf ? "-sdf" : "");
+					}
+				}
+			}
+		}
+	}
+	return count;
+}
+
+//------------------------------------ IMAGES -------------------------------------
+typedef struct
+{
+	int width, height, yOffset;
+	unsigned char* pixels;
+} image_t;
+
+//Binary PGM with the y offset in a comment, readable by most image viewers
+static int WritePGM(const char* path, const image_t* image)
+{
+	FILE* file = fopen(path, "wb");
+	if (file == NULL)
+		return 0;
+	fprintf(file, "P5\n# yOffset %d\n%d %d\n255\n", image->yOffset, image->width, image->height);
+	fwrite(image->pixels, 1, (size_t)image->width * image->height, file);
+	fclose(file);
+	return 1;
+}
+
+static int ReadPGM(const char* path, image_t* image)
+{
+	FILE* file = fopen(path, "rb");
+	if (file == NULL)
+		return 0;
+
+	int maxValue = 0;
+	image->yOffset = 0;
+	if (fscanf(file, "P5 # yOffset %d %d %d %d", &image->yOffset, &image->width, &image->height, &maxValue) != 4 || maxValue != 255 ||
+		image->width < 0 || image->height < 0 || fgetc(file) == EOF)
+	{
+		fclose(file);
+		return 0;
+	}
+
+	size_t size = (size_t)image->width * image->height;
+	image->pixels = malloc(max(size, 1));
+	int complete = fread(image->pixels, 1, size, file) == size;
+	fclose(file);
+	if (!complete)
+		free(image->pixels);
+	return complete;
+}
+
+//------------------------------------ TIMING -------------------------------------
+static double GetSeconds()
+{
+#ifdef _WIN32
+	LARGE_INTEGER counter, frequency;
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+	return (double)counter.QuadPart / frequency.QuadPart;
+#else
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec * 1e-9;
+#endif
+}
+
+static int CompareDoubles(const void* a, const void* b)
+{
+	double x = *(const double*)a, y = *(const double*)b;
+	return (x > y) - (x < y);
+}
+
+//----------------------------------- RUNNING -------------------------------------
+typedef struct
+{
+	const char* fontDir;
+	const char* goldenDir;
+	const char* outputDir;
+	const char* timingsPath;
+	const char* filter;
+	int update;
+	int tolerance;
+	int maxPixels;
+	int repeat;
+	int rasterizer;
+	int edgeSort;
+	int flattening;
+	int queued;
+} options_t;
+
+//Renders a case repeat times, the last result is kept. Returns the median time of measuring and generating, or of
+//queueing and taking the render when it is queued
+static double RenderCase(int handle, const testcase_t* c, int repeat, int queued, image_t* image, double* minimum)
+{
+	utf16_t* text = Utf8ToUtf16(c->text->text);
+	double* times = malloc(sizeof(double) * repeat);
+	image->pixels = NULL;
+	SetRenderMode(c->sdf ? 1 : 0, sdfSpread);
+	SetWrapMode(c->wrap.optimal);
+
+	for (int r = 0; r < repeat; r++)
+	{
+		free(image->pixels);
+
+		if (queued)
+		{
+			double start = GetSeconds();
+			int job = QueueRender(handle, text, (int)Utf16Length(text), c->size, c->wrap.maxWidth, c->wrap.lineSpacing, c->sdf ? sdfSpread : 0);
+			WaitRender(job);
+			GetRenderStatus(job, &image->width, &image->height, &image->yOffset);
+			image->pixels = malloc(max((size_t)image->width * image->height, 1));
+			TakeRender(job, image->pixels);
+			times[r] = GetSeconds() - start;
+			continue;
+		}
+
+		double start = GetSeconds();
+		if (c->utf8)
+			MeasureBitmapUtf8(handle, c->text->text, (int)strlen(c->text->text), c->size, &image->width, &image->height, &image->yOffset, c->wrap.maxWidth, c->wrap.lineSpacing);
+		else
+			MeasureBitmap(handle, text, c->size, &image->width, &image->height, &image->yOffset, c->wrap.maxWidth, c->wrap.lineSpacing);
+		double measured = GetSeconds();
+
+		//Clearing is the caller's job and not timed
+		image->pixels = calloc(max((size_t)image->width * image->height, 1), 1);
+
+		double generating = GetSeconds();
+		GenerateBitmap(handle, image->pixels, image->width);
+		times[r] = (measured - start) + (GetSeconds() - generating);
+	}
+
+	SetRenderMode(0, 0);
+	SetWrapMode(0);
+	qsort(times, repeat, sizeof(double), CompareDoubles);
+	double median = times[repeat / 2];
+	*minimum = times[0];
+	free(times);
+	free(text);
+	return median;
+}
+
+//Returns 1 if the images match, differing is the number of pixels beyond tolerance and largest the biggest difference
+static int CompareImages(const image_t* actual, const image_t* golden, const options_t* options, int* differing, int* largest)
+{
+	*differing = 0;
+	*largest = 0;
+	if (actual->width != golden->width || actual->height != golden->height || actual->yOffset != golden->yOffset)
+		return 0;
+
+	for (size_t i = 0; i < (size_t)actual->width * actual->height; i++)
+	{
+		int difference = abs(actual->pixels[i] - golden->pixels[i]);
+		*largest = max(*largest, difference);
+		if (difference > options->tolerance)
+			(*differing)++;
+	}
+	return *differing <= options->maxPixels;
+}
+
+//The output and a difference image scaled so small changes are visible
+static void WriteFailure(const options_t* options, const testcase_t* c, const image_t* actual, const image_t* golden)
+{
+	if (options->outputDir == NULL)
+		return;
+
+	char path[1024];
+	snprintf(path, sizeof(path), "%s/%s.actual.pgm", options->outputDir, c->name);
+	if (!WritePGM(path, actual))
+	{
+		fprintf(stderr, "  can't write %s\n", path);
+		return;
+	}
+	fprintf(stderr, "  output written to %s\n", path);
+
+	if (golden == NULL || actual->width != golden->width || actual->height != golden->height)
+		return;
+
+	image_t diff = *actual;
+	diff.pixels = malloc(max((size_t)actual->width * actual->height, 1));
+	for (size_t i = 0; i < (size_t)actual->width * actual->height; i++)
+		diff.pixels[i] = (unsigned char)min(abs(actual->pixels[i] - golden->pixels[i]) * 8, 255);
+	snprintf(path, sizeof(path), "%s/%s.diff.pgm", options->outputDir, c->name);
+	WritePGM(path, &diff);
+	free(diff.pixels);
+}
+
+static const char* const rasterizers[] = { "list", "table", "tiled" };
+static const char* const edgeSorts[] = { "quicksort", "buckets" };
+static const char* const flattenings[] = { "halving", "analytic" };
+
+//Index of the name as SetRasterizer, SetEdgeSort or SetFlattening takes it, -1 if there is none
+static int FindName(const char* const* names, int count, const char* name)
+{
+	for (int i = 0; i < count; i++)
+	{
+		if (strcmp(name, names[i]) == 0)
+			return i;
+	}
+	return -1;
+}
+
+static void PrintUsage(const char* program)
+{
+	fprintf(stderr, "Usage: %s --fonts dir --golden dir [--update] [--tolerance n] [--max-pixels n] [--repeat n] [--filter text] "
+		"[--output dir] [--timings file] [--rasterizer list|table|tiled] [--edge-sort quicksort|buckets] "
+		"[--flattening halving|analytic] [--queued]\n", program);
+}
+
+int main(int argc, char** argv)
+{
+	options_t options = { NULL, NULL, NULL, NULL, NULL, 0, 0, 0, 5, 0, 1, 0, 0 };
+	for (int i = 1; i < argc; i++)
+	{
+		int hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "--fonts") == 0 && hasValue)
+			options.fontDir = argv[++i];
+		else if (strcmp(argv[i], "--golden") == 0 && hasValue)
+			options.goldenDir = argv[++i];
+		else if (strcmp(argv[i], "--output") == 0 && hasValue)
+			options.outputDir = argv[++i];
+		else if (strcmp(argv[i], "--timings") == 0 && hasValue)
+			options.timingsPath = argv[++i];
+		else if (strcmp(argv[i], "--filter") == 0 && hasValue)
+			options.filter = argv[++i];
+		else if (strcmp(argv[i], "--tolerance") == 0 && hasValue)
+			options.tolerance = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--max-pixels") == 0 && hasValue)
+			options.maxPixels = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--repeat") == 0 && hasValue)
+			options.repeat = max(atoi(argv[++i]), 1);
+		else if (strcmp(argv[i], "--rasterizer") == 0 && hasValue &&
+			(options.rasterizer = FindName(rasterizers, COUNT(rasterizers), argv[i + 1])) >= 0)
+			i++;
+		else if (strcmp(argv[i], "--edge-sort") == 0 && hasValue &&
+			(options.edgeSort = FindName(edgeSorts, COUNT(edgeSorts), argv[i + 1])) >= 0)
+			i++;
+		else if (strcmp(argv[i], "--flattening") == 0 && hasValue &&
+			(options.flattening = FindName(flattenings, COUNT(flattenings), argv[i + 1])) >= 0)
+			i++;
+		else if (strcmp(argv[i], "--queued") == 0)
+			options.queued = 1;
+		else if (strcmp(argv[i], "--update") == 0)
+			options.update = 1;
+		else
+		{
+			PrintUsage(argv[0]);
+			return 2;
+		}
+	}
+	if (options.fontDir == NULL || options.goldenDir == NULL)
+	{
+		PrintUsage(argv[0]);
+		return 2;
+	}
+
+	SetRasterizer(options.rasterizer);
+	SetEdgeSort(options.edgeSort);
+	SetFlattening(options.flattening);
+
+	static testcase_t cases[1024];
+	int numCases = BuildCases(cases);
+
+	FILE* timings = NULL;
+	if (options.timingsPath != NULL && (timings = fopen(options.timingsPath, "w")) == NULL)
+		fprintf(stderr, "Can't write %s\n", options.timingsPath);
+	if (timings != NULL)
+		fprintf(timings, "{\n\t\"schema\": 1,\n\t\"repeat\": %d,\n\t\"rasterizer\": \"%s\",\n\t\"edge_sort\": \"%s\",\n\t\"flattening\": \"%s\",\n\t"
+			"\"queued\": %s,\n\t\"cases\": [", options.repeat, rasterizers[options.rasterizer], edgeSorts[options.edgeSort],
+			flattenings[options.flattening], options.queued ? "true" : "false");
+
+	int run = 0, failed = 0, updated = 0;
+	double total = 0;
+	for (int i = 0; i < numCases; i++)
+	{
+		testcase_t* c = &cases[i];
+		if (options.filter != NULL && strstr(c->name, options.filter) == NULL)
+			continue;
+
+		char path[1024];
+		snprintf(path, sizeof(path), "%s/%s", options.fontDir, c->font);
+		char* fontName = NULL;
+		int handle = LoadFontUtf8(path, 0, &fontName);
+		if (handle < 0)
+		{
+			fprintf(stderr, "FAIL %s: can't load %s\n", c->name, path);
+			failed++;
+			continue;
+		}
+
+		int fallback = -1;
+		if (c->text->fallback)
+		{
+			snprintf(path, sizeof(path), "%s/%s", options.fontDir, testFonts[strcmp(c->font, testFonts[0]) == 0 ? 1 : 0]);
+			if ((fallback = LoadFontUtf8(path, 0, &fontName)) >= 0)
+				SetFallbackFonts(handle, &fallback, 1);
+		}
+
+		image_t actual;
+		double minimum;
+		double median = RenderCase(handle, c, options.repeat, options.queued, &actual, &minimum);
+		if (fallback >= 0)
+			SetFallbackFonts(handle, NULL, 0);
+		total += median;
+		run++;
+
+		snprintf(path, sizeof(path), "%s/%s.pgm", options.goldenDir, c->name);
+		image_t golden;
+		int hasGolden = ReadPGM(path, &golden);
+		int differing = 0, largest = 0;
+		int matches = hasGolden && CompareImages(&actual, &golden, &options, &differing, &largest);
+
+		if (options.update)
+		{
+			if (!matches)
+			{
+				if (!WritePGM(path, &actual))
+				{
+					fprintf(stderr, "FAIL %s: can't write %s\n", c->name, path);
+					failed++;
+				}
+				else
+				{
+					printf("updated %s\n", c->name);
+					updated++;
+				}
+			}
+		}
+		else if (!hasGolden)
+		{
+			fprintf(stderr, "FAIL %s: no golden at %s, create it with --update\n", c->name, path);
+			WriteFailure(&options, c, &actual, NULL);
+			failed++;
+		}
+		else if (!matches)
+		{
+			if (actual.width != golden.width || actual.height != golden.height || actual.yOffset != golden.yOffset)
+				fprintf(stderr, "FAIL %s: size %dx%d offset %d, expected %dx%d offset %d\n", c->name, actual.width, actual.height, actual.yOffset,
+					golden.width, golden.height, golden.yOffset);
+			else
+				fprintf(stderr, "FAIL %s: %d pixels differ by more than %d, largest difference %d\n", c->name, differing, options.tolerance, largest);
+			WriteFailure(&options, c, &actual, &golden);
+			failed++;
+		}
+
+		printf("%-52s %5dx%-4d %10.1f us %10.1f us min%s\n", c->name, actual.width, actual.height, median * 1e6, minimum * 1e6,
+			matches && largest > 0 ? " (within tolerance)" : "");
+		if (timings != NULL)
+		{
+			fprintf(timings, "%s\n\t\t{ \"name\": \"%s\", \"width\": %d, \"height\": %d, \"median_us\": %.3f, \"min_us\": %.3f, \"max_difference\": %d, \"passed\": %s }",
+				run == 1 ? "" : ",", c->name, actual.width, actual.height, median * 1e6, minimum * 1e6, largest, matches || options.update ? "true" : "false");
+		}
+
+		free(actual.pixels);
+		if (hasGolden)
+			free(golden.pixels);
+	}
+	FreeAllResources();
+
+	if (timings != NULL)
+	{
+		fprintf(timings, "\n\t],\n\t\"total_us\": %.3f\n}\n", total * 1e6);
+		fclose(timings);
+	}
+
+	if (options.update)
+		printf("%d cases, %d goldens updated, %d failed\n", run, updated, failed);
+	else
+		printf("%d cases, %d failed, %.1f us total\n", run, failed, total * 1e6);
+	return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,311 @@
+//Render queue test of simple-font-lib
+//
+//Checks what the goldens rendered through the queue can't show, since they only ever have one job in flight: text
+//scheduled again while it is held keeps its handle and is rendered once, held jobs start when the latency budget has
+//passed or in time for the frame deadline, WaitRender releases a held job, running jobs are replaced and cancelled, and
+//jobs rendered by several workers at once match GenerateBitmap
+//
+//Usage: sfl-render-queue --fonts dir
+//Timings are checked with wide margins so the test holds on a loaded machine with a single core
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "../simple-font-lib/platform.h"
+#include "../simple-font-lib/utf16.h"
+
+//Exports of the shared library
+int LoadFontUtf8(const char* filename, int index, char** actualName);
+void FreeAllResources();
+void SetRenderMode(int mode, int spread);
+void MeasureBitmap(int handle, utf16_t* text, int fontSize, int* width, int* height, int* yOffset, int maxWidth, float lineSpacing);
+void GenerateBitmap(int handle, unsigned char* emptyBitmap, int width);
+int QueueRender(int handle, const utf16_t* text, int length, int fontSize, int maxWidth, float lineSpacing, int spread);
+int ScheduleRender(int target, int handle, const utf16_t* text, int length, int fontSize, int maxWidth, float lineSpacing, int spread);
+void SetRenderLatencyBudget(int microseconds);
+void SetFrameDeadline(int microseconds);
+void FreeRenderTarget(int target);
+int GetRenderStatus(int job, int* width, int* height, int* yOffset);
+int WaitRender(int job);
+int TakeRender(int job, unsigned char* destination);
+void CancelRender(int job);
+void SetRenderWorkers(int count);
+
+enum
+{
+	RENDER_JOB_INVALID = -1,
+	RENDER_JOB_PENDING = 0,
+	RENDER_JOB_RUNNING = 1,
+	RENDER_JOB_DONE = 2
+};
+
+static const char* const shortText = "Held";
+static const char* const newerText = "Replaced while it was held";
+static const char* const longText = "The quick brown fox jumps over the lazy dog. Pack my box with five dozen liquor jugs. "
+	"How vexingly quick daft zebras jump! Sphinx of black quartz, judge my vow. The five boxing wizards jump quickly.";
+
+//------------------------------------ HELPERS ------------------------------------
+static int checks = 0, failures = 0;
+
+static void Check(int passed, const char* what)
+{
+	checks++;
+	if (!passed)
+	{
+		fprintf(stderr, "FAIL %s\n", what);
+		failures++;
+	}
+}
+
+static double GetSeconds()
+{
+#ifdef _WIN32
+	LARGE_INTEGER counter, frequency;
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+	return (double)counter.QuadPart / frequency.QuadPart;
+#else
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec * 1e-9;
+#endif
+}
+
+static void SleepMilliseconds(int milliseconds)
+{
+#ifdef _WIN32
+	Sleep(milliseconds);
+#else
+	struct timespec duration = { milliseconds / 1000, (milliseconds % 1000) * 1000000L };
+	nanosleep(&duration, NULL);
+#endif
+}
+
+//Polls the job until it leaves state or seconds have passed, returns the state it is in then
+static int WaitWhile(int job, int state, double seconds)
+{
+	double start = GetSeconds();
+	int width, height, yOffset, current;
+	while ((current = GetRenderStatus(job, &width, &height, &yOffset)) == state && GetSeconds() - start < seconds)
+		SleepMilliseconds(1);
+	return current;
+}
+
+//Returns 1 if the finished job's bitmap is the one GenerateBitmap gives for the same coverage text, the job is taken
+static int MatchesGenerated(int job, int handle, const char* text, int fontSize, int maxWidth)
+{
+	int width, height, yOffset;
+	if (GetRenderStatus(job, &width, &height, &yOffset) != RENDER_JOB_DONE)
+		return 0;
+	unsigned char* queued = malloc(max((size_t)width * height, 1));
+	TakeRender(job, queued);
+
+	utf16_t* utf16 = Utf8ToUtf16(text);
+	int expectedWidth, expectedHeight, expectedYOffset;
+	MeasureBitmap(handle, utf16, fontSize, &expectedWidth, &expectedHeight, &expectedYOffset, maxWidth, 1.0f);
+	unsigned char* generated = calloc(max((size_t)expectedWidth * expectedHeight, 1), 1);
+	GenerateBitmap(handle, generated, expectedWidth);
+
+	int matches = width == expectedWidth && height == expectedHeight && yOffset == expectedYOffset &&
+		memcmp(queued, generated, (size_t)width * height) == 0;
+	free(generated);
+	free(utf16);
+	free(queued);
+	return matches;
+}
+
+static int Schedule(int target, int handle, const char* text, int fontSize, int maxWidth, int spread)
+{
+	utf16_t* utf16 = Utf8ToUtf16(text);
+	int job = ScheduleRender(target, handle, utf16, (int)Utf16Length(utf16), fontSize, maxWidth, 1.0f, spread);
+	free(utf16);
+	return job;
+}
+
+static int Queue(int handle, const char* text, int fontSize, int maxWidth, int spread)
+{
+	utf16_t* utf16 = Utf8ToUtf16(text);
+	int job = QueueRender(handle, utf16, (int)Utf16Length(utf16), fontSize, maxWidth, 1.0f, spread);
+	free(utf16);
+	return job;
+}
+
+//Queues distance fields of the long text at growing sizes until one is seen running, which is then returned. target
+//is -1 to queue the jobs instead of scheduling them
+static int StartLongJob(int handle, int target)
+{
+	for (int fontSize = 48; fontSize <= 768; fontSize *= 2)
+	{
+		int job = target >= 0 ? Schedule(target, handle, longText, fontSize, 2000, 8) : Queue(handle, longText, fontSize, 2000, 8);
+		int state = WaitWhile(job, RENDER_JOB_PENDING, 10.0);
+		if (state == RENDER_JOB_RUNNING)
+			return job;
+		CancelRender(job);
+	}
+	return -1;
+}
+
+//------------------------------------- TESTS -------------------------------------
+//Text scheduled again while it is held replaces the held text under the same handle, and WaitRender starts it at once
+static void TestReplaceHeld(int handle)
+{
+	SetRenderWorkers(1);
+	SetRenderLatencyBudget(2000000);
+
+	int first = Schedule(1, handle, shortText, 20, 0, 0);
+	int second = Schedule(1, handle, newerText, 20, 0, 0);
+	Check(first >= 0 && second == first, "text scheduled while the target's job is held keeps the job's handle");
+
+	SleepMilliseconds(100);
+	int width, height, yOffset;
+	Check(GetRenderStatus(second, &width, &height, &yOffset) == RENDER_JOB_PENDING, "a scheduled job is held for the latency budget");
+
+	double start = GetSeconds();
+	Check(WaitRender(second) == RENDER_JOB_DONE, "WaitRender returns a held job done");
+	Check(GetSeconds() - start < 1.0, "WaitRender releases a held job before the latency budget has passed");
+	Check(MatchesGenerated(second, handle, newerText, 20, 0), "only the newest text of a held job is rendered");
+
+	//A held job is dropped with its target
+	int held = Schedule(2, handle, shortText, 20, 0, 0);
+	FreeRenderTarget(2);
+	Check(GetRenderStatus(held, &width, &height, &yOffset) == RENDER_JOB_INVALID, "FreeRenderTarget drops the held job");
+	SetRenderLatencyBudget(0);
+}
+
+//A held job starts by itself once the latency budget has passed
+static void TestLatencyBudget(int handle)
+{
+	SetRenderWorkers(1);
+	SetRenderLatencyBudget(300000);
+
+	double start = GetSeconds();
+	int job = Schedule(3, handle, shortText, 20, 0, 0);
+	int state = WaitWhile(job, RENDER_JOB_PENDING, 10.0);
+	double started = GetSeconds() - start;
+	if (state == RENDER_JOB_RUNNING)
+		state = WaitWhile(job, RENDER_JOB_RUNNING, 10.0);
+	Check(state == RENDER_JOB_DONE, "a held job is rendered once the latency budget has passed");
+	Check(started >= 0.29, "a held job isn't started before the latency budget has passed");
+	Check(MatchesGenerated(job, handle, shortText, 20, 0), "a held job renders its text");
+	SetRenderLatencyBudget(0);
+}
+
+//A frame deadline closer than the latency budget starts held jobs in time for it
+static void TestFrameDeadline(int handle)
+{
+	SetRenderWorkers(1);
+	SetRenderLatencyBudget(10000000);
+	SetFrameDeadline(200000);
+
+	double start = GetSeconds();
+	int job = Schedule(4, handle, shortText, 20, 0, 0);
+	int state = WaitWhile(job, RENDER_JOB_PENDING, 10.0);
+	double started = GetSeconds() - start;
+	if (state == RENDER_JOB_RUNNING)
+		state = WaitWhile(job, RENDER_JOB_RUNNING, 10.0);
+	Check(state == RENDER_JOB_DONE, "a held job is rendered for the frame deadline");
+	Check(started >= 0.15, "a held job of a target without renders isn't started before the frame deadline");
+	Check(started < 5.0, "the frame deadline starts a held job before the latency budget has passed");
+	CancelRender(job);
+
+	SetFrameDeadline(0);
+	SetRenderLatencyBudget(0);
+}
+
+//Text scheduled while the target's job is running goes into a new job and the running one is cancelled. A job cancelled
+//while it runs is dropped and the worker goes on with the next one
+static void TestRunning(int handle)
+{
+	SetRenderWorkers(1);
+
+	int running = StartLongJob(handle, 5);
+	Check(running >= 0, "a long job is seen running");
+	if (running >= 0)
+	{
+		int replacement = Schedule(5, handle, shortText, 20, 0, 0);
+		int width, height, yOffset;
+		Check(replacement >= 0 && replacement != running, "text scheduled while the target's job runs gets a new job");
+		Check(GetRenderStatus(running, &width, &height, &yOffset) == RENDER_JOB_INVALID, "the running job of a target is cancelled when it is replaced");
+		Check(WaitRender(replacement) == RENDER_JOB_DONE, "the replacing job is rendered");
+		Check(MatchesGenerated(replacement, handle, shortText, 20, 0), "the replacing job renders the new text");
+	}
+
+	running = StartLongJob(handle, -1);
+	Check(running >= 0, "a long queued job is seen running");
+	if (running >= 0)
+	{
+		CancelRender(running);
+		int width, height, yOffset;
+		Check(GetRenderStatus(running, &width, &height, &yOffset) == RENDER_JOB_INVALID, "a job cancelled while it runs is gone");
+		Check(WaitRender(running) == RENDER_JOB_INVALID, "WaitRender doesn't wait for a cancelled job");
+
+		int next = Queue(handle, newerText, 20, 0, 0);
+		Check(WaitRender(next) == RENDER_JOB_DONE, "the worker renders the next job after a cancelled one");
+		Check(MatchesGenerated(next, handle, newerText, 20, 0), "the job after a cancelled one renders its text");
+	}
+}
+
+//Several workers render many jobs at once, some cancelled before or while they run
+static void TestParallel(int handle)
+{
+	enum { NUM_JOBS = 24 };
+	static const int sizes[] = { 12, 20, 32, 64, 96, 128 };
+	SetRenderWorkers(4);
+
+	int jobs[NUM_JOBS];
+	for (int i = 0; i < NUM_JOBS; i++)
+	{
+		jobs[i] = Queue(handle, i % 2 ? longText : newerText, sizes[i % 6], i % 4 < 2 ? 0 : 400, 0);
+		if (i % 3 == 2)
+			CancelRender(jobs[i]);
+	}
+
+	int rendered = 1, cancelled = 1;
+	for (int i = 0; i < NUM_JOBS; i++)
+	{
+		if (i % 3 == 2)
+			cancelled &= WaitRender(jobs[i]) == RENDER_JOB_INVALID;
+		else
+			rendered &= WaitRender(jobs[i]) == RENDER_JOB_DONE &&
+				MatchesGenerated(jobs[i], handle, i % 2 ? longText : newerText, sizes[i % 6], i % 4 < 2 ? 0 : 400);
+	}
+	Check(rendered, "jobs rendered by several workers match GenerateBitmap");
+	Check(cancelled, "jobs cancelled while several workers run are gone");
+}
+
+int main(int argc, char** argv)
+{
+	if (argc != 3 || strcmp(argv[1], "--fonts") != 0)
+	{
+		fprintf(stderr, "Usage: %s --fonts dir\n", argv[0]);
+		return 2;
+	}
+
+	char path[1024];
+	snprintf(path, sizeof(path), "%s/Lato-Regular.ttf", argv[2]);
+	char* fontName = NULL;
+	int handle = LoadFontUtf8(path, 0, &fontName);
+	if (handle < 0)
+	{
+		fprintf(stderr, "FAIL can't load %s\n", path);
+		return 1;
+	}
+
+	TestReplaceHeld(handle);
+	TestLatencyBudget(handle);
+	TestFrameDeadline(handle);
+	TestRunning(handle);
+	TestParallel(handle);
+
+	SetRenderWorkers(0);
+	FreeAllResources();
+	printf("%d checks, %d failed\n", checks, failures);
+	return failures > 0 ? 1 : 0;
+}